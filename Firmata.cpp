@@ -58,7 +58,7 @@ void FirmataClass::sendValueAsTwo7bitBytes(int value)
  */
 void FirmataClass::startSysex(void)
 {
-  FirmataStream->write(START_SYSEX);
+  marshaller.write(START_SYSEX);
 }
 
 /**
@@ -66,7 +66,7 @@ void FirmataClass::startSysex(void)
  */
 void FirmataClass::endSysex(void)
 {
-  FirmataStream->write(END_SYSEX);
+  marshaller.write(END_SYSEX);
 }
 
 //******************************************************************************
@@ -84,6 +84,8 @@ FirmataClass::FirmataClass()
   firmwareVersionCount = 0;
   firmwareVersionVector = 0;
   blinkVersionDisabled = false;
+  timestampsEnabled = false;
+  lastTimestamp = 0;
 
   // Establish callback translation to parser callbacks
   parser.attach(ANALOG_MESSAGE, (FirmataParser::callbackFunction)staticAnalogCallback, (void *)NULL);
@@ -96,7 +98,10 @@ FirmataClass::FirmataClass()
   parser.attach(START_SYSEX, (FirmataParser::sysexCallbackFunction)staticSysexCallback, (void *)NULL);
   parser.attach(REPORT_FIRMWARE, (FirmataParser::versionCallbackFunction)staticReportFirmwareCallback, this);
   parser.attach(REPORT_VERSION, (FirmataParser::systemCallbackFunction)staticReportVersionCallback, this);
-  parser.attach(SYSTEM_RESET, (FirmataParser::systemCallbackFunction)staticSystemResetCallback, (void *)NULL);
+  parser.attach(SYSTEM_RESET, (FirmataParser::systemCallbackFunction)staticSystemResetCallback, this);
+#ifdef FIRMATA_TRACE
+  parser.attach(TRACE_DATA, (FirmataParser::traceCallbackFunction)staticTraceCallback, this);
+#endif
 }
 
 //******************************************************************************
@@ -288,6 +293,7 @@ boolean FirmataClass::isParsingMessage(void)
  */
 void FirmataClass::sendAnalog(byte pin, int value)
 {
+  stampReport();
   marshaller.sendAnalog(pin, value);
 }
 
@@ -329,6 +335,7 @@ void FirmataClass::sendDigital(byte pin, int value)
  */
 void FirmataClass::sendDigitalPort(byte portNumber, int portData)
 {
+  stampReport();
   marshaller.sendDigitalPort(portNumber, portData);
 }
 
@@ -341,6 +348,9 @@ void FirmataClass::sendDigitalPort(byte portNumber, int portData)
  */
 void FirmataClass::sendSysex(byte command, byte bytec, byte *bytev)
 {
+  if (command == I2C_REPLY) {
+    stampReport();
+  }
   marshaller.sendSysex(command, bytec, bytev);
 }
 
@@ -372,7 +382,7 @@ void FirmataClass::sendString(const char *string)
  */
 void FirmataClass::write(byte c)
 {
-  FirmataStream->write(c);
+  marshaller.write(c);
 }
 
 /**
@@ -467,6 +477,43 @@ void FirmataClass::detach(uint8_t command)
   }
 }
 
+/**
+ * Answer TIMESTAMP_DATA requests from the host software (see setTimestampReporting). The
+ * command is in the user-defined sysex range, so sketches that do not call this method keep
+ * receiving it through their START_SYSEX callback.
+ */
+void FirmataClass::enableTimestamps(void)
+{
+  parser.attach(TIMESTAMP_DATA, (FirmataParser::timestampCallbackFunction)staticTimestampCallback, this);
+}
+
+/**
+ * Answer CLOCK_SYNC requests from the host software (see replyClockSync). Without this call the
+ * command, from the user-defined sysex range, reaches the START_SYSEX callback.
+ */
+void FirmataClass::enableClockSync(void)
+{
+  parser.attach(CLOCK_SYNC, (FirmataParser::clockSyncCallbackFunction)staticClockSyncCallback, this);
+}
+
+/**
+ * Answer ECHO_DATA probes from the host software (see replyEcho). Without this call the
+ * command, from the user-defined sysex range, reaches the START_SYSEX callback.
+ */
+void FirmataClass::enableEcho(void)
+{
+  parser.attach(ECHO_DATA, (FirmataParser::echoCallbackFunction)staticEchoCallback, this);
+}
+
+/**
+ * Answer LINK_STATS queries from the host software (see reportLinkStats). Without this call
+ * the command, from the user-defined sysex range, reaches the START_SYSEX callback.
+ */
+void FirmataClass::enableLinkStats(void)
+{
+  parser.attach(LINK_STATS, (FirmataParser::linkStatsCallbackFunction)staticLinkStatsCallback, this);
+}
+
 /**
  * @param pin The pin to get the configuration of.
  * @return The configuration of the specified pin.
@@ -533,6 +580,114 @@ void FirmataClass::setPinState(byte pin, int state)
 //* Private Methods
 //******************************************************************************
 
+/**
+ * Enable or disable device timestamps upon a TIMESTAMP_DATA request from the host software.
+ * Enabling timestamps is acknowledged with a TIMESTAMP_BASE message, which also lets the host
+ * detect firmware that does not support them.
+ * @private
+ * @param command The timestamp sub-command (TIMESTAMP_ENABLE or TIMESTAMP_DISABLE).
+ */
+void FirmataClass::setTimestampReporting(uint8_t command)
+{
+  switch (command) {
+    case TIMESTAMP_ENABLE:
+      timestampsEnabled = true;
+      lastTimestamp = micros();
+      marshaller.sendTimestampBase(lastTimestamp);
+      break;
+    case TIMESTAMP_DISABLE:
+      timestampsEnabled = false;
+      break;
+  }
+}
+
+/**
+ * Answer a CLOCK_SYNC request from the host software. The receive time is taken when the parser
+ * completes the request, so time spent in the receive buffer counts towards the transport delay.
+ * @private
+ * @param sequence The sequence number of the request.
+ * @param host_time The host time carried by the request.
+ */
+void FirmataClass::replyClockSync(uint8_t sequence, uint32_t host_time)
+{
+  unsigned long receiveTime = micros();
+  marshaller.sendClockSyncReply(sequence, host_time, receiveTime, micros());
+}
+
+/**
+ * Answer an ECHO_DATA request from the host software. The reply is sent from the parser callback,
+ * before control returns to the sketch, so it is not delayed by the remaining work of loop().
+ * @private
+ * @param sequence The sequence number of the request.
+ * @param payloadc The number of payload bytes.
+ * @param payloadv A pointer to the payload bytes.
+ */
+void FirmataClass::replyEcho(uint16_t sequence, size_t payloadc, const uint8_t * payloadv)
+{
+  unsigned long receiveTime = micros();
+  marshaller.sendEchoReply(sequence, receiveTime, micros(), payloadc, payloadv);
+}
+
+/**
+ * Answer a LINK_STATS query from the host software with the parser and marshaller counters.
+ * @private
+ * @param flags LINK_STATS_RESET to clear the counters after reporting them.
+ */
+void FirmataClass::reportLinkStats(uint8_t flags)
+{
+  uint32_t counters[LINK_STATS_COUNTERS];
+  counters[LINK_STATS_BYTES_RECEIVED] = parser.getBytesReceived();
+  counters[LINK_STATS_MESSAGES_PARSED] = parser.getMessagesParsed();
+  counters[LINK_STATS_BUFFER_OVERFLOWS] = parser.getBufferOverflows();
+  counters[LINK_STATS_UNKNOWN_COMMANDS] = parser.getUnknownCommands();
+  counters[LINK_STATS_BYTES_SENT] = marshaller.getBytesSent();
+  counters[LINK_STATS_BYTES_DROPPED] = marshaller.getBytesDropped();
+  marshaller.sendLinkStatsReply(LINK_STATS_COUNTERS, counters);
+
+  if (flags & LINK_STATS_RESET) {
+    parser.resetCounters();
+    marshaller.resetCounters();
+  }
+}
+
+/**
+ * Answer a TRACE_DATA query from the host software with the content of the trace ring. Recording
+ * is suspended while the ring is sent, so the dump does not overwrite the events it reports.
+ * @private
+ * @param flags TRACE_DATA_CLEAR to discard the events after reporting them.
+ */
+void FirmataClass::reportTrace(uint8_t flags)
+{
+#ifdef FIRMATA_TRACE
+  FirmataTrace::setEnabled(false);
+  for (size_t i = 0; i < FirmataTrace::count(); ++i) {
+    const trace_event &e = FirmataTrace::event(i);
+    marshaller.sendTraceEvent(e.id, e.time, e.arg);
+  }
+  marshaller.sendTraceEnd(FirmataTrace::total(), FIRMATA_TRACE_SIZE);
+  if (flags & TRACE_DATA_CLEAR) {
+    FirmataTrace::clear();
+  }
+  FirmataTrace::setEnabled(true);
+#else
+  (void)flags;
+#endif
+}
+
+/**
+ * Precede a report with the device time elapsed since the previous timestamp, if the host
+ * software has enabled timestamps.
+ * @private
+ */
+void FirmataClass::stampReport(void)
+{
+  if (!timestampsEnabled) return;
+
+  unsigned long now = micros();
+  marshaller.sendTimestampDelta(now - lastTimestamp);
+  lastTimestamp = now;
+}
+
 /**
  * Flashing the pin for the version number
  * @private
@@ -18,6 +18,7 @@
 #include "FirmataDefines.h"
 #include "FirmataMarshaller.h"
 #include "FirmataParser.h"
+#include "FirmataTrace.h"
 
 /* DEPRECATED as of Firmata v2.5.1. As of 2.5.1 there are separate version numbers for
  * the protocol version and the firmware version.
@@ -97,6 +98,13 @@ class FirmataClass
     void attach(uint8_t command, sysexCallbackFunction newFunction);
     void detach(uint8_t command);
 
+    /* answer the diagnostics requests of host tools; their sysex commands are in the
+       user-defined range, so they reach the START_SYSEX callback unless enabled */
+    void enableTimestamps(void);
+    void enableClockSync(void);
+    void enableEcho(void);
+    void enableLinkStats(void);
+
     /* access pin state and config */
     byte getPinMode(byte pin);
     void setPinMode(byte pin, byte config);
@@ -126,8 +134,18 @@ class FirmataClass
 
     boolean blinkVersionDisabled;
 
+    /* device timestamps for outbound reports */
+    boolean timestampsEnabled;
+    unsigned long lastTimestamp;
+
     /* private methods ------------------------------ */
     void strobeBlinkPin(byte pin, int count, int onInterval, int offInterval);
+    void setTimestampReporting(uint8_t command);
+    void replyClockSync(uint8_t sequence, uint32_t host_time);
+    void replyEcho(uint16_t sequence, size_t payloadc, const uint8_t * payloadv);
+    void reportLinkStats(uint8_t flags);
+    void reportTrace(uint8_t flags);
+    void stampReport(void);
     friend void FirmataMarshaller::encodeByteStream (size_t bytec, uint8_t * bytev, size_t max_bytes) const;
 
     /* callback functions */
@@ -152,7 +170,12 @@ class FirmataClass
     inline static void staticSysexCallback (void *, uint8_t command, size_t argc, uint8_t *argv) { if ( currentSysexCallback ) { currentSysexCallback(command, (uint8_t)argc, argv); } }
     inline static void staticReportFirmwareCallback (void * context, size_t, size_t, const char *) { if ( context ) { ((FirmataClass *)context)->printFirmwareVersion(); } }
     inline static void staticReportVersionCallback (void * context) { if ( context ) { ((FirmataClass *)context)->printVersion(); } }
-    inline static void staticSystemResetCallback (void *) { if ( currentSystemResetCallback ) { currentSystemResetCallback(); } }
+    inline static void staticSystemResetCallback (void * context) { if ( context ) { ((FirmataClass *)context)->timestampsEnabled = false; } if ( currentSystemResetCallback ) { currentSystemResetCallback(); } }
+    inline static void staticTimestampCallback (void * context, uint8_t command, uint32_t) { if ( context ) { ((FirmataClass *)context)->setTimestampReporting(command); } }
+    inline static void staticTraceCallback (void * context, uint8_t command, uint8_t, uint32_t, uint16_t arg) { if ( context && command == TRACE_DATA_QUERY ) { ((FirmataClass *)context)->reportTrace(arg); } }
+    inline static void staticLinkStatsCallback (void * context, uint8_t command, uint8_t flags, size_t, const uint32_t *) { if ( context && command == LINK_STATS_QUERY ) { ((FirmataClass *)context)->reportLinkStats(flags); } }
+    inline static void staticEchoCallback (void * context, uint8_t command, uint16_t sequence, uint32_t, uint32_t, size_t payloadc, uint8_t * payloadv) { if ( context && command == ECHO_REQUEST ) { ((FirmataClass *)context)->replyEcho(sequence, payloadc, payloadv); } }
+    inline static void staticClockSyncCallback (void * context, uint8_t command, uint8_t sequence, uint32_t host_time, uint32_t, uint32_t) { if ( context && command == CLOCK_SYNC_REQUEST ) { ((FirmataClass *)context)->replyClockSync(sequence, host_time); } }
 };
 
 } // namespace firmata
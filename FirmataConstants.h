@@ -52,6 +52,17 @@ static const int END_SYSEX =               0xF7; // end a MIDI Sysex message
 // extended command set using sysex (0-127/0x00-0x7F)
 /* 0x00-0x0F reserved for user-defined commands */
 
+// diagnostics extensions (allocated from the user-defined range, so a firmware only answers
+// them once it enables them: a FirmataFeature, FIRMATA_TRACE or a FirmataClass::enable...() call)
+static const int LOGIC_CAPTURE =           0x01; // sample digital ports into run-length encoded records
+static const int TIMESTAMP_DATA =          0x02; // negotiate and carry device timestamps for outbound reports
+static const int CLOCK_SYNC =              0x03; // exchange host and device times to synchronize clocks
+static const int ECHO_DATA =               0x04; // round trip latency probe answered as soon as it is parsed
+static const int LOOP_TIMING =             0x05; // query the duration of the stages of the main loop
+static const int LINK_STATS =              0x06; // query the throughput and error counters of the link
+static const int TRACE_DATA =              0x07; // read the event trace ring
+static const int MEMORY_STATS =            0x08; // query the stack high-water mark and free RAM
+
 static const int SERIAL_DATA =             0x60; // communicate with serial devices, including other boards
 static const int ENCODER_DATA =            0x61; // reply with encoders current positions
 static const int SERVO_CONFIG =            0x70; // set max angle, minPulse, maxPulse, freq
@@ -92,6 +103,44 @@ static const int PIN_MODE_IGNORE =         0x7F; // pin configured to be ignored
 
 static const int TOTAL_PIN_MODES =         13;
 
+// timestamp sub-commands
+static const int TIMESTAMP_DISABLE =       0x00; // stop prefixing reports with device timestamps
+static const int TIMESTAMP_ENABLE =        0x01; // prefix reports with device timestamps
+static const int TIMESTAMP_BASE =          0x02; // absolute device time in microseconds
+static const int TIMESTAMP_DELTA =         0x03; // device microseconds elapsed since the previous timestamp
+
+// clock sync sub-commands
+static const int CLOCK_SYNC_REQUEST =      0x00; // host time at transmission, padded to the length of a reply
+static const int CLOCK_SYNC_REPLY =        0x01; // host time, device receive time and device transmit time
+
+// echo sub-commands
+static const int ECHO_REQUEST =            0x00; // sequence number and payload
+static const int ECHO_REPLY =              0x01; // sequence number, device receive and transmit times, payload
+
+// link statistics sub-commands
+static const int LINK_STATS_QUERY =        0x00; // flags
+static const int LINK_STATS_REPLY =        0x01; // counters, five 7-bit bytes each
+
+// link statistics query flags
+static const int LINK_STATS_RESET =        0x01; // clear the counters after reporting them
+
+// link statistics counters, in the order of a reply
+static const int LINK_STATS_BYTES_RECEIVED = 0; // bytes passed to the parser
+static const int LINK_STATS_MESSAGES_PARSED = 1; // complete messages recognized by the parser
+static const int LINK_STATS_BUFFER_OVERFLOWS = 2; // data bytes that did not fit the parser buffer
+static const int LINK_STATS_UNKNOWN_COMMANDS = 3; // bytes that did not start a known message
+static const int LINK_STATS_BYTES_SENT =   4; // bytes accepted by the stream
+static const int LINK_STATS_BYTES_DROPPED = 5; // bytes the stream failed to write
+static const int LINK_STATS_COUNTERS =     6; // number of counters in a reply
+
+// trace sub-commands
+static const int TRACE_DATA_QUERY =        0x00; // flags
+static const int TRACE_DATA_EVENT =        0x01; // event id, time (5), argument (3)
+static const int TRACE_DATA_END =          0x02; // events recorded since the last clear (5), ring size (3)
+
+// trace query flags
+static const int TRACE_DATA_CLEAR =        0x01; // discard the events after reporting them
+
 } // namespace firmata
 
 #endif // FirmataConstants_h
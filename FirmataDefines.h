@@ -98,6 +98,48 @@
 // extended command set using sysex (0-127/0x00-0x7F)
 /* 0x00-0x0F reserved for user-defined commands */
 
+// diagnostics extensions (allocated from the user-defined range)
+
+#ifdef LOGIC_CAPTURE
+#undef LOGIC_CAPTURE
+#endif
+#define LOGIC_CAPTURE           firmata::LOGIC_CAPTURE // sample digital ports into run-length encoded records
+
+#ifdef TIMESTAMP_DATA
+#undef TIMESTAMP_DATA
+#endif
+#define TIMESTAMP_DATA          firmata::TIMESTAMP_DATA // negotiate and carry device timestamps for outbound reports
+
+#ifdef CLOCK_SYNC
+#undef CLOCK_SYNC
+#endif
+#define CLOCK_SYNC              firmata::CLOCK_SYNC // exchange host and device times to synchronize clocks
+
+#ifdef ECHO_DATA
+#undef ECHO_DATA
+#endif
+#define ECHO_DATA               firmata::ECHO_DATA // round trip latency probe answered as soon as it is parsed
+
+#ifdef LOOP_TIMING
+#undef LOOP_TIMING
+#endif
+#define LOOP_TIMING             firmata::LOOP_TIMING // query the duration of the stages of the main loop
+
+#ifdef LINK_STATS
+#undef LINK_STATS
+#endif
+#define LINK_STATS              firmata::LINK_STATS // query the throughput and error counters of the link
+
+#ifdef TRACE_DATA
+#undef TRACE_DATA
+#endif
+#define TRACE_DATA              firmata::TRACE_DATA // read the event trace ring
+
+#ifdef MEMORY_STATS
+#undef MEMORY_STATS
+#endif
+#define MEMORY_STATS            firmata::MEMORY_STATS // query the stack high-water mark and free RAM
+
 #ifdef SERIAL_MESSAGE
 #undef SERIAL_MESSAGE
 #endif
@@ -280,4 +322,130 @@
 #endif
 #define TOTAL_PIN_MODES         firmata::TOTAL_PIN_MODES
 
+// timestamp sub-commands
+
+#ifdef TIMESTAMP_DISABLE
+#undef TIMESTAMP_DISABLE
+#endif
+#define TIMESTAMP_DISABLE       firmata::TIMESTAMP_DISABLE // stop prefixing reports with device timestamps
+
+#ifdef TIMESTAMP_ENABLE
+#undef TIMESTAMP_ENABLE
+#endif
+#define TIMESTAMP_ENABLE        firmata::TIMESTAMP_ENABLE // prefix reports with device timestamps
+
+#ifdef TIMESTAMP_BASE
+#undef TIMESTAMP_BASE
+#endif
+#define TIMESTAMP_BASE          firmata::TIMESTAMP_BASE // absolute device time in microseconds
+
+#ifdef TIMESTAMP_DELTA
+#undef TIMESTAMP_DELTA
+#endif
+#define TIMESTAMP_DELTA         firmata::TIMESTAMP_DELTA // device microseconds elapsed since the previous timestamp
+
+// clock sync sub-commands
+
+#ifdef CLOCK_SYNC_REQUEST
+#undef CLOCK_SYNC_REQUEST
+#endif
+#define CLOCK_SYNC_REQUEST      firmata::CLOCK_SYNC_REQUEST // host time at transmission, padded to the length of a reply
+
+#ifdef CLOCK_SYNC_REPLY
+#undef CLOCK_SYNC_REPLY
+#endif
+#define CLOCK_SYNC_REPLY        firmata::CLOCK_SYNC_REPLY // host time, device receive time and device transmit time
+
+// echo sub-commands
+
+#ifdef ECHO_REQUEST
+#undef ECHO_REQUEST
+#endif
+#define ECHO_REQUEST            firmata::ECHO_REQUEST // sequence number and payload
+
+#ifdef ECHO_REPLY
+#undef ECHO_REPLY
+#endif
+#define ECHO_REPLY              firmata::ECHO_REPLY // sequence number, device receive and transmit times, payload
+
+// link statistics sub-commands
+
+#ifdef LINK_STATS_QUERY
+#undef LINK_STATS_QUERY
+#endif
+#define LINK_STATS_QUERY        firmata::LINK_STATS_QUERY // flags
+
+#ifdef LINK_STATS_REPLY
+#undef LINK_STATS_REPLY
+#endif
+#define LINK_STATS_REPLY        firmata::LINK_STATS_REPLY // counters, five 7-bit bytes each
+
+// link statistics query flags
+
+#ifdef LINK_STATS_RESET
+#undef LINK_STATS_RESET
+#endif
+#define LINK_STATS_RESET        firmata::LINK_STATS_RESET // clear the counters after reporting them
+
+// link statistics counters, in the order of a reply
+
+#ifdef LINK_STATS_BYTES_RECEIVED
+#undef LINK_STATS_BYTES_RECEIVED
+#endif
+#define LINK_STATS_BYTES_RECEIVED firmata::LINK_STATS_BYTES_RECEIVED // bytes passed to the parser
+
+#ifdef LINK_STATS_MESSAGES_PARSED
+#undef LINK_STATS_MESSAGES_PARSED
+#endif
+#define LINK_STATS_MESSAGES_PARSED firmata::LINK_STATS_MESSAGES_PARSED // complete messages recognized by the parser
+
+#ifdef LINK_STATS_BUFFER_OVERFLOWS
+#undef LINK_STATS_BUFFER_OVERFLOWS
+#endif
+#define LINK_STATS_BUFFER_OVERFLOWS firmata::LINK_STATS_BUFFER_OVERFLOWS // data bytes that did not fit the parser buffer
+
+#ifdef LINK_STATS_UNKNOWN_COMMANDS
+#undef LINK_STATS_UNKNOWN_COMMANDS
+#endif
+#define LINK_STATS_UNKNOWN_COMMANDS firmata::LINK_STATS_UNKNOWN_COMMANDS // bytes that did not start a known message
+
+#ifdef LINK_STATS_BYTES_SENT
+#undef LINK_STATS_BYTES_SENT
+#endif
+#define LINK_STATS_BYTES_SENT   firmata::LINK_STATS_BYTES_SENT // bytes accepted by the stream
+
+#ifdef LINK_STATS_BYTES_DROPPED
+#undef LINK_STATS_BYTES_DROPPED
+#endif
+#define LINK_STATS_BYTES_DROPPED firmata::LINK_STATS_BYTES_DROPPED // bytes the stream failed to write
+
+#ifdef LINK_STATS_COUNTERS
+#undef LINK_STATS_COUNTERS
+#endif
+#define LINK_STATS_COUNTERS     firmata::LINK_STATS_COUNTERS // number of counters in a reply
+
+// trace sub-commands
+
+#ifdef TRACE_DATA_QUERY
+#undef TRACE_DATA_QUERY
+#endif
+#define TRACE_DATA_QUERY        firmata::TRACE_DATA_QUERY // flags
+
+#ifdef TRACE_DATA_EVENT
+#undef TRACE_DATA_EVENT
+#endif
+#define TRACE_DATA_EVENT        firmata::TRACE_DATA_EVENT // event id, time (5), argument (3)
+
+#ifdef TRACE_DATA_END
+#undef TRACE_DATA_END
+#endif
+#define TRACE_DATA_END          firmata::TRACE_DATA_END // events recorded since the last clear (5), ring size (3)
+
+// trace query flags
+
+#ifdef TRACE_DATA_CLEAR
+#undef TRACE_DATA_CLEAR
+#endif
+#define TRACE_DATA_CLEAR        firmata::TRACE_DATA_CLEAR // discard the events after reporting them
+
 #endif // FirmataConstants_h
@@ -24,6 +24,7 @@
 #endif
 
 #include "FirmataConstants.h"
+#include "FirmataTrace.h"
 
 using namespace firmata;
 
@@ -45,8 +46,8 @@ const
 {
   if ( (Stream *)NULL == FirmataStream ) { return; }
   // pin can only be 0-15, so chop higher bits
-  FirmataStream->write(REPORT_ANALOG | (pin & 0xF));
-  FirmataStream->write(stream_enable);
+  write(REPORT_ANALOG | (pin & 0xF));
+  write(stream_enable);
 }
 
 /**
@@ -61,8 +62,8 @@ void FirmataMarshaller::reportDigitalPort(uint8_t portNumber, bool stream_enable
 const
 {
   if ( (Stream *)NULL == FirmataStream ) { return; }
-  FirmataStream->write(REPORT_DIGITAL | (portNumber & 0xF));
-  FirmataStream->write(stream_enable);
+  write(REPORT_DIGITAL | (portNumber & 0xF));
+  write(stream_enable);
 }
 
 /**
@@ -76,11 +77,27 @@ void FirmataMarshaller::sendExtendedAnalog(uint8_t pin, size_t bytec, uint8_t *
 const
 {
   if ( (Stream *)NULL == FirmataStream ) { return; }
-  FirmataStream->write(START_SYSEX);
-  FirmataStream->write(EXTENDED_ANALOG);
-  FirmataStream->write(pin);
+  write(START_SYSEX);
+  write(EXTENDED_ANALOG);
+  write(pin);
   encodeByteStream(bytec, bytev, bytec);
-  FirmataStream->write(END_SYSEX);
+  write(END_SYSEX);
+}
+
+/**
+ * Send a TIMESTAMP_DATA message carrying a single 7-bit varint.
+ * @param subcommand The timestamp sub-command (TIMESTAMP_BASE or TIMESTAMP_DELTA).
+ * @param value The time value in microseconds.
+ */
+void FirmataMarshaller::sendTimestamp(uint8_t subcommand, uint32_t value)
+const
+{
+  if ( (Stream *)NULL == FirmataStream ) { return; }
+  write(START_SYSEX);
+  write(TIMESTAMP_DATA);
+  write(subcommand);
+  encodeVarint(value);
+  write(END_SYSEX);
 }
 
 /**
@@ -102,20 +119,67 @@ const
   if ( !max_bytes ) { max_bytes = static_cast<size_t>(-1); }
   for (size_t i = 0 ; (i < bytec) && (bytes_sent < max_bytes) ; ++i) {
     uint8_t transmit_byte = (outstanding_bit_cache|(bytev[i] << outstanding_bits));
-    FirmataStream->write(transmit_mask & transmit_byte);
+    write(transmit_mask & transmit_byte);
     ++bytes_sent;
     outstanding_bit_cache = (bytev[i] >> (transmit_bits - outstanding_bits));
     outstanding_bits = (outstanding_bits + (8 - transmit_bits));
     for ( ; (outstanding_bits >= transmit_bits) && (bytes_sent < max_bytes) ; ) {
       transmit_byte = outstanding_bit_cache;
-    FirmataStream->write(transmit_mask & transmit_byte);
+    write(transmit_mask & transmit_byte);
       ++bytes_sent;
       outstanding_bit_cache >>= transmit_bits;
       outstanding_bits -= transmit_bits;
     }
   }
   if ( outstanding_bits && (bytes_sent < max_bytes) ) {
-    FirmataStream->write(static_cast<uint8_t>((1 << outstanding_bits) - 1) & outstanding_bit_cache);
+    write(static_cast<uint8_t>((1 << outstanding_bits) - 1) & outstanding_bit_cache);
+  }
+}
+
+/**
+ * Transform a 32-bit value into a 7-bit varint. The value is sent least significant group first
+ * using as few bytes as needed (at least one). The length is given by the end of the enclosing
+ * sysex message, so no continuation bits are used.
+ * @param value The value to encode.
+ */
+void FirmataMarshaller::encodeVarint (uint32_t value)
+const
+{
+  do {
+    write(static_cast<uint8_t>(value & 0x7F));
+    value >>= 7;
+  } while ( value );
+}
+
+/**
+ * Transform a 32-bit value into five 7-bit bytes (least significant group first). Unlike
+ * encodeVarint(), the length is fixed so several values can follow each other in one message.
+ * @param value The value to encode.
+ */
+void FirmataMarshaller::encodeUint32 (uint32_t value)
+const
+{
+  for (size_t i = 0 ; i < 5 ; ++i) {
+    write(static_cast<uint8_t>(value & 0x7F));
+    value >>= 7;
+  }
+}
+
+/**
+ * Write a single byte to the stream and count it as sent or, if the stream did not accept it,
+ * as dropped.
+ * @param data The byte to write.
+ */
+void FirmataMarshaller::write (uint8_t data)
+const
+{
+  if ( FirmataStream->write(data) ) {
+    ++bytesSent;
+    // only command bytes are traced, so a message costs one or two events
+    if ( data & 0x80 ) { FIRMATA_TRACE_EVENT(TRACE_SEND, data); }
+  } else {
+    ++bytesDropped;
+    FIRMATA_TRACE_EVENT(TRACE_SEND_DROPPED, data);
   }
 }
 
@@ -128,7 +192,9 @@ const
  */
 FirmataMarshaller::FirmataMarshaller()
 :
-  FirmataStream((Stream *)NULL)
+  FirmataStream((Stream *)NULL),
+  bytesSent(0),
+  bytesDropped(0)
 {
 }
 
@@ -155,6 +221,34 @@ void FirmataMarshaller::end(void)
   FirmataStream = (Stream *)NULL;
 }
 
+/**
+ * @return The number of bytes accepted by the stream.
+ */
+uint32_t FirmataMarshaller::getBytesSent(void)
+const
+{
+  return bytesSent;
+}
+
+/**
+ * @return The number of bytes the stream failed to write, e.g. because its buffer was full or
+ * the connection was lost.
+ */
+uint32_t FirmataMarshaller::getBytesDropped(void)
+const
+{
+  return bytesDropped;
+}
+
+/**
+ * Clear the counters of sent and dropped bytes.
+ */
+void FirmataMarshaller::resetCounters(void)
+{
+  bytesSent = 0;
+  bytesDropped = 0;
+}
+
 //******************************************************************************
 //* Output Stream Handling
 //******************************************************************************
@@ -166,9 +260,9 @@ void FirmataMarshaller::queryFirmwareVersion(void)
 const
 {
   if ( (Stream *)NULL == FirmataStream ) { return; }
-  FirmataStream->write(START_SYSEX);
-  FirmataStream->write(REPORT_FIRMWARE);
-  FirmataStream->write(END_SYSEX);
+  write(START_SYSEX);
+  write(REPORT_FIRMWARE);
+  write(END_SYSEX);
 }
 
 /**
@@ -178,7 +272,7 @@ void FirmataMarshaller::queryVersion(void)
 const
 {
   if ( (Stream *)NULL == FirmataStream ) { return; }
-  FirmataStream->write(REPORT_VERSION);
+  write(REPORT_VERSION);
 }
 
 /**
@@ -233,6 +327,34 @@ const
   reportDigitalPort(portNumber, true);
 }
 
+/**
+ * Ask the target to stop prefixing its reports with TIMESTAMP_DELTA messages.
+ */
+void FirmataMarshaller::reportTimestampsDisable(void)
+const
+{
+  if ( (Stream *)NULL == FirmataStream ) { return; }
+  write(START_SYSEX);
+  write(TIMESTAMP_DATA);
+  write(TIMESTAMP_DISABLE);
+  write(END_SYSEX);
+}
+
+/**
+ * Ask the target to prefix its ANALOG_MESSAGE, DIGITAL_MESSAGE and I2C_REPLY reports with
+ * TIMESTAMP_DELTA messages. A target that supports timestamps acknowledges the request with a
+ * TIMESTAMP_BASE message carrying its current time in microseconds.
+ */
+void FirmataMarshaller::reportTimestampsEnable(void)
+const
+{
+  if ( (Stream *)NULL == FirmataStream ) { return; }
+  write(START_SYSEX);
+  write(TIMESTAMP_DATA);
+  write(TIMESTAMP_ENABLE);
+  write(END_SYSEX);
+}
+
 /**
  * Send an analog message to the Firmata host application. The range of pins is limited to [0..15]
  * when using the ANALOG_MESSAGE. The maximum value of the ANALOG_MESSAGE is limited to 14 bits
@@ -247,7 +369,7 @@ const
 {
   if ( (Stream *)NULL == FirmataStream ) { return; }
   if ( (0xF >= pin) && (0x3FFF >= value) ) {
-    FirmataStream->write(ANALOG_MESSAGE|pin);
+    write(ANALOG_MESSAGE|pin);
     encodeByteStream(sizeof(value), reinterpret_cast<uint8_t *>(&value), sizeof(value));
   } else {
     sendExtendedAnalog(pin, sizeof(value), reinterpret_cast<uint8_t *>(&value));
@@ -276,6 +398,52 @@ const
   sendSysex(CAPABILITY_QUERY, 0, NULL);
 }
 
+/**
+ * Answer a clock sync request. The host time is echoed unchanged, so the host does not need to
+ * keep state per request.
+ * @param sequence The sequence number of the request (0 - 127).
+ * @param host_time_us The host time carried by the request.
+ * @param receive_time_us The device time in microseconds when the request was received.
+ * @param transmit_time_us The device time in microseconds when the reply is sent.
+ */
+void FirmataMarshaller::sendClockSyncReply(uint8_t sequence, uint32_t host_time_us, uint32_t receive_time_us, uint32_t transmit_time_us)
+const
+{
+  if ( (Stream *)NULL == FirmataStream ) { return; }
+  write(START_SYSEX);
+  write(CLOCK_SYNC);
+  write(CLOCK_SYNC_REPLY);
+  write(sequence & 0x7F);
+  encodeUint32(host_time_us);
+  encodeUint32(receive_time_us);
+  encodeUint32(transmit_time_us);
+  write(END_SYSEX);
+}
+
+/**
+ * Send an NTP-style clock sync request to the Firmata host application. The target replies with
+ * the host time, its receive time and its transmit time, from which the host can estimate the
+ * clock offset and the round trip delay. Like in NTP, the request carries the two device times
+ * as zeros, so it is as long as the reply: the receive time is taken after the last byte of the
+ * request arrived and the host takes the reply's receive time after its last byte, so both
+ * directions include the same serialization time.
+ * @param sequence A sequence number to match the reply with the request (0 - 127).
+ * @param host_time_us The host time in microseconds at transmission.
+ */
+void FirmataMarshaller::sendClockSyncRequest(uint8_t sequence, uint32_t host_time_us)
+const
+{
+  if ( (Stream *)NULL == FirmataStream ) { return; }
+  write(START_SYSEX);
+  write(CLOCK_SYNC);
+  write(CLOCK_SYNC_REQUEST);
+  write(sequence & 0x7F);
+  encodeUint32(host_time_us);
+  encodeUint32(0);
+  encodeUint32(0);
+  write(END_SYSEX);
+}
+
 /**
  * Send a single digital pin value to the Firmata host application.
  * @param pin The digital pin to send the value of.
@@ -285,9 +453,9 @@ void FirmataMarshaller::sendDigital(uint8_t pin, uint8_t value)
 const
 {
   if ( (Stream *)NULL == FirmataStream ) { return; }
-  FirmataStream->write(SET_DIGITAL_PIN_VALUE);
-  FirmataStream->write(pin & 0x7F);
-  FirmataStream->write(value != 0);
+  write(SET_DIGITAL_PIN_VALUE);
+  write(pin & 0x7F);
+  write(value != 0);
 }
 
 
@@ -303,12 +471,62 @@ void FirmataMarshaller::sendDigitalPort(uint8_t portNumber, uint16_t portData)
 const
 {
   if ( (Stream *)NULL == FirmataStream ) { return; }
-  FirmataStream->write(DIGITAL_MESSAGE | (portNumber & 0xF));
+  write(DIGITAL_MESSAGE | (portNumber & 0xF));
   // Tx bits  0-6 (protocol v1 and higher)
   // Tx bits 7-13 (bit 7 only for protocol v2 and higher)
   encodeByteStream(sizeof(portData), reinterpret_cast<uint8_t *>(&portData), sizeof(portData));
 }
 
+/**
+ * Answer an echo request with the device receive and transmit times and the unchanged payload.
+ * @param sequence The sequence number of the request (0 - 16383).
+ * @param receive_time_us The device time in microseconds when the request was received.
+ * @param transmit_time_us The device time in microseconds when the reply is sent.
+ * @param bytec The number of payload bytes.
+ * @param bytev A pointer to the 7-bit payload bytes of the request.
+ */
+void FirmataMarshaller::sendEchoReply(uint16_t sequence, uint32_t receive_time_us, uint32_t transmit_time_us, size_t bytec, const uint8_t *bytev)
+const
+{
+  if ( (Stream *)NULL == FirmataStream ) { return; }
+  size_t i;
+  write(START_SYSEX);
+  write(ECHO_DATA);
+  write(ECHO_REPLY);
+  write(sequence & 0x7F);
+  write((sequence >> 7) & 0x7F);
+  encodeUint32(receive_time_us);
+  encodeUint32(transmit_time_us);
+  for (i = 0; i < bytec; ++i) {
+    write(bytev[i] & 0x7F);
+  }
+  write(END_SYSEX);
+}
+
+/**
+ * Send an echo request (ping) to the Firmata host application. The target answers as soon as it
+ * has parsed the request, returning the sequence number, its receive and transmit times and the
+ * payload, which can be used to measure the latency for different message sizes.
+ * @param sequence A sequence number to match the reply with the request (0 - 16383).
+ * @param bytec The number of payload bytes (the payload must fit the target's parser buffer).
+ * @param bytev A pointer to the payload bytes, only the lower 7 bits of each byte are sent.
+ */
+void FirmataMarshaller::sendEchoRequest(uint16_t sequence, size_t bytec, const uint8_t *bytev)
+const
+{
+  if ( (Stream *)NULL == FirmataStream ) { return; }
+  size_t i;
+  write(START_SYSEX);
+  write(ECHO_DATA);
+  write(ECHO_REQUEST);
+  write(sequence & 0x7F);
+  write((sequence >> 7) & 0x7F);
+  for (i = 0; i < bytec; ++i) {
+    write(bytev[i] & 0x7F);
+  }
+  write(END_SYSEX);
+}
+
 /**
  * Sends the firmware name and version to the Firmata host application.
  * @param major The major verison number
@@ -321,14 +539,71 @@ const
 {
   if ( (Stream *)NULL == FirmataStream ) { return; }
   size_t i;
-  FirmataStream->write(START_SYSEX);
-  FirmataStream->write(REPORT_FIRMWARE);
-  FirmataStream->write(major);
-  FirmataStream->write(minor);
+  write(START_SYSEX);
+  write(REPORT_FIRMWARE);
+  write(major);
+  write(minor);
   for (i = 0; i < bytec; ++i) {
     encodeByteStream(sizeof(bytev[i]), reinterpret_cast<uint8_t *>(&bytev[i]));
   }
-  FirmataStream->write(END_SYSEX);
+  write(END_SYSEX);
+}
+
+/**
+ * Send one event of the trace ring (part of the reply to a TRACE_DATA_QUERY).
+ * @param id The event id.
+ * @param time_us The device time of the event in microseconds.
+ * @param arg The event argument.
+ */
+void FirmataMarshaller::sendTraceEvent(uint8_t id, uint32_t time_us, uint16_t arg)
+const
+{
+  if ( (Stream *)NULL == FirmataStream ) { return; }
+  write(START_SYSEX);
+  write(TRACE_DATA);
+  write(TRACE_DATA_EVENT);
+  write(id & 0x7F);
+  encodeUint32(time_us);
+  write(arg & 0x7F);
+  write((arg >> 7) & 0x7F);
+  write((arg >> 14) & 0x7F);
+  write(END_SYSEX);
+}
+
+/**
+ * Terminate a trace dump (the reply to a TRACE_DATA_QUERY).
+ * @param total The number of events recorded since the last clear, including overwritten ones.
+ * @param capacity The number of events the ring holds.
+ */
+void FirmataMarshaller::sendTraceEnd(uint32_t total, uint16_t capacity)
+const
+{
+  if ( (Stream *)NULL == FirmataStream ) { return; }
+  write(START_SYSEX);
+  write(TRACE_DATA);
+  write(TRACE_DATA_END);
+  encodeUint32(total);
+  write(capacity & 0x7F);
+  write((capacity >> 7) & 0x7F);
+  write((capacity >> 14) & 0x7F);
+  write(END_SYSEX);
+}
+
+/**
+ * Ask the target for the content of its trace ring. The target answers with one
+ * TRACE_DATA_EVENT message per event, oldest first, followed by a TRACE_DATA_END message.
+ * Targets built without FIRMATA_TRACE do not answer.
+ * @param flags TRACE_DATA_CLEAR to discard the events after reporting them.
+ */
+void FirmataMarshaller::sendTraceQuery(uint8_t flags)
+const
+{
+  if ( (Stream *)NULL == FirmataStream ) { return; }
+  write(START_SYSEX);
+  write(TRACE_DATA);
+  write(TRACE_DATA_QUERY);
+  write(flags & 0x7F);
+  write(END_SYSEX);
 }
 
 /**
@@ -340,9 +615,44 @@ void FirmataMarshaller::sendVersion(uint8_t major, uint8_t minor)
 const
 {
   if ( (Stream *)NULL == FirmataStream ) { return; }
-  FirmataStream->write(REPORT_VERSION);
-  FirmataStream->write(major);
-  FirmataStream->write(minor);
+  write(REPORT_VERSION);
+  write(major);
+  write(minor);
+}
+
+/**
+ * Query the link counters of the target. The target answers with a LINK_STATS_REPLY message.
+ * @param flags LINK_STATS_RESET to clear the counters after reporting them.
+ */
+void FirmataMarshaller::sendLinkStatsQuery(uint8_t flags)
+const
+{
+  if ( (Stream *)NULL == FirmataStream ) { return; }
+  write(START_SYSEX);
+  write(LINK_STATS);
+  write(LINK_STATS_QUERY);
+  write(flags & 0x7F);
+  write(END_SYSEX);
+}
+
+/**
+ * Send link counters (the reply to a LINK_STATS_QUERY).
+ * @param countc The number of counters.
+ * @param countv The counters in the order LINK_STATS_BYTES_RECEIVED, LINK_STATS_MESSAGES_PARSED,
+ * LINK_STATS_BUFFER_OVERFLOWS, LINK_STATS_UNKNOWN_COMMANDS, LINK_STATS_BYTES_SENT and
+ * LINK_STATS_BYTES_DROPPED.
+ */
+void FirmataMarshaller::sendLinkStatsReply(size_t countc, const uint32_t * countv)
+const
+{
+  if ( (Stream *)NULL == FirmataStream ) { return; }
+  write(START_SYSEX);
+  write(LINK_STATS);
+  write(LINK_STATS_REPLY);
+  for (size_t i = 0 ; i < countc ; ++i) {
+    encodeUint32(countv[i]);
+  }
+  write(END_SYSEX);
 }
 
 /**
@@ -356,9 +666,9 @@ void FirmataMarshaller::sendPinMode(uint8_t pin, uint8_t config)
 const
 {
   if ( (Stream *)NULL == FirmataStream ) { return; }
-  FirmataStream->write(SET_PIN_MODE);
-  FirmataStream->write(pin);
-  FirmataStream->write(config);
+  write(SET_PIN_MODE);
+  write(pin);
+  write(config);
 }
 
 /**
@@ -372,10 +682,29 @@ void FirmataMarshaller::sendPinStateQuery(uint8_t pin)
 const
 {
   if ( (Stream *)NULL == FirmataStream ) { return; }
-  FirmataStream->write(START_SYSEX);
-  FirmataStream->write(PIN_STATE_QUERY);
-  FirmataStream->write(pin);
-  FirmataStream->write(END_SYSEX);
+  write(START_SYSEX);
+  write(PIN_STATE_QUERY);
+  write(pin);
+  write(END_SYSEX);
+}
+
+/**
+ * Send a sysex message whose data bytes are 7-bit already, for messages with fields that
+ * sendSysex() would split into two bytes each (e.g. I2C_REQUEST and SERIAL_DATA).
+ * @param command The sysex command byte.
+ * @param bytec The number of data bytes in the message (excludes start, command and end bytes).
+ * @param bytev A pointer to the array of data bytes; the high bit of each byte is cleared.
+ */
+void FirmataMarshaller::sendRawSysex(uint8_t command, size_t bytec, const uint8_t *bytev)
+const
+{
+  if ( (Stream *)NULL == FirmataStream ) { return; }
+  write(START_SYSEX);
+  write(command);
+  for (size_t i = 0; i < bytec; ++i) {
+    write(bytev[i] & 0x7F);
+  }
+  write(END_SYSEX);
 }
 
 /**
@@ -390,12 +719,33 @@ const
 {
   if ( (Stream *)NULL == FirmataStream ) { return; }
   size_t i;
-  FirmataStream->write(START_SYSEX);
-  FirmataStream->write(command);
+  write(START_SYSEX);
+  write(command);
   for (i = 0; i < bytec; ++i) {
     encodeByteStream(sizeof(bytev[i]), reinterpret_cast<uint8_t *>(&bytev[i]));
   }
-  FirmataStream->write(END_SYSEX);
+  write(END_SYSEX);
+}
+
+/**
+ * Send the absolute device time, which serves as the base for subsequent TIMESTAMP_DELTA messages.
+ * @param timestamp_us The device time in microseconds (such as the value of micros()).
+ */
+void FirmataMarshaller::sendTimestampBase(uint32_t timestamp_us)
+const
+{
+  sendTimestamp(TIMESTAMP_BASE, timestamp_us);
+}
+
+/**
+ * Send the time elapsed since the previous timestamp message. The delta applies to the reports
+ * that follow the message.
+ * @param delta_us The elapsed device time in microseconds.
+ */
+void FirmataMarshaller::sendTimestampDelta(uint32_t delta_us)
+const
+{
+  sendTimestamp(TIMESTAMP_DELTA, delta_us);
 }
 
 /**
@@ -427,5 +777,5 @@ void FirmataMarshaller::systemReset(void)
 const
 {
   if ( (Stream *)NULL == FirmataStream ) { return; }
-  FirmataStream->write(SYSTEM_RESET);
+  write(SYSTEM_RESET);
 }
@@ -38,6 +38,11 @@ class FirmataMarshaller
     void begin(Stream &s);
     void end();
 
+    /* link counters */
+    uint32_t getBytesSent(void) const;
+    uint32_t getBytesDropped(void) const;
+    void resetCounters(void);
+
     /* serial send handling */
     void queryFirmwareVersion(void) const;
     void queryVersion(void) const;
@@ -45,17 +50,31 @@ class FirmataMarshaller
     void reportAnalogEnable(uint8_t pin) const;
     void reportDigitalPortDisable(uint8_t portNumber) const;
     void reportDigitalPortEnable(uint8_t portNumber) const;
+    void reportTimestampsDisable(void) const;
+    void reportTimestampsEnable(void) const;
     void sendAnalog(uint8_t pin, uint16_t value) const;
     void sendAnalogMappingQuery(void) const;
     void sendCapabilityQuery(void) const;
+    void sendClockSyncReply(uint8_t sequence, uint32_t host_time_us, uint32_t receive_time_us, uint32_t transmit_time_us) const;
+    void sendClockSyncRequest(uint8_t sequence, uint32_t host_time_us) const;
     void sendDigital(uint8_t pin, uint8_t value) const;
     void sendDigitalPort(uint8_t portNumber, uint16_t portData) const;
+    void sendEchoReply(uint16_t sequence, uint32_t receive_time_us, uint32_t transmit_time_us, size_t bytec, const uint8_t *bytev) const;
+    void sendEchoRequest(uint16_t sequence, size_t bytec = 0, const uint8_t *bytev = NULL) const;
     void sendFirmwareVersion(uint8_t major, uint8_t minor, size_t bytec, uint8_t *bytev) const;
+    void sendLinkStatsQuery(uint8_t flags = 0) const;
+    void sendLinkStatsReply(size_t countc, const uint32_t * countv) const;
     void sendVersion(uint8_t major, uint8_t minor) const;
     void sendPinMode(uint8_t pin, uint8_t config) const;
     void sendPinStateQuery(uint8_t pin) const;
+    void sendRawSysex(uint8_t command, size_t bytec, const uint8_t *bytev) const;
     void sendString(const char *string) const;
     void sendSysex(uint8_t command, size_t bytec, uint8_t *bytev) const;
+    void sendTimestampBase(uint32_t timestamp_us) const;
+    void sendTimestampDelta(uint32_t delta_us) const;
+    void sendTraceEnd(uint32_t total, uint16_t capacity) const;
+    void sendTraceEvent(uint8_t id, uint32_t time_us, uint16_t arg) const;
+    void sendTraceQuery(uint8_t flags = 0) const;
     void setSamplingInterval(uint16_t interval_ms) const;
     void systemReset(void) const;
 
@@ -64,9 +83,17 @@ class FirmataMarshaller
     void reportAnalog(uint8_t pin, bool stream_enable) const;
     void reportDigitalPort(uint8_t portNumber, bool stream_enable) const;
     void sendExtendedAnalog(uint8_t pin, size_t bytec, uint8_t * bytev) const;
+    void sendTimestamp(uint8_t subcommand, uint32_t value) const;
     void encodeByteStream (size_t bytec, uint8_t * bytev, size_t max_bytes = 0) const;
+    void encodeVarint (uint32_t value) const;
+    void encodeUint32 (uint32_t value) const;
+    void write (uint8_t data) const;
 
     Stream * FirmataStream;
+
+    /* link counters, updated by the const send methods */
+    mutable uint32_t bytesSent;
+    mutable uint32_t bytesDropped;
 };
 
 } // namespace firmata
@@ -18,6 +18,7 @@
 #include "FirmataParser.h"
 
 #include "FirmataConstants.h"
+#include "FirmataTrace.h"
 
 using namespace firmata;
 
@@ -39,6 +40,11 @@ FirmataParser::FirmataParser(uint8_t * const dataBuffer, size_t dataBufferSize)
   waitForData(0),
   parsingSysex(false),
   sysexBytesRead(0),
+  deviceTimestamp(0),
+  bytesReceived(0),
+  messagesParsed(0),
+  bufferOverflows(0),
+  unknownCommands(0),
   currentAnalogCallbackContext((void *)NULL),
   currentDigitalCallbackContext((void *)NULL),
   currentReportAnalogCallbackContext((void *)NULL),
@@ -51,6 +57,11 @@ FirmataParser::FirmataParser(uint8_t * const dataBuffer, size_t dataBufferSize)
   currentStringCallbackContext((void *)NULL),
   currentSysexCallbackContext((void *)NULL),
   currentSystemResetCallbackContext((void *)NULL),
+  currentTimestampCallbackContext((void *)NULL),
+  currentClockSyncCallbackContext((void *)NULL),
+  currentEchoCallbackContext((void *)NULL),
+  currentLinkStatsCallbackContext((void *)NULL),
+  currentTraceCallbackContext((void *)NULL),
   currentAnalogCallback((callbackFunction)NULL),
   currentDigitalCallback((callbackFunction)NULL),
   currentReportAnalogCallback((callbackFunction)NULL),
@@ -62,7 +73,12 @@ FirmataParser::FirmataParser(uint8_t * const dataBuffer, size_t dataBufferSize)
   currentSysexCallback((sysexCallbackFunction)NULL),
   currentReportFirmwareCallback((versionCallbackFunction)NULL),
   currentReportVersionCallback((systemCallbackFunction)NULL),
-  currentSystemResetCallback((systemCallbackFunction)NULL)
+  currentSystemResetCallback((systemCallbackFunction)NULL),
+  currentTimestampCallback((timestampCallbackFunction)NULL),
+  currentClockSyncCallback((clockSyncCallbackFunction)NULL),
+  currentEchoCallback((echoCallbackFunction)NULL),
+  currentLinkStatsCallback((linkStatsCallbackFunction)NULL),
+  currentTraceCallback((traceCallbackFunction)NULL)
 {
     allowBufferUpdate = ((uint8_t *)NULL == dataBuffer);
 }
@@ -82,10 +98,12 @@ void FirmataParser::parse(uint8_t inputData)
 {
   uint8_t command;
 
+  ++bytesReceived;
   if (parsingSysex) {
     if (inputData == END_SYSEX) {
       //stop sysex byte
       parsingSysex = false;
+      ++messagesParsed;
       //fire off handler function
       processSysexMessage();
     } else {
@@ -97,6 +115,7 @@ void FirmataParser::parse(uint8_t inputData)
     --waitForData;
     bufferDataAtPosition(inputData, waitForData);
     if ( (waitForData == 0) && executeMultiByteCommand ) { // got the whole message
+      ++messagesParsed;
       switch (executeMultiByteCommand) {
         case ANALOG_MESSAGE:
           if (currentAnalogCallback) {
@@ -134,6 +153,7 @@ void FirmataParser::parse(uint8_t inputData)
       executeMultiByteCommand = 0;
     }
   } else {
+    FIRMATA_TRACE_EVENT(TRACE_PARSE_COMMAND, inputData);
     // remove channel info from command byte if less than 0xF0
     if (inputData < 0xF0) {
       command = inputData & 0xF0;
@@ -160,12 +180,18 @@ void FirmataParser::parse(uint8_t inputData)
         sysexBytesRead = 0;
         break;
       case SYSTEM_RESET:
+        ++messagesParsed;
         systemReset();
         break;
       case REPORT_VERSION:
+        ++messagesParsed;
         if (currentReportVersionCallback)
           (*currentReportVersionCallback)(currentReportVersionCallbackContext);
         break;
+      default:
+        // unsupported commands and data bytes outside of a message are ignored
+        ++unknownCommands;
+        break;
     }
   }
 }
@@ -204,6 +230,56 @@ int FirmataParser::setDataBufferOfSize(uint8_t * dataBuffer, size_t dataBufferSi
     return result;
 }
 
+//------------------------------------------------------------------------------
+// Link Counters
+
+/**
+ * @return The number of bytes passed to parse().
+ */
+uint32_t FirmataParser::getBytesReceived(void)
+const
+{
+  return bytesReceived;
+}
+
+/**
+ * @return The number of complete messages recognized, whether or not a callback was attached.
+ */
+uint32_t FirmataParser::getMessagesParsed(void)
+const
+{
+  return messagesParsed;
+}
+
+/**
+ * @return The number of data bytes dropped because they did not fit the data buffer.
+ */
+uint32_t FirmataParser::getBufferOverflows(void)
+const
+{
+  return bufferOverflows;
+}
+
+/**
+ * @return The number of bytes that neither started a known message nor belonged to one.
+ */
+uint32_t FirmataParser::getUnknownCommands(void)
+const
+{
+  return unknownCommands;
+}
+
+/**
+ * Clear the link counters. The counters are not affected by SYSTEM_RESET.
+ */
+void FirmataParser::resetCounters(void)
+{
+  bytesReceived = 0;
+  messagesParsed = 0;
+  bufferOverflows = 0;
+  unknownCommands = 0;
+}
+
 /**
  * Attach a generic sysex callback function to a command (options are: ANALOG_MESSAGE,
  * DIGITAL_MESSAGE, REPORT_ANALOG, REPORT DIGITAL, SET_PIN_MODE and SET_DIGITAL_PIN_VALUE).
@@ -261,6 +337,111 @@ void FirmataParser::attach(uint8_t command, versionCallbackFunction newFunction,
   }
 }
 
+/**
+ * Attach a timestamp callback function (supported option: TIMESTAMP_DATA).
+ * The callback receives the sub-command (TIMESTAMP_ENABLE, TIMESTAMP_DISABLE, TIMESTAMP_BASE
+ * or TIMESTAMP_DELTA). For TIMESTAMP_BASE and TIMESTAMP_DELTA the value is the device time in
+ * microseconds that applies to the reports following the message (deltas are accumulated by the
+ * parser); for the other sub-commands the value is 0.
+ * @param command The ID of the command to attach a callback function to.
+ * @param newFunction A reference to the callback function to attach.
+ * @param context An optional context to be provided to the callback function (NULL by default).
+ * @note While no timestamp callback is attached, TIMESTAMP_DATA messages are passed to the
+ *       generic sysex callback.
+ */
+void FirmataParser::attach(uint8_t command, timestampCallbackFunction newFunction, void * context)
+{
+  switch (command) {
+    case TIMESTAMP_DATA:
+      currentTimestampCallback = newFunction;
+      currentTimestampCallbackContext = context;
+      break;
+  }
+}
+
+/**
+ * Attach a clock sync callback function (supported option: CLOCK_SYNC).
+ * The callback receives the sub-command (CLOCK_SYNC_REQUEST or CLOCK_SYNC_REPLY), the sequence
+ * number and the times carried by the message. A request only carries the host time, so the
+ * receive and transmit times are 0.
+ * @param command The ID of the command to attach a callback function to.
+ * @param newFunction A reference to the callback function to attach.
+ * @param context An optional context to be provided to the callback function (NULL by default).
+ * @note While no clock sync callback is attached, CLOCK_SYNC messages are passed to the
+ *       generic sysex callback.
+ */
+void FirmataParser::attach(uint8_t command, clockSyncCallbackFunction newFunction, void * context)
+{
+  switch (command) {
+    case CLOCK_SYNC:
+      currentClockSyncCallback = newFunction;
+      currentClockSyncCallbackContext = context;
+      break;
+  }
+}
+
+/**
+ * Attach an echo callback function (supported option: ECHO_DATA).
+ * The callback receives the sub-command (ECHO_REQUEST or ECHO_REPLY), the 14-bit sequence number,
+ * the device receive and transmit times (0 for a request) and the 7-bit payload bytes.
+ * @param command The ID of the command to attach a callback function to.
+ * @param newFunction A reference to the callback function to attach.
+ * @param context An optional context to be provided to the callback function (NULL by default).
+ * @note While no echo callback is attached, ECHO_DATA messages are passed to the generic
+ *       sysex callback.
+ */
+void FirmataParser::attach(uint8_t command, echoCallbackFunction newFunction, void * context)
+{
+  switch (command) {
+    case ECHO_DATA:
+      currentEchoCallback = newFunction;
+      currentEchoCallbackContext = context;
+      break;
+  }
+}
+
+/**
+ * Attach a link statistics callback function (supported option: LINK_STATS).
+ * The callback receives the sub-command (LINK_STATS_QUERY or LINK_STATS_REPLY), the query flags
+ * and the decoded counters of a reply (see LINK_STATS_BYTES_RECEIVED and following).
+ * @param command The ID of the command to attach a callback function to.
+ * @param newFunction A reference to the callback function to attach.
+ * @param context An optional context to be provided to the callback function (NULL by default).
+ * @note While no link statistics callback is attached, LINK_STATS messages are passed to the
+ *       generic sysex callback.
+ */
+void FirmataParser::attach(uint8_t command, linkStatsCallbackFunction newFunction, void * context)
+{
+  switch (command) {
+    case LINK_STATS:
+      currentLinkStatsCallback = newFunction;
+      currentLinkStatsCallbackContext = context;
+      break;
+  }
+}
+
+/**
+ * Attach a trace callback function (supported option: TRACE_DATA).
+ * The callback is invoked once per message: for TRACE_DATA_QUERY the query flags are passed
+ * in arg, for TRACE_DATA_EVENT id, time and arg describe one event of the target's trace ring,
+ * and for TRACE_DATA_END time holds the number of events recorded since the last clear and arg
+ * the size of the ring.
+ * @param command The ID of the command to attach a callback function to.
+ * @param newFunction A reference to the callback function to attach.
+ * @param context An optional context to be provided to the callback function (NULL by default).
+ * @note While no trace callback is attached, TRACE_DATA messages are passed to the generic
+ *       sysex callback.
+ */
+void FirmataParser::attach(uint8_t command, traceCallbackFunction newFunction, void * context)
+{
+  switch (command) {
+    case TRACE_DATA:
+      currentTraceCallback = newFunction;
+      currentTraceCallbackContext = context;
+      break;
+  }
+}
+
 /**
  * Attach a system callback function (supported options are: SYSTEM_RESET, REPORT_VERSION).
  * @param command The ID of the command to attach a callback function to.
@@ -350,6 +531,21 @@ void FirmataParser::detach(uint8_t command)
     case START_SYSEX:
       attach(command, (sysexCallbackFunction)NULL, NULL);
       break;
+    case TIMESTAMP_DATA:
+      attach(command, (timestampCallbackFunction)NULL, NULL);
+      break;
+    case CLOCK_SYNC:
+      attach(command, (clockSyncCallbackFunction)NULL, NULL);
+      break;
+    case ECHO_DATA:
+      attach(command, (echoCallbackFunction)NULL, NULL);
+      break;
+    case LINK_STATS:
+      attach(command, (linkStatsCallbackFunction)NULL, NULL);
+      break;
+    case TRACE_DATA:
+      attach(command, (traceCallbackFunction)NULL, NULL);
+      break;
     default:
       attach(command, (callbackFunction)NULL, NULL);
       break;
@@ -395,6 +591,9 @@ bool FirmataParser::bufferDataAtPosition(const uint8_t data, const size_t pos)
   if ( !bufferOverflow )
   {
     dataBuffer[pos] = data;
+  } else {
+    ++bufferOverflows;
+    FIRMATA_TRACE_EVENT(TRACE_PARSE_OVERFLOW, pos);
   }
 
   return bufferOverflow;
@@ -420,12 +619,33 @@ size_t FirmataParser::decodeByteStream(size_t bytec, uint8_t * bytev) {
 }
 
 /**
- * Process incoming sysex messages. Handles REPORT_FIRMWARE and STRING_DATA internally.
- * Calls callback function for STRING_DATA and all other sysex messages.
+ * Transform a 7-bit varint into a 32-bit value. The value is transmitted least significant group
+ * first and its length is given by the end of the sysex message, so no continuation bits are used.
+ * @param bytec The number of encoded bytes (only the first 5 are significant).
+ * @param bytev A pointer to the encoded bytes.
+ * @return The decoded value.
+ * @private
+ */
+uint32_t FirmataParser::decodeVarint(size_t bytec, const uint8_t * bytev) const
+{
+  uint32_t value = 0;
+
+  if ( bytec > 5 ) { bytec = 5; }
+  for ( size_t i = 0 ; i < bytec ; ++i ) {
+    value |= (static_cast<uint32_t>(bytev[i] & 0x7F) << (7 * i));
+  }
+
+  return value;
+}
+
+/**
+ * Process incoming sysex messages. Handles REPORT_FIRMWARE, STRING_DATA, TIMESTAMP_DATA,
+ * CLOCK_SYNC, ECHO_DATA, LINK_STATS and TRACE_DATA internally. Calls callback function for STRING_DATA and all other sysex messages.
  * @private
  */
 void FirmataParser::processSysexMessage(void)
 {
+  FIRMATA_TRACE_EVENT(TRACE_SYSEX_BEGIN, dataBuffer[0]);
   switch (dataBuffer[0]) { //first byte in buffer is command
     case REPORT_FIRMWARE:
       if (currentReportFirmwareCallback) {
@@ -450,10 +670,223 @@ void FirmataParser::processSysexMessage(void)
         (*currentStringCallback)(currentStringCallbackContext, (const char *)&dataBuffer[string_offset]);
       }
       break;
+    case TIMESTAMP_DATA:
+      // without a timestamp callback the message is handled as a generic sysex message
+      if (currentTimestampCallback) {
+        processTimestampMessage();
+      } else if (currentSysexCallback) {
+        (*currentSysexCallback)(currentSysexCallbackContext, dataBuffer[0], sysexBytesRead - 1, dataBuffer + 1);
+      }
+      break;
+    case CLOCK_SYNC:
+      // without a clock sync callback the message is handled as a generic sysex message
+      if (currentClockSyncCallback) {
+        processClockSyncMessage();
+      } else if (currentSysexCallback) {
+        (*currentSysexCallback)(currentSysexCallbackContext, dataBuffer[0], sysexBytesRead - 1, dataBuffer + 1);
+      }
+      break;
+    case ECHO_DATA:
+      // without an echo callback the message is handled as a generic sysex message
+      if (currentEchoCallback) {
+        processEchoMessage();
+      } else if (currentSysexCallback) {
+        (*currentSysexCallback)(currentSysexCallbackContext, dataBuffer[0], sysexBytesRead - 1, dataBuffer + 1);
+      }
+      break;
+    case LINK_STATS:
+      // without a link statistics callback the message is handled as a generic sysex message
+      if (currentLinkStatsCallback) {
+        processLinkStatsMessage();
+      } else if (currentSysexCallback) {
+        (*currentSysexCallback)(currentSysexCallbackContext, dataBuffer[0], sysexBytesRead - 1, dataBuffer + 1);
+      }
+      break;
+    case TRACE_DATA:
+      // without a trace callback the message is handled as a generic sysex message
+      if (currentTraceCallback) {
+        processTraceMessage();
+      } else if (currentSysexCallback) {
+        (*currentSysexCallback)(currentSysexCallbackContext, dataBuffer[0], sysexBytesRead - 1, dataBuffer + 1);
+      }
+      break;
     default:
       if (currentSysexCallback)
         (*currentSysexCallback)(currentSysexCallbackContext, dataBuffer[0], sysexBytesRead - 1, dataBuffer + 1);
   }
+  FIRMATA_TRACE_EVENT(TRACE_SYSEX_END, dataBuffer[0]);
+}
+
+/**
+ * Process an incoming TIMESTAMP_DATA message. TIMESTAMP_BASE and TIMESTAMP_DELTA update the
+ * device time that applies to the reports that follow, before the timestamp callback is called.
+ * @private
+ */
+void FirmataParser::processTimestampMessage(void)
+{
+  const size_t subcommand_offset = 1;
+  const size_t value_offset = 2;
+  uint32_t value = 0;
+
+  // only the bytes that fit the data buffer were stored
+  const size_t bytes_stored = ((sysexBytesRead < dataBufferSize) ? sysexBytesRead : dataBufferSize);
+  if ( value_offset > bytes_stored ) { return; }
+  switch (dataBuffer[subcommand_offset]) {
+    case TIMESTAMP_BASE:
+      deviceTimestamp = decodeVarint((bytes_stored - value_offset), &dataBuffer[value_offset]);
+      value = deviceTimestamp;
+      break;
+    case TIMESTAMP_DELTA:
+      deviceTimestamp += decodeVarint((bytes_stored - value_offset), &dataBuffer[value_offset]);
+      value = deviceTimestamp;
+      break;
+  }
+  (*currentTimestampCallback)(currentTimestampCallbackContext, dataBuffer[subcommand_offset], value);
+}
+
+/**
+ * Process an incoming CLOCK_SYNC message. Each time is encoded as five 7-bit bytes (least
+ * significant group first). Messages too short for their sub-command are ignored.
+ * @private
+ */
+void FirmataParser::processClockSyncMessage(void)
+{
+  const size_t subcommand_offset = 1;
+  const size_t sequence_offset = 2;
+  const size_t times_offset = 3;
+  const size_t time_size = 5;
+  uint32_t times[3] = { 0, 0, 0 };
+  size_t time_count;
+
+  // only the bytes that fit the data buffer were stored
+  const size_t bytes_stored = ((sysexBytesRead < dataBufferSize) ? sysexBytesRead : dataBufferSize);
+  if ( times_offset > bytes_stored ) { return; }
+  switch (dataBuffer[subcommand_offset]) {
+    case CLOCK_SYNC_REQUEST:
+      time_count = 1;
+      break;
+    case CLOCK_SYNC_REPLY:
+      time_count = 3;
+      break;
+    default:
+      return;
+  }
+  if ( (times_offset + (time_count * time_size)) > bytes_stored ) { return; }
+
+  for ( size_t i = 0 ; i < time_count ; ++i ) {
+    times[i] = decodeVarint(time_size, &dataBuffer[times_offset + (i * time_size)]);
+  }
+  (*currentClockSyncCallback)(currentClockSyncCallbackContext, dataBuffer[subcommand_offset], dataBuffer[sequence_offset], times[0], times[1], times[2]);
+}
+
+/**
+ * Process an incoming ECHO_DATA message. A request carries a 14-bit sequence number followed by
+ * the payload; a reply also carries the device receive and transmit times (five 7-bit bytes
+ * each) between the sequence number and the payload.
+ * @private
+ */
+void FirmataParser::processEchoMessage(void)
+{
+  const size_t subcommand_offset = 1;
+  const size_t sequence_offset = 2;
+  const size_t times_offset = 4;
+  const size_t time_size = 5;
+  uint32_t receive_time = 0;
+  uint32_t transmit_time = 0;
+  size_t payload_offset;
+
+  // only the bytes that fit the data buffer were stored; a payload that did not fit is truncated
+  const size_t bytes_stored = ((sysexBytesRead < dataBufferSize) ? sysexBytesRead : dataBufferSize);
+  if ( times_offset > bytes_stored ) { return; }
+  switch (dataBuffer[subcommand_offset]) {
+    case ECHO_REQUEST:
+      payload_offset = times_offset;
+      break;
+    case ECHO_REPLY:
+      payload_offset = (times_offset + (2 * time_size));
+      if ( payload_offset > bytes_stored ) { return; }
+      receive_time = decodeVarint(time_size, &dataBuffer[times_offset]);
+      transmit_time = decodeVarint(time_size, &dataBuffer[times_offset + time_size]);
+      break;
+    default:
+      return;
+  }
+
+  const uint16_t sequence = (dataBuffer[sequence_offset] | (dataBuffer[sequence_offset + 1] << 7));
+  (*currentEchoCallback)(currentEchoCallbackContext, dataBuffer[subcommand_offset], sequence, receive_time, transmit_time, (bytes_stored - payload_offset), &dataBuffer[payload_offset]);
+}
+
+/**
+ * Process an incoming LINK_STATS message. A query carries optional flags, a reply carries the
+ * counters as five 7-bit bytes each. Counters beyond LINK_STATS_COUNTERS are ignored.
+ * @private
+ */
+void FirmataParser::processLinkStatsMessage(void)
+{
+  const size_t subcommand_offset = 1;
+  const size_t data_offset = 2;
+  const size_t counter_size = 5;
+  uint32_t counters[LINK_STATS_COUNTERS];
+  size_t count = 0;
+  uint8_t flags = 0;
+
+  // only the bytes that fit the data buffer were stored
+  const size_t bytes_stored = ((sysexBytesRead < dataBufferSize) ? sysexBytesRead : dataBufferSize);
+  if ( data_offset > bytes_stored ) { return; }
+  switch (dataBuffer[subcommand_offset]) {
+    case LINK_STATS_QUERY:
+      if ( data_offset < bytes_stored ) { flags = dataBuffer[data_offset]; }
+      break;
+    case LINK_STATS_REPLY:
+      count = ((bytes_stored - data_offset) / counter_size);
+      if ( count > (size_t)LINK_STATS_COUNTERS ) { count = LINK_STATS_COUNTERS; }
+      for ( size_t i = 0 ; i < count ; ++i ) {
+        counters[i] = decodeVarint(counter_size, &dataBuffer[data_offset + (i * counter_size)]);
+      }
+      break;
+    default:
+      return;
+  }
+  (*currentLinkStatsCallback)(currentLinkStatsCallbackContext, dataBuffer[subcommand_offset], flags, count, counters);
+}
+
+/**
+ * Process an incoming TRACE_DATA message. A query carries optional flags, an event carries the
+ * event id, the time (five 7-bit bytes) and the argument (three 7-bit bytes), and the end of a
+ * dump carries the number of recorded events (five 7-bit bytes) and the ring size (three 7-bit
+ * bytes).
+ * @private
+ */
+void FirmataParser::processTraceMessage(void)
+{
+  const size_t subcommand_offset = 1;
+  const size_t data_offset = 2;
+  uint8_t id = 0;
+  uint32_t time = 0;
+  uint16_t arg = 0;
+
+  // only the bytes that fit the data buffer were stored
+  const size_t bytes_stored = ((sysexBytesRead < dataBufferSize) ? sysexBytesRead : dataBufferSize);
+  if ( data_offset > bytes_stored ) { return; }
+  switch (dataBuffer[subcommand_offset]) {
+    case TRACE_DATA_QUERY:
+      if ( data_offset < bytes_stored ) { arg = dataBuffer[data_offset]; }
+      break;
+    case TRACE_DATA_EVENT:
+      if ( (data_offset + 9) > bytes_stored ) { return; }
+      id = dataBuffer[data_offset];
+      time = decodeVarint(5, &dataBuffer[data_offset + 1]);
+      arg = static_cast<uint16_t>(decodeVarint(3, &dataBuffer[data_offset + 6]));
+      break;
+    case TRACE_DATA_END:
+      if ( (data_offset + 8) > bytes_stored ) { return; }
+      time = decodeVarint(5, &dataBuffer[data_offset]);
+      arg = static_cast<uint16_t>(decodeVarint(3, &dataBuffer[data_offset + 5]));
+      break;
+    default:
+      return;
+  }
+  (*currentTraceCallback)(currentTraceCallbackContext, dataBuffer[subcommand_offset], id, time, arg);
 }
 
 /**
@@ -474,6 +907,7 @@ void FirmataParser::systemReset(void)
 
   parsingSysex = false;
   sysexBytesRead = 0;
+  deviceTimestamp = 0;
 
   if (currentSystemResetCallback)
     (*currentSystemResetCallback)(currentSystemResetCallbackContext);
@@ -33,6 +33,11 @@ class FirmataParser
     typedef void (*stringCallbackFunction)(void * context, const char * c_str);
     typedef void (*sysexCallbackFunction)(void * context, uint8_t command, size_t argc, uint8_t * argv);
     typedef void (*systemCallbackFunction)(void * context);
+    typedef void (*timestampCallbackFunction)(void * context, uint8_t command, uint32_t value);
+    typedef void (*clockSyncCallbackFunction)(void * context, uint8_t command, uint8_t sequence, uint32_t host_time, uint32_t receive_time, uint32_t transmit_time);
+    typedef void (*linkStatsCallbackFunction)(void * context, uint8_t command, uint8_t flags, size_t countc, const uint32_t * countv);
+    typedef void (*traceCallbackFunction)(void * context, uint8_t command, uint8_t id, uint32_t time, uint16_t arg);
+    typedef void (*echoCallbackFunction)(void * context, uint8_t command, uint16_t sequence, uint32_t receive_time, uint32_t transmit_time, size_t payloadc, uint8_t * payloadv);
     typedef void (*versionCallbackFunction)(void * context, size_t sv_major, size_t sv_minor, const char * firmware);
 
     FirmataParser(uint8_t * dataBuffer = (uint8_t *)NULL, size_t dataBufferSize = 0);
@@ -42,6 +47,13 @@ class FirmataParser
     bool isParsingMessage(void) const;
     int setDataBufferOfSize(uint8_t * dataBuffer, size_t dataBufferSize);
 
+    /* link counters */
+    uint32_t getBytesReceived(void) const;
+    uint32_t getMessagesParsed(void) const;
+    uint32_t getBufferOverflows(void) const;
+    uint32_t getUnknownCommands(void) const;
+    void resetCounters(void);
+
     /* attach & detach callback functions to messages */
     void attach(uint8_t command, callbackFunction newFunction, void * context = NULL);
     void attach(dataBufferOverflowCallbackFunction newFunction, void * context = NULL);
@@ -49,6 +61,11 @@ class FirmataParser
     void attach(uint8_t command, sysexCallbackFunction newFunction, void * context = NULL);
     void attach(uint8_t command, systemCallbackFunction newFunction, void * context = NULL);
     void attach(uint8_t command, versionCallbackFunction newFunction, void * context = NULL);
+    void attach(uint8_t command, timestampCallbackFunction newFunction, void * context = NULL);
+    void attach(uint8_t command, clockSyncCallbackFunction newFunction, void * context = NULL);
+    void attach(uint8_t command, echoCallbackFunction newFunction, void * context = NULL);
+    void attach(uint8_t command, linkStatsCallbackFunction newFunction, void * context = NULL);
+    void attach(uint8_t command, traceCallbackFunction newFunction, void * context = NULL);
     void detach(uint8_t command);
     void detach(dataBufferOverflowCallbackFunction);
 
@@ -65,6 +82,15 @@ class FirmataParser
     bool parsingSysex;
     size_t sysexBytesRead;
 
+    /* device time of the most recent timestamp message */
+    uint32_t deviceTimestamp;
+
+    /* link counters (not cleared by SYSTEM_RESET) */
+    uint32_t bytesReceived;
+    uint32_t messagesParsed;
+    uint32_t bufferOverflows;
+    uint32_t unknownCommands;
+
     /* callback context */
     void * currentAnalogCallbackContext;
     void * currentDigitalCallbackContext;
@@ -78,6 +104,11 @@ class FirmataParser
     void * currentStringCallbackContext;
     void * currentSysexCallbackContext;
     void * currentSystemResetCallbackContext;
+    void * currentTimestampCallbackContext;
+    void * currentClockSyncCallbackContext;
+    void * currentEchoCallbackContext;
+    void * currentLinkStatsCallbackContext;
+    void * currentTraceCallbackContext;
 
     /* callback functions */
     callbackFunction currentAnalogCallback;
@@ -92,11 +123,22 @@ class FirmataParser
     versionCallbackFunction currentReportFirmwareCallback;
     systemCallbackFunction currentReportVersionCallback;
     systemCallbackFunction currentSystemResetCallback;
+    timestampCallbackFunction currentTimestampCallback;
+    clockSyncCallbackFunction currentClockSyncCallback;
+    echoCallbackFunction currentEchoCallback;
+    linkStatsCallbackFunction currentLinkStatsCallback;
+    traceCallbackFunction currentTraceCallback;
 
     /* private methods ------------------------------ */
     bool bufferDataAtPosition(const uint8_t data, const size_t pos);
     size_t decodeByteStream(size_t bytec, uint8_t * bytev);
+    uint32_t decodeVarint(size_t bytec, const uint8_t * bytev) const;
     void processSysexMessage(void);
+    void processTimestampMessage(void);
+    void processClockSyncMessage(void);
+    void processEchoMessage(void);
+    void processLinkStatsMessage(void);
+    void processTraceMessage(void);
     void systemReset(void);
 };
 
@@ -0,0 +1,137 @@
+/*
+  FirmataTrace.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "FirmataTrace.h"
+
+#ifdef FIRMATA_TRACE
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+using namespace firmata;
+
+//******************************************************************************
+//* Static Members
+//******************************************************************************
+
+trace_event FirmataTrace::events[FIRMATA_TRACE_SIZE];
+size_t FirmataTrace::next = 0;
+uint32_t FirmataTrace::recorded = 0;
+bool FirmataTrace::enabled = true;
+
+//******************************************************************************
+//* Support Functions
+//******************************************************************************
+
+namespace {
+
+inline uint32_t traceMicros(void)
+{
+#if defined(ARDUINO)
+  return micros();
+#else
+  return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+} // namespace
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+/**
+ * Record an event, overwriting the oldest one when the ring is full.
+ * @param id The event id (TRACE_PARSE_COMMAND, ..., or TRACE_USER and above).
+ * @param arg The event argument.
+ */
+void FirmataTrace::record(uint8_t id, uint16_t arg)
+{
+  if ( !enabled ) { return; }
+  trace_event & e = events[next];
+  e.time = traceMicros();
+  e.arg = arg;
+  e.id = id;
+  next = ((next + 1) % FIRMATA_TRACE_SIZE);
+  ++recorded;
+}
+
+/**
+ * Discard all events.
+ */
+void FirmataTrace::clear(void)
+{
+  next = 0;
+  recorded = 0;
+}
+
+/**
+ * Suspend or resume recording, e.g. while the ring is being sent so the dump does not
+ * overwrite the events it reports.
+ * @param enable false to ignore new events.
+ */
+void FirmataTrace::setEnabled(bool enable)
+{
+  enabled = enable;
+}
+
+/**
+ * @return The number of events in the ring.
+ */
+size_t FirmataTrace::count(void)
+{
+  return ((recorded < FIRMATA_TRACE_SIZE) ? recorded : FIRMATA_TRACE_SIZE);
+}
+
+/**
+ * @return The number of events recorded since the last clear, including overwritten ones.
+ */
+uint32_t FirmataTrace::total(void)
+{
+  return recorded;
+}
+
+/**
+ * @param index The index of the event, 0 is the oldest event in the ring.
+ * @return The event.
+ */
+const trace_event & FirmataTrace::event(size_t index)
+{
+  const size_t oldest = ((recorded < FIRMATA_TRACE_SIZE) ? 0 : next);
+  return events[(oldest + index) % FIRMATA_TRACE_SIZE];
+}
+
+#if !defined(ARDUINO)
+/**
+ * Write the events, oldest first, as "time_us,id,arg" lines.
+ * @param file The file to write to.
+ * @return false if writing failed.
+ */
+bool FirmataTrace::dump(std::FILE * file)
+{
+  size_t i;
+  for (i = 0; i < count(); ++i) {
+    const trace_event & e = event(i);
+    if ( std::fprintf(file, "%lu,%u,%u\n", static_cast<unsigned long>(e.time), static_cast<unsigned>(e.id), static_cast<unsigned>(e.arg)) < 0 ) { return false; }
+  }
+  return (0 == std::fflush(file));
+}
+#endif
+
+#endif /* FIRMATA_TRACE */
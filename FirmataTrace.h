@@ -0,0 +1,99 @@
+/*
+  FirmataTrace.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Event trace ring buffer. When FIRMATA_TRACE is defined, trace points in
+  the parser, the marshaller and the features record small events (id,
+  micros() timestamp, 16-bit argument) into a fixed size ring in RAM. The
+  newest FIRMATA_TRACE_SIZE events can be read back over sysex (TRACE_DATA)
+  or, in host builds, written to a file. Without FIRMATA_TRACE the trace
+  points compile to nothing.
+*/
+
+#ifndef FirmataTrace_h
+#define FirmataTrace_h
+
+// Uncomment the following line to compile the trace points in. Host builds can
+// also define FIRMATA_TRACE on the compiler command line.
+//#define FIRMATA_TRACE
+
+// trace event ids (0x10 - 0x7F are free for sketches and features)
+#define TRACE_PARSE_COMMAND     0x01 // arg: command byte received by the parser
+#define TRACE_PARSE_OVERFLOW    0x02 // arg: buffer position of a data byte that did not fit
+#define TRACE_SYSEX_BEGIN       0x03 // arg: sysex command about to be dispatched
+#define TRACE_SYSEX_END         0x04 // arg: sysex command whose handler returned
+#define TRACE_SEND              0x05 // arg: command byte written by the marshaller
+#define TRACE_SEND_DROPPED      0x06 // arg: byte the stream failed to write
+#define TRACE_FEATURE_BEGIN     0x07 // arg: sysex command of a feature starting work in update()
+#define TRACE_FEATURE_END       0x08 // arg: sysex command of a feature ending work in update()
+#define TRACE_USER              0x10
+
+#ifdef FIRMATA_TRACE
+
+#include <stddef.h>
+#include <stdint.h>
+#if !defined(ARDUINO)
+#include <cstdio>
+#endif
+
+// Number of events held in RAM, each event takes 8 bytes
+#ifndef FIRMATA_TRACE_SIZE
+#if defined(__AVR__)
+#define FIRMATA_TRACE_SIZE      32
+#else
+#define FIRMATA_TRACE_SIZE      1024
+#endif
+#endif
+
+#define FIRMATA_TRACE_EVENT(id, arg)  firmata::FirmataTrace::record((id), (arg))
+
+namespace firmata {
+
+struct trace_event {
+  uint32_t time;  // [us]
+  uint16_t arg;
+  uint8_t id;
+};
+
+/**
+ * The trace ring. All members are static, so trace points anywhere in the library or the
+ * sketch record into the same ring without a reference to it.
+ */
+class FirmataTrace
+{
+  public:
+    static void record(uint8_t id, uint16_t arg);
+    static void clear(void);
+    static void setEnabled(bool enabled);
+
+    static size_t count(void);
+    static uint32_t total(void);
+    static const trace_event & event(size_t index);
+
+#if !defined(ARDUINO)
+    static bool dump(std::FILE * file);
+#endif
+
+  private:
+    static trace_event events[FIRMATA_TRACE_SIZE];
+    static size_t next;
+    static uint32_t recorded;
+    static bool enabled;
+};
+
+} // namespace firmata
+
+#else /* FIRMATA_TRACE */
+
+#define FIRMATA_TRACE_EVENT(id, arg)
+
+#endif /* FIRMATA_TRACE */
+
+#endif /* FirmataTrace_h */
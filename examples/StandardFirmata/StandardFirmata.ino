@@ -27,6 +27,26 @@
 #include <Wire.h>
 #include <Firmata.h>
 
+/*
+ * Uncomment the following include to enable capturing the activity of digital
+ * ports as run-length encoded records (a simple on-board logic analyzer).
+ */
+//#include "utility/LogicCaptureFirmata.h"
+
+/*
+ * Uncomment the following include to report the stack high-water mark and the free RAM with a
+ * MEMORY_STATS sysex message.
+ */
+//#include "utility/MemoryStatsFirmata.h"
+
+/*
+ * Uncomment the following include to measure how long each stage of loop() takes. The host
+ * can query the results with a LOOP_TIMING sysex message. Without it the timing markers in
+ * loop() compile to nothing.
+ */
+//#include "utility/LoopTimingFirmata.h"
+#include "utility/firmataLoopTiming.h"
+
 #define I2C_WRITE                   B00000000
 #define I2C_READ                    B00001000
 #define I2C_READ_CONTINUOUSLY       B00010000
@@ -51,6 +71,19 @@
 SerialFirmata serialFeature;
 #endif
 
+#ifdef FIRMATA_LOGIC_CAPTURE_FEATURE
+LogicCaptureFirmata logicCaptureFeature;
+#endif
+
+#ifdef FIRMATA_LOOP_TIMING_FEATURE
+LoopTimingFirmata loopTimingFeature;
+#endif
+
+#ifdef FIRMATA_MEMORY_STATS_FEATURE
+// constructed before setup() so it can paint the unused RAM while the stack is shallow
+MemoryStatsFirmata memoryStatsFeature;
+#endif
+
 /* analog inputs */
 int analogInputsToReport = 0; // bitwise array to store pin reporting
 
@@ -692,6 +725,24 @@ void sysexCallback(byte command, byte argc, byte *argv)
     case SERIAL_MESSAGE:
 #ifdef FIRMATA_SERIAL_FEATURE
       serialFeature.handleSysex(command, argc, argv);
+#endif
+      break;
+
+    case LOGIC_CAPTURE:
+#ifdef FIRMATA_LOGIC_CAPTURE_FEATURE
+      logicCaptureFeature.handleSysex(command, argc, argv);
+#endif
+      break;
+
+    case LOOP_TIMING:
+#ifdef FIRMATA_LOOP_TIMING_FEATURE
+      loopTimingFeature.handleSysex(command, argc, argv);
+#endif
+      break;
+
+    case MEMORY_STATS:
+#ifdef FIRMATA_MEMORY_STATS_FEATURE
+      memoryStatsFeature.handleSysex(command, argc, argv);
 #endif
       break;
   }
@@ -712,6 +763,14 @@ void systemResetCallback()
   serialFeature.reset();
 #endif
 
+#ifdef FIRMATA_LOGIC_CAPTURE_FEATURE
+  logicCaptureFeature.reset();
+#endif
+
+#ifdef FIRMATA_LOOP_TIMING_FEATURE
+  loopTimingFeature.reset();
+#endif
+
   if (isI2CEnabled) {
     disableI2CPins();
   }
@@ -766,6 +825,12 @@ void setup()
   Firmata.attach(START_SYSEX, sysexCallback);
   Firmata.attach(SYSTEM_RESET, systemResetCallback);
 
+  // answer the diagnostics requests of host tools (sysex commands from the user-defined range)
+  Firmata.enableTimestamps();
+  Firmata.enableClockSync();
+  Firmata.enableEcho();
+  Firmata.enableLinkStats();
+
   // to use a port other than Serial, such as Serial1 on an Arduino Leonardo or Mega,
   // Call begin(baud) on the alternate serial port and pass it to Firmata to begin like this:
   // Serial1.begin(57600);
@@ -787,14 +852,18 @@ void loop()
 {
   byte pin, analogPin;
 
+  LOOP_TIMING_START();
+
   /* DIGITALREAD - as fast as possible, check for changes and output them to the
    * FTDI buffer using Serial.print()  */
   checkDigitalInputs();
+  LOOP_TIMING_STAGE(LOOP_TIMING_DIGITAL_INPUTS);
 
   /* STREAMREAD - processing incoming messagse as soon as possible, while still
    * checking digital inputs.  */
   while (Firmata.available())
     Firmata.processInput();
+  LOOP_TIMING_STAGE(LOOP_TIMING_PROCESS_INPUT);
 
   // TODO - ensure that Stream buffer doesn't go over 60 bytes
 
@@ -810,15 +879,22 @@ void loop()
         }
       }
     }
+    LOOP_TIMING_STAGE(LOOP_TIMING_ANALOG);
     // report i2c data for all device with read continuous mode enabled
     if (queryIndex > -1) {
       for (byte i = 0; i < queryIndex + 1; i++) {
         readAndReportData(query[i].addr, query[i].reg, query[i].bytes, query[i].stopTX);
       }
     }
+    LOOP_TIMING_STAGE(LOOP_TIMING_I2C);
   }
 
 #ifdef FIRMATA_SERIAL_FEATURE
   serialFeature.update();
 #endif
+
+#ifdef FIRMATA_LOGIC_CAPTURE_FEATURE
+  logicCaptureFeature.update();
+#endif
+  LOOP_TIMING_STAGE(LOOP_TIMING_FEATURES);
 }
@@ -38,6 +38,20 @@
 // Arduino IDE v1.6.6 or higher. Hardware serial should work back to Arduino 1.0.
 //#include "utility/SerialFirmata.h"
 
+/*
+ * Uncomment the following include to report the stack high-water mark and the free RAM with a
+ * MEMORY_STATS sysex message.
+ */
+//#include "utility/MemoryStatsFirmata.h"
+
+/*
+ * Uncomment the following include to measure how long each stage of loop() takes. The host
+ * can query the results with a LOOP_TIMING sysex message. Without it the timing markers in
+ * loop() compile to nothing.
+ */
+//#include "utility/LoopTimingFirmata.h"
+#include "utility/firmataLoopTiming.h"
+
 // follow the instructions in bleConfig.h to configure your BLE hardware
 #include "bleConfig.h"
 
@@ -64,6 +78,15 @@
 SerialFirmata serialFeature;
 #endif
 
+#ifdef FIRMATA_LOOP_TIMING_FEATURE
+LoopTimingFirmata loopTimingFeature;
+#endif
+
+#ifdef FIRMATA_MEMORY_STATS_FEATURE
+// constructed before setup() so it can paint the unused RAM while the stack is shallow
+MemoryStatsFirmata memoryStatsFeature;
+#endif
+
 /* analog inputs */
 int analogInputsToReport = 0; // bitwise array to store pin reporting
 
@@ -705,6 +728,18 @@ void sysexCallback(byte command, byte argc, byte *argv)
     case SERIAL_MESSAGE:
 #ifdef FIRMATA_SERIAL_FEATURE
       serialFeature.handleSysex(command, argc, argv);
+#endif
+      break;
+
+    case LOOP_TIMING:
+#ifdef FIRMATA_LOOP_TIMING_FEATURE
+      loopTimingFeature.handleSysex(command, argc, argv);
+#endif
+      break;
+
+    case MEMORY_STATS:
+#ifdef FIRMATA_MEMORY_STATS_FEATURE
+      memoryStatsFeature.handleSysex(command, argc, argv);
 #endif
       break;
   }
@@ -722,6 +757,10 @@ void systemResetCallback()
   serialFeature.reset();
 #endif
 
+#ifdef FIRMATA_LOOP_TIMING_FEATURE
+  loopTimingFeature.reset();
+#endif
+
   if (isI2CEnabled) {
     disableI2CPins();
   }
@@ -754,6 +793,27 @@ void systemResetCallback()
   isResetting = false;
 }
 
+/*
+ * Print how the RAM is used. Called at the end of setup().
+ */
+void printMemoryStats()
+{
+#ifdef FIRMATA_MEMORY_STATS_FEATURE
+  if (memoryStatsFeature.isPainted()) {
+    DEBUG_PRINT( "Stack high-water mark: " );
+    DEBUG_PRINTLN( memoryStatsFeature.stackHighWater() );
+    DEBUG_PRINT( "Never used RAM: " );
+    DEBUG_PRINTLN( memoryStatsFeature.stackHeadroom() );
+  }
+  DEBUG_PRINT( "Free RAM: " );
+  DEBUG_PRINTLN( memoryStatsFeature.freeMemory() );
+  DEBUG_PRINT( "Free heap blocks: " );
+  DEBUG_PRINTLN( memoryStatsFeature.freeHeap() );
+  DEBUG_PRINT( "Heap fragmentation [%]: " );
+  DEBUG_PRINTLN( memoryStatsFeature.fragmentation() );
+#endif
+}
+
 void setup()
 {
   DEBUG_BEGIN(9600);
@@ -769,6 +829,12 @@ void setup()
   Firmata.attach(START_SYSEX, sysexCallback);
   Firmata.attach(SYSTEM_RESET, systemResetCallback);
 
+  // answer the diagnostics requests of host tools (sysex commands from the user-defined range)
+  Firmata.enableTimestamps();
+  Firmata.enableClockSync();
+  Firmata.enableEcho();
+  Firmata.enableLinkStats();
+
   stream.setLocalName(FIRMATA_BLE_LOCAL_NAME);
 
 #ifdef FIRMATA_BLE_ADVERTISING_INTERVAL
@@ -792,6 +858,8 @@ void setup()
   Firmata.begin(stream);
 
   systemResetCallback();  // reset to default config
+
+  printMemoryStats();
 }
 
 /*==============================================================================
@@ -801,18 +869,23 @@ void loop()
 {
   byte pin, analogPin;
 
+  LOOP_TIMING_START();
+
   // do not process data if no BLE connection is established
   // poll will send the TX buffer at the specified flush interval or when the buffer is full
   if (!stream.poll()) return;
+  LOOP_TIMING_STAGE(LOOP_TIMING_NETWORK);
 
   /* DIGITALREAD - as fast as possible, check for changes and output them to the
    * Stream buffer using Stream.write()  */
   checkDigitalInputs();
+  LOOP_TIMING_STAGE(LOOP_TIMING_DIGITAL_INPUTS);
 
   /* STREAMREAD - processing incoming messagse as soon as possible, while still
    * checking digital inputs.  */
   while (Firmata.available())
     Firmata.processInput();
+  LOOP_TIMING_STAGE(LOOP_TIMING_PROCESS_INPUT);
 
   currentMillis = millis();
   if (currentMillis - previousMillis > samplingInterval) {
@@ -826,15 +899,18 @@ void loop()
         }
       }
     }
+    LOOP_TIMING_STAGE(LOOP_TIMING_ANALOG);
     // report i2c data for all device with read continuous mode enabled
     if (queryIndex > -1) {
       for (byte i = 0; i < queryIndex + 1; i++) {
         readAndReportData(query[i].addr, query[i].reg, query[i].bytes, query[i].stopTX);
       }
     }
+    LOOP_TIMING_STAGE(LOOP_TIMING_I2C);
   }
 
 #ifdef FIRMATA_SERIAL_FEATURE
   serialFeature.update();
 #endif
+  LOOP_TIMING_STAGE(LOOP_TIMING_FEATURES);
 }
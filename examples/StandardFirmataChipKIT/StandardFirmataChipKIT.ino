@@ -28,6 +28,14 @@
 #include <Wire.h>
 #include <Firmata.h>
 
+/*
+ * Uncomment the following include to measure how long each stage of loop() takes. The host
+ * can query the results with a LOOP_TIMING sysex message. Without it the timing markers in
+ * loop() compile to nothing.
+ */
+//#include "utility/LoopTimingFirmata.h"
+#include "utility/firmataLoopTiming.h"
+
 #define I2C_WRITE                   B00000000
 #define I2C_READ                    B00001000
 #define I2C_READ_CONTINUOUSLY       B00010000
@@ -48,6 +56,10 @@
  * GLOBAL VARIABLES
  *============================================================================*/
 
+#ifdef FIRMATA_LOOP_TIMING_FEATURE
+LoopTimingFirmata loopTimingFeature;
+#endif
+
 /* analog inputs */
 int analogInputsToReport = 0; // bitwise array to store pin reporting
 
@@ -687,6 +699,12 @@ void sysexCallback(byte command, byte argc, byte *argv)
       }
       Firmata.write(END_SYSEX);
       break;
+
+    case LOOP_TIMING:
+#ifdef FIRMATA_LOOP_TIMING_FEATURE
+      loopTimingFeature.handleSysex(command, argc, argv);
+#endif
+      break;
   }
 }
 
@@ -699,6 +717,11 @@ void systemResetCallback()
   isResetting = true;
   // initialize a defalt state
   // TODO: option to load config from EEPROM instead of default
+
+#ifdef FIRMATA_LOOP_TIMING_FEATURE
+  loopTimingFeature.reset();
+#endif
+
   if (isI2CEnabled) {
     disableI2CPins();
   }
@@ -753,6 +776,12 @@ void setup()
   Firmata.attach(START_SYSEX, sysexCallback);
   Firmata.attach(SYSTEM_RESET, systemResetCallback);
 
+  // answer the diagnostics requests of host tools (sysex commands from the user-defined range)
+  Firmata.enableTimestamps();
+  Firmata.enableClockSync();
+  Firmata.enableEcho();
+  Firmata.enableLinkStats();
+
   /* For chipKIT Pi board, we need to use Serial1. All others just use Serial. */
 #if defined(_BOARD_CHIPKIT_PI_)
   Serial1.begin(57600);
@@ -770,14 +799,18 @@ void loop()
 {
   byte pin, analogPin;
 
+  LOOP_TIMING_START();
+
   /* DIGITALREAD - as fast as possible, check for changes and output them to the
    * FTDI buffer using Serial.print()  */
   checkDigitalInputs();
+  LOOP_TIMING_STAGE(LOOP_TIMING_DIGITAL_INPUTS);
 
   /* STREAMREAD - processing incoming messagse as soon as possible, while still
    * checking digital inputs.  */
   while (Firmata.available())
     Firmata.processInput();
+  LOOP_TIMING_STAGE(LOOP_TIMING_PROCESS_INPUT);
 
   // TODO - ensure that Stream buffer doesn't go over 60 bytes
 
@@ -793,11 +826,13 @@ void loop()
         }
       }
     }
+    LOOP_TIMING_STAGE(LOOP_TIMING_ANALOG);
     // report i2c data for all device with read continuous mode enabled
     if (queryIndex > -1) {
       for (byte i = 0; i < queryIndex + 1; i++) {
         readAndReportData(query[i].addr, query[i].reg, query[i].bytes, query[i].stopTX);
       }
     }
+    LOOP_TIMING_STAGE(LOOP_TIMING_I2C);
   }
 }
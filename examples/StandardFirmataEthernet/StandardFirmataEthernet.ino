@@ -83,6 +83,20 @@
 // Arduino IDE v1.6.6 or higher. Hardware serial should work back to Arduino 1.0.
 //#include "utility/SerialFirmata.h"
 
+/*
+ * Uncomment the following include to report the stack high-water mark and the free RAM with a
+ * MEMORY_STATS sysex message.
+ */
+//#include "utility/MemoryStatsFirmata.h"
+
+/*
+ * Uncomment the following include to measure how long each stage of loop() takes. The host
+ * can query the results with a LOOP_TIMING sysex message. Without it the timing markers in
+ * loop() compile to nothing.
+ */
+//#include "utility/LoopTimingFirmata.h"
+#include "utility/firmataLoopTiming.h"
+
 #define I2C_WRITE                   B00000000
 #define I2C_READ                    B00001000
 #define I2C_READ_CONTINUOUSLY       B00010000
@@ -130,6 +144,15 @@ EthernetServerStream stream(IPAddress(0, 0, 0, 0), network_port);
 SerialFirmata serialFeature;
 #endif
 
+#ifdef FIRMATA_LOOP_TIMING_FEATURE
+LoopTimingFirmata loopTimingFeature;
+#endif
+
+#ifdef FIRMATA_MEMORY_STATS_FEATURE
+// constructed before setup() so it can paint the unused RAM while the stack is shallow
+MemoryStatsFirmata memoryStatsFeature;
+#endif
+
 /* analog inputs */
 int analogInputsToReport = 0;      // bitwise array to store pin reporting
 
@@ -772,6 +795,18 @@ void sysexCallback(byte command, byte argc, byte *argv)
     case SERIAL_MESSAGE:
 #ifdef FIRMATA_SERIAL_FEATURE
       serialFeature.handleSysex(command, argc, argv);
+#endif
+      break;
+
+    case LOOP_TIMING:
+#ifdef FIRMATA_LOOP_TIMING_FEATURE
+      loopTimingFeature.handleSysex(command, argc, argv);
+#endif
+      break;
+
+    case MEMORY_STATS:
+#ifdef FIRMATA_MEMORY_STATS_FEATURE
+      memoryStatsFeature.handleSysex(command, argc, argv);
 #endif
       break;
   }
@@ -792,6 +827,10 @@ void systemResetCallback()
   serialFeature.reset();
 #endif
 
+#ifdef FIRMATA_LOOP_TIMING_FEATURE
+  loopTimingFeature.reset();
+#endif
+
   if (isI2CEnabled) {
     disableI2CPins();
   }
@@ -833,6 +872,28 @@ void systemResetCallback()
   isResetting = false;
 }
 
+/*
+ * Print how the RAM is used. Called after setup and at the end of each host connection, when
+ * the stack high-water mark includes the message handling.
+ */
+void printMemoryStats()
+{
+#ifdef FIRMATA_MEMORY_STATS_FEATURE
+  if (memoryStatsFeature.isPainted()) {
+    DEBUG_PRINT( "Stack high-water mark: " );
+    DEBUG_PRINTLN( memoryStatsFeature.stackHighWater() );
+    DEBUG_PRINT( "Never used RAM: " );
+    DEBUG_PRINTLN( memoryStatsFeature.stackHeadroom() );
+  }
+  DEBUG_PRINT( "Free RAM: " );
+  DEBUG_PRINTLN( memoryStatsFeature.freeMemory() );
+  DEBUG_PRINT( "Free heap blocks: " );
+  DEBUG_PRINTLN( memoryStatsFeature.freeHeap() );
+  DEBUG_PRINT( "Heap fragmentation [%]: " );
+  DEBUG_PRINTLN( memoryStatsFeature.fragmentation() );
+#endif
+}
+
 #ifdef ETHERNETCLIENTSTREAM_H
 /*
  * Called when a TCP connection is either connected or disconnected.
@@ -848,6 +909,7 @@ void hostConnectionCallback(byte state)
       break;
     case HOST_CONNECTION_DISCONNECTED:
       DEBUG_PRINTLN( "TCP connection disconnected" );
+      printMemoryStats();
       break;
   }
 }
@@ -926,6 +988,12 @@ void initFirmata()
   Firmata.attach(START_SYSEX, sysexCallback);
   Firmata.attach(SYSTEM_RESET, systemResetCallback);
 
+  // answer the diagnostics requests of host tools (sysex commands from the user-defined range)
+  Firmata.enableTimestamps();
+  Firmata.enableClockSync();
+  Firmata.enableEcho();
+  Firmata.enableLinkStats();
+
   ignorePins();
 
   // start up Network Firmata:
@@ -940,6 +1008,8 @@ void setup()
   initTransport();
 
   initFirmata();
+
+  printMemoryStats();
 }
 
 /*==============================================================================
@@ -949,14 +1019,18 @@ void loop()
 {
   byte pin, analogPin;
 
+  LOOP_TIMING_START();
+
   /* DIGITALREAD - as fast as possible, check for changes and output them to the
    * Stream buffer using Stream.write()  */
   checkDigitalInputs();
+  LOOP_TIMING_STAGE(LOOP_TIMING_DIGITAL_INPUTS);
 
   /* STREAMREAD - processing incoming messagse as soon as possible, while still
    * checking digital inputs.  */
   while (Firmata.available())
     Firmata.processInput();
+  LOOP_TIMING_STAGE(LOOP_TIMING_PROCESS_INPUT);
 
   // TODO - ensure that Stream buffer doesn't go over 60 bytes
 
@@ -972,17 +1046,20 @@ void loop()
         }
       }
     }
+    LOOP_TIMING_STAGE(LOOP_TIMING_ANALOG);
     // report i2c data for all device with read continuous mode enabled
     if (queryIndex > -1) {
       for (byte i = 0; i < queryIndex + 1; i++) {
         readAndReportData(query[i].addr, query[i].reg, query[i].bytes, query[i].stopTX);
       }
     }
+    LOOP_TIMING_STAGE(LOOP_TIMING_I2C);
   }
 
 #ifdef FIRMATA_SERIAL_FEATURE
   serialFeature.update();
 #endif
+  LOOP_TIMING_STAGE(LOOP_TIMING_FEATURES);
 
 #if !defined local_ip && !defined YUN_ETHERNET
   // only necessary when using DHCP, ensures local IP is updated appropriately if it changes
@@ -990,5 +1067,6 @@ void loop()
     stream.maintain(Ethernet.localIP());
   }
 #endif
+  LOOP_TIMING_STAGE(LOOP_TIMING_NETWORK);
 
 }
@@ -0,0 +1,390 @@
+/*
+  FirmataCapture.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "FirmataCapture.h"
+
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "FirmataClockSync.h"
+
+using namespace firmata;
+
+//******************************************************************************
+//* Support Functions
+//******************************************************************************
+
+namespace {
+
+const uint8_t MAGIC[4] = { 'F', 'C', 'A', 'P' };
+const uint8_t VERSION = 1;
+const size_t HEADER_SIZE = 16;
+const uint8_t DIRECTION_BIT = 0x80;
+const uint8_t LENGTH_MASK = 0x7F;
+
+uint64_t epochMicros(void)
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+void sleepUntil(uint64_t host_time_us)
+{
+  uint64_t now;
+  while ( (now = FirmataClockSync::hostMicros()) < host_time_us ) {
+    const uint64_t wait = host_time_us - now;
+    struct timespec ts = { static_cast<time_t>(wait / 1000000), static_cast<long>((wait % 1000000) * 1000) };
+    ::nanosleep(&ts, NULL);
+  }
+}
+
+} // namespace
+
+//******************************************************************************
+//* FirmataCaptureWriter
+//******************************************************************************
+
+/**
+ * The FirmataCaptureWriter class.
+ */
+FirmataCaptureWriter::FirmataCaptureWriter()
+:
+  file(NULL),
+  startTime(0),
+  lastTime(0),
+  total(0),
+  runLength(0),
+  runDirection(CAPTURE_TO_BOARD),
+  runTime(0)
+{
+}
+
+FirmataCaptureWriter::~FirmataCaptureWriter()
+{
+  close();
+}
+
+/**
+ * Create a capture file and write its header. The time of the records counts from here.
+ * @param path The file to create or truncate.
+ * @return false if the file cannot be written.
+ */
+bool FirmataCaptureWriter::open(const char * path)
+{
+  close();
+  file = std::fopen(path, "wb");
+  if ( !file ) { return false; }
+
+  uint8_t header[HEADER_SIZE] = { 0 };
+  std::memcpy(header, MAGIC, sizeof(MAGIC));
+  header[4] = VERSION;
+  const uint64_t start = epochMicros();
+  for (size_t i = 0; i < 8; ++i) {
+    header[8 + i] = static_cast<uint8_t>(start >> (8 * i));
+  }
+  if ( std::fwrite(header, 1, sizeof(header), file) != sizeof(header) ) {
+    close();
+    return false;
+  }
+  startTime = FirmataClockSync::hostMicros();
+  lastTime = 0;
+  total = 0;
+  runLength = 0;
+  return true;
+}
+
+/**
+ * Write the buffered bytes and close the file.
+ */
+void FirmataCaptureWriter::close(void)
+{
+  if ( !file ) { return; }
+  writeRun();
+  std::fclose(file);
+  file = NULL;
+}
+
+/**
+ * @return true between a successful open() and close().
+ */
+bool FirmataCaptureWriter::isOpen(void)
+const
+{
+  return (file != NULL);
+}
+
+/**
+ * Record one byte at the current host time.
+ * @param direction CAPTURE_TO_BOARD or CAPTURE_FROM_BOARD.
+ * @param c The byte.
+ */
+void FirmataCaptureWriter::record(uint8_t direction, uint8_t c)
+{
+  if ( file ) { record(direction, &c, 1, FirmataClockSync::hostMicros()); }
+}
+
+/**
+ * Record a block of bytes at the current host time, e.g. the result of one read() call.
+ * @param direction CAPTURE_TO_BOARD or CAPTURE_FROM_BOARD.
+ * @param data The bytes.
+ * @param length The number of bytes.
+ */
+void FirmataCaptureWriter::record(uint8_t direction, const uint8_t * data, size_t length)
+{
+  if ( file ) { record(direction, data, length, FirmataClockSync::hostMicros()); }
+}
+
+/**
+ * Record a block of bytes taken at a given time.
+ * @param direction CAPTURE_TO_BOARD or CAPTURE_FROM_BOARD.
+ * @param data The bytes.
+ * @param length The number of bytes.
+ * @param host_time_us The FirmataClockSync::hostMicros() time of the bytes. Times before the
+ * previous record are recorded as the time of the previous record.
+ */
+void FirmataCaptureWriter::record(uint8_t direction, const uint8_t * data, size_t length, uint64_t host_time_us)
+{
+  if ( !file ) { return; }
+  uint64_t time = ((host_time_us > startTime) ? (host_time_us - startTime) : 0);
+  if ( time < lastTime ) { time = lastTime; }
+
+  for (size_t i = 0; i < length; ++i) {
+    if ( runLength == MAX_RUN || (runLength && (direction != runDirection || time != runTime)) ) {
+      writeRun();
+    }
+    if ( runLength == 0 ) {
+      runDirection = direction;
+      runTime = time;
+    }
+    run[runLength++] = data[i];
+  }
+  total += length;
+}
+
+/**
+ * Write the buffered bytes through to the file, e.g. before an operation that may crash.
+ */
+void FirmataCaptureWriter::flush(void)
+{
+  if ( !file ) { return; }
+  writeRun();
+  std::fflush(file);
+}
+
+/**
+ * @return The number of bytes recorded since open().
+ */
+uint64_t FirmataCaptureWriter::bytesRecorded(void)
+const
+{
+  return total;
+}
+
+/**
+ * Write the buffered run as one record.
+ * @private
+ */
+void FirmataCaptureWriter::writeRun(void)
+{
+  if ( runLength == 0 ) { return; }
+
+  uint8_t head[1 + 10];
+  size_t n = 0;
+  head[n++] = static_cast<uint8_t>((runDirection ? DIRECTION_BIT : 0) | (runLength - 1));
+  uint64_t delta = runTime - lastTime;
+  do {
+    head[n] = static_cast<uint8_t>(delta & 0x7F);
+    delta >>= 7;
+    if ( delta ) { head[n] |= 0x80; }
+    ++n;
+  } while ( delta );
+
+  std::fwrite(head, 1, n, file);
+  std::fwrite(run, 1, runLength, file);
+  lastTime = runTime;
+  runLength = 0;
+}
+
+//******************************************************************************
+//* FirmataCaptureReplayer
+//******************************************************************************
+
+/**
+ * The FirmataCaptureReplayer class.
+ */
+FirmataCaptureReplayer::FirmataCaptureReplayer()
+:
+  base(NULL),
+  size(0),
+  position(0),
+  time(0),
+  truncatedCapture(false)
+{
+}
+
+FirmataCaptureReplayer::~FirmataCaptureReplayer()
+{
+  close();
+}
+
+/**
+ * Map a capture file and check its header.
+ * @param path The capture file.
+ * @return false if the file cannot be mapped or is not a capture of a known version.
+ */
+bool FirmataCaptureReplayer::open(const char * path)
+{
+  close();
+  const int fd = ::open(path, O_RDONLY);
+  if ( fd < 0 ) { return false; }
+  struct stat st;
+  if ( ::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEADER_SIZE ) {
+    ::close(fd);
+    return false;
+  }
+  void * mapping = ::mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if ( mapping == MAP_FAILED ) { return false; }
+
+  base = static_cast<const uint8_t *>(mapping);
+  size = st.st_size;
+  if ( std::memcmp(base, MAGIC, sizeof(MAGIC)) != 0 || base[4] != VERSION ) {
+    close();
+    return false;
+  }
+  // records are read once, front to back
+  ::madvise(mapping, size, MADV_SEQUENTIAL);
+  rewind();
+  return true;
+}
+
+/**
+ * Unmap the capture. Records returned by next() are no longer valid.
+ */
+void FirmataCaptureReplayer::close(void)
+{
+  if ( base ) {
+    ::munmap(const_cast<uint8_t *>(base), size);
+    base = NULL;
+  }
+  size = 0;
+  position = 0;
+}
+
+/**
+ * Read the next record.
+ * @param record Set to the record; its data points into the mapping.
+ * @return false at the end of the capture or at a truncated record.
+ */
+bool FirmataCaptureReplayer::next(capture_record &record)
+{
+  if ( position >= size ) { return false; }
+
+  size_t p = position;
+  const uint8_t head = base[p++];
+  uint64_t delta = 0;
+  unsigned shift = 0;
+  uint8_t b;
+  do {
+    if ( p >= size || shift > 63 ) {
+      truncatedCapture = true;
+      position = size;
+      return false;
+    }
+    b = base[p++];
+    delta |= static_cast<uint64_t>(b & 0x7F) << shift;
+    shift += 7;
+  } while ( b & 0x80 );
+
+  const size_t length = (head & LENGTH_MASK) + 1;
+  if ( size - p < length ) {
+    truncatedCapture = true;
+    position = size;
+    return false;
+  }
+  time += delta;
+  record.time = time;
+  record.direction = ((head & DIRECTION_BIT) ? CAPTURE_FROM_BOARD : CAPTURE_TO_BOARD);
+  record.data = base + p;
+  record.length = length;
+  position = p + length;
+  return true;
+}
+
+/**
+ * Continue with the first record.
+ */
+void FirmataCaptureReplayer::rewind(void)
+{
+  position = (base ? HEADER_SIZE : 0);
+  time = 0;
+  truncatedCapture = false;
+}
+
+/**
+ * @return true if next() stopped at a record cut off by the end of the file.
+ */
+bool FirmataCaptureReplayer::truncated(void)
+const
+{
+  return truncatedCapture;
+}
+
+/**
+ * @return The start of the capture in microseconds since the Unix epoch.
+ */
+uint64_t FirmataCaptureReplayer::startTime(void)
+const
+{
+  uint64_t start = 0;
+  if ( !base ) { return 0; }
+  for (size_t i = 0; i < 8; ++i) {
+    start |= static_cast<uint64_t>(base[8 + i]) << (8 * i);
+  }
+  return start;
+}
+
+/**
+ * Feed the bytes of one direction of the whole capture to a parser, from the first record on.
+ * @param parser The parser, with the callbacks of the host stack under test attached.
+ * @param direction CAPTURE_FROM_BOARD to replay what a host received, CAPTURE_TO_BOARD for what
+ * a board received.
+ * @param speed 1.0 keeps the original timing, 2.0 replays twice as fast and so on; 0 feeds the
+ * bytes as fast as the parser takes them.
+ * @return The number of bytes fed to the parser.
+ */
+uint64_t FirmataCaptureReplayer::replay(FirmataParser &parser, uint8_t direction, double speed)
+{
+  const uint64_t begin = FirmataClockSync::hostMicros();
+  uint64_t bytes = 0;
+  capture_record record;
+
+  rewind();
+  while ( next(record) ) {
+    if ( record.direction != direction ) { continue; }
+    if ( speed > 0.0 ) { sleepUntil(begin + static_cast<uint64_t>(record.time / speed)); }
+    for (size_t i = 0; i < record.length; ++i) {
+      parser.parse(record.data[i]);
+    }
+    bytes += record.length;
+  }
+  return bytes;
+}
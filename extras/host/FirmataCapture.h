@@ -0,0 +1,130 @@
+/*
+  FirmataCapture.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Capture files of the bytes on a Firmata connection, in both directions,
+  with the host time at which each byte was sent or received.
+
+  A capture starts with a 16 byte header:
+
+    0   "FCAP"
+    4   version (1)
+    5   flags (0)
+    6   reserved (0, 2 bytes)
+    8   start of the capture [us] since the Unix epoch, 64-bit little-endian
+
+  followed by records of a run of bytes in the same direction taken within
+  the same microsecond:
+
+    0   bit 7: direction (0 to the board, 1 from the board),
+        bits 0 - 6: number of bytes - 1 (runs of 1 - 128 bytes)
+    1   time since the previous record (the start for the first one) [us],
+        unsigned LEB128: 7 bits per byte, least significant first, bit 7 set
+        on all but the last byte
+    n   the bytes
+
+  A byte of a busy stream costs little more than the byte itself. A capture
+  cut off by a crash ends in a truncated record, which the replayer skips.
+*/
+
+#ifndef FirmataCapture_h
+#define FirmataCapture_h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "FirmataParser.h"
+
+namespace firmata {
+
+const uint8_t CAPTURE_TO_BOARD = 0;
+const uint8_t CAPTURE_FROM_BOARD = 1;
+
+/**
+ * One run of bytes of a capture.
+ */
+struct capture_record {
+  uint64_t time;        // [us] since the start of the capture
+  uint8_t direction;    // CAPTURE_TO_BOARD or CAPTURE_FROM_BOARD
+  const uint8_t * data; // points into the mapped capture
+  size_t length;
+};
+
+/**
+ * Writes a capture file. Bytes are buffered until a byte of the other direction or a later
+ * microsecond arrives, then written through stdio; flush() forces both out.
+ */
+class FirmataCaptureWriter
+{
+  public:
+    static const size_t MAX_RUN = 128;
+
+    FirmataCaptureWriter();
+    ~FirmataCaptureWriter();
+
+    bool open(const char * path);
+    void close(void);
+    bool isOpen(void) const;
+
+    void record(uint8_t direction, uint8_t c);
+    void record(uint8_t direction, const uint8_t * data, size_t length);
+    void record(uint8_t direction, const uint8_t * data, size_t length, uint64_t host_time_us);
+    void flush(void);
+
+    uint64_t bytesRecorded(void) const;
+
+  private:
+    void writeRun(void);
+
+    std::FILE * file;
+    uint64_t startTime;     // [us] host clock at open()
+    uint64_t lastTime;      // [us] since startTime, of the last record written
+    uint64_t total;
+    uint8_t run[MAX_RUN];
+    size_t runLength;
+    uint8_t runDirection;
+    uint64_t runTime;       // [us] since startTime
+};
+
+/**
+ * Reads a capture file through a read-only memory mapping and feeds it back through a parser,
+ * at the original pace or as fast as the parser takes it. Records point into the mapping, so
+ * reading a capture copies nothing.
+ */
+class FirmataCaptureReplayer
+{
+  public:
+    FirmataCaptureReplayer();
+    ~FirmataCaptureReplayer();
+
+    bool open(const char * path);
+    void close(void);
+
+    /* records */
+    bool next(capture_record &record);
+    void rewind(void);
+    bool truncated(void) const;
+    uint64_t startTime(void) const;
+
+    /* replay */
+    uint64_t replay(FirmataParser &parser, uint8_t direction, double speed = 0.0);
+
+  private:
+    const uint8_t * base;
+    size_t size;
+    size_t position;
+    uint64_t time;
+    bool truncatedCapture;
+};
+
+} // namespace firmata
+
+#endif /* FirmataCapture_h */
@@ -0,0 +1,1024 @@
+/*
+  FirmataClient.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "FirmataClient.h"
+
+#include <cstring>
+
+#include "FirmataClockSync.h"
+#include "FirmataSysexDecoder.h"
+
+using namespace firmata;
+
+//******************************************************************************
+//* Support Functions
+//******************************************************************************
+
+namespace {
+
+// defined by StandardFirmata, which only compiles for a board
+const uint8_t I2C_WRITE = 0x00;
+const uint8_t I2C_READ = 0x08;
+const uint8_t I2C_READ_CONTINUOUSLY = 0x10;
+const uint8_t SERIAL_CONFIG = 0x10;
+const uint8_t SERIAL_WRITE = 0x20;
+const uint8_t SERIAL_READ = 0x30;
+const uint8_t SERIAL_STOP_READING = 0x01;
+const uint8_t NO_CHANNEL = 0x7F;
+const uint8_t FREE_BLOCK = 0xFF;
+
+/**
+ * @return true if a DIGITAL_MESSAGE reports the value of a pin in this mode.
+ */
+bool isDigitalInput(uint8_t mode)
+{
+  return (mode == PIN_MODE_INPUT || mode == PIN_MODE_PULLUP || mode == PIN_MODE_IGNORE);
+}
+
+/**
+ * @return true if the value of a pin in this mode is set by the host, so a board that was
+ * reset or reconfigured behind its back reports a different one.
+ */
+bool isHostDriven(uint8_t mode)
+{
+  return (mode == PIN_MODE_OUTPUT || mode == PIN_MODE_PWM || mode == PIN_MODE_SERVO);
+}
+
+/**
+ * @return The first slot to probe for an I2C block.
+ */
+size_t i2cHash(uint8_t address, uint8_t reg)
+{
+  return ((address * 31u) ^ reg) & (board_model::MAX_I2C_BLOCKS - 1);
+}
+
+static_assert(sizeof(pin_state) == 16, "four pins per cache line");
+static_assert((board_model::MAX_I2C_BLOCKS & (board_model::MAX_I2C_BLOCKS - 1)) == 0, "the I2C table is probed with a mask");
+
+} // namespace
+
+//******************************************************************************
+//* Constructors
+//******************************************************************************
+
+/**
+ * The FirmataClient class.
+ */
+FirmataClient::FirmataClient()
+:
+  firmataParser(parserBuffer, sizeof(parserBuffer)),
+  stream(NULL),
+  pendingCount(0),
+  nextId(1),
+  timeout(DEFAULT_TIMEOUT),
+  pinCallback(NULL),
+  pinCallbackContext(NULL),
+  stringCallback(NULL),
+  stringCallbackContext(NULL),
+  reconcilePin(board_model::MAX_PINS),
+  reconcileOutstanding(0),
+  reconcileCallback(NULL),
+  reconcileCallbackContext(NULL)
+{
+  std::memset(requests, 0, sizeof(requests));
+  resetModel();
+  firmataParser.attach(ANALOG_MESSAGE, staticAnalogCallback, this);
+  firmataParser.attach(DIGITAL_MESSAGE, staticDigitalCallback, this);
+  firmataParser.attach(REPORT_FIRMWARE, staticFirmwareCallback, this);
+  firmataParser.attach(STRING_DATA, staticStringCallback, this);
+  firmataParser.attach(START_SYSEX, staticSysexCallback, this);
+}
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+/**
+ * Send requests and commands to the board through a stream and forget what was known about the
+ * previous board. The bytes the board sends back are passed to parse() by the caller, which
+ * owns the reading side of the connection.
+ * @param s The stream to the board.
+ */
+void FirmataClient::begin(Stream &s)
+{
+  stream = &s;
+  firmataMarshaller.begin(s);
+  resetModel();
+}
+
+/**
+ * Continue with a new stream to the same board, e.g. after the serial port was reopened. The
+ * model is kept, so reconcile() can compare it with the board; pending requests are cancelled,
+ * as their answers were lost with the old connection.
+ * @param s The stream to the board.
+ */
+void FirmataClient::reconnect(Stream &s)
+{
+  reconcilePin = board_model::MAX_PINS;
+  cancelAll();
+  stream = &s;
+  firmataMarshaller.begin(s);
+}
+
+/**
+ * Parse one byte from the board, updating the board model and completing requests.
+ * @param data The byte.
+ */
+void FirmataClient::parse(uint8_t data)
+{
+  firmataParser.parse(data);
+}
+
+/**
+ * Parse a block of bytes from the board, e.g. the result of one read() call.
+ * @param data The bytes.
+ * @param length The number of bytes.
+ */
+void FirmataClient::parse(const uint8_t * data, size_t length)
+{
+  for (size_t i = 0; i < length; ++i) {
+    firmataParser.parse(data[i]);
+  }
+}
+
+/**
+ * Complete the requests that have waited longer than the timeout with CLIENT_TIMED_OUT and
+ * continue a reconcile() that ran out of request slots. Call it from the event loop, e.g. after
+ * each read or poll timeout.
+ */
+void FirmataClient::update(void)
+{
+  if ( reconcilePin < board_model::MAX_PINS ) { reconcileNext(); }
+  if ( !pendingCount ) { return; }
+  const uint64_t now = FirmataClockSync::hostMicros();
+  for (size_t i = 0; i < MAX_PENDING; ++i) {
+    // requests submitted by the callbacks of this loop are newer than now
+    if ( requests[i].id && requests[i].sent + timeout <= now ) {
+      finish(requests[i], CLIENT_TIMED_OUT, NULL, 0, now);
+    }
+  }
+}
+
+/**
+ * @param timeout_us How long a request may wait for its answer (default 1 s).
+ */
+void FirmataClient::setTimeout(uint32_t timeout_us)
+{
+  timeout = timeout_us;
+}
+
+/**
+ * @return The parser, e.g. to attach callbacks for the messages the client does not handle.
+ * The callbacks of the client must stay attached.
+ */
+FirmataParser & FirmataClient::parser(void)
+{
+  return firmataParser;
+}
+
+/**
+ * @return The marshaller, to send the messages the client has no method for.
+ */
+const FirmataMarshaller & FirmataClient::marshaller(void)
+const
+{
+  return firmataMarshaller;
+}
+
+/**
+ * Ask for the name and version of the firmware.
+ * @param callback Called with the outcome; the answer is in board().
+ * @param context An optional context to be provided to the callback function.
+ * @return The request id, 0 if MAX_PENDING requests are in flight.
+ */
+uint16_t FirmataClient::queryFirmware(completionCallbackFunction callback, void * context)
+{
+  return submit(CLIENT_FIRMWARE, 0, 0, -1, 0, callback, context);
+}
+
+/**
+ * Ask for the modes and resolutions of all pins.
+ * @param callback Called with the outcome; the answer is in board().
+ * @param context An optional context to be provided to the callback function.
+ * @return The request id, 0 if MAX_PENDING requests are in flight.
+ */
+uint16_t FirmataClient::queryCapabilities(completionCallbackFunction callback, void * context)
+{
+  return submit(CLIENT_CAPABILITIES, 0, 0, -1, 0, callback, context);
+}
+
+/**
+ * Ask which pin each analog channel reads.
+ * @param callback Called with the outcome; the answer is in board().
+ * @param context An optional context to be provided to the callback function.
+ * @return The request id, 0 if MAX_PENDING requests are in flight.
+ */
+uint16_t FirmataClient::queryAnalogMapping(completionCallbackFunction callback, void * context)
+{
+  return submit(CLIENT_ANALOG_MAPPING, 0, 0, -1, 0, callback, context);
+}
+
+/**
+ * Ask for the mode and value of a pin.
+ * @param pin The pin.
+ * @param callback Called with the outcome; the answer is in board().pins[pin].
+ * @param context An optional context to be provided to the callback function.
+ * @return The request id, 0 if MAX_PENDING requests are in flight.
+ */
+uint16_t FirmataClient::queryPinState(uint8_t pin, completionCallbackFunction callback, void * context)
+{
+  return submit(CLIENT_PIN_STATE, (pin & 0x7F), 0, -1, 0, callback, context);
+}
+
+/**
+ * Read bytes from an I2C device once. Call configureI2C() first.
+ * @param address The 7-bit address of the device.
+ * @param reg The register to read from, -1 to read without writing a register first.
+ * @param length The number of bytes to read, up to MAX_I2C_DATA.
+ * @param callback Called with the outcome and the bytes read.
+ * @param context An optional context to be provided to the callback function.
+ * @return The request id, 0 if MAX_PENDING requests are in flight or length is too large.
+ */
+uint16_t FirmataClient::readI2C(uint8_t address, int16_t reg, uint8_t length, completionCallbackFunction callback, void * context)
+{
+  if ( length > MAX_I2C_DATA ) { return 0; }
+  return submit(CLIENT_I2C_READ, 0, (address & 0x7F), reg, length, callback, context);
+}
+
+/**
+ * Complete a request with CLIENT_CANCELLED. An answer that arrives later only updates the board
+ * model.
+ * @param id The request id.
+ * @return false if the request is no longer pending.
+ */
+bool FirmataClient::cancel(uint16_t id)
+{
+  if ( !id ) { return false; }
+  for (size_t i = 0; i < MAX_PENDING; ++i) {
+    if ( requests[i].id == id ) {
+      finish(requests[i], CLIENT_CANCELLED, NULL, 0, FirmataClockSync::hostMicros());
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Complete all pending requests with CLIENT_CANCELLED, e.g. when the connection is lost.
+ */
+void FirmataClient::cancelAll(void)
+{
+  const uint64_t now = FirmataClockSync::hostMicros();
+  for (size_t i = 0; i < MAX_PENDING; ++i) {
+    if ( requests[i].id ) { finish(requests[i], CLIENT_CANCELLED, NULL, 0, now); }
+  }
+}
+
+/**
+ * @param id The request id.
+ * @return true until the request completes, times out or is cancelled; lets a caller without
+ * a callback wait for a request.
+ */
+bool FirmataClient::isPending(uint16_t id)
+const
+{
+  if ( !id ) { return false; }
+  for (size_t i = 0; i < MAX_PENDING; ++i) {
+    if ( requests[i].id == id ) { return true; }
+  }
+  return false;
+}
+
+/**
+ * @return The number of requests in flight.
+ */
+size_t FirmataClient::pending(void)
+const
+{
+  return pendingCount;
+}
+
+/**
+ * Set the mode of a pin.
+ * @param pin The pin.
+ * @param mode One of the PIN_MODE_* constants.
+ */
+void FirmataClient::setPinMode(uint8_t pin, uint8_t mode)
+{
+  firmataMarshaller.sendPinMode(pin, mode);
+  pin_state &state = model.pins[pin & 0x7F];
+  state.mode = mode;
+  state.updated = FirmataClockSync::hostMicros();
+}
+
+/**
+ * Set a digital output pin.
+ * @param pin The pin.
+ * @param value 0 or 1.
+ */
+void FirmataClient::digitalWrite(uint8_t pin, uint8_t value)
+{
+  firmataMarshaller.sendDigital(pin, value);
+  pin_state &state = model.pins[pin & 0x7F];
+  state.value = (value ? 1 : 0);
+  state.updated = FirmataClockSync::hostMicros();
+}
+
+/**
+ * Set a PWM or servo pin.
+ * @param pin The pin.
+ * @param value The duty cycle or angle.
+ */
+void FirmataClient::analogWrite(uint8_t pin, uint16_t value)
+{
+  firmataMarshaller.sendAnalog(pin, value);
+  pin_state &state = model.pins[pin & 0x7F];
+  state.value = value;
+  state.updated = FirmataClockSync::hostMicros();
+}
+
+/**
+ * Start or stop the reports of an analog channel.
+ * @param channel The analog channel (0 - 15).
+ * @param enable true to start the reports.
+ */
+void FirmataClient::reportAnalog(uint8_t channel, bool enable)
+{
+  if ( enable ) {
+    firmataMarshaller.reportAnalogEnable(channel);
+  } else {
+    firmataMarshaller.reportAnalogDisable(channel);
+  }
+}
+
+/**
+ * Start or stop the reports of a digital port.
+ * @param port The port (0 - 15), pins 8 * port to 8 * port + 7.
+ * @param enable true to start the reports.
+ */
+void FirmataClient::reportDigitalPort(uint8_t port, bool enable)
+{
+  if ( enable ) {
+    firmataMarshaller.reportDigitalPortEnable(port);
+  } else {
+    firmataMarshaller.reportDigitalPortDisable(port);
+  }
+}
+
+/**
+ * Set the interval of the analog and I2C reports.
+ * @param interval_ms The interval in milliseconds.
+ */
+void FirmataClient::setSamplingInterval(uint16_t interval_ms)
+{
+  firmataMarshaller.setSamplingInterval(interval_ms);
+}
+
+/**
+ * Enable I2C on the board.
+ * @param delay_us The delay between writing a register and reading it, for slow devices.
+ */
+void FirmataClient::configureI2C(uint16_t delay_us)
+{
+  if ( !stream ) { return; }
+  const uint8_t config[] = { static_cast<uint8_t>(delay_us & 0x7F), static_cast<uint8_t>((delay_us >> 7) & 0x7F) };
+  firmataMarshaller.sendRawSysex(I2C_CONFIG, sizeof(config), config);
+}
+
+/**
+ * Write bytes to an I2C device. Call configureI2C() first. The bytes become the block of the
+ * register in the board model.
+ * @param address The 7-bit address of the device.
+ * @param reg The register to write to, -1 to write the bytes alone.
+ * @param data The bytes.
+ * @param length The number of bytes, up to i2c_block::MAX_DATA.
+ */
+void FirmataClient::writeI2C(uint8_t address, int16_t reg, const uint8_t * data, size_t length)
+{
+  if ( !stream || length > i2c_block::MAX_DATA ) { return; }
+  address &= 0x7F;
+  // the fields of I2C_REQUEST are 7-bit, FirmataMarshaller::sendSysex() would split them
+  uint8_t message[4 + 2 * i2c_block::MAX_DATA];
+  size_t n = 0;
+  message[n++] = address;
+  message[n++] = I2C_WRITE;
+  if ( reg >= 0 ) {
+    message[n++] = static_cast<uint8_t>(reg & 0x7F);
+    message[n++] = static_cast<uint8_t>((reg >> 7) & 0x7F);
+  }
+  for (size_t i = 0; i < length; ++i) {
+    message[n++] = static_cast<uint8_t>(data[i] & 0x7F);
+    message[n++] = static_cast<uint8_t>((data[i] >> 7) & 0x7F);
+  }
+  firmataMarshaller.sendRawSysex(I2C_REQUEST, n, message);
+
+  i2c_block * block = findI2CBlock(address, static_cast<uint8_t>(reg < 0 ? 0 : reg), true);
+  if ( !block ) { return; }
+  std::memcpy(block->data, data, length);
+  block->length = static_cast<uint8_t>(length);
+  block->updated = FirmataClockSync::hostMicros();
+}
+
+/**
+ * Open a serial port of the board (SerialFirmata).
+ * @param port HW_SERIAL0 - 7 (0 - 7) or SW_SERIAL0 - 3 (8 - 11). Software serial ports also need
+ * their RX and TX pins, which are left to FirmataClient::marshaller().
+ * @param baud The baud rate.
+ */
+void FirmataClient::configureSerial(uint8_t port, uint32_t baud)
+{
+  if ( !stream || port >= board_model::MAX_SERIAL_PORTS ) { return; }
+  const uint8_t message[] = {
+    static_cast<uint8_t>(SERIAL_CONFIG | port),
+    static_cast<uint8_t>(baud & 0x7F), static_cast<uint8_t>((baud >> 7) & 0x7F), static_cast<uint8_t>((baud >> 14) & 0x7F)
+  };
+  firmataMarshaller.sendRawSysex(SERIAL_DATA, sizeof(message), message);
+  serial_state &state = model.serial[port];
+  state.configured = true;
+  state.baud = baud;
+}
+
+/**
+ * Start or stop the reports of the bytes a serial port receives.
+ * @param port The port, see configureSerial().
+ * @param enable true to read continuously, false to stop reading.
+ */
+void FirmataClient::readSerial(uint8_t port, bool enable)
+{
+  if ( !stream || port >= board_model::MAX_SERIAL_PORTS ) { return; }
+  const uint8_t message[] = { static_cast<uint8_t>(SERIAL_READ | port), static_cast<uint8_t>(enable ? 0x00 : SERIAL_STOP_READING) };
+  firmataMarshaller.sendRawSysex(SERIAL_DATA, sizeof(message), message);
+}
+
+/**
+ * Send bytes through a serial port of the board, in messages that fit the sysex buffer of the
+ * firmware (MAX_DATA_BYTES).
+ * @param port The port, see configureSerial().
+ * @param data The bytes.
+ * @param length The number of bytes.
+ */
+void FirmataClient::writeSerial(uint8_t port, const uint8_t * data, size_t length)
+{
+  if ( !stream || port >= board_model::MAX_SERIAL_PORTS ) { return; }
+  // the command and the port byte, then two bytes per byte sent
+  uint8_t message[MAX_DATA_BYTES - 1];
+  message[0] = static_cast<uint8_t>(SERIAL_WRITE | port);
+  size_t n = 1;
+  for (size_t i = 0; i < length; ++i) {
+    message[n++] = static_cast<uint8_t>(data[i] & 0x7F);
+    message[n++] = static_cast<uint8_t>((data[i] >> 7) & 0x7F);
+    if ( n + 2 > sizeof(message) || i + 1 == length ) {
+      firmataMarshaller.sendRawSysex(SERIAL_DATA, n, message);
+      n = 1;
+    }
+  }
+  model.serial[port].bytesSent += length;
+}
+
+/**
+ * @return The board model.
+ */
+const board_model & FirmataClient::board(void)
+const
+{
+  return model;
+}
+
+/**
+ * @param address The 7-bit address of the device.
+ * @param reg The register, 0 for reads and writes without one.
+ * @return The last bytes read from or written to the register, NULL if there were none.
+ */
+const i2c_block * FirmataClient::i2cBlock(uint8_t address, uint8_t reg)
+const
+{
+  return const_cast<FirmataClient *>(this)->findI2CBlock(address & 0x7F, reg, false);
+}
+
+/**
+ * Query the state of every pin whose mode the model knows, e.g. after reconnect(), and report
+ * the pins whose mode, or value for pins driven by the host, differs from the model. The model
+ * is updated with the answers as they arrive. Queries are sent a few at a time from update()
+ * and parse(), so the board is not flooded.
+ * @param callback Called with the model before and the answer of each pin that differs.
+ * @param context An optional context to be provided to the callback function.
+ * @return false if a reconcile is already running.
+ */
+bool FirmataClient::reconcile(reconcileCallbackFunction callback, void * context)
+{
+  if ( reconciling() ) { return false; }
+  std::memcpy(reconcileExpected, model.pins, sizeof(reconcileExpected));
+  reconcileCallback = callback;
+  reconcileCallbackContext = context;
+  reconcilePin = 0;
+  reconcileNext();
+  return true;
+}
+
+/**
+ * @return true until every pin queried by reconcile() has answered or timed out.
+ */
+bool FirmataClient::reconciling(void)
+const
+{
+  return (reconcilePin < board_model::MAX_PINS || reconcileOutstanding);
+}
+
+/**
+ * Attach a callback for changes of a pin value reported by the board: digital inputs, and
+ * analog inputs once the analog mapping is known.
+ * @param callback The callback, NULL to detach.
+ * @param context An optional context to be provided to the callback function.
+ */
+void FirmataClient::attach(pinCallbackFunction callback, void * context)
+{
+  pinCallback = callback;
+  pinCallbackContext = context;
+}
+
+/**
+ * Attach a callback for STRING_DATA messages, e.g. the errors of the board.
+ * @param callback The callback, NULL to detach.
+ * @param context An optional context to be provided to the callback function.
+ */
+void FirmataClient::attach(stringCallbackFunction callback, void * context)
+{
+  stringCallback = callback;
+  stringCallbackContext = context;
+}
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+/**
+ * Take a slot for a request and send it unless the same request is already in flight.
+ * @private
+ */
+uint16_t FirmataClient::submit(client_request_type type, uint8_t pin, uint8_t address, int16_t reg, uint8_t length, completionCallbackFunction callback, void * context)
+{
+  if ( pendingCount == MAX_PENDING ) { return 0; }
+
+  bool in_flight = false;
+  pending_request * slot = NULL;
+  for (size_t i = 0; i < MAX_PENDING; ++i) {
+    if ( !requests[i].id ) {
+      if ( !slot ) { slot = &requests[i]; }
+    } else if ( matches(requests[i], type, pin, address, reg, length) ) {
+      in_flight = true;
+    }
+  }
+
+  slot->id = nextId;
+  nextId = ((nextId == 0xFFFF) ? 1 : (nextId + 1));
+  slot->type = type;
+  slot->pin = pin;
+  slot->address = address;
+  slot->reg = reg;
+  slot->length = length;
+  slot->sent = FirmataClockSync::hostMicros();
+  slot->answered = false;
+  slot->callback = callback;
+  slot->context = context;
+  ++pendingCount;
+
+  if ( !in_flight ) { send(*slot); }
+  return slot->id;
+}
+
+/**
+ * @return true if a pending request asks for the same answer.
+ * @private
+ */
+bool FirmataClient::matches(const pending_request &request, client_request_type type, uint8_t pin, uint8_t address, int16_t reg, uint8_t length)
+const
+{
+  if ( request.type != type || request.answered ) { return false; }
+  switch (type) {
+    case CLIENT_PIN_STATE:
+      return (request.pin == pin);
+    case CLIENT_I2C_READ:
+      return (request.address == address && request.reg == reg && request.length == length);
+    default:
+      return true;
+  }
+}
+
+/**
+ * Send the query of a request.
+ * @private
+ */
+void FirmataClient::send(const pending_request &request)
+{
+  switch (request.type) {
+    case CLIENT_FIRMWARE:
+      firmataMarshaller.queryFirmwareVersion();
+      break;
+    case CLIENT_CAPABILITIES:
+      firmataMarshaller.sendCapabilityQuery();
+      break;
+    case CLIENT_ANALOG_MAPPING:
+      firmataMarshaller.sendAnalogMappingQuery();
+      break;
+    case CLIENT_PIN_STATE:
+      firmataMarshaller.sendPinStateQuery(request.pin);
+      break;
+    case CLIENT_I2C_READ: {
+      // the fields of I2C_REQUEST are 7-bit, FirmataMarshaller::sendSysex() would split them
+      uint8_t message[6];
+      size_t n = 0;
+      message[n++] = request.address;
+      message[n++] = I2C_READ;
+      if ( request.reg >= 0 ) {
+        message[n++] = static_cast<uint8_t>(request.reg & 0x7F);
+        message[n++] = static_cast<uint8_t>((request.reg >> 7) & 0x7F);
+      }
+      message[n++] = static_cast<uint8_t>(request.length & 0x7F);
+      message[n++] = static_cast<uint8_t>((request.length >> 7) & 0x7F);
+      firmataMarshaller.sendRawSysex(I2C_REQUEST, n, message);
+      break;
+    }
+  }
+}
+
+/**
+ * Complete all pending requests answered by a reply, oldest first. An I2C reply completes the
+ * reads of its address, register and length; if the device returned fewer bytes than asked for,
+ * it completes the oldest read of the address and register alone. The requests are picked before
+ * the first callback runs, so a request submitted by a callback waits for the next reply.
+ * @param reg The register of an I2C reply; StandardFirmata replies 0 for reads without one.
+ * @return The number of requests completed.
+ * @private
+ */
+size_t FirmataClient::complete(client_request_type type, uint8_t pin, uint8_t address, int16_t reg, const uint8_t * data, size_t length)
+{
+  if ( !pendingCount ) { return 0; }
+
+  size_t slots[MAX_PENDING];
+  uint16_t ids[MAX_PENDING];
+  size_t count = 0;
+  size_t oldest_any_length = MAX_PENDING;
+  for (size_t i = 0; i < MAX_PENDING; ++i) {
+    const pending_request &request = requests[i];
+    if ( !request.id || request.type != type ) { continue; }
+    if ( type == CLIENT_PIN_STATE && request.pin != pin ) { continue; }
+    if ( type == CLIENT_I2C_READ ) {
+      if ( request.address != address || (request.reg < 0 ? 0 : request.reg) != reg ) { continue; }
+      if ( request.length != length ) {
+        if ( oldest_any_length == MAX_PENDING || request.sent < requests[oldest_any_length].sent ) { oldest_any_length = i; }
+        continue;
+      }
+    }
+    // insertion sort by the time sent
+    size_t k = count++;
+    for (; k > 0 && requests[slots[k - 1]].sent > request.sent; --k) {
+      slots[k] = slots[k - 1];
+      ids[k] = ids[k - 1];
+    }
+    slots[k] = i;
+    ids[k] = request.id;
+  }
+  if ( count == 0 && oldest_any_length != MAX_PENDING ) {
+    slots[0] = oldest_any_length;
+    ids[0] = requests[oldest_any_length].id;
+    count = 1;
+  }
+
+  // a callback that asks again must send a new query
+  for (size_t k = 0; k < count; ++k) {
+    requests[slots[k]].answered = true;
+  }
+  const uint64_t now = FirmataClockSync::hostMicros();
+  size_t completed = 0;
+  for (size_t k = 0; k < count; ++k) {
+    // an earlier callback may have cancelled it
+    if ( requests[slots[k]].id != ids[k] ) { continue; }
+    finish(requests[slots[k]], CLIENT_COMPLETED, data, length, now);
+    ++completed;
+  }
+  return completed;
+}
+
+/**
+ * Free the slot of a request, then call its callback, which may submit new requests.
+ * @private
+ */
+void FirmataClient::finish(pending_request &request, client_request_status status, const uint8_t * data, size_t length, uint64_t now)
+{
+  const pending_request done = request;
+  request.id = 0;
+  --pendingCount;
+  if ( !done.callback ) { return; }
+
+  client_completion completion;
+  completion.id = done.id;
+  completion.type = done.type;
+  completion.status = status;
+  completion.pin = done.pin;
+  completion.address = done.address;
+  completion.reg = done.reg;
+  completion.length = length;
+  completion.data = data;
+  completion.latency = static_cast<uint32_t>(now - done.sent);
+  (*done.callback)(done.context, completion);
+}
+
+/**
+ * Update the value of a pin and report a change.
+ * @private
+ */
+void FirmataClient::setPinValue(uint8_t pin, uint32_t value, uint64_t now)
+{
+  pin_state &state = model.pins[pin];
+  state.updated = now;
+  if ( state.value == value ) { return; }
+  state.value = value;
+  if ( pinCallback ) { (*pinCallback)(pinCallbackContext, pin, value); }
+}
+
+/**
+ * Forget everything known about the board.
+ * @private
+ */
+void FirmataClient::resetModel(void)
+{
+  std::memset(&model, 0, sizeof(model));
+  for (size_t pin = 0; pin < board_model::MAX_PINS; ++pin) {
+    model.pins[pin].mode = PIN_MODE_IGNORE;
+    model.pins[pin].analogChannel = NO_CHANNEL;
+  }
+  std::memset(model.analogPins, NO_CHANNEL, sizeof(model.analogPins));
+  for (size_t i = 0; i < board_model::MAX_I2C_BLOCKS; ++i) {
+    model.i2c[i].address = FREE_BLOCK;
+  }
+  reconcilePin = board_model::MAX_PINS;
+}
+
+/**
+ * Linear probing from the hash of the address and register. The table is never shrunk, a
+ * board talks to a few devices.
+ * @param create true to take a free slot if the block is not in the table yet.
+ * @return The block, NULL if it is not found or the table is full.
+ * @private
+ */
+i2c_block * FirmataClient::findI2CBlock(uint8_t address, uint8_t reg, bool create)
+{
+  const size_t mask = board_model::MAX_I2C_BLOCKS - 1;
+  for (size_t i = i2cHash(address, reg), probes = 0; probes < board_model::MAX_I2C_BLOCKS; i = (i + 1) & mask, ++probes) {
+    i2c_block &block = model.i2c[i];
+    if ( block.address == address && block.reg == reg ) { return &block; }
+    if ( block.address == FREE_BLOCK ) {
+      if ( !create ) { return NULL; }
+      block.address = address;
+      block.reg = reg;
+      block.length = 0;
+      return &block;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Send pin state queries for the next pins of a reconcile() until RECONCILE_WINDOW are in
+ * flight.
+ * @private
+ */
+void FirmataClient::reconcileNext(void)
+{
+  while ( reconcilePin < board_model::MAX_PINS && reconcileOutstanding < RECONCILE_WINDOW ) {
+    const uint8_t pin = static_cast<uint8_t>(reconcilePin);
+    if ( reconcileExpected[pin].mode == PIN_MODE_IGNORE ) {
+      ++reconcilePin;
+      continue;
+    }
+    if ( !queryPinState(pin, staticReconcileCallback, this) ) { return; }
+    ++reconcilePin;
+    ++reconcileOutstanding;
+  }
+}
+
+/**
+ * @private
+ */
+void FirmataClient::handleAnalog(uint8_t channel, uint16_t value)
+{
+  const uint64_t now = FirmataClockSync::hostMicros();
+  model.analogValues[channel] = value;
+  model.analogUpdated[channel] = now;
+  const uint8_t pin = model.analogPins[channel];
+  if ( pin != NO_CHANNEL ) { setPinValue(pin, value, now); }
+}
+
+/**
+ * @private
+ */
+void FirmataClient::handleDigital(uint8_t port, uint16_t value)
+{
+  const uint64_t now = FirmataClockSync::hostMicros();
+  // every input pin is stamped, so the pins that changed are left to setPinValue()
+  model.digitalPorts.update(port, static_cast<uint8_t>(value));
+  for (uint8_t bit = 0; bit < 8; ++bit) {
+    const uint8_t pin = static_cast<uint8_t>(port * 8 + bit);
+    if ( isDigitalInput(model.pins[pin].mode) ) {
+      setPinValue(pin, ((value >> bit) & 0x01), now);
+    }
+  }
+}
+
+/**
+ * @private
+ */
+void FirmataClient::handleFirmware(size_t sv_major, size_t sv_minor, const char * firmware)
+{
+  // a query echoed back has no version
+  if ( !firmware ) { return; }
+  model.firmwareKnown = true;
+  model.firmwareMajor = static_cast<uint8_t>(sv_major);
+  model.firmwareMinor = static_cast<uint8_t>(sv_minor);
+  std::strncpy(model.firmwareName, firmware, sizeof(model.firmwareName) - 1);
+  model.firmwareName[sizeof(model.firmwareName) - 1] = '\0';
+  complete(CLIENT_FIRMWARE, 0, 0, 0, NULL, 0);
+}
+
+/**
+ * @private
+ */
+void FirmataClient::handleSysex(uint8_t command, size_t argc, uint8_t * argv)
+{
+  switch (command) {
+    case CAPABILITY_RESPONSE:
+      handleCapabilities(argc, argv);
+      break;
+    case ANALOG_MAPPING_RESPONSE:
+      handleAnalogMapping(argc, argv);
+      break;
+    case PIN_STATE_RESPONSE:
+      handlePinState(argc, argv);
+      break;
+    case I2C_REPLY:
+      handleI2CReply(argc, argv);
+      break;
+    case SERIAL_DATA:
+      handleSerialReply(argc, argv);
+      break;
+  }
+}
+
+/**
+ * @private
+ */
+void FirmataClient::handleCapabilities(size_t argc, const uint8_t * argv)
+{
+  capability_view view;
+  if ( !FirmataSysexDecoder::decodeCapabilities(argc, argv, view) ) { return; }
+  model.pinCount = (view.pinCount < board_model::MAX_PINS) ? view.pinCount : board_model::MAX_PINS;
+  std::memset(model.resolutions, 0, sizeof(model.resolutions));
+  for (size_t pin = 0; pin < model.pinCount; ++pin) {
+    model.pins[pin].modes = view.modes[pin] & ((1 << TOTAL_PIN_MODES) - 1);
+    for (size_t i = view.offsets[pin]; argv[i] != 0x7F; i += 2) {
+      if ( argv[i] < TOTAL_PIN_MODES ) { model.resolutions[pin][argv[i]] = argv[i + 1]; }
+    }
+  }
+  model.capabilitiesKnown = true;
+  complete(CLIENT_CAPABILITIES, 0, 0, 0, NULL, 0);
+}
+
+/**
+ * @private
+ */
+void FirmataClient::handleAnalogMapping(size_t argc, const uint8_t * argv)
+{
+  analog_mapping_view view;
+  if ( !FirmataSysexDecoder::decodeAnalogMapping(argc, argv, view) ) { return; }
+  std::memcpy(model.analogPins, view.pins, sizeof(model.analogPins));
+  for (size_t pin = 0; pin < board_model::MAX_PINS; ++pin) {
+    model.pins[pin].analogChannel = view.channel(static_cast<uint8_t>(pin));
+  }
+  model.analogMappingKnown = true;
+  complete(CLIENT_ANALOG_MAPPING, 0, 0, 0, NULL, 0);
+}
+
+/**
+ * @private
+ */
+void FirmataClient::handlePinState(size_t argc, const uint8_t * argv)
+{
+  pin_state_view view;
+  if ( !FirmataSysexDecoder::decodePinState(argc, argv, view) ) { return; }
+  pin_state &state = model.pins[view.pin];
+  state.mode = view.mode;
+  state.value = view.value;
+  state.updated = FirmataClockSync::hostMicros();
+  complete(CLIENT_PIN_STATE, view.pin, 0, 0, NULL, 0);
+}
+
+/**
+ * @private
+ */
+void FirmataClient::handleI2CReply(size_t argc, uint8_t * argv)
+{
+  i2c_reply_view view;
+  if ( !FirmataSysexDecoder::decodeI2CReply(argc, argv, view) ) { return; }
+  const uint8_t address = view.address & 0x7F;
+  const uint8_t reg = static_cast<uint8_t>(view.reg);
+  const size_t length = (view.length < MAX_I2C_DATA) ? view.length : MAX_I2C_DATA;
+  // continuous reads land here too, with no request to complete
+  i2c_block * block = findI2CBlock(address, reg, true);
+  if ( block ) {
+    block->length = static_cast<uint8_t>((length < i2c_block::MAX_DATA) ? length : i2c_block::MAX_DATA);
+    std::memcpy(block->data, view.data, block->length);
+    block->updated = FirmataClockSync::hostMicros();
+  }
+  complete(CLIENT_I2C_READ, 0, address, reg, view.data, length);
+}
+
+/**
+ * Keeps the last serial_state::MAX_DATA bytes received, shifting out the oldest.
+ * @private
+ */
+void FirmataClient::handleSerialReply(size_t argc, uint8_t * argv)
+{
+  serial_reply_view view;
+  if ( !FirmataSysexDecoder::decodeSerialReply(argc, argv, view) ) { return; }
+  if ( view.port >= board_model::MAX_SERIAL_PORTS ) { return; }
+  serial_state &state = model.serial[view.port];
+  const size_t keep = (view.length < serial_state::MAX_DATA) ? view.length : serial_state::MAX_DATA;
+  const size_t old = (state.lastLength + keep > serial_state::MAX_DATA) ? (serial_state::MAX_DATA - keep) : state.lastLength;
+  std::memmove(state.last, state.last + (state.lastLength - old), old);
+  std::memcpy(state.last + old, view.data + (view.length - keep), keep);
+  state.lastLength = static_cast<uint8_t>(old + keep);
+  state.bytesReceived += view.length;
+  state.updated = FirmataClockSync::hostMicros();
+}
+
+/**
+ * @private
+ */
+void FirmataClient::staticAnalogCallback(void * context, uint8_t command, uint16_t value)
+{
+  static_cast<FirmataClient *>(context)->handleAnalog((command & 0x0F), value);
+}
+
+/**
+ * @private
+ */
+void FirmataClient::staticDigitalCallback(void * context, uint8_t command, uint16_t value)
+{
+  static_cast<FirmataClient *>(context)->handleDigital((command & 0x0F), value);
+}
+
+/**
+ * @private
+ */
+void FirmataClient::staticFirmwareCallback(void * context, size_t sv_major, size_t sv_minor, const char * firmware)
+{
+  static_cast<FirmataClient *>(context)->handleFirmware(sv_major, sv_minor, firmware);
+}
+
+/**
+ * @private
+ */
+void FirmataClient::staticSysexCallback(void * context, uint8_t command, size_t argc, uint8_t * argv)
+{
+  static_cast<FirmataClient *>(context)->handleSysex(command, argc, argv);
+}
+
+/**
+ * Compare the answer of a pin with the snapshot taken by reconcile(), then query the next pin.
+ * @private
+ */
+void FirmataClient::staticReconcileCallback(void * context, const client_completion & completion)
+{
+  FirmataClient * client = static_cast<FirmataClient *>(context);
+  --client->reconcileOutstanding;
+  if ( completion.status == CLIENT_COMPLETED && client->reconcileCallback ) {
+    const pin_state &expected = client->reconcileExpected[completion.pin];
+    const pin_state &actual = client->model.pins[completion.pin];
+    if ( expected.mode != actual.mode || (isHostDriven(expected.mode) && expected.value != actual.value) ) {
+      (*client->reconcileCallback)(client->reconcileCallbackContext, completion.pin, expected, actual);
+    }
+  }
+  client->reconcileNext();
+}
+
+/**
+ * @private
+ */
+void FirmataClient::staticStringCallback(void * context, const char * c_str)
+{
+  FirmataClient * client = static_cast<FirmataClient *>(context);
+  if ( client->stringCallback ) { (*client->stringCallback)(client->stringCallbackContext, c_str); }
+}
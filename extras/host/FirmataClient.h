@@ -0,0 +1,260 @@
+/*
+  FirmataClient.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#ifndef FirmataClient_h
+#define FirmataClient_h
+
+#include <cstddef>
+#include <cstdint>
+
+#include "FirmataConstants.h"
+#include "FirmataMarshaller.h"
+#include "FirmataParser.h"
+#include "FirmataPortLevels.h"
+
+namespace firmata {
+
+/**
+ * What the host knows about one pin of the board. 16 bytes, four pins per cache line; the
+ * resolutions, which are only read when configuring, are kept apart in board_model.
+ */
+struct pin_state {
+  uint32_t value;                        // last value reported by or written to the board
+  uint8_t mode;                          // PIN_MODE_*, PIN_MODE_IGNORE until known
+  uint8_t analogChannel;                 // 0x7F for a pin without analog input
+  uint16_t modes;                        // bit n is set if the pin supports mode n
+  uint64_t updated;                      // [us] host time the mode or value was last reported or set, 0 if never
+};
+
+/**
+ * The last bytes read from or written to a register block of an I2C device.
+ */
+struct i2c_block {
+  static const size_t MAX_DATA = 32;
+
+  uint8_t address;                       // 0xFF for a free entry
+  uint8_t reg;                           // 0 for reads without a register, as StandardFirmata replies
+  uint8_t length;
+  uint8_t data[MAX_DATA];
+  uint64_t updated;                      // [us] host time
+};
+
+/**
+ * A serial port of SerialFirmata (HW_SERIAL0 - 7, SW_SERIAL0 - 3).
+ */
+struct serial_state {
+  static const size_t MAX_DATA = 32;
+
+  bool configured;
+  uint32_t baud;
+  uint64_t bytesReceived;
+  uint64_t bytesSent;
+  uint8_t last[MAX_DATA];                // the last bytes received, oldest first
+  uint8_t lastLength;
+  uint64_t updated;                      // [us] host time of the last bytes received
+};
+
+/**
+ * The mirror of the board, updated from every message the client parses and every command it
+ * sends. All of it is fixed size, so keeping it current never allocates, and every lookup is
+ * an array index (I2C blocks: a short probe of a hash table).
+ */
+struct board_model {
+  static const size_t MAX_PINS = 128;    // pin numbers are 7-bit
+  static const size_t MAX_CHANNELS = 16; // ANALOG_MESSAGE and DIGITAL_MESSAGE carry 4-bit channels
+  static const size_t MAX_I2C_BLOCKS = 64;
+  static const size_t MAX_SERIAL_PORTS = 12;
+
+  bool firmwareKnown;
+  bool capabilitiesKnown;
+  bool analogMappingKnown;
+  uint8_t firmwareMajor;
+  uint8_t firmwareMinor;
+  char firmwareName[64];
+
+  size_t pinCount;                       // from the capability response
+  pin_state pins[MAX_PINS];
+  uint8_t analogPins[MAX_CHANNELS];      // channel -> pin, 0x7F until the mapping is known
+  uint16_t analogValues[MAX_CHANNELS];   // by channel, kept before the mapping is known
+  uint64_t analogUpdated[MAX_CHANNELS];  // [us] host time of the last report of each channel
+  port_levels digitalPorts;              // last reported value of each port
+  uint8_t resolutions[MAX_PINS][TOTAL_PIN_MODES];   // [bits] by pin and mode, from the capability response
+
+  i2c_block i2c[MAX_I2C_BLOCKS];         // open addressing by address and register, see FirmataClient::i2cBlock()
+  serial_state serial[MAX_SERIAL_PORTS];
+};
+
+enum client_request_type {
+  CLIENT_FIRMWARE,
+  CLIENT_CAPABILITIES,
+  CLIENT_ANALOG_MAPPING,
+  CLIENT_PIN_STATE,
+  CLIENT_I2C_READ,
+};
+
+enum client_request_status {
+  CLIENT_COMPLETED,
+  CLIENT_TIMED_OUT,
+  CLIENT_CANCELLED,
+};
+
+/**
+ * The outcome of a request, passed to its completion callback. The data is only valid during
+ * the callback; the rest of the answer is in the board model.
+ */
+struct client_completion {
+  uint16_t id;
+  client_request_type type;
+  client_request_status status;
+  uint8_t pin;            // CLIENT_PIN_STATE
+  uint8_t address;        // CLIENT_I2C_READ
+  int16_t reg;            // CLIENT_I2C_READ, -1 if not specified
+  size_t length;          // CLIENT_I2C_READ: bytes read
+  const uint8_t * data;   // CLIENT_I2C_READ: the bytes read
+  uint32_t latency;       // [us] from sending the request to its completion
+};
+
+/**
+ * Asynchronous host client of one board on top of FirmataParser and FirmataMarshaller.
+ *
+ * Queries return at once with a request id and complete through a callback when the answer is
+ * parsed, when they time out (see update()) or when they are cancelled. Any number of requests
+ * up to MAX_PENDING may be in flight. A query that matches one already in flight (the same
+ * kind, pin, or I2C address, register and length) is not sent again; the answer completes both.
+ * The pending table, the board model and the I2C reply buffer are members, so the client does
+ * not allocate after construction.
+ */
+class FirmataClient
+{
+  public:
+    static const size_t MAX_PENDING = 32;
+    static const size_t MAX_I2C_DATA = 64;    // [bytes] per I2C read
+    static const uint32_t DEFAULT_TIMEOUT = 1000000; // [us]
+
+    typedef void (*completionCallbackFunction)(void * context, const client_completion & completion);
+    typedef void (*pinCallbackFunction)(void * context, uint8_t pin, uint32_t value);
+    typedef void (*stringCallbackFunction)(void * context, const char * c_str);
+    typedef void (*reconcileCallbackFunction)(void * context, uint8_t pin, const pin_state & expected, const pin_state & actual);
+
+    FirmataClient();
+
+    /* connection */
+    void begin(Stream &s);
+    void reconnect(Stream &s);
+    void parse(uint8_t data);
+    void parse(const uint8_t * data, size_t length);
+    void update(void);
+    void setTimeout(uint32_t timeout_us);
+    FirmataParser & parser(void);
+    const FirmataMarshaller & marshaller(void) const;
+
+    /* requests */
+    uint16_t queryFirmware(completionCallbackFunction callback = NULL, void * context = NULL);
+    uint16_t queryCapabilities(completionCallbackFunction callback = NULL, void * context = NULL);
+    uint16_t queryAnalogMapping(completionCallbackFunction callback = NULL, void * context = NULL);
+    uint16_t queryPinState(uint8_t pin, completionCallbackFunction callback = NULL, void * context = NULL);
+    uint16_t readI2C(uint8_t address, int16_t reg, uint8_t length, completionCallbackFunction callback = NULL, void * context = NULL);
+    bool cancel(uint16_t id);
+    void cancelAll(void);
+    bool isPending(uint16_t id) const;
+    size_t pending(void) const;
+
+    /* commands */
+    void setPinMode(uint8_t pin, uint8_t mode);
+    void digitalWrite(uint8_t pin, uint8_t value);
+    void analogWrite(uint8_t pin, uint16_t value);
+    void reportAnalog(uint8_t channel, bool enable);
+    void reportDigitalPort(uint8_t port, bool enable);
+    void setSamplingInterval(uint16_t interval_ms);
+    void configureI2C(uint16_t delay_us = 0);
+    void writeI2C(uint8_t address, int16_t reg, const uint8_t * data, size_t length);
+    void configureSerial(uint8_t port, uint32_t baud);
+    void readSerial(uint8_t port, bool enable = true);
+    void writeSerial(uint8_t port, const uint8_t * data, size_t length);
+
+    /* board model */
+    const board_model & board(void) const;
+    const i2c_block * i2cBlock(uint8_t address, uint8_t reg) const;
+    bool reconcile(reconcileCallbackFunction callback, void * context = NULL);
+    bool reconciling(void) const;
+    void attach(pinCallbackFunction callback, void * context = NULL);
+    void attach(stringCallbackFunction callback, void * context = NULL);
+
+  private:
+    struct pending_request {
+      uint16_t id;                  // 0 for a free slot
+      client_request_type type;
+      uint8_t pin;
+      uint8_t address;
+      int16_t reg;
+      uint8_t length;
+      uint64_t sent;                // [us] host time
+      bool answered;                // picked by complete(), no longer coalesces
+      completionCallbackFunction callback;
+      void * context;
+    };
+
+    uint16_t submit(client_request_type type, uint8_t pin, uint8_t address, int16_t reg, uint8_t length, completionCallbackFunction callback, void * context);
+    bool matches(const pending_request &request, client_request_type type, uint8_t pin, uint8_t address, int16_t reg, uint8_t length) const;
+    void send(const pending_request &request);
+    size_t complete(client_request_type type, uint8_t pin, uint8_t address, int16_t reg, const uint8_t * data, size_t length);
+    void finish(pending_request &request, client_request_status status, const uint8_t * data, size_t length, uint64_t now);
+    void setPinValue(uint8_t pin, uint32_t value, uint64_t now);
+    void resetModel(void);
+    i2c_block * findI2CBlock(uint8_t address, uint8_t reg, bool create);
+    void reconcileNext(void);
+
+    void handleAnalog(uint8_t channel, uint16_t value);
+    void handleDigital(uint8_t port, uint16_t value);
+    void handleFirmware(size_t sv_major, size_t sv_minor, const char * firmware);
+    void handleSysex(uint8_t command, size_t argc, uint8_t * argv);
+    void handleCapabilities(size_t argc, const uint8_t * argv);
+    void handleAnalogMapping(size_t argc, const uint8_t * argv);
+    void handlePinState(size_t argc, const uint8_t * argv);
+    void handleI2CReply(size_t argc, uint8_t * argv);
+    void handleSerialReply(size_t argc, uint8_t * argv);
+
+    static void staticAnalogCallback(void * context, uint8_t command, uint16_t value);
+    static void staticDigitalCallback(void * context, uint8_t command, uint16_t value);
+    static void staticFirmwareCallback(void * context, size_t sv_major, size_t sv_minor, const char * firmware);
+    static void staticSysexCallback(void * context, uint8_t command, size_t argc, uint8_t * argv);
+    static void staticStringCallback(void * context, const char * c_str);
+    static void staticReconcileCallback(void * context, const client_completion & completion);
+
+    uint8_t parserBuffer[1024];     // a capability response of a large board fits
+    FirmataParser firmataParser;
+    FirmataMarshaller firmataMarshaller;
+    Stream * stream;
+
+    board_model model;
+    pending_request requests[MAX_PENDING];
+    size_t pendingCount;
+    uint16_t nextId;
+    uint32_t timeout;
+
+    pinCallbackFunction pinCallback;
+    void * pinCallbackContext;
+    stringCallbackFunction stringCallback;
+    void * stringCallbackContext;
+
+    /* reconcile() */
+    static const size_t RECONCILE_WINDOW = 8;   // pin state queries in flight
+    pin_state reconcileExpected[board_model::MAX_PINS];
+    size_t reconcilePin;                        // next pin to query
+    size_t reconcileOutstanding;
+    reconcileCallbackFunction reconcileCallback;
+    void * reconcileCallbackContext;
+};
+
+} // namespace firmata
+
+#endif /* FirmataClient_h */
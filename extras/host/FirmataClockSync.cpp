@@ -0,0 +1,292 @@
+/*
+  FirmataClockSync.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "FirmataClockSync.h"
+
+#include <chrono>
+#include <cmath>
+
+#include "FirmataConstants.h"
+
+using namespace firmata;
+
+//******************************************************************************
+//* Support Functions
+//******************************************************************************
+
+namespace {
+
+// samples whose delay exceeds max(2 * minimum, minimum + slack) are not used by the fit
+const uint32_t DELAY_SLACK_US = 50;
+
+// the drift is only estimated once the window spans this much device time
+const uint64_t MIN_DRIFT_SPAN_US = 1000000;
+
+// drift beyond this is treated as a measurement error (ceramic resonators reach ~0.5 %)
+const double MAX_DRIFT = 0.01;
+
+} // namespace
+
+//******************************************************************************
+//* Constructors
+//******************************************************************************
+
+/**
+ * The FirmataClockSync class.
+ */
+FirmataClockSync::FirmataClockSync()
+:
+  sequence(0)
+{
+  reset();
+}
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+/**
+ * Route CLOCK_SYNC replies decoded by the parser into this estimator. The host receive time is
+ * taken when the parser completes the reply.
+ * @param parser The parser connected to the target.
+ */
+void FirmataClockSync::attach(FirmataParser &parser)
+{
+  parser.attach(CLOCK_SYNC, staticClockSyncCallback, this);
+}
+
+/**
+ * Send a clock sync request stamped with the current host time.
+ * @param marshaller The marshaller connected to the target.
+ */
+void FirmataClockSync::sendRequest(const FirmataMarshaller &marshaller)
+{
+  sendRequest(marshaller, hostMicros());
+}
+
+/**
+ * Send a clock sync request.
+ * @param marshaller The marshaller connected to the target.
+ * @param host_time_us The host time in microseconds at transmission.
+ */
+void FirmataClockSync::sendRequest(const FirmataMarshaller &marshaller, uint64_t host_time_us)
+{
+  marshaller.sendClockSyncRequest(sequence, static_cast<uint32_t>(host_time_us));
+  sequence = (sequence + 1) & 0x7F;
+}
+
+/**
+ * Add the result of one clock sync exchange and update the estimate.
+ * @param host_transmit_us The host time when the request was sent (t1).
+ * @param device_receive_us The device time when the request was received (t2).
+ * @param device_transmit_us The device time when the reply was sent (t3).
+ * @param host_receive_us The host time when the reply was received (t4).
+ * @return false if the times are inconsistent and the sample was dropped.
+ */
+bool FirmataClockSync::addSample(uint64_t host_transmit_us, uint32_t device_receive_us, uint32_t device_transmit_us, uint64_t host_receive_us)
+{
+  if ( host_receive_us < host_transmit_us ) { return false; }
+
+  const uint64_t round_trip = host_receive_us - host_transmit_us;
+  const uint32_t turnaround = device_transmit_us - device_receive_us;
+  if ( turnaround > round_trip || (round_trip - turnaround) > UINT32_MAX ) { return false; }
+
+  if ( 0 == storedSamples ) { lastDeviceTime = device_receive_us; }
+  sync_sample & sample = samples[sampleIndex];
+  sample.device = unwrapDeviceTime(device_receive_us) + (turnaround / 2);
+  sample.host = host_transmit_us + (round_trip / 2);
+  sample.delay = static_cast<uint32_t>(round_trip - turnaround);
+  lastDeviceTime = sample.device;
+
+  sampleIndex = (sampleIndex + 1) % WINDOW_SIZE;
+  if ( storedSamples < WINDOW_SIZE ) { ++storedSamples; }
+  fit();
+  return true;
+}
+
+/**
+ * Discard all samples, for example after the target has been reset.
+ */
+void FirmataClockSync::reset(void)
+{
+  sampleIndex = 0;
+  storedSamples = 0;
+  lastDeviceTime = 0;
+  deviceRef = 0;
+  hostRef = 0;
+  slope = 1.0;
+  minDelay = 0;
+}
+
+/**
+ * @return Returns true once at least one exchange has completed.
+ */
+bool FirmataClockSync::isValid(void)
+const
+{
+  return (storedSamples > 0);
+}
+
+/**
+ * @return The number of exchanges in the sliding window.
+ */
+size_t FirmataClockSync::sampleCount(void)
+const
+{
+  return storedSamples;
+}
+
+/**
+ * @return The rate error of the device clock in parts per million (positive if the device
+ * clock runs slow compared to the host clock).
+ */
+double FirmataClockSync::driftPpm(void)
+const
+{
+  return ((slope - 1.0) * 1e6);
+}
+
+/**
+ * @return The host time minus the device time at the most recent reference point, in
+ * microseconds.
+ */
+int64_t FirmataClockSync::offset(void)
+const
+{
+  return static_cast<int64_t>(hostRef - deviceRef);
+}
+
+/**
+ * @return The smallest round trip delay in the window. Half of it bounds the error of the
+ * estimate caused by an asymmetric transport.
+ */
+uint32_t FirmataClockSync::minRoundTripDelay(void)
+const
+{
+  return minDelay;
+}
+
+/**
+ * Map a 32-bit device time (such as a TIMESTAMP_DATA value) onto the host clock.
+ * @param device_time_us The device micros() value.
+ * @return The corresponding host time in microseconds.
+ * @note The device time must lie within 35 minutes of the most recent exchange.
+ */
+uint64_t FirmataClockSync::toHostTime(uint32_t device_time_us)
+const
+{
+  return toHostTime64(unwrapDeviceTime(device_time_us));
+}
+
+/**
+ * Map an unwrapped 64-bit device time onto the host clock.
+ * @param device_time_us The unwrapped device time.
+ * @return The corresponding host time in microseconds.
+ */
+uint64_t FirmataClockSync::toHostTime64(uint64_t device_time_us)
+const
+{
+  const int64_t since_ref = static_cast<int64_t>(device_time_us - deviceRef);
+  return (hostRef + static_cast<int64_t>(std::llround(slope * static_cast<double>(since_ref))));
+}
+
+/**
+ * Extend a 32-bit device time, which wraps every 71 minutes, to 64 bits using the most recent
+ * exchange as reference.
+ * @param device_time_us The device micros() value.
+ * @return The unwrapped device time.
+ */
+uint64_t FirmataClockSync::unwrapDeviceTime(uint32_t device_time_us)
+const
+{
+  const int32_t delta = static_cast<int32_t>(device_time_us - static_cast<uint32_t>(lastDeviceTime));
+  return (lastDeviceTime + static_cast<int64_t>(delta));
+}
+
+/**
+ * @return A monotonic host time in microseconds.
+ */
+uint64_t FirmataClockSync::hostMicros(void)
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+/**
+ * Fit host = hostRef + slope * (device - deviceRef) through the low-delay samples of the window.
+ * Values are taken relative to the first accepted sample so the doubles keep full precision.
+ * @private
+ */
+void FirmataClockSync::fit(void)
+{
+  size_t i;
+
+  minDelay = UINT32_MAX;
+  for (i = 0; i < storedSamples; ++i) {
+    if ( samples[i].delay < minDelay ) { minDelay = samples[i].delay; }
+  }
+  const uint32_t threshold = ((minDelay > DELAY_SLACK_US) ? (2 * minDelay) : (minDelay + DELAY_SLACK_US));
+
+  const sync_sample * base = NULL;
+  double sum_x = 0, sum_y = 0;
+  size_t accepted = 0;
+  uint64_t first_device = UINT64_MAX, last_device = 0;
+  for (i = 0; i < storedSamples; ++i) {
+    if ( samples[i].delay > threshold ) { continue; }
+    if ( !base ) { base = &samples[i]; }
+    sum_x += static_cast<double>(static_cast<int64_t>(samples[i].device - base->device));
+    sum_y += static_cast<double>(static_cast<int64_t>(samples[i].host - base->host));
+    if ( samples[i].device < first_device ) { first_device = samples[i].device; }
+    if ( samples[i].device > last_device ) { last_device = samples[i].device; }
+    ++accepted;
+  }
+
+  const double mean_x = (sum_x / accepted);
+  const double mean_y = (sum_y / accepted);
+  double sxx = 0, sxy = 0;
+  for (i = 0; i < storedSamples; ++i) {
+    if ( samples[i].delay > threshold ) { continue; }
+    const double dx = static_cast<double>(static_cast<int64_t>(samples[i].device - base->device)) - mean_x;
+    const double dy = static_cast<double>(static_cast<int64_t>(samples[i].host - base->host)) - mean_y;
+    sxx += (dx * dx);
+    sxy += (dx * dy);
+  }
+
+  slope = 1.0;
+  if ( accepted > 1 && (last_device - first_device) >= MIN_DRIFT_SPAN_US && sxx > 0 ) {
+    const double fitted = (sxy / sxx);
+    if ( std::fabs(fitted - 1.0) <= MAX_DRIFT ) { slope = fitted; }
+  }
+  deviceRef = base->device + static_cast<int64_t>(std::llround(mean_x));
+  hostRef = base->host + static_cast<int64_t>(std::llround(mean_y));
+}
+
+/**
+ * Parser callback for CLOCK_SYNC messages. The host transmit time is recovered from the 32-bit
+ * echo relative to the receive time, so replies to any request can be used.
+ * @private
+ */
+void FirmataClockSync::staticClockSyncCallback (void * context, uint8_t command, uint8_t, uint32_t host_time, uint32_t receive_time, uint32_t transmit_time)
+{
+  if ( !context || CLOCK_SYNC_REPLY != command ) { return; }
+
+  const uint64_t host_receive = hostMicros();
+  const uint64_t host_transmit = host_receive - static_cast<uint32_t>(static_cast<uint32_t>(host_receive) - host_time);
+  static_cast<FirmataClockSync *>(context)->addSample(host_transmit, receive_time, transmit_time, host_receive);
+}
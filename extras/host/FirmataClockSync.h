@@ -0,0 +1,95 @@
+/*
+  FirmataClockSync.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#ifndef FirmataClockSync_h
+#define FirmataClockSync_h
+
+#include <cstddef>
+#include <cstdint>
+
+#include "FirmataMarshaller.h"
+#include "FirmataParser.h"
+
+namespace firmata {
+
+/**
+ * Host side estimator that maps device micros() values onto the host clock.
+ *
+ * Each CLOCK_SYNC exchange yields the four NTP times t1 (host transmit), t2 (device receive),
+ * t3 (device transmit) and t4 (host receive). The midpoint of the device times is paired with
+ * the midpoint of the host times, and the round trip delay ((t4 - t1) - (t3 - t2)) bounds the
+ * error of that pair. A least squares line through the low-delay pairs of a sliding window gives
+ * the offset and the drift of the device clock.
+ *
+ * The midpoint assumes the same delay in both directions. Requests are padded to the length of
+ * a reply, so the serialization time cancels out. What remains is a bias of half the difference
+ * between the two waits: the request waits in the receive buffer of the device until loop()
+ * parses it (t2 is late, up to one loop() period), and the reply waits behind output already in
+ * the transmit buffer (t3 is early). USB serial adapters add their own buffering, which may
+ * differ by direction. The low-delay filter keeps the exchanges where both waits were short;
+ * the error of the estimate stays within half of minRoundTripDelay().
+ */
+class FirmataClockSync
+{
+  public:
+    static const size_t WINDOW_SIZE = 32; // number of exchanges used by the estimate
+
+    FirmataClockSync();
+
+    /* protocol */
+    void attach(FirmataParser &parser);
+    void sendRequest(const FirmataMarshaller &marshaller);
+    void sendRequest(const FirmataMarshaller &marshaller, uint64_t host_time_us);
+
+    /* estimator */
+    bool addSample(uint64_t host_transmit_us, uint32_t device_receive_us, uint32_t device_transmit_us, uint64_t host_receive_us);
+    void reset(void);
+
+    /* results */
+    bool isValid(void) const;
+    size_t sampleCount(void) const;
+    double driftPpm(void) const;
+    int64_t offset(void) const;
+    uint32_t minRoundTripDelay(void) const;
+    uint64_t toHostTime(uint32_t device_time_us) const;
+    uint64_t toHostTime64(uint64_t device_time_us) const;
+    uint64_t unwrapDeviceTime(uint32_t device_time_us) const;
+
+    static uint64_t hostMicros(void);
+
+  private:
+    struct sync_sample {
+      uint64_t device; // midpoint of the device receive and transmit times (unwrapped)
+      uint64_t host;   // midpoint of the host transmit and receive times
+      uint32_t delay;  // round trip delay without the device turnaround time
+    };
+
+    sync_sample samples[WINDOW_SIZE];
+    size_t sampleIndex;
+    size_t storedSamples;
+    uint64_t lastDeviceTime;
+    uint8_t sequence;
+
+    /* fitted line: host = hostRef + slope * (device - deviceRef) */
+    uint64_t deviceRef;
+    uint64_t hostRef;
+    double slope;
+    uint32_t minDelay;
+
+    void fit(void);
+
+    static void staticClockSyncCallback (void * context, uint8_t command, uint8_t sequence, uint32_t host_time, uint32_t receive_time, uint32_t transmit_time);
+};
+
+} // namespace firmata
+
+#endif /* FirmataClockSync_h */
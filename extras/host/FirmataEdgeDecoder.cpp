@@ -0,0 +1,297 @@
+/*
+  FirmataEdgeDecoder.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "FirmataEdgeDecoder.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "FirmataClockSync.h"
+#include "FirmataConstants.h"
+
+using namespace firmata;
+
+//******************************************************************************
+//* Support Functions
+//******************************************************************************
+
+namespace {
+
+#if !defined(__SSE2__)
+/**
+ * Transpose an 8x8 bit matrix, one row per byte (Hacker's Delight, 7-3): afterwards byte b
+ * holds bit b of each of the 8 bytes before, bit j from byte j.
+ */
+uint64_t transpose8(uint64_t x)
+{
+  uint64_t t;
+  t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+  x = x ^ t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+  x = x ^ t ^ (t << 14);
+  t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+  x = x ^ t ^ (t << 28);
+  return x;
+}
+#endif
+
+/**
+ * Transpose 16 port values into the history of each of their 8 pins.
+ * @param values 16 values of a port, oldest first.
+ * @param histories Set to bit j = the level of the pin in value j, by pin.
+ */
+void transpose16(const uint8_t * values, uint16_t * histories)
+{
+#if defined(__SSE2__)
+  // movemask gathers the top bit of each byte; doubling each byte brings the next bit up
+  __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+  for (int bit = 7; bit >= 0; --bit) {
+    histories[bit] = static_cast<uint16_t>(_mm_movemask_epi8(x));
+    x = _mm_add_epi8(x, x);
+  }
+#else
+  uint64_t low;
+  uint64_t high;
+  std::memcpy(&low, values, sizeof(low));
+  std::memcpy(&high, values + 8, sizeof(high));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  low = __builtin_bswap64(low);
+  high = __builtin_bswap64(high);
+#endif
+  low = transpose8(low);
+  high = transpose8(high);
+  for (int bit = 0; bit < 8; ++bit) {
+    histories[bit] = static_cast<uint16_t>(((low >> (8 * bit)) & 0xFF) | (((high >> (8 * bit)) & 0xFF) << 8));
+  }
+#endif
+}
+
+} // namespace
+
+//******************************************************************************
+//* Constructors
+//******************************************************************************
+
+/**
+ * The FirmataEdgeDecoder class. All buffers are reserved here, so decoding batches does not
+ * allocate.
+ * @param capacity The number of reports in a batch.
+ */
+FirmataEdgeDecoder::FirmataEdgeDecoder(size_t capacity)
+:
+  batchSize(0),
+  edgeCallback(NULL),
+  edgeCallbackContext(NULL)
+{
+  if ( capacity == 0 ) { capacity = 1; }
+  batchTimes.resize(capacity);
+  batchPorts.resize(capacity);
+  batchValues.resize(capacity);
+  // every port may need one partial chunk
+  const size_t padded = capacity + PORTS * (CHUNK - 1);
+  sortedTimes.reserve(padded);
+  sortedValues.reserve(padded);
+  histories.reserve(padded / CHUNK * 8);
+  changes.reserve(padded / CHUNK * 8);
+  edges.times.reserve(capacity * 8);
+  edges.levels.reserve(capacity * 8);
+  std::memset(edges.offsets, 0, sizeof(edges.offsets));
+  levels.reset();
+}
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+/**
+ * Collect the DIGITAL_MESSAGE reports a parser decodes, stamped with the host time. This
+ * replaces the callback of the parser for DIGITAL_MESSAGE.
+ * @param parser The parser of the board stream.
+ */
+void FirmataEdgeDecoder::attach(FirmataParser &parser)
+{
+  parser.attach(DIGITAL_MESSAGE, staticDigitalCallback, this);
+}
+
+/**
+ * Attach a callback for the edges of each batch, decoded when the batch is full or flushed.
+ * @param callback The callback, NULL to detach.
+ * @param context An optional context to be provided to the callback function.
+ */
+void FirmataEdgeDecoder::attach(edgeCallbackFunction callback, void * context)
+{
+  edgeCallback = callback;
+  edgeCallbackContext = context;
+}
+
+/**
+ * Add a report to the batch, decoding the batch first if it is full.
+ * @param port The port (0 - 15).
+ * @param value The value of the port.
+ * @param time [us] The time of the report.
+ */
+void FirmataEdgeDecoder::add(uint8_t port, uint8_t value, uint64_t time)
+{
+  if ( batchSize == batchTimes.size() ) { flush(); }
+  batchTimes[batchSize] = time;
+  batchPorts[batchSize] = port & 0x0F;
+  batchValues[batchSize] = value;
+  ++batchSize;
+}
+
+/**
+ * Decode the reports of the batch and start a new one. The first report of a port only sets
+ * its levels, later ones are compared with the last report, also across batches.
+ * @return The edges of the batch, valid until the next batch is decoded.
+ */
+const edge_streams & FirmataEdgeDecoder::flush(void)
+{
+  decode();
+  batchSize = 0;
+  if ( edgeCallback ) { (*edgeCallback)(edgeCallbackContext, edges); }
+  return edges;
+}
+
+/**
+ * Drop the batch and forget the levels of the ports, e.g. after a reconnect.
+ */
+void FirmataEdgeDecoder::reset(void)
+{
+  batchSize = 0;
+  levels.reset();
+}
+
+/**
+ * @return The number of reports in the batch.
+ */
+size_t FirmataEdgeDecoder::size(void)
+const
+{
+  return batchSize;
+}
+
+/**
+ * @return The number of reports in a batch.
+ */
+size_t FirmataEdgeDecoder::capacity(void)
+const
+{
+  return batchTimes.size();
+}
+
+/**
+ * @param port The port (0 - 15).
+ * @return The value of the last decoded report of the port.
+ */
+uint8_t FirmataEdgeDecoder::level(uint8_t port)
+const
+{
+  return levels.values[port & 0x0F];
+}
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+/**
+ * Group the batch by port, transpose it chunk by chunk, count the edges of each pin, then
+ * write them to their place in edges.
+ * @private
+ */
+void FirmataEdgeDecoder::decode(void)
+{
+  // counting sort by port; each port starts on a chunk and its last chunk is padded with its
+  // last value, which adds no edges
+  size_t counts[PORTS] = { 0 };
+  for (size_t i = 0; i < batchSize; ++i) {
+    ++counts[batchPorts[i]];
+  }
+  size_t starts[PORTS + 1];
+  starts[0] = 0;
+  for (size_t port = 0; port < PORTS; ++port) {
+    starts[port + 1] = starts[port] + (counts[port] + CHUNK - 1) / CHUNK * CHUNK;
+  }
+  sortedTimes.resize(starts[PORTS]);
+  sortedValues.resize(starts[PORTS]);
+  size_t cursors[PORTS];
+  std::memcpy(cursors, starts, sizeof(cursors));
+  for (size_t i = 0; i < batchSize; ++i) {
+    const size_t k = cursors[batchPorts[i]]++;
+    sortedTimes[k] = batchTimes[i];
+    sortedValues[k] = batchValues[i];
+  }
+  for (size_t port = 0; port < PORTS; ++port) {
+    if ( cursors[port] > starts[port] ) {
+      std::memset(&sortedValues[cursors[port]], sortedValues[cursors[port] - 1], starts[port + 1] - cursors[port]);
+    }
+  }
+
+  // pass 1: the history and the edges of each pin, chunk by chunk
+  histories.resize(starts[PORTS] / CHUNK * 8);
+  changes.resize(starts[PORTS] / CHUNK * 8);
+  uint32_t pinCounts[edge_streams::MAX_PINS] = { 0 };
+  for (size_t port = 0; port < PORTS; ++port) {
+    if ( !counts[port] ) { continue; }
+    uint8_t previous = (levels.isKnown(port) ? levels.values[port] : sortedValues[starts[port]]);
+    for (size_t chunk = starts[port] / CHUNK; chunk < starts[port + 1] / CHUNK; ++chunk) {
+      uint16_t * history = &histories[chunk * 8];
+      uint16_t * change = &changes[chunk * 8];
+      transpose16(&sortedValues[chunk * CHUNK], history);
+      for (size_t bit = 0; bit < 8; ++bit) {
+        const uint16_t before = static_cast<uint16_t>((history[bit] << 1) | ((previous >> bit) & 0x01));
+        change[bit] = history[bit] ^ before;
+        pinCounts[port * 8 + bit] += __builtin_popcount(change[bit]);
+      }
+      previous = sortedValues[chunk * CHUNK + CHUNK - 1];
+    }
+    levels.update(port, previous);
+  }
+
+  // pass 2: the edges of each pin in order of time
+  edges.offsets[0] = 0;
+  for (size_t pin = 0; pin < edge_streams::MAX_PINS; ++pin) {
+    edges.offsets[pin + 1] = edges.offsets[pin] + pinCounts[pin];
+  }
+  edges.times.resize(edges.offsets[edge_streams::MAX_PINS]);
+  edges.levels.resize(edges.offsets[edge_streams::MAX_PINS]);
+  for (size_t port = 0; port < PORTS; ++port) {
+    for (size_t bit = 0; bit < 8; ++bit) {
+      const size_t pin = port * 8 + bit;
+      if ( !pinCounts[pin] ) { continue; }
+      uint32_t out = edges.offsets[pin];
+      for (size_t chunk = starts[port] / CHUNK; chunk < starts[port + 1] / CHUNK; ++chunk) {
+        const uint16_t history = histories[chunk * 8 + bit];
+        for (uint32_t mask = changes[chunk * 8 + bit]; mask; mask &= (mask - 1)) {
+          const int j = __builtin_ctz(mask);
+          edges.times[out] = sortedTimes[chunk * CHUNK + j];
+          edges.levels[out] = static_cast<uint8_t>((history >> j) & 0x01);
+          ++out;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @private
+ */
+void FirmataEdgeDecoder::staticDigitalCallback(void * context, uint8_t command, uint16_t value)
+{
+  static_cast<FirmataEdgeDecoder *>(context)->add((command & 0x0F), static_cast<uint8_t>(value), FirmataClockSync::hostMicros());
+}
@@ -0,0 +1,102 @@
+/*
+  FirmataEdgeDecoder.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Batch decoding of DIGITAL_MESSAGE port reports into the edges of each pin.
+  Reports are collected as they are parsed, with the host time, and decoded
+  a batch at a time: the reports are grouped by port, and 16 reports of a
+  port are transposed at once into one 16-bit history per pin (SSE2
+  movemask, or two 8x8 bit matrix transpositions on other hosts). The edges
+  of a pin are then the set bits of its history xor the history shifted by
+  one report, counted with popcount and emitted with count trailing zeros.
+
+  The edges come out as structure of arrays, grouped by pin:
+
+    offsets   the edges of pin p are [offsets[p], offsets[p + 1])
+    times     [us] host time of the report with the new level
+    levels    1 for a rising edge, 0 for a falling one
+
+  so that analytics run over plain arrays of one type.
+*/
+
+#ifndef FirmataEdgeDecoder_h
+#define FirmataEdgeDecoder_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "FirmataParser.h"
+#include "FirmataPortLevels.h"
+
+namespace firmata {
+
+/**
+ * The edges of one batch, see the comment at the top of this file.
+ */
+struct edge_streams {
+  static const size_t MAX_PINS = 128;    // 16 ports of 8 pins
+
+  uint32_t offsets[MAX_PINS + 1];
+  std::vector<uint64_t> times;
+  std::vector<uint8_t> levels;
+
+  size_t count(uint8_t pin) const { return offsets[pin + 1] - offsets[pin]; }
+  size_t size(void) const { return offsets[MAX_PINS]; }
+};
+
+class FirmataEdgeDecoder
+{
+  public:
+    typedef void (*edgeCallbackFunction)(void * context, const edge_streams & edges);
+
+    explicit FirmataEdgeDecoder(size_t capacity = 4096);
+
+    void attach(FirmataParser &parser);
+    void attach(edgeCallbackFunction callback, void * context = NULL);
+
+    void add(uint8_t port, uint8_t value, uint64_t time);
+    const edge_streams & flush(void);
+    void reset(void);
+
+    size_t size(void) const;
+    size_t capacity(void) const;
+    uint8_t level(uint8_t port) const;
+
+  private:
+    static const size_t PORTS = port_levels::PORTS;
+    static const size_t CHUNK = 16;      // reports transposed at once
+
+    void decode(void);
+
+    static void staticDigitalCallback(void * context, uint8_t command, uint16_t value);
+
+    /* the batch, in order of arrival */
+    std::vector<uint64_t> batchTimes;
+    std::vector<uint8_t> batchPorts;
+    std::vector<uint8_t> batchValues;
+    size_t batchSize;
+
+    /* the batch grouped by port, each port padded to whole chunks */
+    std::vector<uint64_t> sortedTimes;
+    std::vector<uint8_t> sortedValues;
+    std::vector<uint16_t> histories;     // per chunk, 8 pins
+    std::vector<uint16_t> changes;       // per chunk, 8 pins
+
+    port_levels levels;                  // the last decoded report of each port
+
+    edge_streams edges;
+    edgeCallbackFunction edgeCallback;
+    void * edgeCallbackContext;
+};
+
+} // namespace firmata
+
+#endif /* FirmataEdgeDecoder_h */
@@ -0,0 +1,772 @@
+/*
+  FirmataEngine.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "FirmataEngine.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "FirmataClockSync.h"
+
+using namespace firmata;
+
+//******************************************************************************
+//* Support Functions
+//******************************************************************************
+
+namespace {
+
+const size_t MAX_EVENTS = 64;
+const uint8_t SYSEX_DATA = 0xFF;    // a sysex takes data bytes up to END_SYSEX
+
+/**
+ * @return The number of data bytes that follow a command byte sent to a board.
+ */
+uint8_t dataBytes(uint8_t command)
+{
+  if ( command == START_SYSEX ) { return SYSEX_DATA; }
+  if ( command == SET_PIN_MODE || command == SET_DIGITAL_PIN_VALUE ) { return 2; }
+  if ( command >= 0xF0 ) { return 0; }    // REPORT_VERSION and SYSTEM_RESET queries
+  const uint8_t message = command & 0xF0;
+  return ((message == REPORT_ANALOG || message == REPORT_DIGITAL) ? 1 : 2);
+}
+
+bool setNonBlocking(int fd)
+{
+  const int flags = ::fcntl(fd, F_GETFL);
+  return (flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0);
+}
+
+speed_t baudConstant(uint32_t baud)
+{
+  switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+#ifdef B460800
+    case 460800: return B460800;
+#endif
+#ifdef B921600
+    case 921600: return B921600;
+#endif
+    default: return B0;
+  }
+}
+
+} // namespace
+
+//******************************************************************************
+//* FirmataEngineBoard
+//******************************************************************************
+
+/**
+ * The FirmataEngineBoard class. Boards are created by their shard.
+ * @private
+ */
+FirmataEngineBoard::FirmataEngineBoard(FirmataEngineShard &shard, uint64_t id, int fd, void * user)
+:
+  user(user),
+  owner(shard),
+  serial(id),
+  descriptor(fd),
+  head(0),
+  used(0),
+  partial(0),
+  expected(0),
+  discarding(false),
+  dirty(false),
+  writable(true),
+  received(0),
+  sent(0),
+  dropped(0),
+  droppedMessages(0)
+{
+  client.begin(*this);
+}
+
+/**
+ * @return The file descriptor of the board, -1 once it is closed.
+ */
+int FirmataEngineBoard::fd(void)
+const
+{
+  return descriptor;
+}
+
+/**
+ * @return The index of the shard that owns the board.
+ */
+size_t FirmataEngineBoard::shard(void)
+const
+{
+  return owner.index;
+}
+
+/**
+ * @return The id of the board, unique within its shard. Unlike the address of the board, it is
+ * not reused by a later board.
+ */
+uint64_t FirmataEngineBoard::id(void)
+const
+{
+  return serial;
+}
+
+/**
+ * @return The number of bytes read from the board.
+ */
+uint64_t FirmataEngineBoard::bytesRead(void)
+const
+{
+  return received;
+}
+
+/**
+ * @return The number of bytes written to the board.
+ */
+uint64_t FirmataEngineBoard::bytesWritten(void)
+const
+{
+  return sent;
+}
+
+/**
+ * @return The number of bytes dropped because the output ring was full while the board did not
+ * keep up.
+ */
+uint64_t FirmataEngineBoard::bytesDropped(void)
+const
+{
+  return dropped;
+}
+
+/**
+ * @return The number of messages dropped whole because the output ring was full.
+ */
+uint64_t FirmataEngineBoard::messagesDropped(void)
+const
+{
+  return droppedMessages;
+}
+
+/**
+ * @return The number of bytes waiting in the output ring.
+ */
+size_t FirmataEngineBoard::pendingOutput(void)
+const
+{
+  return used;
+}
+
+/**
+ * The input is pushed to the client by the shard; there is nothing to read.
+ */
+int FirmataEngineBoard::available(void)
+{
+  return 0;
+}
+
+int FirmataEngineBoard::read(void)
+{
+  return -1;
+}
+
+int FirmataEngineBoard::peek(void)
+{
+  return -1;
+}
+
+/**
+ * Append a byte to the output ring. The shard sends it at the end of the event loop iteration.
+ * @param c The byte.
+ * @return 1, or 0 if the ring is full and the board does not take more.
+ */
+size_t FirmataEngineBoard::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+/**
+ * Append bytes to the output ring. The shard sends them at the end of the event loop iteration.
+ * The bytes of a message are only sent once the message is complete. A message that does not fit
+ * is dropped whole: the bytes of it already in the ring are taken back and the rest is skipped.
+ * @param buffer The bytes.
+ * @param size The number of bytes.
+ * @return The number of bytes taken.
+ */
+size_t FirmataEngineBoard::write(const uint8_t * buffer, size_t size)
+{
+  if ( descriptor < 0 ) { return 0; }
+  size_t n = 0;
+  for (size_t i = 0; i < size; ++i) {
+    const uint8_t c = buffer[i];
+    const bool command = ((c & 0x80) && c != END_SYSEX);
+    if ( command ) {
+      // a message left unfinished by the caller goes out as it is
+      partial = 0;
+      discarding = false;
+    }
+    if ( discarding ) {
+      ++dropped;
+      continue;
+    }
+    if ( used == OUTPUT_CAPACITY && writable ) {
+      // make room now rather than drop
+      flushOutput();
+    }
+    if ( used == OUTPUT_CAPACITY ) {
+      // the message is taken back, also its bytes of earlier calls
+      n -= std::min(n, partial);
+      used -= partial;
+      dropped += partial + 1;
+      ++droppedMessages;
+      partial = 0;
+      discarding = true;
+      continue;
+    }
+    output[(head + used) % OUTPUT_CAPACITY] = c;
+    ++used;
+    ++partial;
+    ++n;
+    if ( command ) {
+      expected = dataBytes(c);
+    } else if ( expected == SYSEX_DATA ) {
+      if ( c == END_SYSEX ) { expected = 0; }
+    } else if ( expected ) {
+      --expected;
+    }
+    if ( !expected ) { partial = 0; }
+  }
+  if ( n && !dirty ) { owner.markDirty(this); }
+  return n;
+}
+
+/**
+ * @return The free space of the output ring.
+ */
+int FirmataEngineBoard::availableForWrite(void)
+{
+  return static_cast<int>(OUTPUT_CAPACITY - used);
+}
+
+/**
+ * Send the output ring now instead of at the end of the event loop iteration.
+ */
+void FirmataEngineBoard::flush(void)
+{
+  if ( descriptor >= 0 && writable ) { flushOutput(); }
+}
+
+/**
+ * Send as much of the output ring as the descriptor takes, both parts of a wrapped ring in one
+ * writev(). An unfinished message at the end of the ring is kept back.
+ * @return 1 if all complete messages are sent, 0 if the descriptor is full, -1 on an error.
+ * @private
+ */
+int FirmataEngineBoard::flushOutput(void)
+{
+  while ( used > partial ) {
+    struct iovec iov[2];
+    const size_t ready = used - partial;
+    const size_t first = std::min(ready, OUTPUT_CAPACITY - head);
+    iov[0].iov_base = output + head;
+    iov[0].iov_len = first;
+    iov[1].iov_base = output;
+    iov[1].iov_len = ready - first;
+    const ssize_t n = ::writev(descriptor, iov, (iov[1].iov_len ? 2 : 1));
+    if ( n > 0 ) {
+      head = (head + n) % OUTPUT_CAPACITY;
+      used -= n;
+      sent += n;
+    } else if ( n < 0 && errno == EINTR ) {
+      continue;
+    } else if ( n < 0 && errno == EAGAIN ) {
+      return 0;
+    } else {
+      return -1;
+    }
+  }
+  if ( !used ) { head = 0; }
+  return 1;
+}
+
+//******************************************************************************
+//* FirmataEngine
+//******************************************************************************
+
+/**
+ * The FirmataEngine class.
+ * @param shard_count The number of worker threads, 0 for one per hardware thread.
+ */
+FirmataEngine::FirmataEngine(size_t shard_count)
+:
+  nextShard(0),
+  boardCount(0),
+  boardCallback(NULL),
+  boardCallbackContext(NULL),
+  running(false)
+{
+  if ( shard_count == 0 ) {
+    shard_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (size_t i = 0; i < shard_count; ++i) {
+    shardList.push_back(std::unique_ptr<FirmataEngineShard>(new FirmataEngineShard(*this, i)));
+  }
+}
+
+FirmataEngine::~FirmataEngine()
+{
+  stop();
+}
+
+/**
+ * Attach the callback for boards being added and closed. It runs on the thread of the shard of
+ * the board, so it may use the board. Attach it before start().
+ * @param callback The callback.
+ * @param context An optional context to be provided to the callback function.
+ */
+void FirmataEngine::attach(boardCallbackFunction callback, void * context)
+{
+  boardCallback = callback;
+  boardCallbackContext = context;
+}
+
+/**
+ * Start the worker threads.
+ * @return false if a shard cannot create its epoll instance.
+ */
+bool FirmataEngine::start(void)
+{
+  if ( running ) { return true; }
+  for (size_t i = 0; i < shardList.size(); ++i) {
+    if ( !shardList[i]->start() ) {
+      stop();
+      return false;
+    }
+  }
+  running = true;
+  return true;
+}
+
+/**
+ * Stop and join the worker threads. The boards stay open until the engine is destroyed.
+ */
+void FirmataEngine::stop(void)
+{
+  for (size_t i = 0; i < shardList.size(); ++i) {
+    shardList[i]->stop();
+  }
+  running = false;
+}
+
+/**
+ * Hand a descriptor to the engine, which makes it non-blocking and closes it with the board.
+ * The boards are spread over the shards round robin. Safe to call from any thread, before or
+ * after start().
+ * @param fd A serial port, pty or socket connected to a board.
+ * @param user An optional pointer kept in FirmataEngineBoard::user.
+ * @return false if the descriptor cannot be made non-blocking.
+ */
+bool FirmataEngine::add(int fd, void * user)
+{
+  if ( fd < 0 || !setNonBlocking(fd) ) { return false; }
+  const size_t shard = nextShard.fetch_add(1) % shardList.size();
+  return shardList[shard]->enqueue(fd, user);
+}
+
+/**
+ * Run a task on the thread of the shard of a board, e.g. to send to it from another thread.
+ * Tasks for a board that is closed by then are dropped.
+ * @param board The board.
+ * @param task The task.
+ * @param context An optional context to be provided to the task.
+ * @return false if the inbox of the shard cannot be woken.
+ */
+bool FirmataEngine::post(FirmataEngineBoard &board, taskFunction task, void * context)
+{
+  return board.owner.enqueue(board, task, context);
+}
+
+/**
+ * @return The number of shards.
+ */
+size_t FirmataEngine::shards(void)
+const
+{
+  return shardList.size();
+}
+
+/**
+ * @return The number of open boards.
+ */
+size_t FirmataEngine::boards(void)
+const
+{
+  return boardCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * Open a serial port (or pty) in raw mode.
+ * @param path The device.
+ * @param baud The baud rate; ignored by ptys.
+ * @return The descriptor, -1 on an error or an unsupported baud rate.
+ */
+int FirmataEngine::openSerial(const char * path, uint32_t baud)
+{
+  const speed_t speed = baudConstant(baud);
+  if ( speed == B0 ) { return -1; }
+  const int fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if ( fd < 0 ) { return -1; }
+  struct termios tio;
+  if ( ::tcgetattr(fd, &tio) == 0 ) {
+    ::cfmakeraw(&tio);
+    tio.c_cflag |= (CLOCAL | CREAD);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    ::cfsetispeed(&tio, speed);
+    ::cfsetospeed(&tio, speed);
+    ::tcsetattr(fd, TCSANOW, &tio);
+  }
+  return fd;
+}
+
+/**
+ * Connect to a board behind a TCP bridge (e.g. an ESP8266 running StandardFirmataWiFi).
+ * @param host The host name or address.
+ * @param port The port.
+ * @return The connected socket with Nagle's algorithm off, -1 on an error.
+ */
+int FirmataEngine::connectTcp(const char * host, uint16_t port)
+{
+  struct addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  char service[8];
+  std::snprintf(service, sizeof(service), "%u", port);
+  struct addrinfo * addresses = NULL;
+  if ( ::getaddrinfo(host, service, &hints, &addresses) != 0 ) { return -1; }
+
+  int fd = -1;
+  for (struct addrinfo * a = addresses; a; a = a->ai_next) {
+    fd = ::socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+    if ( fd < 0 ) { continue; }
+    if ( ::connect(fd, a->ai_addr, a->ai_addrlen) == 0 ) { break; }
+    ::close(fd);
+    fd = -1;
+  }
+  ::freeaddrinfo(addresses);
+  if ( fd >= 0 ) {
+    const int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+  return fd;
+}
+
+//******************************************************************************
+//* FirmataEngineShard
+//******************************************************************************
+
+/**
+ * The FirmataEngineShard class.
+ */
+FirmataEngineShard::FirmataEngineShard(FirmataEngine &engine, size_t index)
+:
+  engine(engine),
+  index(index),
+  epollFd(-1),
+  wakeFd(-1),
+  stopping(false),
+  nextId(1),
+  readBuffer(new uint8_t[READ_CHUNK]),
+  lastTick(0)
+{
+}
+
+FirmataEngineShard::~FirmataEngineShard()
+{
+  stop();
+  for (size_t i = 0; i < boardList.size(); ++i) {
+    ::close(boardList[i]->descriptor);
+  }
+  for (size_t i = 0; i < inbox.size(); ++i) {
+    if ( inbox[i].fd >= 0 ) { ::close(inbox[i].fd); }
+  }
+  if ( wakeFd >= 0 ) { ::close(wakeFd); }
+  if ( epollFd >= 0 ) { ::close(epollFd); }
+}
+
+/**
+ * Create the epoll instance on the first start and run the worker thread.
+ * @return false if the epoll instance or the eventfd cannot be created.
+ */
+bool FirmataEngineShard::start(void)
+{
+  if ( epollFd < 0 ) {
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ( epollFd < 0 || wakeFd < 0 ) { return false; }
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if ( ::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) != 0 ) { return false; }
+  }
+  stopping = false;
+  thread = std::thread(&FirmataEngineShard::run, this);
+  return true;
+}
+
+/**
+ * Stop and join the worker thread.
+ */
+void FirmataEngineShard::stop(void)
+{
+  if ( !thread.joinable() ) { return; }
+  stopping = true;
+  const uint64_t one = 1;
+  if ( ::write(wakeFd, &one, sizeof(one)) < 0 ) { /* already signalled */ }
+  thread.join();
+}
+
+/**
+ * Queue a descriptor to be added as a board by the worker thread.
+ * @return false if the worker thread cannot be woken.
+ */
+bool FirmataEngineShard::enqueue(int fd, void * user)
+{
+  inbox_entry entry = { fd, user, 0, NULL, NULL };
+  {
+    std::lock_guard<std::mutex> lock(inboxLock);
+    inbox.push_back(entry);
+  }
+  const uint64_t one = 1;
+  return (wakeFd < 0 || ::write(wakeFd, &one, sizeof(one)) == sizeof(one) || errno == EAGAIN);
+}
+
+/**
+ * Queue a task to be run by the worker thread.
+ * @return false if the worker thread cannot be woken.
+ */
+bool FirmataEngineShard::enqueue(FirmataEngineBoard &board, FirmataEngine::taskFunction task, void * context)
+{
+  inbox_entry entry = { -1, NULL, board.serial, task, context };
+  {
+    std::lock_guard<std::mutex> lock(inboxLock);
+    inbox.push_back(entry);
+  }
+  const uint64_t one = 1;
+  return (wakeFd < 0 || ::write(wakeFd, &one, sizeof(one)) == sizeof(one) || errno == EAGAIN);
+}
+
+/**
+ * The event loop of the worker thread.
+ * @private
+ */
+void FirmataEngineShard::run(void)
+{
+  struct epoll_event events[MAX_EVENTS];
+  lastTick = FirmataClockSync::hostMicros();
+  drainInbox();
+  flushDirty();
+
+  while ( !stopping ) {
+    const int n = ::epoll_wait(epollFd, events, MAX_EVENTS, TICK_MS);
+    if ( n < 0 && errno != EINTR ) { break; }
+
+    for (int i = 0; i < n; ++i) {
+      FirmataEngineBoard * board = static_cast<FirmataEngineBoard *>(events[i].data.ptr);
+      if ( !board ) {
+        uint64_t count;
+        if ( ::read(wakeFd, &count, sizeof(count)) < 0 ) { /* spurious wakeup */ }
+        drainInbox();
+        continue;
+      }
+      // closed by an earlier event of this batch
+      if ( board->descriptor < 0 ) { continue; }
+      if ( events[i].events & EPOLLOUT ) {
+        const int status = board->flushOutput();
+        if ( status < 0 ) {
+          closeBoard(board);
+          continue;
+        }
+        if ( status > 0 ) {
+          struct epoll_event event;
+          event.events = EPOLLIN;
+          event.data.ptr = board;
+          ::epoll_ctl(epollFd, EPOLL_CTL_MOD, board->descriptor, &event);
+          board->writable = true;
+        }
+      }
+      if ( events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR) ) {
+        readBoard(board);
+      }
+    }
+
+    flushDirty();
+    if ( FirmataClockSync::hostMicros() - lastTick >= TICK_MS * 1000u ) { tick(); }
+    closedList.clear();
+  }
+}
+
+/**
+ * Add the queued boards and run the queued tasks.
+ * @private
+ */
+void FirmataEngineShard::drainInbox(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(inboxLock);
+    work.swap(inbox);
+  }
+  for (size_t i = 0; i < work.size(); ++i) {
+    const inbox_entry &entry = work[i];
+    if ( entry.fd >= 0 ) {
+      addBoard(entry.fd, entry.user);
+    } else {
+      // a board closed since may have been freed and its address reused
+      const std::unordered_map<uint64_t, FirmataEngineBoard *>::const_iterator live = liveBoards.find(entry.board);
+      if ( live != liveBoards.end() ) { (*entry.task)(entry.context, *live->second); }
+    }
+  }
+  work.clear();
+}
+
+/**
+ * @private
+ */
+void FirmataEngineShard::addBoard(int fd, void * user)
+{
+  std::unique_ptr<FirmataEngineBoard> board(new FirmataEngineBoard(*this, nextId++, fd, user));
+  struct epoll_event event;
+  event.events = EPOLLIN;
+  event.data.ptr = board.get();
+  if ( ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0 ) {
+    ::close(fd);
+    return;
+  }
+  FirmataEngineBoard * added = board.get();
+  liveBoards[added->serial] = added;
+  boardList.push_back(std::move(board));
+  engine.boardCount.fetch_add(1, std::memory_order_relaxed);
+  if ( engine.boardCallback ) { (*engine.boardCallback)(engine.boardCallbackContext, *added, ENGINE_BOARD_ADDED); }
+}
+
+/**
+ * Close the descriptor of a board and delete the board at the end of the iteration, when no
+ * event of the batch refers to it anymore.
+ * @private
+ */
+void FirmataEngineShard::closeBoard(FirmataEngineBoard * board)
+{
+  if ( board->descriptor < 0 ) { return; }
+  ::epoll_ctl(epollFd, EPOLL_CTL_DEL, board->descriptor, NULL);
+  ::close(board->descriptor);
+  board->descriptor = -1;
+  // waiters learn about the loss before the board goes away
+  board->client.cancelAll();
+  if ( engine.boardCallback ) { (*engine.boardCallback)(engine.boardCallbackContext, *board, ENGINE_BOARD_CLOSED); }
+  liveBoards.erase(board->serial);
+  engine.boardCount.fetch_sub(1, std::memory_order_relaxed);
+
+  for (size_t i = 0; i < boardList.size(); ++i) {
+    if ( boardList[i].get() == board ) {
+      closedList.push_back(std::move(boardList[i]));
+      boardList[i] = std::move(boardList.back());
+      boardList.pop_back();
+      break;
+    }
+  }
+}
+
+/**
+ * Read one chunk and feed it to the client. The descriptor is level-triggered, so a board with
+ * more input is read again in the next iteration, after the other ready boards had their turn.
+ * @private
+ */
+void FirmataEngineShard::readBoard(FirmataEngineBoard * board)
+{
+  const ssize_t n = ::read(board->descriptor, readBuffer.get(), READ_CHUNK);
+  if ( n > 0 ) {
+    board->received += n;
+    board->client.parse(readBuffer.get(), n);
+  } else if ( n == 0 || (errno != EAGAIN && errno != EINTR) ) {
+    closeBoard(board);
+  }
+}
+
+/**
+ * @private
+ */
+void FirmataEngineShard::markDirty(FirmataEngineBoard * board)
+{
+  board->dirty = true;
+  dirtyList.push_back(board);
+}
+
+/**
+ * Send the output of every board written to in this iteration, one writev() each.
+ * @private
+ */
+void FirmataEngineShard::flushDirty(void)
+{
+  // flushing may close boards, which only moves them to closedList
+  for (size_t i = 0; i < dirtyList.size(); ++i) {
+    FirmataEngineBoard * board = dirtyList[i];
+    board->dirty = false;
+    if ( board->descriptor < 0 || !board->writable ) { continue; }
+    const int status = board->flushOutput();
+    if ( status < 0 ) {
+      closeBoard(board);
+    } else if ( status == 0 ) {
+      struct epoll_event event;
+      event.events = EPOLLIN | EPOLLOUT;
+      event.data.ptr = board;
+      ::epoll_ctl(epollFd, EPOLL_CTL_MOD, board->descriptor, &event);
+      board->writable = false;
+    }
+  }
+  dirtyList.clear();
+}
+
+/**
+ * Time out the pending requests of the boards.
+ * @private
+ */
+void FirmataEngineShard::tick(void)
+{
+  lastTick = FirmataClockSync::hostMicros();
+  for (size_t i = 0; i < boardList.size(); ++i) {
+    boardList[i]->client.update();
+  }
+  // completions may have sent requests
+  flushDirty();
+}
@@ -0,0 +1,201 @@
+/*
+  FirmataEngine.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Event-driven I/O for many boards on Linux. Boards are spread over shards,
+  one worker thread with its own epoll instance each. A board is only ever
+  touched by its shard, so the hot path takes no locks; other threads reach
+  a board through post(), which queues to the inbox of its shard.
+*/
+
+#ifndef FirmataEngine_h
+#define FirmataEngine_h
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <Stream.h>
+
+#include "FirmataClient.h"
+
+namespace firmata {
+
+class FirmataEngine;
+class FirmataEngineShard;
+
+enum engine_event {
+  ENGINE_BOARD_ADDED,     // the board is registered with its shard; send the first queries here
+  ENGINE_BOARD_CLOSED,    // end of file or an error; pending requests are cancelled first and
+                          // the board is deleted after the callback
+};
+
+/**
+ * One board of the engine: a file descriptor (serial port, pty or socket) and a FirmataClient
+ * parsing its input. The client writes into an output ring, which the shard flushes with one
+ * writev() per event loop iteration however many messages were sent. When the ring is full, the
+ * message being written is dropped whole, so the board never receives a cut off one. Only use a
+ * board from the callbacks of its shard or from a task posted to it.
+ */
+class FirmataEngineBoard : public Stream
+{
+  public:
+    static const size_t OUTPUT_CAPACITY = 4096;   // [bytes] unsent output per board
+
+    FirmataClient client;
+    void * user;
+
+    int fd(void) const;
+    size_t shard(void) const;
+    uint64_t id(void) const;
+    uint64_t bytesRead(void) const;
+    uint64_t bytesWritten(void) const;
+    uint64_t bytesDropped(void) const;
+    uint64_t messagesDropped(void) const;
+    size_t pendingOutput(void) const;
+
+    /* Stream */
+    int available(void);
+    int read(void);
+    int peek(void);
+    size_t write(uint8_t c);
+    size_t write(const uint8_t * buffer, size_t size);
+    using Print::write;
+    int availableForWrite(void);
+    void flush(void);
+
+  private:
+    friend class FirmataEngine;
+    friend class FirmataEngineShard;
+
+    FirmataEngineBoard(FirmataEngineShard &shard, uint64_t id, int fd, void * user);
+    int flushOutput(void);
+
+    FirmataEngineShard &owner;
+    const uint64_t serial;      // unique within the shard, never reused
+    int descriptor;
+    uint8_t output[OUTPUT_CAPACITY];
+    size_t head;                // next byte to send
+    size_t used;
+    size_t partial;             // bytes of an unfinished message at the end of the ring, not sent yet
+    uint8_t expected;           // data bytes the unfinished message still needs, 0xFF for a sysex
+    bool discarding;            // the rest of a dropped message follows
+    bool dirty;                 // on the flush list of the shard
+    bool writable;              // false while the kernel buffer is full (EPOLLOUT armed)
+    uint64_t received;
+    uint64_t sent;
+    uint64_t dropped;
+    uint64_t droppedMessages;
+};
+
+/**
+ * The shards and their worker threads.
+ */
+class FirmataEngine
+{
+  public:
+    typedef void (*boardCallbackFunction)(void * context, FirmataEngineBoard &board, engine_event event);
+    typedef void (*taskFunction)(void * context, FirmataEngineBoard &board);
+
+    explicit FirmataEngine(size_t shard_count = 0);
+    ~FirmataEngine();
+
+    void attach(boardCallbackFunction callback, void * context = NULL);
+    bool start(void);
+    void stop(void);
+
+    /* boards */
+    bool add(int fd, void * user = NULL);
+    bool post(FirmataEngineBoard &board, taskFunction task, void * context = NULL);
+    size_t shards(void) const;
+    size_t boards(void) const;
+
+    /* descriptors */
+    static int openSerial(const char * path, uint32_t baud = 57600);
+    static int connectTcp(const char * host, uint16_t port);
+
+  private:
+    friend class FirmataEngineShard;
+
+    std::vector<std::unique_ptr<FirmataEngineShard> > shardList;
+    std::atomic<size_t> nextShard;
+    std::atomic<size_t> boardCount;
+    boardCallbackFunction boardCallback;
+    void * boardCallbackContext;
+    bool running;
+};
+
+/**
+ * One worker thread: an epoll instance, the boards assigned to it and an inbox for boards and
+ * tasks from other threads, woken through an eventfd. The inbox lock is the only one, and it is
+ * only shared with the threads that post to this shard.
+ */
+class FirmataEngineShard
+{
+  public:
+    static const size_t READ_CHUNK = 65536;   // [bytes] per read() call
+    static const int TICK_MS = 10;            // FirmataClient::update() interval
+
+    FirmataEngineShard(FirmataEngine &engine, size_t index);
+    ~FirmataEngineShard();
+
+    bool start(void);
+    void stop(void);
+    bool enqueue(int fd, void * user);
+    bool enqueue(FirmataEngineBoard &board, FirmataEngine::taskFunction task, void * context);
+
+  private:
+    friend class FirmataEngineBoard;
+
+    struct inbox_entry {
+      int fd;                               // a board to add, or -1 for a task
+      void * user;
+      uint64_t board;                       // the id of the board of a task, its address may be reused
+      FirmataEngine::taskFunction task;
+      void * context;
+    };
+
+    void run(void);
+    void drainInbox(void);
+    void addBoard(int fd, void * user);
+    void closeBoard(FirmataEngineBoard * board);
+    void readBoard(FirmataEngineBoard * board);
+    void markDirty(FirmataEngineBoard * board);
+    void flushDirty(void);
+    void tick(void);
+
+    FirmataEngine &engine;
+    const size_t index;
+    int epollFd;
+    int wakeFd;
+    std::thread thread;
+    std::atomic<bool> stopping;
+
+    std::mutex inboxLock;
+    std::vector<inbox_entry> inbox;
+    std::vector<inbox_entry> work;          // swapped with inbox, drained without the lock
+
+    std::vector<std::unique_ptr<FirmataEngineBoard> > boardList;
+    std::unordered_map<uint64_t, FirmataEngineBoard *> liveBoards;    // by id, to drop tasks for closed boards
+    uint64_t nextId;
+    std::vector<FirmataEngineBoard *> dirtyList;
+    std::vector<std::unique_ptr<FirmataEngineBoard> > closedList;   // deleted after the events of an iteration
+    std::unique_ptr<uint8_t[]> readBuffer;
+    uint64_t lastTick;
+};
+
+} // namespace firmata
+
+#endif /* FirmataEngine_h */
@@ -0,0 +1,356 @@
+/*
+  FirmataEventRing.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "FirmataEventRing.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "FirmataClockSync.h"
+#include "FirmataConstants.h"
+
+using namespace firmata;
+
+//******************************************************************************
+//* Support Functions
+//******************************************************************************
+
+namespace {
+
+const char MAGIC[4] = { 'F', 'E', 'V', 'R' };
+const uint32_t VERSION = 1;
+
+static_assert(sizeof(event_ring_header) == 64, "the slots must start on a cache line");
+static_assert(sizeof(event_ring_slot) == 32, "two slots per cache line");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "the ring needs lock-free 64-bit atomics to be shared between processes");
+
+size_t ringSize(uint64_t capacity)
+{
+  return sizeof(event_ring_header) + capacity * sizeof(event_ring_slot);
+}
+
+} // namespace
+
+//******************************************************************************
+//* FirmataEventPublisher
+//******************************************************************************
+
+/**
+ * The FirmataEventPublisher class.
+ */
+FirmataEventPublisher::FirmataEventPublisher()
+:
+  header(NULL),
+  slots(NULL),
+  mask(0),
+  head(0),
+  mappedSize(0)
+{
+  ringName[0] = '\0';
+  ports.reset();
+}
+
+FirmataEventPublisher::~FirmataEventPublisher()
+{
+  close();
+}
+
+/**
+ * Create (or replace) a shared memory ring.
+ * @param name The POSIX shared memory name, e.g. "/firmata-board0".
+ * @param capacity The number of events the ring holds, rounded up to a power of two.
+ * @return false if the shared memory cannot be created or mapped.
+ */
+bool FirmataEventPublisher::create(const char * name, size_t capacity)
+{
+  close();
+  uint64_t slots_count = 1;
+  while ( slots_count < capacity ) { slots_count <<= 1; }
+  if ( std::strlen(name) >= sizeof(ringName) ) { return false; }
+
+  // a fresh object, so that readers of the previous ring keep their own
+  ::shm_unlink(name);
+  const int fd = ::shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+  if ( fd < 0 ) { return false; }
+  const size_t size = ringSize(slots_count);
+  void * mapping = MAP_FAILED;
+  if ( ::ftruncate(fd, size) == 0 ) {
+    mapping = ::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if ( mapping == MAP_FAILED ) {
+    ::shm_unlink(name);
+    return false;
+  }
+
+  // ftruncate() zeroed the slots
+  header = static_cast<event_ring_header *>(mapping);
+  slots = reinterpret_cast<event_ring_slot *>(static_cast<uint8_t *>(mapping) + sizeof(event_ring_header));
+  mappedSize = size;
+  mask = slots_count - 1;
+  head = 0;
+  ports.reset();
+  std::strcpy(ringName, name);
+  header->version = VERSION;
+  header->capacity = slots_count;
+  header->head.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+  return true;
+}
+
+/**
+ * Unmap the ring and remove its name. Subscribers that have it mapped keep reading it.
+ */
+void FirmataEventPublisher::close(void)
+{
+  if ( !header ) { return; }
+  ::munmap(header, mappedSize);
+  ::shm_unlink(ringName);
+  header = NULL;
+  slots = NULL;
+  mappedSize = 0;
+}
+
+/**
+ * Publish the ANALOG_MESSAGE and DIGITAL_MESSAGE reports a parser decodes. This replaces the
+ * callbacks of the parser for these two messages.
+ * @param parser The parser of the board stream.
+ */
+void FirmataEventPublisher::attach(FirmataParser &parser)
+{
+  parser.attach(ANALOG_MESSAGE, staticAnalogCallback, this);
+  parser.attach(DIGITAL_MESSAGE, staticDigitalCallback, this);
+}
+
+/**
+ * Append an event stamped with the current host time.
+ * @param type A pin_event_type.
+ * @param index The analog channel or the pin.
+ * @param value The value.
+ */
+void FirmataEventPublisher::publish(uint8_t type, uint8_t index, uint32_t value)
+{
+  publish(type, index, value, FirmataClockSync::hostMicros());
+}
+
+/**
+ * Append an event.
+ * @param type A pin_event_type.
+ * @param index The analog channel or the pin.
+ * @param value The value.
+ * @param time The time of the event [us].
+ */
+void FirmataEventPublisher::publish(uint8_t type, uint8_t index, uint32_t value, uint64_t time)
+{
+  if ( !header ) { return; }
+  event_ring_slot &slot = slots[head & mask];
+  // odd while written, so a reader that lapped into this slot sees the change
+  slot.sequence.store(2 * head + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.time.store(time, std::memory_order_relaxed);
+  slot.payload.store(type | (static_cast<uint64_t>(index) << 8) | (static_cast<uint64_t>(value) << 32), std::memory_order_relaxed);
+  slot.sequence.store(2 * head + 2, std::memory_order_release);
+  header->head.store(++head, std::memory_order_release);
+}
+
+/**
+ * @return The number of events published since create().
+ */
+uint64_t FirmataEventPublisher::published(void)
+const
+{
+  return head;
+}
+
+/**
+ * @private
+ */
+void FirmataEventPublisher::staticAnalogCallback(void * context, uint8_t command, uint16_t value)
+{
+  static_cast<FirmataEventPublisher *>(context)->publish(PIN_EVENT_ANALOG, (command & 0x0F), value);
+}
+
+/**
+ * One event per pin of the port that changed; all eight for the first report of a port.
+ * @private
+ */
+void FirmataEventPublisher::staticDigitalCallback(void * context, uint8_t command, uint16_t value)
+{
+  FirmataEventPublisher * publisher = static_cast<FirmataEventPublisher *>(context);
+  const uint8_t port = command & 0x0F;
+  const uint8_t changed = publisher->ports.update(port, static_cast<uint8_t>(value));
+  if ( !changed ) { return; }
+
+  const uint64_t now = FirmataClockSync::hostMicros();
+  for (uint8_t bit = 0; bit < 8; ++bit) {
+    if ( changed & (1 << bit) ) {
+      publisher->publish(PIN_EVENT_DIGITAL, static_cast<uint8_t>(port * 8 + bit), ((value >> bit) & 0x01), now);
+    }
+  }
+}
+
+//******************************************************************************
+//* FirmataEventSubscriber
+//******************************************************************************
+
+/**
+ * The FirmataEventSubscriber class.
+ */
+FirmataEventSubscriber::FirmataEventSubscriber()
+:
+  header(NULL),
+  slots(NULL),
+  mask(0),
+  capacity(0),
+  cursor(0),
+  lostEvents(0),
+  mappedSize(0)
+{
+}
+
+FirmataEventSubscriber::~FirmataEventSubscriber()
+{
+  close();
+}
+
+/**
+ * Map a ring read-only and start at its latest event.
+ * @param name The name passed to FirmataEventPublisher::create().
+ * @return false if there is no ring of this name or it is not a ring of a known version.
+ */
+bool FirmataEventSubscriber::open(const char * name)
+{
+  close();
+  const int fd = ::shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+  if ( fd < 0 ) { return false; }
+  struct stat st;
+  void * mapping = MAP_FAILED;
+  if ( ::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(event_ring_header) ) {
+    mapping = ::mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if ( mapping == MAP_FAILED ) { return false; }
+
+  header = static_cast<const event_ring_header *>(mapping);
+  slots = reinterpret_cast<const event_ring_slot *>(static_cast<const uint8_t *>(mapping) + sizeof(event_ring_header));
+  mappedSize = st.st_size;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  capacity = header->capacity;
+  if ( std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION
+    || capacity == 0 || (capacity & (capacity - 1)) || ringSize(capacity) != mappedSize ) {
+    close();
+    return false;
+  }
+  mask = capacity - 1;
+  lostEvents = 0;
+  seekToLatest();
+  return true;
+}
+
+/**
+ * Unmap the ring.
+ */
+void FirmataEventSubscriber::close(void)
+{
+  if ( !header ) { return; }
+  ::munmap(const_cast<event_ring_header *>(header), mappedSize);
+  header = NULL;
+  slots = NULL;
+  mappedSize = 0;
+}
+
+/**
+ * Read the next event. The slot is read in place and checked against its sequence, so an event
+ * overwritten while it was read is never returned.
+ * @param event Set to the event.
+ * @return false if there is no new event.
+ */
+bool FirmataEventSubscriber::next(pin_event &event)
+{
+  if ( !header ) { return false; }
+  for (;;) {
+    const uint64_t published = header->head.load(std::memory_order_acquire);
+    if ( cursor >= published ) { return false; }
+    if ( published - cursor > capacity ) {
+      // the oldest slot may be rewritten any moment, skip it too
+      const uint64_t oldest = published - capacity + 1;
+      lostEvents += oldest - cursor;
+      cursor = oldest;
+    }
+
+    const event_ring_slot &slot = slots[cursor & mask];
+    const uint64_t expected = 2 * cursor + 2;
+    const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if ( before == expected ) {
+      const uint64_t time = slot.time.load(std::memory_order_relaxed);
+      const uint64_t payload = slot.payload.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if ( slot.sequence.load(std::memory_order_relaxed) == before ) {
+        event.time = time;
+        event.type = static_cast<uint8_t>(payload);
+        event.index = static_cast<uint8_t>(payload >> 8);
+        event.value = static_cast<uint32_t>(payload >> 32);
+        ++cursor;
+        return true;
+      }
+    }
+    // lapped by the publisher while reading; count the slot and catch up
+    ++lostEvents;
+    ++cursor;
+  }
+}
+
+/**
+ * @return The number of events published and not read yet, including those already lost.
+ */
+uint64_t FirmataEventSubscriber::available(void)
+const
+{
+  if ( !header ) { return 0; }
+  const uint64_t published = header->head.load(std::memory_order_acquire);
+  return ((published > cursor) ? (published - cursor) : 0);
+}
+
+/**
+ * @return The number of events overwritten before this subscriber read them.
+ */
+uint64_t FirmataEventSubscriber::lost(void)
+const
+{
+  return lostEvents;
+}
+
+/**
+ * @return The number of the next event to read.
+ */
+uint64_t FirmataEventSubscriber::position(void)
+const
+{
+  return cursor;
+}
+
+/**
+ * Skip the events not read yet without counting them as lost.
+ */
+void FirmataEventSubscriber::seekToLatest(void)
+{
+  if ( header ) { cursor = header->head.load(std::memory_order_acquire); }
+}
@@ -0,0 +1,133 @@
+/*
+  FirmataEventRing.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Fan-out of decoded pin events through POSIX shared memory. One publisher
+  parses the stream of a board and appends an event per analog report and
+  per changed digital pin to a ring; any number of processes map the ring
+  and read it at their own pace, without syscalls or locks.
+
+  The ring is a 64 byte header followed by a power of two of 32 byte slots:
+
+    header   "FEVR", version (1), capacity, head (events published)
+    slot     sequence (2 * position + 2 once written, odd while written),
+             time [us], type, index, value
+
+  A reader that falls more than a ring behind loses the oldest events; the
+  next read reports the overrun and continues with the oldest event still
+  in the ring.
+*/
+
+#ifndef FirmataEventRing_h
+#define FirmataEventRing_h
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "FirmataParser.h"
+#include "FirmataPortLevels.h"
+
+namespace firmata {
+
+enum pin_event_type {
+  PIN_EVENT_ANALOG = 1,     // index: the analog channel
+  PIN_EVENT_DIGITAL = 2,    // index: the pin
+};
+
+/**
+ * One decoded event.
+ */
+struct pin_event {
+  uint64_t time;            // [us] FirmataClockSync::hostMicros() of the publisher
+  uint8_t type;             // pin_event_type
+  uint8_t index;
+  uint32_t value;
+};
+
+/**
+ * The shared layout, see the comment at the top of this file.
+ */
+struct event_ring_header {
+  char magic[4];
+  uint32_t version;
+  uint64_t capacity;                // slots, a power of two
+  std::atomic<uint64_t> head;       // events published
+  uint8_t padding[40];              // the slots start on a cache line
+};
+
+struct event_ring_slot {
+  std::atomic<uint64_t> sequence;
+  std::atomic<uint64_t> time;
+  std::atomic<uint64_t> payload;    // type | index << 8 | value << 32
+  uint64_t padding;
+};
+
+/**
+ * Creates a ring and appends the events decoded by a parser to it. Single writer.
+ */
+class FirmataEventPublisher
+{
+  public:
+    FirmataEventPublisher();
+    ~FirmataEventPublisher();
+
+    bool create(const char * name, size_t capacity = 65536);
+    void close(void);
+    void attach(FirmataParser &parser);
+
+    void publish(uint8_t type, uint8_t index, uint32_t value);
+    void publish(uint8_t type, uint8_t index, uint32_t value, uint64_t time);
+    uint64_t published(void) const;
+
+  private:
+    static void staticAnalogCallback(void * context, uint8_t command, uint16_t value);
+    static void staticDigitalCallback(void * context, uint8_t command, uint16_t value);
+
+    event_ring_header * header;
+    event_ring_slot * slots;
+    uint64_t mask;
+    uint64_t head;
+    size_t mappedSize;
+    char ringName[64];
+    port_levels ports;              // the last report of each digital port
+};
+
+/**
+ * Maps a ring read-only and reads it from its own position.
+ */
+class FirmataEventSubscriber
+{
+  public:
+    FirmataEventSubscriber();
+    ~FirmataEventSubscriber();
+
+    bool open(const char * name);
+    void close(void);
+
+    bool next(pin_event &event);
+    uint64_t available(void) const;
+    uint64_t lost(void) const;
+    uint64_t position(void) const;
+    void seekToLatest(void);
+
+  private:
+    const event_ring_header * header;
+    const event_ring_slot * slots;
+    uint64_t mask;
+    uint64_t capacity;
+    uint64_t cursor;
+    uint64_t lostEvents;
+    size_t mappedSize;
+};
+
+} // namespace firmata
+
+#endif /* FirmataEventRing_h */
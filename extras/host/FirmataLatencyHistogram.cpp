@@ -0,0 +1,207 @@
+/*
+  FirmataLatencyHistogram.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "FirmataLatencyHistogram.h"
+
+#include <cmath>
+
+using namespace firmata;
+
+//******************************************************************************
+//* Constructors
+//******************************************************************************
+
+/**
+ * The FirmataLatencyHistogram class.
+ */
+FirmataLatencyHistogram::FirmataLatencyHistogram()
+{
+  reset();
+}
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+/**
+ * Count one occurrence of a value.
+ * @param value The value to record.
+ */
+void FirmataLatencyHistogram::record(uint32_t value)
+{
+  record(value, 1);
+}
+
+/**
+ * Count several occurrences of a value.
+ * @param value The value to record.
+ * @param count The number of occurrences.
+ */
+void FirmataLatencyHistogram::record(uint32_t value, uint32_t count)
+{
+  if ( 0 == count ) { return; }
+  counts[bucketIndex(value)] += count;
+  totalCount += count;
+  totalSum += (static_cast<uint64_t>(value) * count);
+  if ( value < minValue ) { minValue = value; }
+  if ( value > maxValue ) { maxValue = value; }
+}
+
+/**
+ * Add the counts of another histogram, for example to combine the histograms of several
+ * connections or to accumulate interval histograms.
+ * @param other The histogram to add.
+ */
+void FirmataLatencyHistogram::merge(const FirmataLatencyHistogram &other)
+{
+  size_t i;
+  for (i = 0; i < BUCKET_COUNT; ++i) {
+    counts[i] += other.counts[i];
+  }
+  totalCount += other.totalCount;
+  totalSum += other.totalSum;
+  if ( other.minValue < minValue ) { minValue = other.minValue; }
+  if ( other.maxValue > maxValue ) { maxValue = other.maxValue; }
+}
+
+/**
+ * Discard all recorded values.
+ */
+void FirmataLatencyHistogram::reset(void)
+{
+  size_t i;
+  for (i = 0; i < BUCKET_COUNT; ++i) {
+    counts[i] = 0;
+  }
+  totalCount = 0;
+  totalSum = 0;
+  minValue = UINT32_MAX;
+  maxValue = 0;
+}
+
+/**
+ * @return The number of recorded values.
+ */
+uint64_t FirmataLatencyHistogram::count(void)
+const
+{
+  return totalCount;
+}
+
+/**
+ * @return The smallest recorded value (exact), or 0 if the histogram is empty.
+ */
+uint32_t FirmataLatencyHistogram::min(void)
+const
+{
+  return (totalCount ? minValue : 0);
+}
+
+/**
+ * @return The largest recorded value (exact).
+ */
+uint32_t FirmataLatencyHistogram::max(void)
+const
+{
+  return maxValue;
+}
+
+/**
+ * @return The mean of the recorded values (exact), or 0 if the histogram is empty.
+ */
+double FirmataLatencyHistogram::mean(void)
+const
+{
+  return (totalCount ? (static_cast<double>(totalSum) / totalCount) : 0.0);
+}
+
+/**
+ * Find the value below or at which the given percentage of the recorded values lie.
+ * @param percent The percentile, 0.0 - 100.0 (e.g. 99.0 for p99).
+ * @return The highest value equivalent to the bucket holding the percentile, limited to the
+ * largest recorded value, or 0 if the histogram is empty.
+ */
+uint32_t FirmataLatencyHistogram::percentile(double percent)
+const
+{
+  if ( 0 == totalCount ) { return 0; }
+  if ( percent < 0.0 ) { percent = 0.0; }
+  if ( percent > 100.0 ) { percent = 100.0; }
+
+  uint64_t rank = static_cast<uint64_t>(std::ceil((percent / 100.0) * totalCount));
+  if ( rank < 1 ) { rank = 1; }
+
+  uint64_t seen = 0;
+  size_t i;
+  for (i = 0; i < BUCKET_COUNT; ++i) {
+    seen += counts[i];
+    if ( seen >= rank ) {
+      const uint32_t highest = bucketHighest(i);
+      return ((highest < maxValue) ? highest : maxValue);
+    }
+  }
+  return maxValue;
+}
+
+/**
+ * @param value A value.
+ * @return The index of the bucket counting the value.
+ */
+size_t FirmataLatencyHistogram::bucketIndex(uint32_t value)
+{
+  if ( value < SUB_BUCKET_COUNT ) { return value; }
+
+  // keep the SUB_BUCKET_BITS - 1 bits below the most significant bit
+  size_t msb = 0;
+  while ( (value >> msb) > 1 ) { ++msb; }
+  const size_t shift = (msb - (SUB_BUCKET_BITS - 1));
+  const size_t half = (SUB_BUCKET_COUNT / 2);
+  return (SUB_BUCKET_COUNT + ((shift - 1) * half) + ((value >> shift) - half));
+}
+
+/**
+ * @param index A bucket index.
+ * @return The smallest value counted by the bucket.
+ */
+uint32_t FirmataLatencyHistogram::bucketLowest(size_t index)
+{
+  if ( index < SUB_BUCKET_COUNT ) { return static_cast<uint32_t>(index); }
+
+  const size_t half = (SUB_BUCKET_COUNT / 2);
+  const size_t shift = (((index - SUB_BUCKET_COUNT) / half) + 1);
+  const uint64_t sub = (((index - SUB_BUCKET_COUNT) % half) + half);
+  return static_cast<uint32_t>(sub << shift);
+}
+
+/**
+ * @param index A bucket index.
+ * @return The largest value counted by the bucket.
+ */
+uint32_t FirmataLatencyHistogram::bucketHighest(size_t index)
+{
+  if ( (index + 1) >= BUCKET_COUNT ) { return UINT32_MAX; }
+  return (bucketLowest(index + 1) - 1);
+}
+
+/**
+ * @param index A bucket index.
+ * @return The number of values counted by the bucket.
+ */
+uint64_t FirmataLatencyHistogram::bucketCount(size_t index)
+const
+{
+  return ((index < BUCKET_COUNT) ? counts[index] : 0);
+}
@@ -0,0 +1,65 @@
+/*
+  FirmataLatencyHistogram.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#ifndef FirmataLatencyHistogram_h
+#define FirmataLatencyHistogram_h
+
+#include <cstddef>
+#include <cstdint>
+
+namespace firmata {
+
+/**
+ * Fixed size histogram of 32-bit values (typically microseconds) in the style of HdrHistogram.
+ *
+ * Values below SUB_BUCKET_COUNT are counted exactly. Larger values are counted in log-linear
+ * buckets: every power of two range is split into SUB_BUCKET_COUNT / 2 equal sub-buckets, so
+ * the reported value is within 1.6 % of the recorded one over the whole range. Recording is a
+ * handful of integer operations and never allocates, and two histograms can be merged.
+ */
+class FirmataLatencyHistogram
+{
+  public:
+    static const size_t SUB_BUCKET_BITS = 7;
+    static const size_t SUB_BUCKET_COUNT = (1 << SUB_BUCKET_BITS);
+    static const size_t BUCKET_COUNT = (SUB_BUCKET_COUNT + (32 - SUB_BUCKET_BITS) * (SUB_BUCKET_COUNT / 2));
+
+    FirmataLatencyHistogram();
+
+    void record(uint32_t value);
+    void record(uint32_t value, uint32_t count);
+    void merge(const FirmataLatencyHistogram &other);
+    void reset(void);
+
+    uint64_t count(void) const;
+    uint32_t min(void) const;
+    uint32_t max(void) const;
+    double mean(void) const;
+    uint32_t percentile(double percent) const;
+
+    /* raw buckets, e.g. for export */
+    static size_t bucketIndex(uint32_t value);
+    static uint32_t bucketLowest(size_t index);
+    static uint32_t bucketHighest(size_t index);
+    uint64_t bucketCount(size_t index) const;
+
+  private:
+    uint64_t counts[BUCKET_COUNT];
+    uint64_t totalCount;
+    uint64_t totalSum;
+    uint32_t minValue;
+    uint32_t maxValue;
+};
+
+} // namespace firmata
+
+#endif /* FirmataLatencyHistogram_h */
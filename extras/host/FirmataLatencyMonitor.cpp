@@ -0,0 +1,208 @@
+/*
+  FirmataLatencyMonitor.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "FirmataLatencyMonitor.h"
+
+#include "FirmataClockSync.h"
+#include "FirmataConstants.h"
+
+using namespace firmata;
+
+//******************************************************************************
+//* Support Functions
+//******************************************************************************
+
+namespace {
+
+// sequence numbers are sent as two 7-bit bytes
+const uint16_t SEQUENCE_MASK = 0x3FFF;
+
+} // namespace
+
+//******************************************************************************
+//* Constructors
+//******************************************************************************
+
+/**
+ * The FirmataLatencyMonitor class.
+ */
+FirmataLatencyMonitor::FirmataLatencyMonitor()
+:
+  sequence(0)
+{
+  reset();
+}
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+/**
+ * Route ECHO_DATA replies decoded by the parser into this monitor. The host receive time is
+ * taken when the parser completes the reply.
+ * @param parser The parser connected to the target.
+ */
+void FirmataLatencyMonitor::attach(FirmataParser &parser)
+{
+  parser.attach(ECHO_DATA, staticEchoCallback, this);
+}
+
+/**
+ * Send an echo request and remember its transmission time. If the slot of the new request is
+ * still waiting for an older reply, that request is counted as lost.
+ * @param marshaller The marshaller connected to the target.
+ * @param payloadc The number of payload bytes, to measure the latency of larger messages.
+ * @param payloadv A pointer to the payload bytes (7-bit).
+ * @return The sequence number of the request.
+ */
+uint16_t FirmataLatencyMonitor::sendPing(const FirmataMarshaller &marshaller, size_t payloadc, const uint8_t * payloadv)
+{
+  const uint16_t current = sequence;
+  pending_request & request = requests[current % MAX_PENDING];
+  if ( request.active ) { ++lostCount; }
+
+  sequence = ((sequence + 1) & SEQUENCE_MASK);
+  request.sequence = current;
+  request.active = true;
+  request.sent = FirmataClockSync::hostMicros();
+  marshaller.sendEchoRequest(current, payloadc, payloadv);
+  return current;
+}
+
+/**
+ * Record the result of one echo exchange.
+ * @param sequence The sequence number of the reply.
+ * @param device_receive_us The device time when the request was received.
+ * @param device_transmit_us The device time when the reply was sent.
+ * @param host_receive_us The host time when the reply was received.
+ * @return false if the reply does not match an outstanding request.
+ */
+bool FirmataLatencyMonitor::handleReply(uint16_t sequence, uint32_t device_receive_us, uint32_t device_transmit_us, uint64_t host_receive_us)
+{
+  pending_request & request = requests[sequence % MAX_PENDING];
+  if ( !request.active || request.sequence != sequence || host_receive_us < request.sent ) {
+    ++unmatchedCount;
+    return false;
+  }
+  request.active = false;
+
+  const uint64_t round_trip64 = (host_receive_us - request.sent);
+  const uint32_t round_trip = ((round_trip64 > UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(round_trip64));
+  const uint32_t turnaround = (device_transmit_us - device_receive_us);
+  roundTripHistogram.record(round_trip);
+  intervalHistogram.record(round_trip);
+  linkHistogram.record((turnaround < round_trip) ? (round_trip - turnaround) : 0);
+  return true;
+}
+
+/**
+ * Forget all outstanding requests and clear the histograms and counters.
+ */
+void FirmataLatencyMonitor::reset(void)
+{
+  size_t i;
+  for (i = 0; i < MAX_PENDING; ++i) {
+    requests[i].active = false;
+  }
+  lostCount = 0;
+  unmatchedCount = 0;
+  roundTripHistogram.reset();
+  linkHistogram.reset();
+  intervalHistogram.reset();
+}
+
+/**
+ * @return The round trip times since the last reset, in microseconds.
+ */
+const FirmataLatencyHistogram & FirmataLatencyMonitor::roundTrip(void)
+const
+{
+  return roundTripHistogram;
+}
+
+/**
+ * @return The round trip times without the device turnaround time, i.e. the time spent in
+ * the transport (serial driver, USB adapter, network) in both directions, in microseconds.
+ */
+const FirmataLatencyHistogram & FirmataLatencyMonitor::link(void)
+const
+{
+  return linkHistogram;
+}
+
+/**
+ * @return The round trip times since the last call of takeInterval(), in microseconds.
+ */
+const FirmataLatencyHistogram & FirmataLatencyMonitor::intervalRoundTrip(void)
+const
+{
+  return intervalHistogram;
+}
+
+/**
+ * Copy the round trip times of the current interval and start a new interval.
+ * @param out Receives the histogram of the interval that ended.
+ */
+void FirmataLatencyMonitor::takeInterval(FirmataLatencyHistogram &out)
+{
+  out = intervalHistogram;
+  intervalHistogram.reset();
+}
+
+/**
+ * @return The number of requests whose reply did not arrive before their slot was reused.
+ */
+uint32_t FirmataLatencyMonitor::lost(void)
+const
+{
+  return lostCount;
+}
+
+/**
+ * @return The number of replies that did not match an outstanding request.
+ */
+uint32_t FirmataLatencyMonitor::unmatched(void)
+const
+{
+  return unmatchedCount;
+}
+
+/**
+ * @return The number of requests waiting for a reply.
+ */
+size_t FirmataLatencyMonitor::pending(void)
+const
+{
+  size_t i, result = 0;
+  for (i = 0; i < MAX_PENDING; ++i) {
+    if ( requests[i].active ) { ++result; }
+  }
+  return result;
+}
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+/**
+ * Parser callback for ECHO_DATA messages.
+ * @private
+ */
+void FirmataLatencyMonitor::staticEchoCallback (void * context, uint8_t command, uint16_t sequence, uint32_t receive_time, uint32_t transmit_time, size_t, uint8_t *)
+{
+  if ( !context || ECHO_REPLY != command ) { return; }
+  static_cast<FirmataLatencyMonitor *>(context)->handleReply(sequence, receive_time, transmit_time, FirmataClockSync::hostMicros());
+}
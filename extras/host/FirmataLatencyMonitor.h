@@ -0,0 +1,76 @@
+/*
+  FirmataLatencyMonitor.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#ifndef FirmataLatencyMonitor_h
+#define FirmataLatencyMonitor_h
+
+#include <cstddef>
+#include <cstdint>
+
+#include "FirmataLatencyHistogram.h"
+#include "FirmataMarshaller.h"
+#include "FirmataParser.h"
+
+namespace firmata {
+
+/**
+ * Measures the round trip latency of one connection with ECHO_DATA probes.
+ *
+ * Each reply is matched with its request by sequence number. The round trip time and the link
+ * time (the round trip time without the device turnaround) are recorded in a histogram for the
+ * whole session and in a second one for the current interval, which the application can take
+ * periodically to watch for a regression of p99 or the maximum.
+ */
+class FirmataLatencyMonitor
+{
+  public:
+    static const size_t MAX_PENDING = 64; // requests that may be outstanding at the same time
+
+    FirmataLatencyMonitor();
+
+    /* protocol */
+    void attach(FirmataParser &parser);
+    uint16_t sendPing(const FirmataMarshaller &marshaller, size_t payloadc = 0, const uint8_t * payloadv = NULL);
+    bool handleReply(uint16_t sequence, uint32_t device_receive_us, uint32_t device_transmit_us, uint64_t host_receive_us);
+    void reset(void);
+
+    /* results */
+    const FirmataLatencyHistogram & roundTrip(void) const;
+    const FirmataLatencyHistogram & link(void) const;
+    const FirmataLatencyHistogram & intervalRoundTrip(void) const;
+    void takeInterval(FirmataLatencyHistogram &out);
+    uint32_t lost(void) const;
+    uint32_t unmatched(void) const;
+    size_t pending(void) const;
+
+  private:
+    struct pending_request {
+      uint64_t sent;     // host time of transmission
+      uint16_t sequence;
+      bool active;
+    };
+
+    pending_request requests[MAX_PENDING];
+    uint16_t sequence;
+    uint32_t lostCount;
+    uint32_t unmatchedCount;
+
+    FirmataLatencyHistogram roundTripHistogram;
+    FirmataLatencyHistogram linkHistogram;
+    FirmataLatencyHistogram intervalHistogram;
+
+    static void staticEchoCallback (void * context, uint8_t command, uint16_t sequence, uint32_t receive_time, uint32_t transmit_time, size_t payloadc, uint8_t * payloadv);
+};
+
+} // namespace firmata
+
+#endif /* FirmataLatencyMonitor_h */
@@ -0,0 +1,57 @@
+/*
+  FirmataPortLevels.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  The last report of each digital port, for the host components that turn
+  DIGITAL_MESSAGE reports into pin events.
+*/
+
+#ifndef FirmataPortLevels_h
+#define FirmataPortLevels_h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace firmata {
+
+/**
+ * The last value of each digital port. A plain struct, so that it can be zeroed with the
+ * structure that holds it.
+ */
+struct port_levels {
+  static const size_t PORTS = 16;        // DIGITAL_MESSAGE carries 4-bit ports
+
+  uint8_t values[PORTS];
+  uint16_t known;                        // bit n is set once port n reported
+
+  /**
+   * Record a report of a port.
+   * @param port The port (0 - 15).
+   * @param value The levels of the eight pins of the port.
+   * @return The pins of the port whose level changed, one bit per pin; all eight for the first
+   * report of the port.
+   */
+  uint8_t update(uint8_t port, uint8_t value) {
+    port &= 0x0F;
+    const uint16_t bit = static_cast<uint16_t>(1 << port);
+    const uint8_t changed = ((known & bit) ? (values[port] ^ value) : 0xFF);
+    values[port] = value;
+    known |= bit;
+    return changed;
+  }
+
+  bool isKnown(uint8_t port) const { return (known >> (port & 0x0F)) & 0x01; }
+  void reset(void) { std::memset(values, 0, sizeof(values)); known = 0; }
+};
+
+} // namespace firmata
+
+#endif /* FirmataPortLevels_h */
@@ -0,0 +1,89 @@
+/*
+  FirmataRecordingStream.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "FirmataRecordingStream.h"
+
+using namespace firmata;
+
+//******************************************************************************
+//* Constructors
+//******************************************************************************
+
+/**
+ * The FirmataRecordingStream class.
+ * @param stream The stream to the board.
+ * @param writer The open capture the traffic goes to.
+ */
+FirmataRecordingStream::FirmataRecordingStream(Stream &stream, FirmataCaptureWriter &writer)
+:
+  stream(stream),
+  writer(writer)
+{
+}
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+int FirmataRecordingStream::available(void)
+{
+  return stream.available();
+}
+
+/**
+ * Read a byte and record it as received from the board.
+ */
+int FirmataRecordingStream::read(void)
+{
+  const int c = stream.read();
+  if ( c >= 0 ) { writer.record(CAPTURE_FROM_BOARD, static_cast<uint8_t>(c)); }
+  return c;
+}
+
+int FirmataRecordingStream::peek(void)
+{
+  return stream.peek();
+}
+
+/**
+ * Write a byte and record it as sent to the board, if the stream took it.
+ */
+size_t FirmataRecordingStream::write(uint8_t c)
+{
+  const size_t n = stream.write(c);
+  if ( n ) { writer.record(CAPTURE_TO_BOARD, c); }
+  return n;
+}
+
+/**
+ * Write a block and record the part the stream took, with a single timestamp.
+ */
+size_t FirmataRecordingStream::write(const uint8_t * buffer, size_t size)
+{
+  const size_t n = stream.write(buffer, size);
+  writer.record(CAPTURE_TO_BOARD, buffer, n);
+  return n;
+}
+
+int FirmataRecordingStream::availableForWrite(void)
+{
+  return stream.availableForWrite();
+}
+
+void FirmataRecordingStream::flush(void)
+{
+  stream.flush();
+}
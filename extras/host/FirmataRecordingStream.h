@@ -0,0 +1,51 @@
+/*
+  FirmataRecordingStream.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#ifndef FirmataRecordingStream_h
+#define FirmataRecordingStream_h
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Stream.h>
+
+#include "FirmataCapture.h"
+
+namespace firmata {
+
+/**
+ * A Stream that passes everything through to another Stream and records the bytes read from
+ * and written to it in a capture. Hand it to FirmataMarshaller::begin() and read the input
+ * through it, and the capture has the whole conversation with the board.
+ */
+class FirmataRecordingStream : public Stream
+{
+  public:
+    FirmataRecordingStream(Stream &stream, FirmataCaptureWriter &writer);
+
+    int available(void);
+    int read(void);
+    int peek(void);
+    size_t write(uint8_t c);
+    size_t write(const uint8_t * buffer, size_t size);
+    using Print::write;
+    int availableForWrite(void);
+    void flush(void);
+
+  private:
+    Stream &stream;
+    FirmataCaptureWriter &writer;
+};
+
+} // namespace firmata
+
+#endif /* FirmataRecordingStream_h */
@@ -0,0 +1,643 @@
+/*
+  FirmataSampleStore.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "FirmataSampleStore.h"
+
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "FirmataConstants.h"
+#include "FirmataSysexDecoder.h"
+
+using namespace firmata;
+
+//******************************************************************************
+//* Support Functions
+//******************************************************************************
+
+namespace {
+
+const char MAGIC[4] = { 'F', 'S', 'M', 'P' };
+const uint32_t VERSION = 1;
+const uint64_t GROWTH = 1 << 20;        // [bytes] the file grows by at least this much
+
+static_assert(sizeof(sample_store_header) == 64, "the header is 64 bytes");
+static_assert(sizeof(sample_block_header) == 48, "the block header keeps the payload 8-byte aligned");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "the end of the store is shared with readers in other processes");
+
+/**
+ * @return [us] The wall clock time since the Unix epoch. Unlike the host time of
+ * FirmataClockSync, it keeps counting across reboots, so a reopened store stays in order.
+ */
+uint64_t wallMicros(void)
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+uint32_t seriesOf(uint8_t kind, uint16_t index)
+{
+  return (static_cast<uint32_t>(kind) << 16) | index;
+}
+
+unsigned bitsFor(uint64_t x)
+{
+  return (x ? (64 - __builtin_clzll(x)) : 0);
+}
+
+/**
+ * Append the low bits of a value at a bit position of zeroed words.
+ */
+void putBits(uint64_t * words, uint64_t & position, uint64_t value, unsigned bits)
+{
+  if ( !bits ) { return; }
+  const size_t word = position >> 6;
+  const unsigned offset = position & 63;
+  words[word] |= value << offset;
+  if ( offset + bits > 64 ) { words[word + 1] |= value >> (64 - offset); }
+  position += bits;
+}
+
+uint64_t getBits(const uint64_t * words, uint64_t & position, unsigned bits)
+{
+  if ( !bits ) { return 0; }
+  const size_t word = position >> 6;
+  const unsigned offset = position & 63;
+  uint64_t value = words[word] >> offset;
+  if ( offset + bits > 64 ) { value |= words[word + 1] << (64 - offset); }
+  position += bits;
+  return ((bits == 64) ? value : (value & ((static_cast<uint64_t>(1) << bits) - 1)));
+}
+
+uint64_t payloadSize(uint32_t count, unsigned timeBits, unsigned valueBits)
+{
+  const uint64_t bits = static_cast<uint64_t>(count - 1) * timeBits + static_cast<uint64_t>(count) * valueBits;
+  return (bits + 63) / 64 * 8;
+}
+
+/**
+ * @return true if a block header is consistent and the block ends before end.
+ */
+bool validBlock(const sample_block_header * block, uint64_t offset, uint64_t end)
+{
+  return (block->size >= sizeof(sample_block_header) && (block->size & 7) == 0 && offset + block->size <= end
+    && block->count > 0 && block->count <= FirmataSampleStore::BLOCK_SAMPLES && block->timeBits <= 64 && block->valueBits <= 32
+    && sizeof(sample_block_header) + payloadSize(block->count, block->timeBits, block->valueBits) == block->size);
+}
+
+/**
+ * Unpack the samples of a block.
+ */
+void decodeBlock(const sample_block_header * block, uint64_t * times, uint32_t * values)
+{
+  const uint64_t * words = reinterpret_cast<const uint64_t *>(block + 1);
+  uint64_t position = 0;
+  uint64_t time = block->firstTime;
+  times[0] = time;
+  for (uint32_t i = 1; i < block->count; ++i) {
+    time += getBits(words, position, block->timeBits);
+    times[i] = time;
+  }
+  for (uint32_t i = 0; i < block->count; ++i) {
+    values[i] = block->minValue + static_cast<uint32_t>(getBits(words, position, block->valueBits));
+  }
+}
+
+} // namespace
+
+//******************************************************************************
+//* FirmataSampleStore
+//******************************************************************************
+
+/**
+ * The FirmataSampleStore class.
+ */
+FirmataSampleStore::FirmataSampleStore()
+:
+  fd(-1),
+  mapping(NULL),
+  mappedSize(0),
+  header(NULL),
+  end(0),
+  sampleCount(0)
+{
+  ports.reset();
+}
+
+FirmataSampleStore::~FirmataSampleStore()
+{
+  close();
+}
+
+/**
+ * Create a store, or continue one after its last complete block.
+ * @param path The file.
+ * @return false if the file cannot be opened or mapped, or is not a store of a known version.
+ */
+bool FirmataSampleStore::open(const char * path)
+{
+  close();
+  fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if ( fd < 0 ) { return false; }
+  struct stat st;
+  if ( ::fstat(fd, &st) != 0 || (st.st_size > 0 && static_cast<size_t>(st.st_size) < sizeof(sample_store_header)) ) {
+    close();
+    return false;
+  }
+
+  const bool created = (st.st_size == 0);
+  end = sizeof(sample_store_header);
+  if ( created ) {
+    if ( ::ftruncate(fd, GROWTH) != 0 ) {
+      close();
+      return false;
+    }
+    mappedSize = GROWTH;
+  } else {
+    mappedSize = st.st_size;
+  }
+  void * m = ::mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if ( m == MAP_FAILED ) {
+    mappedSize = 0;
+    close();
+    return false;
+  }
+  mapping = static_cast<uint8_t *>(m);
+  header = reinterpret_cast<sample_store_header *>(mapping);
+
+  if ( created ) {
+    header->version = VERSION;
+    header->end.store(end, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+    return true;
+  }
+
+  if ( std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ) {
+    header = NULL;
+    close();
+    return false;
+  }
+  // continue the chain of each series from the last complete block
+  const uint64_t recorded = header->end.load(std::memory_order_acquire);
+  const uint64_t limit = ((recorded <= mappedSize) ? recorded : mappedSize);
+  while ( end < limit ) {
+    const sample_block_header * block = reinterpret_cast<const sample_block_header *>(mapping + end);
+    if ( !validBlock(block, end, limit) ) { break; }
+    open_series * &buffer = series[block->series];
+    if ( !buffer ) {
+      buffer = new open_series;
+      buffer->count = 0;
+      buffer->lastTime = 0;
+    }
+    buffer->previous = end;
+    if ( block->lastTime > buffer->lastTime ) { buffer->lastTime = block->lastTime; }
+    sampleCount += block->count;
+    end += block->size;
+  }
+  header->end.store(end, std::memory_order_release);
+  return true;
+}
+
+/**
+ * Write the buffered samples and cut the file to its end.
+ */
+void FirmataSampleStore::close(void)
+{
+  if ( header ) {
+    flush();
+    ::ftruncate(fd, end);
+  }
+  if ( mapping ) { ::munmap(mapping, mappedSize); }
+  if ( fd >= 0 ) { ::close(fd); }
+  for (std::unordered_map<uint32_t, open_series *>::iterator it = series.begin(); it != series.end(); ++it) {
+    delete it->second;
+  }
+  series.clear();
+  fd = -1;
+  mapping = NULL;
+  mappedSize = 0;
+  header = NULL;
+  end = 0;
+  sampleCount = 0;
+  ports.reset();
+}
+
+/**
+ * Store the analog and digital reports and the I2C replies a parser decodes, stamped with the
+ * wall clock time [us since the Unix epoch]. This replaces the callbacks of the parser for ANALOG_MESSAGE, DIGITAL_MESSAGE and
+ * START_SYSEX; a client that needs the sysex callback calls appendI2C() instead.
+ * @param parser The parser of the board stream.
+ */
+void FirmataSampleStore::attach(FirmataParser &parser)
+{
+  parser.attach(ANALOG_MESSAGE, staticAnalogCallback, this);
+  parser.attach(DIGITAL_MESSAGE, staticDigitalCallback, this);
+  parser.attach(START_SYSEX, staticSysexCallback, this);
+}
+
+/**
+ * Buffer a sample, writing the block of its series when it is full. The times of a series must
+ * not go backwards, also across blocks and reopens; an earlier time is stored as the latest
+ * time of the series so far.
+ * @param kind A sample_kind.
+ * @param index The analog channel, the pin or the address and register.
+ * @param value The value.
+ * @param time [us] The time of the sample.
+ */
+void FirmataSampleStore::append(uint8_t kind, uint16_t index, uint32_t value, uint64_t time)
+{
+  if ( !header ) { return; }
+  const uint32_t id = seriesOf(kind, index);
+  open_series * &buffer = series[id];
+  if ( !buffer ) {
+    buffer = new open_series;
+    buffer->previous = 0;
+    buffer->count = 0;
+    buffer->lastTime = 0;
+  }
+  if ( time < buffer->lastTime ) { time = buffer->lastTime; }
+  buffer->lastTime = time;
+  buffer->times[buffer->count] = time;
+  buffer->values[buffer->count] = value;
+  ++sampleCount;
+  if ( ++buffer->count == BLOCK_SAMPLES ) { seal(id, *buffer); }
+}
+
+/**
+ * Buffer the bytes of an I2C reply as samples of consecutive registers.
+ * @param address The 7-bit address of the device.
+ * @param reg The first register, 0 for a read without one.
+ * @param data The bytes.
+ * @param length The number of bytes.
+ * @param time [us] The time of the reply.
+ */
+void FirmataSampleStore::appendI2C(uint8_t address, uint8_t reg, const uint8_t * data, size_t length, uint64_t time)
+{
+  for (size_t i = 0; i < length; ++i) {
+    append(SAMPLE_I2C, static_cast<uint16_t>(((address & 0x7F) << 8) | ((reg + i) & 0xFF)), data[i], time);
+  }
+}
+
+/**
+ * Write the buffered samples of every series as blocks, so readers see them. Call it now and
+ * then, e.g. once a second; smaller blocks compress less well.
+ */
+void FirmataSampleStore::flush(void)
+{
+  for (std::unordered_map<uint32_t, open_series *>::iterator it = series.begin(); it != series.end(); ++it) {
+    seal(it->first, *it->second);
+  }
+}
+
+/**
+ * @return The number of samples in the store, including those not written yet.
+ */
+uint64_t FirmataSampleStore::samples(void)
+const
+{
+  return sampleCount;
+}
+
+/**
+ * @return The bytes of the blocks written, header included.
+ */
+uint64_t FirmataSampleStore::size(void)
+const
+{
+  return end;
+}
+
+/**
+ * Pack the buffered samples of a series into a block at the end of the file.
+ * @private
+ */
+void FirmataSampleStore::seal(uint32_t id, open_series &buffer)
+{
+  const uint32_t count = buffer.count;
+  if ( !count ) { return; }
+  buffer.count = 0;
+
+  uint32_t low = buffer.values[0];
+  uint32_t high = buffer.values[0];
+  uint64_t largestDelta = 0;
+  for (uint32_t i = 1; i < count; ++i) {
+    if ( buffer.values[i] < low ) { low = buffer.values[i]; }
+    if ( buffer.values[i] > high ) { high = buffer.values[i]; }
+    const uint64_t delta = buffer.times[i] - buffer.times[i - 1];
+    if ( delta > largestDelta ) { largestDelta = delta; }
+  }
+  const unsigned timeBits = bitsFor(largestDelta);
+  const unsigned valueBits = bitsFor(high - low);
+  const uint64_t blockSize = sizeof(sample_block_header) + payloadSize(count, timeBits, valueBits);
+  if ( !reserve(blockSize) ) { return; }
+
+  sample_block_header * block = reinterpret_cast<sample_block_header *>(mapping + end);
+  uint64_t * words = reinterpret_cast<uint64_t *>(block + 1);
+  // the space past the end may hold a block cut off by a crash
+  std::memset(words, 0, blockSize - sizeof(sample_block_header));
+  uint64_t position = 0;
+  for (uint32_t i = 1; i < count; ++i) {
+    putBits(words, position, buffer.times[i] - buffer.times[i - 1], timeBits);
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    putBits(words, position, buffer.values[i] - low, valueBits);
+  }
+  block->size = static_cast<uint32_t>(blockSize);
+  block->series = id;
+  block->count = count;
+  block->timeBits = static_cast<uint8_t>(timeBits);
+  block->valueBits = static_cast<uint8_t>(valueBits);
+  block->reserved = 0;
+  block->firstTime = buffer.times[0];
+  block->lastTime = buffer.times[count - 1];
+  block->minValue = low;
+  block->maxValue = high;
+  block->previous = buffer.previous;
+
+  buffer.previous = end;
+  end += blockSize;
+  header->end.store(end, std::memory_order_release);
+}
+
+/**
+ * Grow the file and its mapping so that bytes more fit after the end.
+ * @return false if the file cannot grow.
+ * @private
+ */
+bool FirmataSampleStore::reserve(uint64_t bytes)
+{
+  if ( end + bytes <= mappedSize ) { return true; }
+  uint64_t grown = mappedSize * 2;
+  if ( grown < end + bytes + GROWTH ) { grown = end + bytes + GROWTH; }
+  if ( ::ftruncate(fd, grown) != 0 ) { return false; }
+  void * m = ::mmap(NULL, grown, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if ( m == MAP_FAILED ) { return false; }
+  ::munmap(mapping, mappedSize);
+  mapping = static_cast<uint8_t *>(m);
+  mappedSize = grown;
+  header = reinterpret_cast<sample_store_header *>(mapping);
+  return true;
+}
+
+/**
+ * @private
+ */
+void FirmataSampleStore::staticAnalogCallback(void * context, uint8_t command, uint16_t value)
+{
+  static_cast<FirmataSampleStore *>(context)->append(SAMPLE_ANALOG, (command & 0x0F), value, wallMicros());
+}
+
+/**
+ * One sample per pin of the port that changed; all eight for the first report of a port.
+ * @private
+ */
+void FirmataSampleStore::staticDigitalCallback(void * context, uint8_t command, uint16_t value)
+{
+  FirmataSampleStore * store = static_cast<FirmataSampleStore *>(context);
+  const uint8_t port = command & 0x0F;
+  const uint8_t changed = store->ports.update(port, static_cast<uint8_t>(value));
+  if ( !changed ) { return; }
+
+  const uint64_t now = wallMicros();
+  for (uint8_t bit = 0; bit < 8; ++bit) {
+    if ( changed & (1 << bit) ) {
+      store->append(SAMPLE_DIGITAL, static_cast<uint16_t>(port * 8 + bit), ((value >> bit) & 0x01), now);
+    }
+  }
+}
+
+/**
+ * @private
+ */
+void FirmataSampleStore::staticSysexCallback(void * context, uint8_t command, size_t argc, uint8_t * argv)
+{
+  i2c_reply_view reply;
+  if ( command != I2C_REPLY || !FirmataSysexDecoder::decodeI2CReply(argc, argv, reply) ) { return; }
+  static_cast<FirmataSampleStore *>(context)->appendI2C(reply.address, static_cast<uint8_t>(reply.reg), reply.data, reply.length, wallMicros());
+}
+
+//******************************************************************************
+//* FirmataSampleReader
+//******************************************************************************
+
+/**
+ * The FirmataSampleReader class.
+ */
+FirmataSampleReader::FirmataSampleReader()
+:
+  fd(-1),
+  mapping(NULL),
+  mappedSize(0),
+  indexed(0),
+  blockCount(0)
+{
+}
+
+FirmataSampleReader::~FirmataSampleReader()
+{
+  close();
+}
+
+/**
+ * Map a store read-only and index its blocks.
+ * @param path The file.
+ * @return false if the file is not a store of a known version.
+ */
+bool FirmataSampleReader::open(const char * path)
+{
+  close();
+  fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if ( fd < 0 ) { return false; }
+  indexed = sizeof(sample_store_header);
+  if ( !refresh() ) {
+    close();
+    return false;
+  }
+  const sample_store_header * header = reinterpret_cast<const sample_store_header *>(mapping);
+  if ( std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Unmap the store.
+ */
+void FirmataSampleReader::close(void)
+{
+  if ( mapping ) { ::munmap(const_cast<uint8_t *>(mapping), mappedSize); }
+  if ( fd >= 0 ) { ::close(fd); }
+  fd = -1;
+  mapping = NULL;
+  mappedSize = 0;
+  indexed = 0;
+  blockCount = 0;
+  index.clear();
+}
+
+/**
+ * Index the blocks written since open() or the last refresh().
+ * @return false if the store cannot be mapped.
+ */
+bool FirmataSampleReader::refresh(void)
+{
+  if ( fd < 0 ) { return false; }
+  uint64_t end = (mapping ? reinterpret_cast<const sample_store_header *>(mapping)->end.load(std::memory_order_acquire) : 0);
+  if ( !mapping || end > mappedSize ) {
+    // the writer grows the file before it moves the end past the old size
+    struct stat st;
+    if ( ::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(sample_store_header) ) { return false; }
+    void * m = ::mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if ( m == MAP_FAILED ) { return false; }
+    if ( mapping ) { ::munmap(const_cast<uint8_t *>(mapping), mappedSize); }
+    mapping = static_cast<const uint8_t *>(m);
+    mappedSize = st.st_size;
+    end = reinterpret_cast<const sample_store_header *>(mapping)->end.load(std::memory_order_acquire);
+    if ( end > mappedSize ) { end = mappedSize; }
+  }
+
+  while ( indexed < end ) {
+    const sample_block_header * block = reinterpret_cast<const sample_block_header *>(mapping + indexed);
+    if ( !validBlock(block, indexed, end) ) { break; }
+    block_entry entry;
+    entry.offset = indexed;
+    entry.firstTime = block->firstTime;
+    entry.lastTime = block->lastTime;
+    entry.minValue = block->minValue;
+    entry.maxValue = block->maxValue;
+    index[block->series].push_back(entry);
+    ++blockCount;
+    indexed += block->size;
+  }
+  return true;
+}
+
+/**
+ * Call a callback for each sample of a series in a time range, oldest first.
+ * @param kind A sample_kind.
+ * @param index The analog channel, the pin or the address and register.
+ * @param from [us] The first time, inclusive.
+ * @param to [us] The last time, inclusive.
+ * @param callback Called with the time and the value of each sample.
+ * @param context An optional context to be provided to the callback function.
+ * @return The number of samples.
+ */
+size_t FirmataSampleReader::query(uint8_t kind, uint16_t index, uint64_t from, uint64_t to, sampleCallbackFunction callback, void * context)
+const
+{
+  return query(kind, index, from, to, 0, 0xFFFFFFFF, callback, context);
+}
+
+/**
+ * Call a callback for each sample of a series in a time range and a value range, oldest first.
+ * Blocks whose values are all outside the value range are skipped, e.g. to find the samples
+ * above a threshold.
+ * @param low The lowest value, inclusive.
+ * @param high The highest value, inclusive.
+ * @return The number of samples.
+ */
+size_t FirmataSampleReader::query(uint8_t kind, uint16_t index, uint64_t from, uint64_t to, uint32_t low, uint32_t high, sampleCallbackFunction callback, void * context)
+const
+{
+  std::unordered_map<uint32_t, std::vector<block_entry> >::const_iterator it = this->index.find(seriesOf(kind, index));
+  if ( it == this->index.end() ) { return 0; }
+  uint64_t times[FirmataSampleStore::BLOCK_SAMPLES];
+  uint32_t values[FirmataSampleStore::BLOCK_SAMPLES];
+  size_t found = 0;
+  for (size_t b = 0; b < it->second.size(); ++b) {
+    const block_entry &entry = it->second[b];
+    if ( entry.lastTime < from || entry.firstTime > to || entry.maxValue < low || entry.minValue > high ) { continue; }
+    const sample_block_header * header = block(entry);
+    decodeBlock(header, times, values);
+    for (uint32_t i = 0; i < header->count; ++i) {
+      if ( times[i] < from || times[i] > to || values[i] < low || values[i] > high ) { continue; }
+      if ( callback ) { (*callback)(context, times[i], values[i]); }
+      ++found;
+    }
+  }
+  return found;
+}
+
+/**
+ * Count a series in a time range and find its extremes. Blocks entirely in the range are
+ * answered from their header.
+ * @param kind A sample_kind.
+ * @param index The analog channel, the pin or the address and register.
+ * @param from [us] The first time, inclusive.
+ * @param to [us] The last time, inclusive.
+ * @return The summary; min and max are 0 if there are no samples.
+ */
+sample_summary FirmataSampleReader::summarize(uint8_t kind, uint16_t index, uint64_t from, uint64_t to)
+const
+{
+  sample_summary summary;
+  std::memset(&summary, 0, sizeof(summary));
+  summary.min = 0xFFFFFFFF;
+  std::unordered_map<uint32_t, std::vector<block_entry> >::const_iterator it = this->index.find(seriesOf(kind, index));
+  if ( it != this->index.end() ) {
+    uint64_t times[FirmataSampleStore::BLOCK_SAMPLES];
+    uint32_t values[FirmataSampleStore::BLOCK_SAMPLES];
+    for (size_t b = 0; b < it->second.size(); ++b) {
+      const block_entry &entry = it->second[b];
+      if ( entry.lastTime < from || entry.firstTime > to ) {
+        ++summary.blocksSkipped;
+        continue;
+      }
+      const sample_block_header * header = block(entry);
+      if ( entry.firstTime >= from && entry.lastTime <= to ) {
+        summary.count += header->count;
+        if ( entry.minValue < summary.min ) { summary.min = entry.minValue; }
+        if ( entry.maxValue > summary.max ) { summary.max = entry.maxValue; }
+        ++summary.blocksSkipped;
+        continue;
+      }
+      decodeBlock(header, times, values);
+      for (uint32_t i = 0; i < header->count; ++i) {
+        if ( times[i] < from || times[i] > to ) { continue; }
+        ++summary.count;
+        if ( values[i] < summary.min ) { summary.min = values[i]; }
+        if ( values[i] > summary.max ) { summary.max = values[i]; }
+      }
+      ++summary.blocksRead;
+    }
+  }
+  if ( !summary.count ) { summary.min = 0; }
+  return summary;
+}
+
+/**
+ * @return The number of blocks indexed.
+ */
+size_t FirmataSampleReader::blocks(void)
+const
+{
+  return blockCount;
+}
+
+/**
+ * @private
+ */
+const sample_block_header * FirmataSampleReader::block(const block_entry &entry)
+const
+{
+  return reinterpret_cast<const sample_block_header *>(mapping + entry.offset);
+}
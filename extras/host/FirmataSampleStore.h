@@ -0,0 +1,187 @@
+/*
+  FirmataSampleStore.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  A columnar store of decoded samples: analog channels, digital pins and I2C
+  registers, one series each. Samples are buffered per series and written
+  as blocks of up to 1024 samples to a memory-mapped file that only grows.
+
+  A store is a 64 byte header followed by blocks:
+
+    header   "FSMP", version (1), end (bytes of complete blocks, header
+             included), 48 bytes reserved
+    block    size (bytes, header included, a multiple of 8), series (kind
+             << 16 | index), count, time bits, value bits, reserved (2),
+             first time [us], last time [us], min value, max value,
+             offset of the previous block of the series (0 for none),
+             then the time deltas and the values as bit-packed 64-bit words
+
+  The first time is in the header; the count - 1 deltas to the previous
+  sample follow, each in time bits. The values are stored as value - min
+  value, each in value bits, so a pin that did not change costs no value
+  bits at all. Multi-byte fields are in host byte order.
+
+  Samples stored from a parser are stamped with the wall clock (us since
+  the Unix epoch), which, unlike the host time of FirmataClockSync, goes on
+  across reboots. The times of a series never go backwards, across blocks
+  and reopens alike: an earlier time is stored as the latest one so far.
+
+  The end in the header moves past a block only once the block is written,
+  so a reader, even in another process, never sees a partial block, and a
+  writer that reopens the file after a crash continues from the last
+  complete block. Queries skip the blocks whose time range, or value range,
+  cannot match without decoding them.
+*/
+
+#ifndef FirmataSampleStore_h
+#define FirmataSampleStore_h
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "FirmataParser.h"
+#include "FirmataPortLevels.h"
+
+namespace firmata {
+
+enum sample_kind {
+  SAMPLE_ANALOG = 1,        // index: the analog channel
+  SAMPLE_DIGITAL = 2,       // index: the pin
+  SAMPLE_I2C = 3,           // index: address << 8 | register, one series per register byte
+};
+
+/**
+ * The on-disk layout, see the comment at the top of this file.
+ */
+struct sample_store_header {
+  char magic[4];
+  uint32_t version;
+  std::atomic<uint64_t> end;
+  uint8_t reserved[48];
+};
+
+struct sample_block_header {
+  uint32_t size;
+  uint32_t series;
+  uint32_t count;
+  uint8_t timeBits;
+  uint8_t valueBits;
+  uint16_t reserved;
+  uint64_t firstTime;
+  uint64_t lastTime;
+  uint32_t minValue;
+  uint32_t maxValue;
+  uint64_t previous;
+};
+
+/**
+ * The count, minimum and maximum of the samples of a series in a time range.
+ */
+struct sample_summary {
+  uint64_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t blocksRead;      // blocks decoded
+  uint64_t blocksSkipped;   // blocks answered from their header or skipped
+};
+
+/**
+ * Appends samples to a store. Single writer; not thread-safe.
+ */
+class FirmataSampleStore
+{
+  public:
+    static const size_t BLOCK_SAMPLES = 1024;
+
+    FirmataSampleStore();
+    ~FirmataSampleStore();
+
+    bool open(const char * path);
+    void close(void);
+    void attach(FirmataParser &parser);
+
+    void append(uint8_t kind, uint16_t index, uint32_t value, uint64_t time);
+    void appendI2C(uint8_t address, uint8_t reg, const uint8_t * data, size_t length, uint64_t time);
+    void flush(void);
+
+    uint64_t samples(void) const;
+    uint64_t size(void) const;
+
+  private:
+    struct open_series {
+      uint64_t previous;                 // offset of the last block written
+      uint64_t lastTime;                 // [us] of the latest sample, written or buffered
+      uint32_t count;
+      uint64_t times[BLOCK_SAMPLES];
+      uint32_t values[BLOCK_SAMPLES];
+    };
+
+    void seal(uint32_t series, open_series &buffer);
+    bool reserve(uint64_t bytes);
+
+    static void staticAnalogCallback(void * context, uint8_t command, uint16_t value);
+    static void staticDigitalCallback(void * context, uint8_t command, uint16_t value);
+    static void staticSysexCallback(void * context, uint8_t command, size_t argc, uint8_t * argv);
+
+    int fd;
+    uint8_t * mapping;
+    uint64_t mappedSize;
+    sample_store_header * header;
+    uint64_t end;
+    uint64_t sampleCount;
+    std::unordered_map<uint32_t, open_series *> series;
+    port_levels ports;                   // the last report of each digital port
+};
+
+/**
+ * Maps a store read-only and answers range queries, also while it is written.
+ */
+class FirmataSampleReader
+{
+  public:
+    typedef void (*sampleCallbackFunction)(void * context, uint64_t time, uint32_t value);
+
+    FirmataSampleReader();
+    ~FirmataSampleReader();
+
+    bool open(const char * path);
+    void close(void);
+    bool refresh(void);
+
+    size_t query(uint8_t kind, uint16_t index, uint64_t from, uint64_t to, sampleCallbackFunction callback, void * context = NULL) const;
+    size_t query(uint8_t kind, uint16_t index, uint64_t from, uint64_t to, uint32_t low, uint32_t high, sampleCallbackFunction callback, void * context = NULL) const;
+    sample_summary summarize(uint8_t kind, uint16_t index, uint64_t from, uint64_t to) const;
+    size_t blocks(void) const;
+
+  private:
+    struct block_entry {
+      uint64_t offset;
+      uint64_t firstTime;
+      uint64_t lastTime;
+      uint32_t minValue;
+      uint32_t maxValue;
+    };
+
+    const sample_block_header * block(const block_entry &entry) const;
+
+    int fd;
+    const uint8_t * mapping;
+    uint64_t mappedSize;
+    uint64_t indexed;                    // offset up to which the blocks are indexed
+    size_t blockCount;
+    std::unordered_map<uint32_t, std::vector<block_entry> > index;
+};
+
+} // namespace firmata
+
+#endif /* FirmataSampleStore_h */
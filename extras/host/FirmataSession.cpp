@@ -0,0 +1,130 @@
+/*
+  FirmataSession.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "FirmataSession.h"
+
+#include <memory>
+#include <new>
+#include <vector>
+
+using namespace firmata;
+
+//******************************************************************************
+//* Support Functions
+//******************************************************************************
+
+namespace {
+
+const size_t MIN_FRAME_SHIFT = 6;           // 64 bytes
+const size_t MAX_FRAME_SHIFT = 12;          // 4 KB
+const size_t SIZE_CLASSES = MAX_FRAME_SHIFT - MIN_FRAME_SHIFT + 1;
+const size_t SLAB_SIZE = 65536;
+
+struct free_frame {
+  free_frame * next;
+};
+
+struct frame_pool {
+  free_frame * freeLists[SIZE_CLASSES];
+  std::vector<std::unique_ptr<uint8_t[]> > slabs;
+  size_t slabUsed;                          // [bytes] carved from the last slab
+  size_t inUse;
+
+  frame_pool(void) : slabUsed(SLAB_SIZE), inUse(0)
+  {
+    for (size_t i = 0; i < SIZE_CLASSES; ++i) { freeLists[i] = NULL; }
+  }
+};
+
+thread_local frame_pool pool;
+
+/**
+ * @return The size class of a frame, SIZE_CLASSES if it is too large for the pool.
+ */
+size_t sizeClass(size_t size)
+{
+  size_t shift = MIN_FRAME_SHIFT;
+  while ( shift <= MAX_FRAME_SHIFT && (static_cast<size_t>(1) << shift) < size ) { ++shift; }
+  return shift - MIN_FRAME_SHIFT;
+}
+
+} // namespace
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+/**
+ * Take a frame from the free list of its size class, or carve it from the current slab.
+ * @param size The size of the frame.
+ * @return The frame; throws std::bad_alloc like operator new.
+ */
+void * FirmataFramePool::allocate(size_t size)
+{
+  const size_t c = sizeClass(size);
+  if ( c >= SIZE_CLASSES ) { return ::operator new(size); }
+
+  free_frame * frame = pool.freeLists[c];
+  if ( frame ) {
+    pool.freeLists[c] = frame->next;
+    ++pool.inUse;
+    return frame;
+  }
+  const size_t bytes = static_cast<size_t>(1) << (c + MIN_FRAME_SHIFT);
+  if ( pool.slabUsed + bytes > SLAB_SIZE ) {
+    pool.slabs.push_back(std::unique_ptr<uint8_t[]>(new uint8_t[SLAB_SIZE]));
+    pool.slabUsed = 0;
+  }
+  void * carved = pool.slabs.back().get() + pool.slabUsed;
+  pool.slabUsed += bytes;
+  ++pool.inUse;
+  return carved;
+}
+
+/**
+ * Put a frame back on the free list of its size class. Must run on the thread that allocated
+ * it, which a session coroutine does as it is resumed on the thread of its client.
+ * @param frame The frame.
+ * @param size The size passed to allocate().
+ */
+void FirmataFramePool::deallocate(void * frame, size_t size)
+{
+  const size_t c = sizeClass(size);
+  if ( c >= SIZE_CLASSES ) {
+    ::operator delete(frame);
+    return;
+  }
+  --pool.inUse;
+  free_frame * f = static_cast<free_frame *>(frame);
+  f->next = pool.freeLists[c];
+  pool.freeLists[c] = f;
+}
+
+/**
+ * @return The number of pooled frames in use on this thread.
+ */
+size_t FirmataFramePool::framesInUse(void)
+{
+  return pool.inUse;
+}
+
+/**
+ * @return The bytes of the slabs of this thread.
+ */
+size_t FirmataFramePool::bytesReserved(void)
+{
+  return pool.slabs.size() * SLAB_SIZE;
+}
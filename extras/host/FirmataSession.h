@@ -0,0 +1,174 @@
+/*
+  FirmataSession.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  C++20 coroutine API on top of FirmataClient, for sequential control logic
+  without a thread per board:
+
+    firmata::session_task control(firmata::FirmataSession session)
+    {
+      firmata::session_reply reply = co_await session.capabilities();
+      reply = co_await session.i2cRead(0x48, 0x00, 2);
+      if (reply.ok()) { ... reply.data[0] ... }
+    }
+
+  A coroutine runs on the thread that feeds its client, e.g. the shard of a
+  FirmataEngine board, and is resumed from the completion callbacks of the
+  client. Its frame comes from FirmataFramePool. Unlike the rest of this
+  directory, this file needs -std=c++20.
+*/
+
+#ifndef FirmataSession_h
+#define FirmataSession_h
+
+#if __cplusplus < 202002L
+#error "FirmataSession.h needs C++20 coroutines (-std=c++20)"
+#endif
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+
+#include "FirmataClient.h"
+
+namespace firmata {
+
+/**
+ * Free lists of coroutine frames in size classes of 64 bytes to 4 KB, carved from 64 KB slabs,
+ * one pool per thread. Slabs are kept until the thread exits, so a steady number of sessions
+ * stops allocating after the first frames. Larger frames go to the global operator new.
+ */
+class FirmataFramePool
+{
+  public:
+    static void * allocate(size_t size);
+    static void deallocate(void * frame, size_t size);
+    static size_t framesInUse(void);
+    static size_t bytesReserved(void);
+};
+
+/**
+ * The return type of a session coroutine. It starts at once, runs to its first co_await and
+ * frees its frame when it returns; nothing waits for it.
+ */
+struct session_task {
+  struct promise_type {
+    session_task get_return_object(void) noexcept { return session_task(); }
+    std::suspend_never initial_suspend(void) noexcept { return std::suspend_never(); }
+    std::suspend_never final_suspend(void) noexcept { return std::suspend_never(); }
+    void return_void(void) noexcept {}
+    void unhandled_exception(void) noexcept { std::terminate(); }
+
+    static void * operator new(size_t size) { return FirmataFramePool::allocate(size); }
+    static void operator delete(void * frame, size_t size) { FirmataFramePool::deallocate(frame, size); }
+  };
+};
+
+/**
+ * The result of an awaited request. CLIENT_CANCELLED also reports a request that was not sent
+ * because MAX_PENDING requests were in flight.
+ */
+struct session_reply {
+  client_request_status status;
+  uint32_t latency;       // [us]
+  size_t length;          // i2cRead(): bytes read
+  uint8_t data[FirmataClient::MAX_I2C_DATA];
+
+  bool ok(void) const { return (status == CLIENT_COMPLETED); }
+};
+
+/**
+ * The awaitable of one request. It lives in the frame of the awaiting coroutine, which is where
+ * the completion callback copies the reply to.
+ */
+class session_request
+{
+  public:
+    session_request(FirmataClient &client, client_request_type type, uint8_t pin = 0, uint8_t address = 0, int16_t reg = -1, uint8_t length = 0)
+    :
+      client(client),
+      type(type),
+      pin(pin),
+      address(address),
+      reg(reg),
+      length(length)
+    {
+    }
+
+    bool await_ready(void) const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+      waiter = handle;
+      uint16_t id = 0;
+      switch (type) {
+        case CLIENT_FIRMWARE: id = client.queryFirmware(staticCompletionCallback, this); break;
+        case CLIENT_CAPABILITIES: id = client.queryCapabilities(staticCompletionCallback, this); break;
+        case CLIENT_ANALOG_MAPPING: id = client.queryAnalogMapping(staticCompletionCallback, this); break;
+        case CLIENT_PIN_STATE: id = client.queryPinState(pin, staticCompletionCallback, this); break;
+        case CLIENT_I2C_READ: id = client.readI2C(address, reg, length, staticCompletionCallback, this); break;
+      }
+      if ( id ) { return true; }
+      reply.status = CLIENT_CANCELLED;
+      reply.latency = 0;
+      reply.length = 0;
+      return false;
+    }
+
+    session_reply await_resume(void) const noexcept { return reply; }
+
+  private:
+    static void staticCompletionCallback(void * context, const client_completion &completion)
+    {
+      session_request * request = static_cast<session_request *>(context);
+      request->reply.status = completion.status;
+      request->reply.latency = completion.latency;
+      request->reply.length = completion.length;
+      if ( completion.length ) { std::memcpy(request->reply.data, completion.data, completion.length); }
+      request->waiter.resume();
+    }
+
+    FirmataClient &client;
+    client_request_type type;
+    uint8_t pin;
+    uint8_t address;
+    int16_t reg;
+    uint8_t length;
+    std::coroutine_handle<> waiter;
+    session_reply reply;
+};
+
+/**
+ * A board as seen from a coroutine: the awaitable queries of its client and its model. Cheap to
+ * copy, so pass it to session coroutines by value.
+ */
+class FirmataSession
+{
+  public:
+    explicit FirmataSession(FirmataClient &client) : firmataClient(&client) {}
+
+    session_request firmware(void) const { return session_request(*firmataClient, CLIENT_FIRMWARE); }
+    session_request capabilities(void) const { return session_request(*firmataClient, CLIENT_CAPABILITIES); }
+    session_request analogMapping(void) const { return session_request(*firmataClient, CLIENT_ANALOG_MAPPING); }
+    session_request queryPinState(uint8_t pin) const { return session_request(*firmataClient, CLIENT_PIN_STATE, pin); }
+    session_request i2cRead(uint8_t address, int16_t reg, uint8_t length) const { return session_request(*firmataClient, CLIENT_I2C_READ, 0, address, reg, length); }
+
+    FirmataClient & client(void) const { return *firmataClient; }
+    const board_model & board(void) const { return firmataClient->board(); }
+
+  private:
+    FirmataClient * firmataClient;
+};
+
+} // namespace firmata
+
+#endif /* FirmataSession_h */
@@ -0,0 +1,214 @@
+/*
+  FirmataSysexDecoder.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "FirmataSysexDecoder.h"
+
+#include <cstring>
+
+using namespace firmata;
+
+//******************************************************************************
+//* Support Functions
+//******************************************************************************
+
+namespace {
+
+// defined by SerialFirmata, which only compiles for a board
+const uint8_t SERIAL_REPLY = 0x40;
+const uint8_t SERIAL_PORT_MASK = 0x0F;
+const uint8_t END_OF_PIN = 0x7F;
+const uint8_t NO_CHANNEL = 0x7F;
+
+} // namespace
+
+//******************************************************************************
+//* Views
+//******************************************************************************
+
+/**
+ * @param pin The pin.
+ * @param mode One of the PIN_MODE_* constants.
+ * @return true if the pin supports the mode.
+ */
+bool capability_view::supports(uint8_t pin, uint8_t mode)
+const
+{
+  return (pin < pinCount && mode < 16 && (modes[pin] & (1 << mode)));
+}
+
+/**
+ * @param pin The pin.
+ * @param mode One of the PIN_MODE_* constants.
+ * @return The resolution of the pin in the mode [bits], 0 if the pin does not support it.
+ */
+uint8_t capability_view::resolution(uint8_t pin, uint8_t mode)
+const
+{
+  if ( !supports(pin, mode) ) { return 0; }
+  // a handful of pairs, ended by END_OF_PIN as checked by decodeCapabilities()
+  for (size_t i = offsets[pin]; argv[i] != END_OF_PIN; i += 2) {
+    if ( argv[i] == mode ) { return argv[i + 1]; }
+  }
+  return 0;
+}
+
+/**
+ * @param pin The pin.
+ * @return The analog channel of the pin, 0x7F if it has none.
+ */
+uint8_t analog_mapping_view::channel(uint8_t pin)
+const
+{
+  return ((pin < pinCount) ? channels[pin] : NO_CHANNEL);
+}
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+/**
+ * Pins as runs of (mode, resolution) pairs, each run ended by 0x7F.
+ * @param argc The number of bytes of the reply.
+ * @param argv The reply.
+ * @param view Set to the decoded reply.
+ * @return false if a run is not ended or there are more than capability_view::MAX_PINS.
+ */
+bool FirmataSysexDecoder::decodeCapabilities(size_t argc, const uint8_t * argv, capability_view &view)
+{
+  size_t pin = 0;
+  size_t i = 0;
+  while ( i < argc ) {
+    if ( pin == capability_view::MAX_PINS ) { return false; }
+    uint16_t modes = 0;
+    view.offsets[pin] = static_cast<uint16_t>(i);
+    for (; i < argc && argv[i] != END_OF_PIN; i += 2) {
+      if ( i + 1 >= argc ) { return false; }
+      if ( argv[i] < 16 ) { modes |= static_cast<uint16_t>(1 << argv[i]); }
+    }
+    if ( i >= argc ) { return false; }
+    view.modes[pin++] = modes;
+    ++i;
+  }
+  view.pinCount = pin;
+  view.argv = argv;
+  return true;
+}
+
+/**
+ * The analog channel of each pin, 0x7F for none.
+ * @param argc The number of bytes of the reply.
+ * @param argv The reply.
+ * @param view Set to the decoded reply.
+ * @return false if there are more pins than pin numbers.
+ */
+bool FirmataSysexDecoder::decodeAnalogMapping(size_t argc, const uint8_t * argv, analog_mapping_view &view)
+{
+  if ( argc > capability_view::MAX_PINS ) { return false; }
+  view.pinCount = argc;
+  view.channels = argv;
+  std::memset(view.pins, NO_CHANNEL, sizeof(view.pins));
+  for (size_t pin = 0; pin < argc; ++pin) {
+    if ( argv[pin] < analog_mapping_view::MAX_CHANNELS ) {
+      view.pins[argv[pin]] = static_cast<uint8_t>(pin);
+    }
+  }
+  return true;
+}
+
+/**
+ * The pin, its mode and its value in 7-bit bytes, least significant first.
+ * @param argc The number of bytes of the reply.
+ * @param argv The reply.
+ * @param view Set to the decoded reply.
+ * @return false if the pin or the mode is missing.
+ */
+bool FirmataSysexDecoder::decodePinState(size_t argc, const uint8_t * argv, pin_state_view &view)
+{
+  if ( argc < 2 ) { return false; }
+  view.pin = argv[0] & 0x7F;
+  view.mode = argv[1];
+  uint32_t value = 0;
+  for (size_t i = 2; i < argc && i < 2 + 5; ++i) {
+    value |= static_cast<uint32_t>(argv[i] & 0x7F) << (7 * (i - 2));
+  }
+  view.value = value;
+  return true;
+}
+
+/**
+ * The address, the register and the data, each byte as two 7-bit bytes. The data is decoded in
+ * place.
+ * @param argc The number of bytes of the reply.
+ * @param argv The reply, overwritten by the data.
+ * @param view Set to the decoded reply.
+ * @return false if the address or the register is missing.
+ */
+bool FirmataSysexDecoder::decodeI2CReply(size_t argc, uint8_t * argv, i2c_reply_view &view)
+{
+  if ( argc < 4 ) { return false; }
+  view.address = static_cast<uint8_t>(argv[0] | (argv[1] << 7));
+  view.reg = static_cast<uint16_t>(argv[2] | (argv[3] << 7));
+  view.length = decodePairs(argv + 4, (argc - 4) / 2, argv + 4);
+  view.data = argv + 4;
+  return true;
+}
+
+/**
+ * SERIAL_REPLY | port, then the bytes received, each as two 7-bit bytes. The bytes are decoded
+ * in place.
+ * @param argc The number of bytes of the SERIAL_DATA message.
+ * @param argv The message, overwritten by the bytes.
+ * @param view Set to the decoded reply.
+ * @return false if the message is not a SERIAL_REPLY.
+ */
+bool FirmataSysexDecoder::decodeSerialReply(size_t argc, uint8_t * argv, serial_reply_view &view)
+{
+  if ( argc < 1 || (argv[0] & ~SERIAL_PORT_MASK) != SERIAL_REPLY ) { return false; }
+  view.port = argv[0] & SERIAL_PORT_MASK;
+  view.length = decodePairs(argv + 1, (argc - 1) / 2, argv + 1);
+  view.data = argv + 1;
+  return true;
+}
+
+/**
+ * Join 7-bit pairs (least significant 7 bits first) to bytes, four at a time on little-endian
+ * hosts: the pairs are read as one 64-bit word, each 16-bit lane is folded to its byte, and the
+ * four bytes are packed with two shifts. bytes may be pairs, as the bytes never overtake the
+ * pairs still to be read.
+ * @param pairs 2 * count 7-bit bytes.
+ * @param count The number of pairs.
+ * @param bytes Set to count bytes.
+ * @return count.
+ */
+size_t FirmataSysexDecoder::decodePairs(const uint8_t * pairs, size_t count, uint8_t * bytes)
+{
+  size_t i = 0;
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  for (; i + 4 <= count; i += 4) {
+    uint64_t x;
+    std::memcpy(&x, pairs + 2 * i, sizeof(x));
+    x = (x & 0x007F007F007F007FULL) | ((x >> 1) & 0x0080008000800080ULL);
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+    const uint32_t packed = static_cast<uint32_t>(x);
+    std::memcpy(bytes + i, &packed, sizeof(packed));
+  }
+#endif
+  for (; i < count; ++i) {
+    bytes[i] = static_cast<uint8_t>(pairs[2 * i] | (pairs[2 * i + 1] << 7));
+  }
+  return count;
+}
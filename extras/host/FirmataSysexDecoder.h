@@ -0,0 +1,114 @@
+/*
+  FirmataSysexDecoder.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Typed views of the sysex replies of StandardFirmata, decoded from the argv
+  that FirmataParser passes to the generic sysex callback:
+
+    void sysexCallback(void * context, uint8_t command, size_t argc, uint8_t * argv)
+    {
+      firmata::i2c_reply_view reply;
+      if (command == I2C_REPLY && firmata::FirmataSysexDecoder::decodeI2CReply(argc, argv, reply)) {
+        // reply.data[0 .. reply.length - 1]
+      }
+    }
+
+  Nothing is copied: the views point into argv, and the byte payloads of
+  I2C_REPLY and SERIAL_REPLY are decoded from 7-bit pairs in place, which
+  overwrites argv. Like argv itself, a view is only valid during the
+  callback.
+*/
+
+#ifndef FirmataSysexDecoder_h
+#define FirmataSysexDecoder_h
+
+#include <cstddef>
+#include <cstdint>
+
+#include "FirmataConstants.h"
+
+namespace firmata {
+
+/**
+ * CAPABILITY_RESPONSE: the modes of each pin as a bitset, and the position of its (mode,
+ * resolution) pairs in argv for the resolutions.
+ */
+struct capability_view {
+  static const size_t MAX_PINS = 128;
+
+  size_t pinCount;
+  uint16_t modes[MAX_PINS];              // bit n is set if the pin supports mode n
+  uint16_t offsets[MAX_PINS];            // index in argv of the first pair of the pin
+  const uint8_t * argv;
+
+  bool supports(uint8_t pin, uint8_t mode) const;
+  uint8_t resolution(uint8_t pin, uint8_t mode) const;
+};
+
+/**
+ * ANALOG_MAPPING_RESPONSE: the analog channel of each pin (argv itself) and the reverse map.
+ */
+struct analog_mapping_view {
+  static const size_t MAX_CHANNELS = 16;
+
+  size_t pinCount;
+  const uint8_t * channels;              // by pin, 0x7F for a pin without analog input
+  uint8_t pins[MAX_CHANNELS];            // by channel, 0x7F for a channel without pin
+
+  uint8_t channel(uint8_t pin) const;
+};
+
+/**
+ * PIN_STATE_RESPONSE.
+ */
+struct pin_state_view {
+  uint8_t pin;
+  uint8_t mode;
+  uint32_t value;                        // up to 35 bits are sent, the upper ones are dropped
+};
+
+/**
+ * I2C_REPLY.
+ */
+struct i2c_reply_view {
+  uint8_t address;
+  uint16_t reg;                          // 0 for a read without a register
+  const uint8_t * data;                  // in argv
+  size_t length;
+};
+
+/**
+ * SERIAL_DATA with the SERIAL_REPLY subcommand.
+ */
+struct serial_reply_view {
+  uint8_t port;                          // HW_SERIAL0 - 7 (0 - 7), SW_SERIAL0 - 3 (8 - 11)
+  const uint8_t * data;                  // in argv
+  size_t length;
+};
+
+/**
+ * Decoders of the sysex replies. Each checks the length of argv and returns false for a reply
+ * it cannot decode, leaving the view undefined.
+ */
+class FirmataSysexDecoder
+{
+  public:
+    static bool decodeCapabilities(size_t argc, const uint8_t * argv, capability_view &view);
+    static bool decodeAnalogMapping(size_t argc, const uint8_t * argv, analog_mapping_view &view);
+    static bool decodePinState(size_t argc, const uint8_t * argv, pin_state_view &view);
+    static bool decodeI2CReply(size_t argc, uint8_t * argv, i2c_reply_view &view);
+    static bool decodeSerialReply(size_t argc, uint8_t * argv, serial_reply_view &view);
+
+    static size_t decodePairs(const uint8_t * pairs, size_t count, uint8_t * bytes);
+};
+
+} // namespace firmata
+
+#endif /* FirmataSysexDecoder_h */
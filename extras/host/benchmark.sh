@@ -0,0 +1,70 @@
+#!/bin/sh
+
+# Build and run a host benchmark. The results are written as JSON. See readme.md.
+#
+# usage: extras/host/benchmark.sh [loopback|micro|decode|replay] [benchmark options...]
+#
+# loopback   the workloads of benchmark/loopback.cpp against StandardFirmataPlus
+#            built for the emulated Mega (options: -d seconds -o file -w workload)
+# micro      FirmataParser and FirmataMarshaller on in-memory message corpora
+#            (options: -t seconds -o file)
+# decode     FirmataSysexDecoder against naive decoding of sysex replies
+#            (options: -t seconds -o file)
+# replay     a capture through FirmataParser (options: -s speed -n passes
+#            -t board|host -o file, then the capture file)
+#
+# The binaries go to extras/host/build. CXX and CXXFLAGS are honored.
+
+set -e
+
+HOST_DIR=$(cd "$(dirname "$0")" && pwd)
+ROOT_DIR=$(cd "$HOST_DIR/../.." && pwd)
+BUILD_DIR="$HOST_DIR/build"
+
+target=loopback
+case $1 in
+  -*|"") ;;
+  *) target=$1; shift ;;
+esac
+
+mkdir -p "$BUILD_DIR"
+CXXFLAGS=${CXXFLAGS:--O2 -g -Wall}
+host_build() {
+  ${CXX:-g++} -std=c++11 $CXXFLAGS -I"$HOST_DIR/emulator" -I"$ROOT_DIR" -I"$HOST_DIR" "$@"
+}
+
+case $target in
+  loopback)
+    "$HOST_DIR/build.sh" -b mega -o "$BUILD_DIR/StandardFirmataPlus-mega" StandardFirmataPlus > /dev/null
+    host_build "$HOST_DIR/benchmark/loopback.cpp" \
+      "$ROOT_DIR/FirmataParser.cpp" "$ROOT_DIR/FirmataMarshaller.cpp" \
+      "$HOST_DIR/FirmataClockSync.cpp" "$HOST_DIR/FirmataLatencyHistogram.cpp" "$HOST_DIR/FirmataLatencyMonitor.cpp" \
+      "$HOST_DIR/FirmataCapture.cpp" "$HOST_DIR/FirmataRecordingStream.cpp" \
+      "$HOST_DIR/emulator/Print.cpp" \
+      -o "$BUILD_DIR/loopback"
+    "$BUILD_DIR/loopback" "$@" "$BUILD_DIR/StandardFirmataPlus-mega"
+    ;;
+  micro)
+    host_build "$HOST_DIR/benchmark/micro.cpp" \
+      "$ROOT_DIR/FirmataParser.cpp" "$ROOT_DIR/FirmataMarshaller.cpp" \
+      "$HOST_DIR/emulator/Print.cpp" \
+      -o "$BUILD_DIR/micro"
+    "$BUILD_DIR/micro" "$@"
+    ;;
+  decode)
+    host_build "$HOST_DIR/benchmark/decode.cpp" "$HOST_DIR/FirmataSysexDecoder.cpp" \
+      -o "$BUILD_DIR/decode"
+    "$BUILD_DIR/decode" "$@"
+    ;;
+  replay)
+    host_build "$HOST_DIR/benchmark/replay.cpp" \
+      "$ROOT_DIR/FirmataParser.cpp" "$HOST_DIR/FirmataCapture.cpp" "$HOST_DIR/FirmataClockSync.cpp" \
+      "$ROOT_DIR/FirmataMarshaller.cpp" "$HOST_DIR/emulator/Print.cpp" \
+      -o "$BUILD_DIR/replay"
+    "$BUILD_DIR/replay" "$@"
+    ;;
+  *)
+    echo "unknown benchmark: $target (loopback, micro, decode, replay)"
+    exit 1
+    ;;
+esac
@@ -0,0 +1,443 @@
+/*
+  decode.cpp - FirmataSysexDecoder against naive decoding of sysex replies
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Decodes the argv of sysex replies as FirmataParser passes them to the
+  generic sysex callback:
+
+  capability      CAPABILITY_RESPONSE of a Mega (70 pins, several modes each)
+  analog_mapping  ANALOG_MAPPING_RESPONSE of a Mega
+  pin_state       PIN_STATE_RESPONSE of a servo pin
+  i2c             I2C_REPLY with 32 data bytes
+  serial          SERIAL_REPLY with 64 data bytes
+
+  typed/<reply> decodes with FirmataSysexDecoder into a view. naive/<reply>
+  decodes the way a client written against argv usually does: a copy of
+  argv in a std::vector, bytes appended to a std::vector, modes and
+  resolutions in a std::map per pin. Both first copy argv into a scratch
+  buffer, as the parser would have written it, since the typed decoders
+  overwrite argv. The two are checked to agree before measuring.
+
+  Each benchmark repeats until it ran for the minimum time, REPETITIONS
+  times; the median repetition is reported as JSON.
+
+  usage: decode [-t seconds] [-o file]
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <getopt.h>
+
+#include "FirmataConstants.h"
+#include "FirmataSysexDecoder.h"
+
+using namespace firmata;
+
+namespace {
+
+//******************************************************************************
+//* Support
+//******************************************************************************
+
+const size_t MESSAGES = 256;           // per pass, different payloads so the branch predictor cannot learn one
+const size_t REPETITIONS = 5;
+const size_t I2C_REPLY_BYTES = 32;
+const size_t SERIAL_REPLY_BYTES = 64;
+
+uint64_t nowNanos(void)
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// a deterministic pseudo random sequence, so every run uses the same corpora
+uint32_t nextRandom(uint32_t & state)
+{
+  state ^= (state << 13);
+  state ^= (state >> 17);
+  state ^= (state << 5);
+  return state;
+}
+
+void appendPairs(std::vector<uint8_t> & argv, size_t count, uint32_t & random)
+{
+  for (size_t i = 0; i < count; ++i) {
+    const uint8_t byte = static_cast<uint8_t>(nextRandom(random));
+    argv.push_back(byte & 0x7F);
+    argv.push_back(byte >> 7);
+  }
+}
+
+//******************************************************************************
+//* Corpora
+//******************************************************************************
+
+enum reply_id {
+  CAPABILITY,
+  ANALOG_MAPPING,
+  PIN_STATE,
+  I2C,
+  SERIAL,
+  REPLIES
+};
+
+const char * const replyNames[REPLIES] = { "capability", "analog_mapping", "pin_state", "i2c", "serial" };
+
+/**
+ * @return The argv of one reply, as FirmataParser passes it to the sysex callback.
+ */
+std::vector<uint8_t> generate(reply_id reply, uint32_t & random)
+{
+  std::vector<uint8_t> argv;
+  switch (reply) {
+    case CAPABILITY:
+      // 70 pins: 2 serial, 52 digital (15 with PWM), 16 analog
+      for (uint8_t pin = 0; pin < 70; ++pin) {
+        if ( pin >= 2 ) {
+          const uint8_t modes[] = { PIN_MODE_INPUT, 1, PIN_MODE_PULLUP, 1, PIN_MODE_OUTPUT, 1, PIN_MODE_SERVO, 14 };
+          argv.insert(argv.end(), modes, modes + sizeof(modes));
+        }
+        if ( pin <= 13 || (pin >= 44 && pin <= 46) ) {
+          argv.push_back(PIN_MODE_PWM);
+          argv.push_back(8);
+        }
+        if ( pin >= 54 ) {
+          argv.push_back(PIN_MODE_ANALOG);
+          argv.push_back(10);
+        }
+        if ( pin == 20 || pin == 21 ) {
+          argv.push_back(PIN_MODE_I2C);
+          argv.push_back(1);
+        }
+        argv.push_back(0x7F);
+      }
+      break;
+    case ANALOG_MAPPING:
+      for (uint8_t pin = 0; pin < 70; ++pin) {
+        argv.push_back((pin >= 54) ? static_cast<uint8_t>(pin - 54) : 0x7F);
+      }
+      break;
+    case PIN_STATE: {
+      const uint32_t angle = nextRandom(random) % 181;
+      argv.push_back(static_cast<uint8_t>(nextRandom(random) % 54));
+      argv.push_back(PIN_MODE_SERVO);
+      argv.push_back(angle & 0x7F);
+      argv.push_back((angle >> 7) & 0x7F);
+      break;
+    }
+    case I2C:
+      argv.push_back(0x48);
+      argv.push_back(0x00);
+      argv.push_back(static_cast<uint8_t>(nextRandom(random) & 0x7F));
+      argv.push_back(0x00);
+      appendPairs(argv, I2C_REPLY_BYTES, random);
+      break;
+    case SERIAL:
+      argv.push_back(0x40 | 0x01);  // SERIAL_REPLY | HW_SERIAL1
+      appendPairs(argv, SERIAL_REPLY_BYTES, random);
+      break;
+    default:
+      break;
+  }
+  return argv;
+}
+
+std::vector<std::vector<uint8_t> > buildCorpus(reply_id reply, size_t & bytes)
+{
+  std::vector<std::vector<uint8_t> > corpus;
+  uint32_t random = 0x2545F491;
+  bytes = 0;
+  for (size_t i = 0; i < MESSAGES; ++i) {
+    corpus.push_back(generate(reply, random));
+    bytes += corpus.back().size();
+  }
+  return corpus;
+}
+
+//******************************************************************************
+//* Decoders
+//******************************************************************************
+
+// what the decoders produce is folded into sink, so the compiler cannot drop the decoding
+uint64_t sink = 0;
+
+/**
+ * @return A checksum of the decoded reply.
+ */
+uint64_t decodeTyped(reply_id reply, size_t argc, uint8_t * argv)
+{
+  switch (reply) {
+    case CAPABILITY: {
+      capability_view view;
+      if ( !FirmataSysexDecoder::decodeCapabilities(argc, argv, view) ) { return 0; }
+      uint64_t sum = view.pinCount;
+      for (uint8_t pin = 0; pin < view.pinCount; ++pin) {
+        sum += view.modes[pin] + view.resolution(pin, PIN_MODE_PWM) + view.resolution(pin, PIN_MODE_ANALOG);
+      }
+      return sum;
+    }
+    case ANALOG_MAPPING: {
+      analog_mapping_view view;
+      if ( !FirmataSysexDecoder::decodeAnalogMapping(argc, argv, view) ) { return 0; }
+      uint64_t sum = view.pinCount;
+      for (size_t channel = 0; channel < analog_mapping_view::MAX_CHANNELS; ++channel) { sum += view.pins[channel]; }
+      return sum;
+    }
+    case PIN_STATE: {
+      pin_state_view view;
+      if ( !FirmataSysexDecoder::decodePinState(argc, argv, view) ) { return 0; }
+      return view.pin + view.mode + view.value;
+    }
+    case I2C: {
+      i2c_reply_view view;
+      if ( !FirmataSysexDecoder::decodeI2CReply(argc, argv, view) ) { return 0; }
+      uint64_t sum = view.address + view.reg + view.length;
+      for (size_t i = 0; i < view.length; ++i) { sum += view.data[i] * (i + 1); }
+      return sum;
+    }
+    case SERIAL: {
+      serial_reply_view view;
+      if ( !FirmataSysexDecoder::decodeSerialReply(argc, argv, view) ) { return 0; }
+      uint64_t sum = view.port + view.length;
+      for (size_t i = 0; i < view.length; ++i) { sum += view.data[i] * (i + 1); }
+      return sum;
+    }
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @return The same checksum as decodeTyped().
+ */
+uint64_t decodeNaive(reply_id reply, size_t argc, const uint8_t * argv)
+{
+  const std::vector<uint8_t> message(argv, argv + argc);
+  switch (reply) {
+    case CAPABILITY: {
+      std::vector<std::map<uint8_t, uint8_t> > pins(1);
+      for (size_t i = 0; i < message.size(); ) {
+        if ( message[i] == 0x7F ) {
+          pins.push_back(std::map<uint8_t, uint8_t>());
+          ++i;
+        } else {
+          pins.back()[message[i]] = message[i + 1];
+          i += 2;
+        }
+      }
+      pins.pop_back();
+      uint64_t sum = pins.size();
+      for (size_t pin = 0; pin < pins.size(); ++pin) {
+        for (std::map<uint8_t, uint8_t>::const_iterator it = pins[pin].begin(); it != pins[pin].end(); ++it) {
+          if ( it->first < 16 ) { sum += (1 << it->first); }
+        }
+        std::map<uint8_t, uint8_t>::const_iterator pwm = pins[pin].find(PIN_MODE_PWM);
+        std::map<uint8_t, uint8_t>::const_iterator analog = pins[pin].find(PIN_MODE_ANALOG);
+        sum += ((pwm != pins[pin].end()) ? pwm->second : 0) + ((analog != pins[pin].end()) ? analog->second : 0);
+      }
+      return sum;
+    }
+    case ANALOG_MAPPING: {
+      std::map<uint8_t, uint8_t> pins;
+      for (size_t pin = 0; pin < message.size(); ++pin) {
+        if ( message[pin] != 0x7F ) { pins[message[pin]] = static_cast<uint8_t>(pin); }
+      }
+      uint64_t sum = message.size();
+      for (uint8_t channel = 0; channel < 16; ++channel) {
+        std::map<uint8_t, uint8_t>::const_iterator it = pins.find(channel);
+        sum += ((it != pins.end()) ? it->second : 0x7F);
+      }
+      return sum;
+    }
+    case PIN_STATE: {
+      uint32_t value = 0;
+      for (size_t i = 2; i < message.size() && i < 2 + 5; ++i) {
+        value |= static_cast<uint32_t>(message[i]) << (7 * (i - 2));
+      }
+      return message[0] + message[1] + value;
+    }
+    case I2C: {
+      std::vector<uint8_t> data;
+      for (size_t i = 4; i + 1 < message.size(); i += 2) {
+        data.push_back(static_cast<uint8_t>(message[i] | (message[i + 1] << 7)));
+      }
+      uint64_t sum = (message[0] | (message[1] << 7)) + (message[2] | (message[3] << 7)) + data.size();
+      for (size_t i = 0; i < data.size(); ++i) { sum += data[i] * (i + 1); }
+      return sum;
+    }
+    case SERIAL: {
+      std::vector<uint8_t> data;
+      for (size_t i = 1; i + 1 < message.size(); i += 2) {
+        data.push_back(static_cast<uint8_t>(message[i] | (message[i + 1] << 7)));
+      }
+      uint64_t sum = (message[0] & 0x0F) + data.size();
+      for (size_t i = 0; i < data.size(); ++i) { sum += data[i] * (i + 1); }
+      return sum;
+    }
+    default:
+      return 0;
+  }
+}
+
+//******************************************************************************
+//* Benchmarks
+//******************************************************************************
+
+struct result {
+  std::string name;
+  uint64_t bytes;     // per pass
+  uint64_t messages;  // per pass
+  double nsPerMessage;
+  double messagesPerSecond;
+};
+
+/**
+ * Call pass() until minimum seconds passed, REPETITIONS times.
+ * @return [ns] The median time of one pass.
+ */
+template <typename Pass>
+double measure(double minimum, Pass pass)
+{
+  std::vector<double> times;
+  pass();  // warm up the caches
+  for (size_t r = 0; r < REPETITIONS; ++r) {
+    const uint64_t start = nowNanos();
+    const uint64_t end = start + static_cast<uint64_t>(minimum * 1e9 / REPETITIONS);
+    uint64_t passes = 0;
+    uint64_t now;
+    do {
+      pass();
+      ++passes;
+      now = nowNanos();
+    } while ( now < end );
+    times.push_back(static_cast<double>(now - start) / passes);
+  }
+  std::sort(times.begin(), times.end());
+  return times[REPETITIONS / 2];
+}
+
+/**
+ * @return false if the decoders disagree on a message of the corpus.
+ */
+bool check(reply_id reply, const std::vector<std::vector<uint8_t> > & corpus)
+{
+  static uint8_t scratch[4096];
+  for (size_t m = 0; m < corpus.size(); ++m) {
+    const std::vector<uint8_t> & argv = corpus[m];
+    std::memcpy(scratch, argv.data(), argv.size());
+    const uint64_t typed = decodeTyped(reply, argv.size(), scratch);
+    if ( typed == 0 || typed != decodeNaive(reply, argv.size(), argv.data()) ) { return false; }
+  }
+  return true;
+}
+
+result benchmarkDecode(reply_id reply, bool typed, double minimum)
+{
+  size_t bytes;
+  const std::vector<std::vector<uint8_t> > corpus = buildCorpus(reply, bytes);
+  static uint8_t scratch[4096];
+
+  const double ns = measure(minimum, [&]() {
+    for (size_t m = 0; m < corpus.size(); ++m) {
+      const std::vector<uint8_t> & argv = corpus[m];
+      std::memcpy(scratch, argv.data(), argv.size());
+      sink += (typed ? decodeTyped(reply, argv.size(), scratch) : decodeNaive(reply, argv.size(), scratch));
+    }
+  });
+
+  result r = { std::string(typed ? "typed/" : "naive/") + replyNames[reply], bytes, corpus.size(), ns / corpus.size(), corpus.size() * 1e9 / ns };
+  return r;
+}
+
+//******************************************************************************
+//* Output
+//******************************************************************************
+
+void writeJson(std::FILE * file, double minimum, const std::vector<result> & results)
+{
+  std::fprintf(file, "{\n  \"benchmark\": \"decode\",\n  \"min_time_s\": %.3f,\n  \"repetitions\": %zu,\n  \"results\": [", minimum, REPETITIONS);
+  for (size_t i = 0; i < results.size(); ++i) {
+    const result & r = results[i];
+    std::fprintf(file, "%s\n    { \"name\": \"%s\", \"bytes\": %llu, \"messages\": %llu, \"ns_per_message\": %.3f, \"messages_per_s\": %.0f }",
+      (i ? "," : ""), r.name.c_str(), static_cast<unsigned long long>(r.bytes), static_cast<unsigned long long>(r.messages),
+      r.nsPerMessage, r.messagesPerSecond);
+  }
+  std::fprintf(file, "\n  ]\n}\n");
+}
+
+} // namespace
+
+//******************************************************************************
+//* Main
+//******************************************************************************
+
+int main(int argc, char * argv[])
+{
+  static const struct option options[] = {
+    { "time", required_argument, NULL, 't' },
+    { "output", required_argument, NULL, 'o' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+  double minimum = 1.0;
+  const char * output = NULL;
+  int option;
+
+  while ( (option = ::getopt_long(argc, argv, "t:o:h", options, NULL)) != -1 ) {
+    switch (option) {
+      case 't':
+        minimum = std::atof(optarg);
+        break;
+      case 'o':
+        output = optarg;
+        break;
+      default:
+        std::fprintf(stderr,
+          "usage: %s [-t seconds] [-o file]\n"
+          "  -t, --time SECS    minimum run time of each benchmark (default 1)\n"
+          "  -o, --output FILE  JSON results (default stdout)\n",
+          argv[0]);
+        return ((option == 'h') ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+  }
+
+  for (int r = 0; r < REPLIES; ++r) {
+    size_t bytes;
+    if ( !check(static_cast<reply_id>(r), buildCorpus(static_cast<reply_id>(r), bytes)) ) {
+      std::fprintf(stderr, "%s: the typed and the naive decoder disagree\n", replyNames[r]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::vector<result> results;
+  for (int r = 0; r < REPLIES; ++r) {
+    results.push_back(benchmarkDecode(static_cast<reply_id>(r), false, minimum));
+    results.push_back(benchmarkDecode(static_cast<reply_id>(r), true, minimum));
+  }
+
+  std::FILE * file = (output ? std::fopen(output, "w") : stdout);
+  if ( !file ) {
+    std::perror(output);
+    return EXIT_FAILURE;
+  }
+  writeJson(file, minimum, results);
+  if ( output ) { std::fclose(file); }
+  return ((sink == 0) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
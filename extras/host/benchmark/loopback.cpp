@@ -0,0 +1,592 @@
+/*
+  loopback.cpp - end-to-end benchmark of a host client and the emulated firmware
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Connects a client built on FirmataParser and FirmataMarshaller to a
+  firmware built with ../build.sh over a socketpair and runs the standard
+  workloads, each against a fresh firmware process:
+
+  analog    all analog inputs reported at a 1 ms sampling interval
+  digital   port writes as fast as the firmware acknowledges them
+  i2c       continuous read of 6 registers at a 1 ms sampling interval
+  serial    32 byte SERIAL_WRITEs relayed back by the Serial1 loopback
+
+  ECHO_DATA probes measure the round trip time while the workload runs. The
+  results go to a JSON file; see ../readme.md. With --capture the traffic of
+  all workloads is recorded for the replay benchmark.
+
+  usage: loopback [-d seconds] [-o file] [-c capture] [-w workload]... firmware [options]
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "FirmataCapture.h"
+#include "FirmataClockSync.h"
+#include "FirmataConstants.h"
+#include "FirmataLatencyHistogram.h"
+#include "FirmataLatencyMonitor.h"
+#include "FirmataMarshaller.h"
+#include "FirmataParser.h"
+#include "FirmataRecordingStream.h"
+
+using namespace firmata;
+
+namespace {
+
+//******************************************************************************
+//* Constants
+//******************************************************************************
+
+// defined by StandardFirmata and SerialFirmata.h, which only compile for a board
+const uint8_t I2C_READ_CONTINUOUSLY = 0x10;
+const uint8_t SERIAL_CONFIG = 0x10;
+const uint8_t SERIAL_WRITE = 0x20;
+const uint8_t SERIAL_READ = 0x30;
+const uint8_t SERIAL_REPLY = 0x40;
+const uint8_t SERIAL_READ_CONTINUOUSLY = 0x00;
+const uint8_t HW_SERIAL1 = 0x01;
+
+const uint8_t I2C_DEVICE = 0x48;        // the emulator attaches a register device here
+const uint64_t WARM_UP = 200000;        // [us] run before the counters start
+const uint64_t DRAIN_TIMEOUT = 1000000; // [us] wait for outstanding acknowledgements
+const uint64_t PING_INTERVAL = 10000;   // [us]
+const size_t DIGITAL_BATCH = 16;        // port writes per acknowledging probe
+const size_t DIGITAL_WINDOW = 4;        // batches in flight
+const size_t SERIAL_CHUNK = 32;         // bytes per SERIAL_WRITE
+
+uint64_t cpuNanos(clockid_t clock)
+{
+  struct timespec ts;
+  if ( ::clock_gettime(clock, &ts) != 0 ) { return 0; }
+  return (static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec);
+}
+
+//******************************************************************************
+//* Descriptor Stream
+//******************************************************************************
+
+/**
+ * The write side of the socket. Writes are buffered until flush(), so a message costs one
+ * system call rather than one per byte.
+ */
+class DescriptorStream : public Stream
+{
+  public:
+    DescriptorStream(void) : fd(-1), used(0), total(0) {}
+
+    void attach(int descriptor) { fd = descriptor; used = 0; total = 0; }
+    uint64_t bytesWritten(void) const { return total; }
+
+    int available(void) { return 0; }
+    int read(void) { return -1; }
+    int peek(void) { return -1; }
+
+    size_t write(uint8_t c)
+    {
+      if ( used == sizeof(buffer) ) { flush(); }
+      buffer[used++] = c;
+      ++total;
+      return 1;
+    }
+    using Print::write;
+
+    void flush(void)
+    {
+      size_t done = 0;
+      while ( done < used ) {
+        const ssize_t n = ::write(fd, buffer + done, used - done);
+        if ( n > 0 ) {
+          done += n;
+        } else if ( n < 0 && (errno == EAGAIN || errno == EINTR) ) {
+          struct pollfd pfd = { fd, POLLOUT, 0 };
+          ::poll(&pfd, 1, -1);
+        } else {
+          break;
+        }
+      }
+      used = 0;
+    }
+
+  private:
+    int fd;
+    uint8_t buffer[4096];
+    size_t used;
+    uint64_t total;
+};
+
+//******************************************************************************
+//* Session
+//******************************************************************************
+
+FirmataCaptureWriter capture;  // records nothing unless opened
+
+/**
+ * One firmware process and the client state of the connection to it.
+ */
+class Session
+{
+  public:
+    Session(void)
+      : pid(-1),
+        fd(-1),
+        parser(parserBuffer, sizeof(parserBuffer)),
+        recorder(stream, capture),
+        ready(false),
+        analogMessages(0),
+        i2cReplies(0),
+        serialBytes(0)
+    {
+      parser.attach(ANALOG_MESSAGE, staticAnalogCallback, this);
+      parser.attach(REPORT_FIRMWARE, staticFirmwareCallback, this);
+      parser.attach(START_SYSEX, staticSysexCallback, this);
+      latency.attach(parser);
+    }
+
+    ~Session(void)
+    {
+      finish();
+    }
+
+    /**
+     * Start the firmware with one end of a socketpair as its Serial and wait until it answers.
+     * @return false if the firmware did not start or answer within 5 s.
+     */
+    bool start(const std::vector<std::string> & command)
+    {
+      int fds[2];
+      if ( ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0 ) { return false; }
+      pid = ::fork();
+      if ( pid == 0 ) {
+        ::close(fds[0]);
+        std::vector<std::string> args(command);
+        args.push_back("--fd");
+        args.push_back(std::to_string(fds[1]));
+        args.push_back("--i2c");
+        args.push_back(std::to_string(I2C_DEVICE));
+        std::vector<char *> argv;
+        for (size_t i = 0; i < args.size(); ++i) { argv.push_back(const_cast<char *>(args[i].c_str())); }
+        argv.push_back(NULL);
+        ::execv(argv[0], argv.data());
+        std::fprintf(stderr, "cannot run %s: %s\n", argv[0], std::strerror(errno));
+        ::_exit(127);
+      }
+      ::close(fds[1]);
+      if ( pid < 0 ) { ::close(fds[0]); return false; }
+      fd = fds[0];
+      ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+      stream.attach(fd);
+      marshaller.begin(recorder);
+      if ( ::clock_getcpuclockid(pid, &boardClock) != 0 ) { return false; }
+
+      const uint64_t deadline = FirmataClockSync::hostMicros() + 5000000;
+      marshaller.queryFirmwareVersion();
+      stream.flush();
+      while ( !ready && FirmataClockSync::hostMicros() < deadline ) {
+        if ( !pump(10000) ) { return false; }
+      }
+      return ready;
+    }
+
+    /**
+     * Close the connection, which ends the firmware process.
+     */
+    void finish(void)
+    {
+      if ( fd >= 0 ) { ::close(fd); fd = -1; }
+      if ( pid > 0 ) {
+        int status;
+        ::waitpid(pid, &status, 0);
+        pid = -1;
+      }
+    }
+
+    /**
+     * Parse what arrives within the timeout.
+     * @param timeout [us]
+     * @return false once the firmware hung up.
+     */
+    bool pump(uint64_t timeout)
+    {
+      stream.flush();
+      struct pollfd pfd = { fd, POLLIN, 0 };
+      struct timespec ts = { static_cast<time_t>(timeout / 1000000), static_cast<long>((timeout % 1000000) * 1000) };
+      if ( ::ppoll(&pfd, 1, &ts, NULL) <= 0 ) { return true; }
+
+      uint8_t data[4096];
+      ssize_t n;
+      while ( (n = ::read(fd, data, sizeof(data))) > 0 ) {
+        capture.record(CAPTURE_FROM_BOARD, data, n);
+        for (ssize_t i = 0; i < n; ++i) { parser.parse(data[i]); }
+      }
+      return (n < 0 && (errno == EAGAIN || errno == EINTR));
+    }
+
+    uint64_t boardCpu(void) const { return cpuNanos(boardClock); }
+
+    /* raw sysex, for the messages with 7-bit fields FirmataMarshaller has no method for */
+    void sendSysex(uint8_t command, const uint8_t * data, size_t length)
+    {
+      recorder.write(START_SYSEX);
+      recorder.write(command);
+      recorder.write(data, length);
+      recorder.write(END_SYSEX);
+    }
+
+    pid_t pid;
+    int fd;
+    clockid_t boardClock;
+    uint8_t parserBuffer[256];
+    FirmataParser parser;
+    FirmataMarshaller marshaller;
+    DescriptorStream stream;
+    FirmataRecordingStream recorder;
+    FirmataLatencyMonitor latency;
+
+    bool ready;
+    uint64_t analogMessages;
+    uint64_t i2cReplies;
+    uint64_t serialBytes;
+
+  private:
+    static void staticAnalogCallback(void * context, uint8_t, uint16_t)
+    {
+      ++static_cast<Session *>(context)->analogMessages;
+    }
+
+    static void staticFirmwareCallback(void * context, size_t, size_t, const char *)
+    {
+      static_cast<Session *>(context)->ready = true;
+    }
+
+    static void staticSysexCallback(void * context, uint8_t command, size_t argc, uint8_t * argv)
+    {
+      Session * session = static_cast<Session *>(context);
+      if ( command == I2C_REPLY ) {
+        ++session->i2cReplies;
+      } else if ( command == SERIAL_DATA && argc > 0 && (argv[0] & 0xF0) == SERIAL_REPLY ) {
+        session->serialBytes += (argc - 1) / 2;
+      }
+    }
+};
+
+//******************************************************************************
+//* Workloads
+//******************************************************************************
+
+enum workload_id {
+  ANALOG_STREAMING,
+  DIGITAL_TOGGLING,
+  I2C_CONTINUOUS_READ,
+  SERIAL_BRIDGING,
+  WORKLOADS
+};
+
+const char * const workloadNames[WORKLOADS] = { "analog", "digital", "i2c", "serial" };
+const char * const workloadUnits[WORKLOADS] = { "ANALOG_MESSAGE", "DIGITAL_MESSAGE", "I2C_REPLY", "SERIAL_WRITE" };
+
+struct result {
+  workload_id workload;
+  double seconds;
+  uint64_t messages;
+  uint64_t bytesToHost;
+  uint64_t bytesToBoard;
+  uint64_t hostCpu;   // [ns]
+  uint64_t boardCpu;  // [ns]
+  uint32_t probesLost;
+  FirmataLatencyHistogram roundTrip;
+};
+
+/**
+ * The workload state of one run.
+ */
+struct driver {
+  workload_id workload;
+  uint8_t portValue;
+  uint64_t toggles;
+  uint64_t serialSent;
+  uint64_t nextPing;
+};
+
+void setUp(Session & session, driver & d)
+{
+  switch (d.workload) {
+    case ANALOG_STREAMING:
+      session.marshaller.setSamplingInterval(1);
+      for (uint8_t channel = 0; channel < 16; ++channel) {
+        session.marshaller.reportAnalogEnable(channel);
+      }
+      break;
+    case DIGITAL_TOGGLING:
+      for (uint8_t pin = 2; pin < 8; ++pin) {
+        session.marshaller.sendPinMode(pin, PIN_MODE_OUTPUT);
+      }
+      break;
+    case I2C_CONTINUOUS_READ: {
+      const uint8_t config[] = { 0x00, 0x00 };
+      const uint8_t request[] = { I2C_DEVICE, I2C_READ_CONTINUOUSLY, 0x00, 0x00, 0x06, 0x00 };
+      session.marshaller.setSamplingInterval(1);
+      session.sendSysex(I2C_CONFIG, config, sizeof(config));
+      session.sendSysex(I2C_REQUEST, request, sizeof(request));
+      break;
+    }
+    case SERIAL_BRIDGING: {
+      const uint32_t baud = 115200;
+      const uint8_t config[] = { static_cast<uint8_t>(SERIAL_CONFIG | HW_SERIAL1), static_cast<uint8_t>(baud & 0x7F), static_cast<uint8_t>((baud >> 7) & 0x7F), static_cast<uint8_t>((baud >> 14) & 0x7F) };
+      const uint8_t read[] = { static_cast<uint8_t>(SERIAL_READ | HW_SERIAL1), SERIAL_READ_CONTINUOUSLY };
+      session.sendSysex(SERIAL_DATA, config, sizeof(config));
+      session.sendSysex(SERIAL_DATA, read, sizeof(read));
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/**
+ * Send what the workload sends next. The digital writes are acknowledged by the probe after
+ * each batch, the serial chunks by their echo.
+ */
+void drive(Session & session, driver & d, bool sending)
+{
+  const uint64_t now = FirmataClockSync::hostMicros();
+  if ( d.workload == DIGITAL_TOGGLING ) {
+    if ( sending && session.latency.pending() < DIGITAL_WINDOW ) {
+      for (size_t i = 0; i < DIGITAL_BATCH; ++i) {
+        d.portValue ^= 0xFC;
+        session.marshaller.sendDigitalPort(0, d.portValue);
+      }
+      d.toggles += DIGITAL_BATCH;
+      session.latency.sendPing(session.marshaller);
+    }
+    return;
+  }
+
+  if ( sending && d.workload == SERIAL_BRIDGING && session.serialBytes >= d.serialSent ) {
+    uint8_t message[1 + 2 * SERIAL_CHUNK];
+    message[0] = (SERIAL_WRITE | HW_SERIAL1);
+    for (size_t i = 0; i < SERIAL_CHUNK; ++i) {
+      const uint8_t value = static_cast<uint8_t>(d.serialSent + i);
+      message[1 + 2 * i] = (value & 0x7F);
+      message[2 + 2 * i] = (value >> 7);
+    }
+    session.sendSysex(SERIAL_DATA, message, sizeof(message));
+    d.serialSent += SERIAL_CHUNK;
+  }
+  if ( sending && now >= d.nextPing ) {
+    session.latency.sendPing(session.marshaller);
+    d.nextPing = now + PING_INTERVAL;
+  }
+}
+
+uint64_t messages(const Session & session, const driver & d)
+{
+  switch (d.workload) {
+    case ANALOG_STREAMING: return session.analogMessages;
+    case DIGITAL_TOGGLING: return (d.toggles - session.latency.pending() * DIGITAL_BATCH);
+    case I2C_CONTINUOUS_READ: return session.i2cReplies;
+    case SERIAL_BRIDGING: return (session.serialBytes / SERIAL_CHUNK);
+    default: return 0;
+  }
+}
+
+bool acknowledged(const Session & session, const driver & d)
+{
+  if ( d.workload == DIGITAL_TOGGLING ) { return (session.latency.pending() == 0); }
+  if ( d.workload == SERIAL_BRIDGING ) { return (session.serialBytes >= d.serialSent); }
+  return true;
+}
+
+/**
+ * Run one workload against a fresh firmware process.
+ * @return false if the firmware did not start or hung up.
+ */
+bool run(const std::vector<std::string> & command, workload_id workload, double duration, result & r)
+{
+  Session session;
+  if ( !session.start(command) ) { return false; }
+
+  driver d = { workload, 0, 0, 0, 0 };
+  setUp(session, d);
+  uint64_t end = FirmataClockSync::hostMicros() + WARM_UP;
+  while ( FirmataClockSync::hostMicros() < end ) {
+    drive(session, d, true);
+    if ( !session.pump(100) ) { return false; }
+  }
+
+  // measure from here on
+  const uint64_t messagesBefore = messages(session, d);
+  const uint64_t bytesToHostBefore = session.parser.getBytesReceived();
+  const uint64_t bytesToBoardBefore = session.stream.bytesWritten();
+  const uint64_t hostCpuBefore = cpuNanos(CLOCK_PROCESS_CPUTIME_ID);
+  const uint64_t boardCpuBefore = session.boardCpu();
+  const uint64_t start = FirmataClockSync::hostMicros();
+  session.latency.reset();
+  d.nextPing = start;
+
+  end = start + static_cast<uint64_t>(duration * 1e6);
+  while ( FirmataClockSync::hostMicros() < end ) {
+    drive(session, d, true);
+    if ( !session.pump(100) ) { return false; }
+  }
+  end = FirmataClockSync::hostMicros() + DRAIN_TIMEOUT;
+  while ( !acknowledged(session, d) && FirmataClockSync::hostMicros() < end ) {
+    if ( !session.pump(100) ) { return false; }
+  }
+
+  r.workload = workload;
+  r.seconds = (FirmataClockSync::hostMicros() - start) / 1e6;
+  r.messages = messages(session, d) - messagesBefore;
+  r.bytesToHost = session.parser.getBytesReceived() - bytesToHostBefore;
+  r.bytesToBoard = session.stream.bytesWritten() - bytesToBoardBefore;
+  r.hostCpu = cpuNanos(CLOCK_PROCESS_CPUTIME_ID) - hostCpuBefore;
+  r.boardCpu = session.boardCpu() - boardCpuBefore;
+  r.probesLost = session.latency.lost() + static_cast<uint32_t>(session.latency.pending());
+  r.roundTrip.reset();
+  r.roundTrip.merge(session.latency.roundTrip());
+  return true;
+}
+
+//******************************************************************************
+//* Output
+//******************************************************************************
+
+void writeJson(std::FILE * file, const std::string & firmware, double duration, const std::vector<result> & results)
+{
+  std::fprintf(file, "{\n  \"benchmark\": \"loopback\",\n  \"firmware\": \"%s\",\n  \"duration_s\": %.3f,\n  \"workloads\": [", firmware.c_str(), duration);
+  for (size_t i = 0; i < results.size(); ++i) {
+    const result & r = results[i];
+    const double perMessage = (r.messages ? 1.0 / r.messages : 0.0);
+    std::fprintf(file, "%s\n    {\n", (i ? "," : ""));
+    std::fprintf(file, "      \"name\": \"%s\",\n", workloadNames[r.workload]);
+    std::fprintf(file, "      \"message\": \"%s\",\n", workloadUnits[r.workload]);
+    std::fprintf(file, "      \"elapsed_s\": %.6f,\n", r.seconds);
+    std::fprintf(file, "      \"messages\": %llu,\n", static_cast<unsigned long long>(r.messages));
+    std::fprintf(file, "      \"messages_per_s\": %.1f,\n", (r.seconds > 0.0 ? r.messages / r.seconds : 0.0));
+    std::fprintf(file, "      \"bytes_to_host\": %llu,\n", static_cast<unsigned long long>(r.bytesToHost));
+    std::fprintf(file, "      \"bytes_to_board\": %llu,\n", static_cast<unsigned long long>(r.bytesToBoard));
+    std::fprintf(file, "      \"host_cpu_ns_per_message\": %.1f,\n", r.hostCpu * perMessage);
+    std::fprintf(file, "      \"firmware_cpu_ns_per_message\": %.1f,\n", r.boardCpu * perMessage);
+    std::fprintf(file, "      \"round_trip_us\": { \"count\": %llu, \"min\": %u, \"mean\": %.1f, \"p50\": %u, \"p90\": %u, \"p99\": %u, \"p999\": %u, \"max\": %u },\n",
+      static_cast<unsigned long long>(r.roundTrip.count()), r.roundTrip.min(), r.roundTrip.mean(), r.roundTrip.percentile(50.0),
+      r.roundTrip.percentile(90.0), r.roundTrip.percentile(99.0), r.roundTrip.percentile(99.9), r.roundTrip.max());
+    std::fprintf(file, "      \"probes_lost\": %u\n    }", r.probesLost);
+  }
+  std::fprintf(file, "\n  ]\n}\n");
+}
+
+void usage(const char * program)
+{
+  std::fprintf(stderr,
+    "usage: %s [-d seconds] [-o file] [-c capture] [-w workload]... firmware [firmware options]\n"
+    "  -d, --duration SECS  measured time per workload (default 5)\n"
+    "  -o, --output FILE    JSON results (default stdout)\n"
+    "  -c, --capture FILE   record the traffic of all workloads\n"
+    "  -w, --workload NAME  analog, digital, i2c or serial (repeatable, default all)\n",
+    program);
+}
+
+} // namespace
+
+//******************************************************************************
+//* Main
+//******************************************************************************
+
+int main(int argc, char * argv[])
+{
+  static const struct option options[] = {
+    { "duration", required_argument, NULL, 'd' },
+    { "output", required_argument, NULL, 'o' },
+    { "capture", required_argument, NULL, 'c' },
+    { "workload", required_argument, NULL, 'w' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+  double duration = 5.0;
+  const char * output = NULL;
+  std::vector<workload_id> workloads;
+  int option;
+
+  // stop at the firmware path, the rest are firmware options
+  while ( (option = ::getopt_long(argc, argv, "+d:o:c:w:h", options, NULL)) != -1 ) {
+    switch (option) {
+      case 'd':
+        duration = std::atof(optarg);
+        break;
+      case 'o':
+        output = optarg;
+        break;
+      case 'c':
+        if ( !capture.open(optarg) ) {
+          std::fprintf(stderr, "cannot write %s: %s\n", optarg, std::strerror(errno));
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'w': {
+        int w;
+        for (w = 0; w < WORKLOADS && std::strcmp(optarg, workloadNames[w]) != 0; ++w) {}
+        if ( w == WORKLOADS ) {
+          std::fprintf(stderr, "unknown workload: %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+        workloads.push_back(static_cast<workload_id>(w));
+        break;
+      }
+      default:
+        usage(argv[0]);
+        return ((option == 'h') ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+  }
+  if ( optind >= argc ) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  const std::vector<std::string> command(argv + optind, argv + argc);
+  if ( workloads.empty() ) {
+    for (int w = 0; w < WORKLOADS; ++w) { workloads.push_back(static_cast<workload_id>(w)); }
+  }
+
+  ::signal(SIGPIPE, SIG_IGN);
+  std::vector<result> results(workloads.size());
+  for (size_t i = 0; i < workloads.size(); ++i) {
+    std::fprintf(stderr, "%s ...\n", workloadNames[workloads[i]]);
+    if ( !run(command, workloads[i], duration, results[i]) ) {
+      std::fprintf(stderr, "%s: the firmware did not respond\n", workloadNames[workloads[i]]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::FILE * file = (output ? std::fopen(output, "w") : stdout);
+  if ( !file ) {
+    std::fprintf(stderr, "cannot write %s: %s\n", output, std::strerror(errno));
+    return EXIT_FAILURE;
+  }
+  const std::string firmware = command[0].substr(command[0].rfind('/') + 1);
+  writeJson(file, firmware, duration, results);
+  if ( output ) { std::fclose(file); }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,348 @@
+/*
+  micro.cpp - microbenchmarks of FirmataParser and FirmataMarshaller
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Measures the parser and the marshaller in memory, without a transport, on
+  corpora of realistic traffic:
+
+  mixed        analog and digital reports of a Mega sampling 16 inputs
+  i2c          32 byte I2C_REPLY messages
+  capability   CAPABILITY_RESPONSE of a Mega (70 pins, several modes each)
+  string       STRING_DATA messages of 20 - 60 characters
+
+  parse/<corpus> feeds a corpus to FirmataParser::parse() with callbacks
+  attached, which includes decodeByteStream() for the strings.
+  encode/<corpus> regenerates the messages of a corpus with
+  FirmataMarshaller (sendAnalog(), sendDigitalPort(), sendSysex(),
+  sendString()), whose 7-bit encoding is encodeByteStream().
+
+  Each benchmark repeats until it ran for the minimum time, REPETITIONS
+  times; the median repetition is reported as JSON.
+
+  usage: micro [-t seconds] [-o file]
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <getopt.h>
+
+#include "FirmataConstants.h"
+#include "FirmataMarshaller.h"
+#include "FirmataParser.h"
+
+using namespace firmata;
+
+namespace {
+
+//******************************************************************************
+//* Support
+//******************************************************************************
+
+const size_t CORPUS_SIZE = 64 * 1024;  // [bytes] at least, so a pass is well above the timer resolution
+const size_t REPETITIONS = 5;
+const size_t I2C_REPLY_BYTES = 32;
+
+/**
+ * Collects the bytes the marshaller writes.
+ */
+class BufferStream : public Stream
+{
+  public:
+    int available(void) { return 0; }
+    int read(void) { return -1; }
+    int peek(void) { return -1; }
+    size_t write(uint8_t c) { bytes.push_back(c); return 1; }
+    using Print::write;
+
+    std::vector<uint8_t> bytes;
+};
+
+/**
+ * Counts the bytes the marshaller writes and discards them.
+ */
+class NullStream : public Stream
+{
+  public:
+    NullStream(void) : count(0) {}
+    int available(void) { return 0; }
+    int read(void) { return -1; }
+    int peek(void) { return -1; }
+    size_t write(uint8_t) { ++count; return 1; }
+    using Print::write;
+
+    uint64_t count;
+};
+
+uint64_t nowNanos(void)
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// a deterministic pseudo random sequence, so every run uses the same corpora
+uint32_t nextRandom(uint32_t & state)
+{
+  state ^= (state << 13);
+  state ^= (state >> 17);
+  state ^= (state << 5);
+  return state;
+}
+
+//******************************************************************************
+//* Corpora
+//******************************************************************************
+
+enum corpus_id {
+  MIXED,
+  I2C,
+  CAPABILITY,
+  STRING,
+  CORPORA
+};
+
+const char * const corpusNames[CORPORA] = { "mixed", "i2c", "capability", "string" };
+
+/**
+ * Write one round of the messages of a corpus.
+ * @return The number of messages written.
+ */
+size_t generate(corpus_id corpus, const FirmataMarshaller & marshaller, Stream & stream, uint32_t & random)
+{
+  switch (corpus) {
+    case MIXED: {
+      for (uint8_t channel = 0; channel < 16; ++channel) {
+        marshaller.sendAnalog(channel, nextRandom(random) & 0x3FF);
+      }
+      marshaller.sendDigitalPort(0, nextRandom(random) & 0xFC);
+      marshaller.sendDigitalPort(1, nextRandom(random) & 0xFF);
+      return 18;
+    }
+    case I2C: {
+      uint8_t reply[2 + I2C_REPLY_BYTES];
+      reply[0] = 0x48;
+      reply[1] = 0x00;
+      for (size_t i = 0; i < I2C_REPLY_BYTES; ++i) {
+        reply[2 + i] = static_cast<uint8_t>(nextRandom(random));
+      }
+      marshaller.sendSysex(I2C_REPLY, sizeof(reply), reply);
+      return 1;
+    }
+    case CAPABILITY: {
+      // 70 pins: 2 serial, 52 digital (15 with PWM), 16 analog
+      stream.write(START_SYSEX);
+      stream.write(CAPABILITY_RESPONSE);
+      for (uint8_t pin = 0; pin < 70; ++pin) {
+        if ( pin >= 2 ) {
+          stream.write(PIN_MODE_INPUT); stream.write(1);
+          stream.write(PIN_MODE_PULLUP); stream.write(1);
+          stream.write(PIN_MODE_OUTPUT); stream.write(1);
+          stream.write(PIN_MODE_SERVO); stream.write(14);
+        }
+        if ( pin <= 13 || (pin >= 44 && pin <= 46) ) {
+          stream.write(PIN_MODE_PWM); stream.write(8);
+        }
+        if ( pin >= 54 ) {
+          stream.write(PIN_MODE_ANALOG); stream.write(10);
+        }
+        if ( pin == 20 || pin == 21 ) {
+          stream.write(PIN_MODE_I2C); stream.write(1);
+        }
+        stream.write(0x7F);
+      }
+      stream.write(END_SYSEX);
+      return 1;
+    }
+    case STRING: {
+      static const char text[] = "I2C: Too few bytes received; analog pin 7 sampling at 19 ms";
+      const size_t length = 20 + nextRandom(random) % 41;
+      const std::string s(text, length);
+      marshaller.sendString(s.c_str());
+      return 1;
+    }
+    default:
+      return 0;
+  }
+}
+
+std::vector<uint8_t> buildCorpus(corpus_id corpus, size_t & messages)
+{
+  BufferStream stream;
+  FirmataMarshaller marshaller;
+  uint32_t random = 0x2545F491;
+  marshaller.begin(stream);
+  messages = 0;
+  while ( stream.bytes.size() < CORPUS_SIZE ) {
+    messages += generate(corpus, marshaller, stream, random);
+  }
+  return stream.bytes;
+}
+
+//******************************************************************************
+//* Benchmarks
+//******************************************************************************
+
+struct result {
+  std::string name;
+  uint64_t bytes;     // per pass
+  uint64_t messages;  // per pass
+  double nsPerByte;
+  double messagesPerSecond;
+};
+
+// the callbacks do the least a client would do, so the compiler cannot drop the parsing
+uint64_t sink = 0;
+
+void analogCallback(void *, uint8_t command, uint16_t value) { sink += command + value; }
+void sysexCallback(void *, uint8_t command, size_t argc, uint8_t * argv) { sink += command + argc + (argc ? argv[argc - 1] : 0); }
+void stringCallback(void *, const char * c_str) { sink += static_cast<uint8_t>(c_str[0]); }
+
+/**
+ * Call pass() until minimum seconds passed, REPETITIONS times.
+ * @return [ns] The median time of one pass.
+ */
+template <typename Pass>
+double measure(double minimum, Pass pass)
+{
+  std::vector<double> times;
+  pass();  // warm up the caches
+  for (size_t r = 0; r < REPETITIONS; ++r) {
+    const uint64_t start = nowNanos();
+    const uint64_t end = start + static_cast<uint64_t>(minimum * 1e9 / REPETITIONS);
+    uint64_t passes = 0;
+    uint64_t now;
+    do {
+      pass();
+      ++passes;
+      now = nowNanos();
+    } while ( now < end );
+    times.push_back(static_cast<double>(now - start) / passes);
+  }
+  std::sort(times.begin(), times.end());
+  return times[REPETITIONS / 2];
+}
+
+result benchmarkParse(corpus_id corpus, double minimum)
+{
+  size_t messages;
+  const std::vector<uint8_t> bytes = buildCorpus(corpus, messages);
+  static uint8_t buffer[4096];
+  FirmataParser parser(buffer, sizeof(buffer));
+  parser.attach(ANALOG_MESSAGE, analogCallback);
+  parser.attach(DIGITAL_MESSAGE, analogCallback);
+  parser.attach(START_SYSEX, sysexCallback);
+  parser.attach(STRING_DATA, stringCallback);
+
+  const double ns = measure(minimum, [&]() {
+    const uint8_t * p = bytes.data();
+    const uint8_t * const end = p + bytes.size();
+    for ( ; p < end; ++p) { parser.parse(*p); }
+  });
+
+  result r = { std::string("parse/") + corpusNames[corpus], bytes.size(), messages, ns / bytes.size(), messages * 1e9 / ns };
+  return r;
+}
+
+result benchmarkEncode(corpus_id corpus, double minimum)
+{
+  size_t messages;
+  const std::vector<uint8_t> bytes = buildCorpus(corpus, messages);
+  NullStream stream;
+  FirmataMarshaller marshaller;
+  marshaller.begin(stream);
+
+  const double ns = measure(minimum, [&]() {
+    uint32_t random = 0x2545F491;
+    size_t written = 0;
+    while ( written < messages ) { written += generate(corpus, marshaller, stream, random); }
+  });
+  sink += stream.count;
+
+  result r = { std::string("encode/") + corpusNames[corpus], bytes.size(), messages, ns / bytes.size(), messages * 1e9 / ns };
+  return r;
+}
+
+//******************************************************************************
+//* Output
+//******************************************************************************
+
+void writeJson(std::FILE * file, double minimum, const std::vector<result> & results)
+{
+  std::fprintf(file, "{\n  \"benchmark\": \"micro\",\n  \"min_time_s\": %.3f,\n  \"repetitions\": %zu,\n  \"results\": [", minimum, REPETITIONS);
+  for (size_t i = 0; i < results.size(); ++i) {
+    const result & r = results[i];
+    std::fprintf(file, "%s\n    { \"name\": \"%s\", \"bytes\": %llu, \"messages\": %llu, \"ns_per_byte\": %.3f, \"messages_per_s\": %.0f }",
+      (i ? "," : ""), r.name.c_str(), static_cast<unsigned long long>(r.bytes), static_cast<unsigned long long>(r.messages),
+      r.nsPerByte, r.messagesPerSecond);
+  }
+  std::fprintf(file, "\n  ]\n}\n");
+}
+
+} // namespace
+
+//******************************************************************************
+//* Main
+//******************************************************************************
+
+int main(int argc, char * argv[])
+{
+  static const struct option options[] = {
+    { "time", required_argument, NULL, 't' },
+    { "output", required_argument, NULL, 'o' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+  double minimum = 1.0;
+  const char * output = NULL;
+  int option;
+
+  while ( (option = ::getopt_long(argc, argv, "t:o:h", options, NULL)) != -1 ) {
+    switch (option) {
+      case 't':
+        minimum = std::atof(optarg);
+        break;
+      case 'o':
+        output = optarg;
+        break;
+      default:
+        std::fprintf(stderr,
+          "usage: %s [-t seconds] [-o file]\n"
+          "  -t, --time SECS    minimum run time of each benchmark (default 1)\n"
+          "  -o, --output FILE  JSON results (default stdout)\n",
+          argv[0]);
+        return ((option == 'h') ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+  }
+
+  std::vector<result> results;
+  for (int c = 0; c < CORPORA; ++c) {
+    results.push_back(benchmarkParse(static_cast<corpus_id>(c), minimum));
+  }
+  for (int c = 0; c < CORPORA; ++c) {
+    results.push_back(benchmarkEncode(static_cast<corpus_id>(c), minimum));
+  }
+
+  std::FILE * file = (output ? std::fopen(output, "w") : stdout);
+  if ( !file ) {
+    std::perror(output);
+    return EXIT_FAILURE;
+  }
+  writeJson(file, minimum, results);
+  if ( output ) { std::fclose(file); }
+  return ((sink == 0) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,255 @@
+/*
+  replay.cpp - replays a capture through FirmataParser
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Feeds one direction of a capture (see ../FirmataCapture.h) to a parser
+  with callbacks that count the messages by type, either as fast as
+  possible (the default, to profile the host stack on real traffic) or at
+  the original pace scaled by --speed (to reproduce an incident). At full
+  speed the capture is replayed --passes times and the median pass is
+  reported. Capture traffic with "loopback --capture" or by wrapping the
+  Stream of a client in FirmataRecordingStream.
+
+  usage: replay [-s speed] [-n passes] [-t board|host] [-o file] capture
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <getopt.h>
+
+#include "FirmataCapture.h"
+#include "FirmataConstants.h"
+#include "FirmataParser.h"
+
+using namespace firmata;
+
+namespace {
+
+uint64_t nowNanos(void)
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+//******************************************************************************
+//* Counting Client
+//******************************************************************************
+
+enum message_kind {
+  ANALOG,
+  DIGITAL,
+  SYSEX,
+  STRING,
+  VERSION,
+  KINDS
+};
+
+const char * const kindNames[KINDS] = { "analog", "digital", "sysex", "string", "version" };
+
+struct counters {
+  uint64_t kinds[KINDS];
+  uint64_t sysex[128];  // by sysex command
+};
+
+void valueCallback(void * context, uint8_t command, uint16_t)
+{
+  ++static_cast<counters *>(context)->kinds[(command == ANALOG_MESSAGE) ? ANALOG : DIGITAL];
+}
+
+void sysexCallback(void * context, uint8_t command, size_t, uint8_t *)
+{
+  counters * c = static_cast<counters *>(context);
+  ++c->kinds[SYSEX];
+  ++c->sysex[command & 0x7F];
+}
+
+void stringCallback(void * context, const char *)
+{
+  ++static_cast<counters *>(context)->kinds[STRING];
+}
+
+void versionCallback(void * context, size_t, size_t, const char *)
+{
+  ++static_cast<counters *>(context)->kinds[VERSION];
+}
+
+//******************************************************************************
+//* Replay
+//******************************************************************************
+
+struct pass {
+  uint64_t elapsed;   // [ns]
+  uint64_t bytes;
+  uint64_t messages;
+  counters counts;
+};
+
+/**
+ * Replay the capture once through a fresh parser.
+ */
+pass replayOnce(FirmataCaptureReplayer & replayer, uint8_t direction, double speed)
+{
+  static uint8_t buffer[1024];
+  pass p;
+  std::memset(&p, 0, sizeof(p));
+
+  FirmataParser parser(buffer, sizeof(buffer));
+  parser.attach(ANALOG_MESSAGE, valueCallback, &p.counts);
+  parser.attach(DIGITAL_MESSAGE, valueCallback, &p.counts);
+  parser.attach(START_SYSEX, sysexCallback, &p.counts);
+  parser.attach(STRING_DATA, stringCallback, &p.counts);
+  parser.attach(REPORT_FIRMWARE, versionCallback, &p.counts);
+
+  const uint64_t start = nowNanos();
+  p.bytes = replayer.replay(parser, direction, speed);
+  p.elapsed = nowNanos() - start;
+  p.messages = parser.getMessagesParsed();
+  return p;
+}
+
+void writeJson(std::FILE * file, const char * path, FirmataCaptureReplayer & replayer, uint8_t direction, double speed, const pass & p, size_t passes)
+{
+  // the capture itself
+  capture_record record;
+  uint64_t records = 0;
+  uint64_t bytes[2] = { 0, 0 };
+  uint64_t duration = 0;
+  replayer.rewind();
+  while ( replayer.next(record) ) {
+    ++records;
+    bytes[record.direction] += record.length;
+    duration = record.time;
+  }
+
+  std::fprintf(file, "{\n  \"benchmark\": \"replay\",\n  \"capture\": \"%s\",\n", path);
+  std::fprintf(file, "  \"capture_start_us\": %llu,\n", static_cast<unsigned long long>(replayer.startTime()));
+  std::fprintf(file, "  \"capture_duration_s\": %.6f,\n", duration / 1e6);
+  std::fprintf(file, "  \"records\": %llu,\n", static_cast<unsigned long long>(records));
+  std::fprintf(file, "  \"bytes_to_board\": %llu,\n", static_cast<unsigned long long>(bytes[CAPTURE_TO_BOARD]));
+  std::fprintf(file, "  \"bytes_from_board\": %llu,\n", static_cast<unsigned long long>(bytes[CAPTURE_FROM_BOARD]));
+  std::fprintf(file, "  \"truncated\": %s,\n", (replayer.truncated() ? "true" : "false"));
+  std::fprintf(file, "  \"replayed\": \"%s\",\n", ((direction == CAPTURE_FROM_BOARD) ? "host" : "board"));
+  std::fprintf(file, "  \"speed\": %.3f,\n", speed);
+  std::fprintf(file, "  \"passes\": %zu,\n", passes);
+  std::fprintf(file, "  \"elapsed_s\": %.6f,\n", p.elapsed / 1e9);
+  std::fprintf(file, "  \"bytes\": %llu,\n", static_cast<unsigned long long>(p.bytes));
+  std::fprintf(file, "  \"messages\": %llu,\n", static_cast<unsigned long long>(p.messages));
+  std::fprintf(file, "  \"ns_per_byte\": %.3f,\n", (p.bytes ? static_cast<double>(p.elapsed) / p.bytes : 0.0));
+  std::fprintf(file, "  \"messages_per_s\": %.0f,\n", (p.elapsed ? p.messages * 1e9 / p.elapsed : 0.0));
+  std::fprintf(file, "  \"by_type\": {");
+  for (size_t k = 0; k < KINDS; ++k) {
+    std::fprintf(file, "%s \"%s\": %llu", (k ? "," : ""), kindNames[k], static_cast<unsigned long long>(p.counts.kinds[k]));
+  }
+  std::fprintf(file, " },\n  \"by_sysex_command\": {");
+  bool first = true;
+  for (size_t c = 0; c < 128; ++c) {
+    if ( !p.counts.sysex[c] ) { continue; }
+    std::fprintf(file, "%s \"0x%02zx\": %llu", (first ? "" : ","), c, static_cast<unsigned long long>(p.counts.sysex[c]));
+    first = false;
+  }
+  std::fprintf(file, " }\n}\n");
+}
+
+void usage(const char * program)
+{
+  std::fprintf(stderr,
+    "usage: %s [options] capture\n"
+    "  -s, --speed X        1 replays at the original pace, 2 twice as fast (default 0: full speed)\n"
+    "  -n, --passes N       full speed passes, the median is reported (default 5)\n"
+    "  -t, --to board|host  replay what the host received (default) or what the board received\n"
+    "  -o, --output FILE    JSON results (default stdout)\n",
+    program);
+}
+
+} // namespace
+
+//******************************************************************************
+//* Main
+//******************************************************************************
+
+int main(int argc, char * argv[])
+{
+  static const struct option options[] = {
+    { "speed", required_argument, NULL, 's' },
+    { "passes", required_argument, NULL, 'n' },
+    { "to", required_argument, NULL, 't' },
+    { "output", required_argument, NULL, 'o' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+  double speed = 0.0;
+  size_t passes = 5;
+  uint8_t direction = CAPTURE_FROM_BOARD;
+  const char * output = NULL;
+  int option;
+
+  while ( (option = ::getopt_long(argc, argv, "s:n:t:o:h", options, NULL)) != -1 ) {
+    switch (option) {
+      case 's':
+        speed = std::atof(optarg);
+        break;
+      case 'n':
+        passes = std::strtoul(optarg, NULL, 10);
+        break;
+      case 't':
+        if ( std::strcmp(optarg, "host") == 0 ) {
+          direction = CAPTURE_FROM_BOARD;
+        } else if ( std::strcmp(optarg, "board") == 0 ) {
+          direction = CAPTURE_TO_BOARD;
+        } else {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'o':
+        output = optarg;
+        break;
+      default:
+        usage(argv[0]);
+        return ((option == 'h') ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+  }
+  if ( optind != argc - 1 ) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  const char * path = argv[optind];
+
+  FirmataCaptureReplayer replayer;
+  if ( !replayer.open(path) ) {
+    std::fprintf(stderr, "%s is not a readable capture\n", path);
+    return EXIT_FAILURE;
+  }
+
+  // paced replays take as long as the capture, one is enough
+  if ( speed > 0.0 || passes == 0 ) { passes = 1; }
+  std::vector<pass> results;
+  for (size_t i = 0; i < passes; ++i) {
+    results.push_back(replayOnce(replayer, direction, speed));
+  }
+  std::sort(results.begin(), results.end(), [](const pass & a, const pass & b) { return (a.elapsed < b.elapsed); });
+
+  std::FILE * file = (output ? std::fopen(output, "w") : stdout);
+  if ( !file ) {
+    std::perror(output);
+    return EXIT_FAILURE;
+  }
+  writeJson(file, path, replayer, direction, speed, results[passes / 2], passes);
+  if ( output ) { std::fclose(file); }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,69 @@
+#!/bin/sh
+
+# Build an example sketch as a native Linux executable on the emulated Arduino
+# core in emulator/. See readme.md.
+#
+# usage: extras/host/build.sh [-b uno|mega] [-o output] sketch [compiler flags...]
+#
+# sketch is the name of a directory in examples/ or the path of an .ino file.
+# The library .cpp files are compiled in, plus the utility/*.cpp files of the
+# features the sketch includes. CXX and CXXFLAGS are honored.
+
+set -e
+
+HOST_DIR=$(cd "$(dirname "$0")" && pwd)
+ROOT_DIR=$(cd "$HOST_DIR/../.." && pwd)
+EMULATOR_DIR="$HOST_DIR/emulator"
+
+board=mega
+output=
+while getopts "b:o:" option; do
+  case $option in
+    b) board=$OPTARG ;;
+    o) output=$OPTARG ;;
+    *) sed -n 's/^# \{0,1\}//; 6p' "$0"; exit 1 ;;
+  esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -lt 1 ]; then
+  sed -n 's/^# \{0,1\}//; 6p' "$0"
+  exit 1
+fi
+sketch=$1
+shift
+
+case $board in
+  uno) board_flags="-D__AVR_ATmega328P__ -DARDUINO_AVR_UNO" ;;
+  mega) board_flags="-D__AVR_ATmega2560__ -DARDUINO_AVR_MEGA2560" ;;
+  *) echo "unknown board: $board (uno, mega)"; exit 1 ;;
+esac
+
+if [ -f "$sketch" ]; then
+  ino=$sketch
+else
+  ino="$ROOT_DIR/examples/$sketch/$sketch.ino"
+fi
+if [ ! -f "$ino" ]; then
+  echo "sketch not found: $sketch"
+  exit 1
+fi
+name=$(basename "$ino" .ino)
+output=${output:-$name-$board}
+
+# the features the sketch includes (commented includes are skipped)
+features=
+for header in $(sed -n 's/^#include *"utility\/\([A-Za-z0-9_]*\)\.h".*/\1/p' "$ino"); do
+  if [ -f "$ROOT_DIR/utility/$header.cpp" ]; then
+    features="$features $ROOT_DIR/utility/$header.cpp"
+  fi
+done
+
+${CXX:-g++} -std=gnu++11 ${CXXFLAGS:--O2 -g -Wall} \
+  -DARDUINO=10813 $board_flags "$@" \
+  -I"$EMULATOR_DIR" -I"$ROOT_DIR" \
+  -x c++ -include Arduino.h "$ino" -x none \
+  "$ROOT_DIR"/*.cpp $features "$EMULATOR_DIR"/*.cpp \
+  -o "$output"
+
+echo "$output"
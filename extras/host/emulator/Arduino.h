@@ -0,0 +1,120 @@
+/*
+  Arduino.h - emulated Arduino core for Linux host builds
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  The subset of the Arduino API used by the Firmata library and the
+  example sketches, so they build unmodified as native executables. The
+  pins are backed by the board model in Emulator.h, the time by the host
+  clock and Serial by a pty or a socket (see main.cpp).
+
+  Unlike on AVR, unsigned long is 64 bits wide on Linux, so millis() and
+  micros() do not wrap around.
+*/
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binary.h"
+#include "pins_arduino.h"
+
+// Boards.h and the Firmata headers test ARDUINO before they include this file
+#ifndef ARDUINO
+#error "Compile with -DARDUINO=10813 (see extras/host/build.sh)"
+#endif
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define PI 3.1415926535897932384626433832795
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define SERIAL  0x0
+#define DISPLAY 0x1
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEFAULT 1
+#define EXTERNAL 0
+
+#define lowByte(w) ((uint8_t) ((w) & 0xff))
+#define highByte(w) ((uint8_t) ((w) >> 8))
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+#define bit(b) (1UL << (b))
+
+#define interrupts()
+#define noInterrupts()
+#define cli()
+#define sei()
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+typedef unsigned int word;
+typedef bool boolean;
+typedef uint8_t byte;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogReference(uint8_t mode);
+void analogWrite(uint8_t pin, int val);
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+void setup(void);
+void loop(void);
+
+// templates rather than the macros of the AVR core, so <algorithm> still compiles
+template<typename T, typename U>
+inline auto min(const T & a, const U & b) -> decltype(a < b ? a : b) { return ((b < a) ? b : a); }
+template<typename T, typename U>
+inline auto max(const T & a, const U & b) -> decltype(a < b ? a : b) { return ((a < b) ? b : a); }
+template<typename T, typename L, typename H>
+inline T constrain(const T & x, const L & low, const H & high) { return ((x < low) ? low : ((x > high) ? high : x)); }
+template<typename T>
+inline T sq(const T & x) { return (x * x); }
+
+#include "HardwareSerial.h"
+
+#endif /* Arduino_h */
@@ -0,0 +1,47 @@
+/*
+  EEPROM.h - emulated Arduino core for Linux host builds
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  The EEPROM lives in RAM and starts out erased (0xFF) on every run.
+*/
+
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include <stdint.h>
+#include <string.h>
+
+#include "pins_arduino.h"
+
+#if defined(__AVR_ATmega2560__)
+#define E2END 0xFFF
+#else
+#define E2END 0x3FF
+#endif
+
+class EEPROMClass
+{
+  public:
+    EEPROMClass(void) { memset(cells, 0xFF, sizeof(cells)); }
+    uint8_t read(int address) { return (valid(address) ? cells[address] : 0); }
+    void write(int address, uint8_t value) { if (valid(address)) cells[address] = value; }
+    void update(int address, uint8_t value) { write(address, value); }
+    uint16_t length(void) { return E2END + 1; }
+
+  private:
+    uint8_t cells[E2END + 1];
+
+    bool valid(int address) { return (address >= 0 && address <= E2END); }
+};
+
+// one instance per translation unit, like the AVR library
+static EEPROMClass EEPROM;
+
+#endif /* EEPROM_h */
@@ -0,0 +1,445 @@
+/*
+  Emulator.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "Emulator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "Arduino.h"
+
+//******************************************************************************
+//* Board State
+//******************************************************************************
+
+namespace {
+
+struct pin_state {
+  uint8_t mode;
+  uint8_t latch;    // PORTx bit: the output level, or the pull-up of an input
+  int8_t drive;     // drive_level of the external circuit
+  uint8_t pwm;      // analogWrite() duty cycle, 0 when not generating PWM
+  uint16_t servo;   // [us] pulse width, 0 when no servo is attached
+};
+
+pin_state pins[NUM_DIGITAL_PINS];
+uint16_t analogInputs[NUM_ANALOG_INPUTS];
+emulator::I2CDevice * i2cDevices[128];
+bool verbose = false;
+bool virtualTime = false;
+uint64_t virtualNow = 0;  // [ns]
+
+struct pin_init {
+  pin_init(void)
+  {
+    for (size_t pin = 0; pin < NUM_DIGITAL_PINS; ++pin) {
+      pins[pin].drive = emulator::FLOATING;
+    }
+  }
+} pinInit;
+
+inline bool validPin(uint8_t pin)
+{
+  return (pin < NUM_DIGITAL_PINS);
+}
+
+void log(uint8_t pin, const char * format, unsigned value)
+{
+  if ( !verbose ) { return; }
+  const uint64_t now = emulator::micros64();
+  std::fprintf(stderr, "%llu.%06llu pin %u ", static_cast<unsigned long long>(now / 1000000), static_cast<unsigned long long>(now % 1000000), static_cast<unsigned>(pin));
+  std::fprintf(stderr, format, value);
+  std::fputc('\n', stderr);
+}
+
+void setLatch(uint8_t pin, uint8_t level)
+{
+  if ( pins[pin].latch == level ) { return; }
+  pins[pin].latch = level;
+  if ( pins[pin].mode == OUTPUT ) { log(pin, "level %u", level); }
+}
+
+} // namespace
+
+#if defined(__AVR_ATmega328P__)
+emulator::InputRegister PINB(8, 6);
+emulator::InputRegister PINC(14, 6);
+emulator::InputRegister PIND(0, 8);
+emulator::OutputRegister PORTB(8, 6);
+emulator::OutputRegister PORTC(14, 6);
+emulator::OutputRegister PORTD(0, 8);
+#endif
+
+//******************************************************************************
+//* Arduino API
+//******************************************************************************
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  emulator::charge(emulator::costs.digitalIO);
+  if ( !validPin(pin) ) { return; }
+  if ( mode == INPUT ) {
+    pins[pin].latch = LOW;
+  } else if ( mode == INPUT_PULLUP ) {
+    pins[pin].latch = HIGH;
+    mode = INPUT;
+  }
+  if ( pins[pin].mode != mode ) {
+    pins[pin].mode = mode;
+    log(pin, "mode %u", mode);
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  emulator::charge(emulator::costs.digitalIO);
+  if ( !validPin(pin) ) { return; }
+  pins[pin].pwm = 0;
+  setLatch(pin, (val ? HIGH : LOW));
+}
+
+int digitalRead(uint8_t pin)
+{
+  emulator::charge(emulator::costs.digitalIO);
+  if ( !validPin(pin) ) { return LOW; }
+  return emulator::pinLevel(pin);
+}
+
+int analogRead(uint8_t pin)
+{
+  emulator::charge(emulator::costs.analogRead);
+  if ( pin >= A0 ) { pin -= A0; }
+  if ( pin >= NUM_ANALOG_INPUTS ) { return 0; }
+  return analogInputs[pin];
+}
+
+void analogReference(uint8_t mode)
+{
+  (void)mode;
+}
+
+void analogWrite(uint8_t pin, int val)
+{
+  emulator::charge(emulator::costs.analogWrite);
+  if ( !validPin(pin) ) { return; }
+  pinMode(pin, OUTPUT);
+  if ( val <= 0 ) {
+    digitalWrite(pin, LOW);
+  } else if ( val >= 255 ) {
+    digitalWrite(pin, HIGH);
+  } else if ( !digitalPinHasPWM(pin) ) {
+    digitalWrite(pin, (val < 128 ? LOW : HIGH));
+  } else if ( pins[pin].pwm != val ) {
+    pins[pin].pwm = val;
+    log(pin, "pwm %u", val);
+  }
+}
+
+unsigned long millis(void)
+{
+  emulator::charge(emulator::costs.clock);
+  return static_cast<unsigned long>(emulator::micros64() / 1000);
+}
+
+unsigned long micros(void)
+{
+  emulator::charge(emulator::costs.clock);
+  return static_cast<unsigned long>(emulator::micros64());
+}
+
+void delay(unsigned long ms)
+{
+  emulator::sleepMicros(static_cast<uint64_t>(ms) * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  emulator::sleepMicros(us);
+}
+
+void yield(void)
+{
+}
+
+long random(long howbig)
+{
+  if ( howbig == 0 ) { return 0; }
+  return (::random() % howbig);
+}
+
+long random(long howsmall, long howbig)
+{
+  if ( howsmall >= howbig ) { return howsmall; }
+  return (random(howbig - howsmall) + howsmall);
+}
+
+void randomSeed(unsigned long seed)
+{
+  if ( seed != 0 ) { ::srandom(static_cast<unsigned>(seed)); }
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+  return ((x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min);
+}
+
+//******************************************************************************
+//* Emulator API
+//******************************************************************************
+
+namespace emulator {
+
+cost_model costs = {
+  2000,    // loop
+  3500,    // clock
+  4000,    // digitalIO
+  112000,  // analogRead: 13 ADC cycles at 125 kHz
+  6000,    // analogWrite
+  1000,    // serialCall
+  5000,    // serialWrite
+  20000,   // i2cCall
+};
+
+/**
+ * Switch between the host clock and virtual time. Select the clock before setup() runs,
+ * virtual time starts at 0.
+ * @param enable true for virtual time.
+ */
+void setVirtualTime(bool enable)
+{
+  virtualTime = enable;
+  virtualNow = 0;
+}
+
+bool isVirtualTime(void)
+{
+  return virtualTime;
+}
+
+/**
+ * @return [ns] The time since the program started.
+ */
+uint64_t nanos64(void)
+{
+  if ( virtualTime ) { return virtualNow; }
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+/**
+ * @return [us] The time since the program started.
+ */
+uint64_t micros64(void)
+{
+  return (nanos64() / 1000);
+}
+
+/**
+ * Account for the time an operation takes. Does nothing on the host clock, where the
+ * operation took its time already.
+ * @param duration [ns]
+ */
+void charge(uint64_t duration)
+{
+  if ( virtualTime ) { virtualNow += duration; }
+}
+
+/**
+ * Let virtual time pass until a point in time, e.g. while the CPU waits for the TX buffer.
+ * @param time [ns] Ignored if it is not in the future.
+ */
+void advanceTo(uint64_t time)
+{
+  if ( virtualTime && time > virtualNow ) { virtualNow = time; }
+}
+
+/**
+ * @param duration [us]
+ */
+void sleepMicros(uint64_t duration)
+{
+  if ( virtualTime ) {
+    charge(duration * 1000);
+  } else {
+    std::this_thread::sleep_for(std::chrono::microseconds(duration));
+  }
+}
+
+/**
+ * Drive an input pin from outside the board.
+ * @param pin The Arduino pin number.
+ * @param level The level, or FLOATING to release the pin.
+ */
+void driveDigital(uint8_t pin, drive_level level)
+{
+  if ( !validPin(pin) ) { return; }
+  pins[pin].drive = level;
+}
+
+/**
+ * Set the voltage on an analog input.
+ * @param channel The analog channel (0 for A0).
+ * @param value The value analogRead() returns, 0 - 1023.
+ */
+void driveAnalog(uint8_t channel, uint16_t value)
+{
+  if ( channel >= NUM_ANALOG_INPUTS ) { return; }
+  analogInputs[channel] = (value & 0x3FF);
+}
+
+/**
+ * @return INPUT or OUTPUT, an input with the pull-up enabled reports INPUT.
+ */
+uint8_t pinModeOf(uint8_t pin)
+{
+  if ( !validPin(pin) ) { return INPUT; }
+  return pins[pin].mode;
+}
+
+/**
+ * @return The level a digitalRead() of the pin returns.
+ */
+int pinLevel(uint8_t pin)
+{
+  if ( !validPin(pin) ) { return LOW; }
+  const pin_state & state = pins[pin];
+  if ( state.mode == INPUT && state.drive != FLOATING ) { return state.drive; }
+  return state.latch;
+}
+
+/**
+ * @return The duty cycle of the pin, 0 if it does not generate PWM.
+ */
+uint8_t pwmValue(uint8_t pin)
+{
+  if ( !validPin(pin) ) { return 0; }
+  return pins[pin].pwm;
+}
+
+/**
+ * @return [us] The servo pulse width of the pin, 0 if no servo is attached.
+ */
+uint16_t servoMicros(uint8_t pin)
+{
+  if ( !validPin(pin) ) { return 0; }
+  return pins[pin].servo;
+}
+
+void setServoMicros(uint8_t pin, uint16_t value)
+{
+  if ( !validPin(pin) || pins[pin].servo == value ) { return; }
+  pins[pin].servo = value;
+  log(pin, "servo %u", value);
+}
+
+/**
+ * @param enable true to print the pin changes to stderr.
+ */
+void setVerbose(bool enable)
+{
+  verbose = enable;
+}
+
+InputRegister::InputRegister(uint8_t first, uint8_t count)
+  : firstPin(first),
+    pinCount(count)
+{
+}
+
+InputRegister::operator uint8_t() const
+{
+  uint8_t value = 0;
+  for (uint8_t bit = 0; bit < pinCount; ++bit) {
+    if ( pinLevel(firstPin + bit) ) { value |= (1 << bit); }
+  }
+  return value;
+}
+
+OutputRegister::OutputRegister(uint8_t first, uint8_t count)
+  : firstPin(first),
+    pinCount(count)
+{
+}
+
+OutputRegister::operator uint8_t() const
+{
+  uint8_t value = 0;
+  for (uint8_t bit = 0; bit < pinCount; ++bit) {
+    if ( pins[firstPin + bit].latch ) { value |= (1 << bit); }
+  }
+  return value;
+}
+
+OutputRegister & OutputRegister::operator=(uint8_t value)
+{
+  for (uint8_t bit = 0; bit < pinCount; ++bit) {
+    setLatch(firstPin + bit, ((value >> bit) & 0x01));
+  }
+  return *this;
+}
+
+I2CRegisterDevice::I2CRegisterDevice(void)
+  : pointer(0)
+{
+  for (size_t i = 0; i < sizeof(registers); ++i) {
+    registers[i] = static_cast<uint8_t>(i);
+  }
+}
+
+bool I2CRegisterDevice::receive(const uint8_t * data, size_t length)
+{
+  if ( length == 0 ) { return true; }
+  pointer = data[0];
+  for (size_t i = 1; i < length; ++i) {
+    registers[pointer++] = data[i];
+  }
+  return true;
+}
+
+size_t I2CRegisterDevice::request(uint8_t * data, size_t length)
+{
+  for (size_t i = 0; i < length; ++i) {
+    data[i] = registers[pointer++];
+  }
+  return length;
+}
+
+/**
+ * Connect a device to the bus. The device must outlive the emulation.
+ * @param address The 7-bit address.
+ * @param device The device, replaces a device attached before.
+ */
+void attachI2CDevice(uint8_t address, I2CDevice * device)
+{
+  i2cDevices[address & 0x7F] = device;
+}
+
+void detachI2CDevice(uint8_t address)
+{
+  i2cDevices[address & 0x7F] = NULL;
+}
+
+/**
+ * @return The device at the address, NULL if nothing is attached.
+ */
+I2CDevice * i2cDevice(uint8_t address)
+{
+  if ( address > 0x7F ) { return NULL; }
+  return i2cDevices[address];
+}
+
+} // namespace emulator
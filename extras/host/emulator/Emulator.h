@@ -0,0 +1,163 @@
+/*
+  Emulator.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  The board model behind the emulated Arduino core: the pin levels, the
+  analog inputs, the clock and the I2C devices on the bus.
+
+  The clock runs on the host time, or in virtual time where it only
+  advances by the simulated cost of the Arduino calls the sketch makes (see
+  cost_model). Virtual time does not depend on the speed or the load of the
+  host, so a simulation gives the same results on every run. The sketch only
+  sees the Arduino API (Arduino.h, Wire.h, Servo.h). The emulator main and
+  test harnesses use the functions declared here to drive the inputs and
+  observe the outputs.
+*/
+
+#ifndef Emulator_h
+#define Emulator_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace emulator {
+
+//******************************************************************************
+//* Clock
+//******************************************************************************
+
+/**
+ * What the Arduino calls cost in virtual time. The defaults approximate an ATmega at 16 MHz.
+ * Every call that can be polled in a loop costs time, so busy waits on millis() end.
+ */
+struct cost_model {
+  uint32_t loop;          // [ns] the main() iteration around loop()
+  uint32_t clock;         // [ns] millis(), micros()
+  uint32_t digitalIO;     // [ns] pinMode(), digitalRead(), digitalWrite()
+  uint32_t analogRead;    // [ns] one conversion
+  uint32_t analogWrite;   // [ns]
+  uint32_t serialCall;    // [ns] available(), peek(), read()
+  uint32_t serialWrite;   // [ns] one byte into the TX buffer
+  uint32_t i2cCall;       // [ns] per transfer, plus 9 bit times per byte at the Wire clock
+};
+
+extern cost_model costs;
+
+void setVirtualTime(bool enable);
+bool isVirtualTime(void);
+uint64_t nanos64(void);
+uint64_t micros64(void);
+void charge(uint64_t duration);
+void advanceTo(uint64_t time);
+void sleepMicros(uint64_t duration);
+
+//******************************************************************************
+//* Pins
+//******************************************************************************
+
+/**
+ * The level an external circuit drives onto a pin. A floating input reads HIGH with the pull-up
+ * enabled and LOW otherwise, so results do not depend on noise.
+ */
+enum drive_level {
+  FLOATING = -1,
+  DRIVEN_LOW = 0,
+  DRIVEN_HIGH = 1,
+};
+
+void driveDigital(uint8_t pin, drive_level level);
+void driveAnalog(uint8_t channel, uint16_t value);
+
+uint8_t pinModeOf(uint8_t pin);
+int pinLevel(uint8_t pin);
+uint8_t pwmValue(uint8_t pin);
+uint16_t servoMicros(uint8_t pin);
+void setServoMicros(uint8_t pin, uint16_t value);
+
+void setVerbose(bool verbose);
+
+/**
+ * The PINx (read) and PORTx (read and write) registers of one AVR port, for the boards that
+ * use ARDUINO_PINOUT_OPTIMIZE in Boards.h. Bit n maps to the Arduino pin firstPin + n.
+ */
+class InputRegister
+{
+  public:
+    InputRegister(uint8_t firstPin, uint8_t pinCount);
+    operator uint8_t() const;
+
+  private:
+    const uint8_t firstPin;
+    const uint8_t pinCount;
+};
+
+class OutputRegister
+{
+  public:
+    OutputRegister(uint8_t firstPin, uint8_t pinCount);
+    operator uint8_t() const;
+    OutputRegister & operator=(uint8_t value);
+
+  private:
+    const uint8_t firstPin;
+    const uint8_t pinCount;
+};
+
+//******************************************************************************
+//* I2C
+//******************************************************************************
+
+/**
+ * A peripheral on the emulated I2C bus.
+ */
+class I2CDevice
+{
+  public:
+    virtual ~I2CDevice() {}
+
+    /**
+     * The controller wrote one transaction.
+     * @return false to NACK the transfer.
+     */
+    virtual bool receive(const uint8_t * data, size_t length) = 0;
+
+    /**
+     * The controller reads up to length bytes.
+     * @return The number of bytes stored in data.
+     */
+    virtual size_t request(uint8_t * data, size_t length) = 0;
+};
+
+/**
+ * A device with 256 byte-wide registers, the common layout of sensors. A write sets the
+ * register pointer with its first byte and stores the following bytes; a read returns the
+ * registers from the pointer on. The pointer increments after each byte. Register n starts
+ * out with the value n.
+ */
+class I2CRegisterDevice : public I2CDevice
+{
+  public:
+    I2CRegisterDevice(void);
+    bool receive(const uint8_t * data, size_t length);
+    size_t request(uint8_t * data, size_t length);
+
+    uint8_t registers[256];
+
+  private:
+    uint8_t pointer;
+};
+
+void attachI2CDevice(uint8_t address, I2CDevice * device);
+void detachI2CDevice(uint8_t address);
+I2CDevice * i2cDevice(uint8_t address);
+
+} // namespace emulator
+
+#endif /* Emulator_h */
@@ -0,0 +1,231 @@
+/*
+  HardwareSerial.cpp - emulated Arduino core for Linux host builds
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#include "HardwareSerial.h"
+
+#include "Emulator.h"
+#include "SimulatedLink.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+#if NUM_SERIAL_PORTS > 1
+HardwareSerial Serial1;
+HardwareSerial Serial2;
+HardwareSerial Serial3;
+#endif
+
+HardwareSerial::HardwareSerial(void)
+  : fd(-1),
+    blocking(true),
+    link(NULL),
+    baud(0),
+    hangup(false),
+    rxHead(0),
+    rxCount(0)
+{
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+  this->baud = baud;
+}
+
+void HardwareSerial::begin(unsigned long baud, uint8_t config)
+{
+  (void)config;
+  begin(baud);
+}
+
+void HardwareSerial::end(void)
+{
+  baud = 0;
+  rxHead = 0;
+  rxCount = 0;
+}
+
+int HardwareSerial::available(void)
+{
+  emulator::charge(emulator::costs.serialCall);
+  if (link) return link->available();
+  fill();
+  return (int)rxCount;
+}
+
+int HardwareSerial::peek(void)
+{
+  emulator::charge(emulator::costs.serialCall);
+  if (link) return link->peek();
+  fill();
+  if (rxCount == 0) return -1;
+  return rxBuffer[rxHead];
+}
+
+int HardwareSerial::read(void)
+{
+  emulator::charge(emulator::costs.serialCall);
+  if (link) return link->read();
+  fill();
+  if (rxCount == 0) return -1;
+  uint8_t c = rxBuffer[rxHead];
+  rxHead = (rxHead + 1) % SERIAL_RX_BUFFER_SIZE;
+  rxCount--;
+  return c;
+}
+
+int HardwareSerial::availableForWrite(void)
+{
+  // the kernel buffers the descriptor, so a write never waits for long
+  return SERIAL_RX_BUFFER_SIZE - 1;
+}
+
+void HardwareSerial::flush(void)
+{
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+/**
+ * A blocking port waits until the descriptor took all bytes, like the AVR core waits while its
+ * TX buffer is full.
+ * @return The number of bytes written, less than size if bytes were dropped or the other end
+ * is gone.
+ */
+size_t HardwareSerial::write(const uint8_t * buffer, size_t size)
+{
+  size_t i;
+  emulator::charge(size * (uint64_t)emulator::costs.serialWrite);
+  if (link) {
+    for (i = 0; i < size; i++) {
+      link->write(buffer[i]);
+    }
+    return size;
+  }
+  if (fd < 0) {
+    for (i = 0; i < size; i++) {
+      store(buffer[i]);
+    }
+    return size;
+  }
+
+  size_t written = 0;
+  while (written < size && !hangup) {
+    ssize_t n = ::write(fd, buffer + written, size - written);
+    if (n > 0) {
+      written += n;
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (!blocking) break;
+      struct pollfd pfd = { fd, POLLOUT, 0 };
+      poll(&pfd, 1, -1);
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else {
+      hangup = true;
+    }
+  }
+  return written;
+}
+
+/**
+ * Connect the port to a file descriptor opened with O_NONBLOCK.
+ * @param fd The descriptor, -1 selects the loopback.
+ * @param blocking false to drop the bytes the descriptor cannot take.
+ */
+void HardwareSerial::attach(int fd, bool blocking)
+{
+  this->fd = fd;
+  this->blocking = blocking;
+  link = NULL;
+  hangup = false;
+  rxHead = 0;
+  rxCount = 0;
+}
+
+/**
+ * Connect the port to the board side of a simulated line.
+ */
+void HardwareSerial::attach(emulator::SimulatedLink * link)
+{
+  this->link = link;
+  fd = -1;
+  hangup = false;
+  rxHead = 0;
+  rxCount = 0;
+}
+
+int HardwareSerial::descriptor(void) const
+{
+  return fd;
+}
+
+/**
+ * @return The baud rate passed to begin(), 0 before begin() or after end().
+ */
+unsigned long HardwareSerial::baudRate(void) const
+{
+  return baud;
+}
+
+/**
+ * @return true once the other end of the descriptor closed the connection.
+ */
+bool HardwareSerial::hungUp(void) const
+{
+  return hangup;
+}
+
+/**
+ * Sleep until data arrives or the timeout expires.
+ * @param timeout [us]
+ * @return true if data is available.
+ */
+bool HardwareSerial::waitForInput(unsigned long timeout)
+{
+  if (available() > 0) return true;
+  if (link || fd < 0 || hangup) return false;
+
+  struct pollfd pfd = { fd, POLLIN, 0 };
+  struct timespec ts;
+  ts.tv_sec = timeout / 1000000UL;
+  ts.tv_nsec = (timeout % 1000000UL) * 1000L;
+  ppoll(&pfd, 1, &ts, NULL);
+  return (available() > 0);
+}
+
+// move bytes from the descriptor into the receive buffer
+void HardwareSerial::fill(void)
+{
+  if (fd < 0 || hangup || rxCount == SERIAL_RX_BUFFER_SIZE) return;
+
+  uint8_t chunk[SERIAL_RX_BUFFER_SIZE];
+  ssize_t n = ::read(fd, chunk, SERIAL_RX_BUFFER_SIZE - rxCount);
+  if (n > 0) {
+    for (ssize_t i = 0; i < n; i++) {
+      store(chunk[i]);
+    }
+  } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+    hangup = true;
+  }
+}
+
+void HardwareSerial::store(uint8_t c)
+{
+  if (rxCount == SERIAL_RX_BUFFER_SIZE) return;
+  rxBuffer[(rxHead + rxCount) % SERIAL_RX_BUFFER_SIZE] = c;
+  rxCount++;
+}
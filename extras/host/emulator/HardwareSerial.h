@@ -0,0 +1,94 @@
+/*
+  HardwareSerial.h - emulated Arduino core for Linux host builds
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  A serial port is either attached to a file descriptor (a pty master or one
+  end of a socketpair) or, when nothing is attached, loops its TX back to
+  its RX. Like on AVR the receive buffer holds SERIAL_RX_BUFFER_SIZE bytes;
+  the rest waits in the kernel buffer of the descriptor. In loopback mode
+  bytes that do not fit the receive buffer are lost, like an overrun.
+
+  Writes to a blocking port wait until the descriptor takes the bytes. A
+  non-blocking port (a pty nobody has opened yet) drops what does not fit,
+  like a UART transmitting without a listener.
+
+  In virtual time a port is attached to an emulator::SimulatedLink instead,
+  which models the timing of the line and of the AVR UART buffers.
+*/
+
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Stream.h"
+#include "pins_arduino.h"
+
+#define SERIAL_RX_BUFFER_SIZE 64
+#define SERIAL_TX_BUFFER_SIZE 64
+
+#define SERIAL_5N1 0x00
+#define SERIAL_6N1 0x02
+#define SERIAL_7N1 0x04
+#define SERIAL_8N1 0x06
+
+namespace emulator {
+class SimulatedLink;
+}
+
+class HardwareSerial : public Stream
+{
+  public:
+    HardwareSerial(void);
+
+    void begin(unsigned long baud);
+    void begin(unsigned long baud, uint8_t config);
+    void end(void);
+    int available(void);
+    int peek(void);
+    int read(void);
+    int availableForWrite(void);
+    void flush(void);
+    size_t write(uint8_t c);
+    size_t write(const uint8_t * buffer, size_t size);
+    using Print::write;
+    operator bool() { return true; }
+
+    // emulator side
+    void attach(int fd, bool blocking = true);
+    void attach(emulator::SimulatedLink * link);
+    int descriptor(void) const;
+    unsigned long baudRate(void) const;
+    bool hungUp(void) const;
+    bool waitForInput(unsigned long timeout);
+
+  private:
+    int fd;
+    bool blocking;
+    emulator::SimulatedLink * link;
+    unsigned long baud;
+    bool hangup;
+    uint8_t rxBuffer[SERIAL_RX_BUFFER_SIZE];
+    size_t rxHead;
+    size_t rxCount;
+
+    void fill(void);
+    void store(uint8_t c);
+};
+
+extern HardwareSerial Serial;
+#if NUM_SERIAL_PORTS > 1
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+extern HardwareSerial Serial3;
+#endif
+
+#endif /* HardwareSerial_h */
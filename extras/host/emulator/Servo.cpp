@@ -0,0 +1,90 @@
+/*
+  Servo.cpp - emulated Arduino core for Linux host builds
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#include "Servo.h"
+
+#include "Arduino.h"
+#include "Emulator.h"
+
+static uint8_t servoCount = 0;
+
+Servo::Servo(void)
+  : servoIndex((servoCount < MAX_SERVOS) ? servoCount++ : INVALID_SERVO),
+    pin(-1),
+    min(MIN_PULSE_WIDTH),
+    max(MAX_PULSE_WIDTH),
+    pulseWidth(DEFAULT_PULSE_WIDTH)
+{
+}
+
+uint8_t Servo::attach(int pin)
+{
+  return attach(pin, MIN_PULSE_WIDTH, MAX_PULSE_WIDTH);
+}
+
+/**
+ * @return The servo index, INVALID_SERVO if more than MAX_SERVOS instances exist.
+ */
+uint8_t Servo::attach(int pin, int min, int max)
+{
+  if (servoIndex == INVALID_SERVO) return INVALID_SERVO;
+  pinMode(pin, OUTPUT);
+  this->pin = pin;
+  this->min = min;
+  this->max = max;
+  emulator::setServoMicros(pin, pulseWidth);
+  return servoIndex;
+}
+
+void Servo::detach(void)
+{
+  if (pin >= 0) {
+    emulator::setServoMicros(pin, 0);
+  }
+  pin = -1;
+}
+
+/**
+ * @param value An angle in degrees, or a pulse width in microseconds if it is not smaller than
+ * MIN_PULSE_WIDTH.
+ */
+void Servo::write(int value)
+{
+  if (value < MIN_PULSE_WIDTH) {
+    value = constrain(value, 0, 180);
+    value = map(value, 0, 180, min, max);
+  }
+  writeMicroseconds(value);
+}
+
+void Servo::writeMicroseconds(int value)
+{
+  pulseWidth = constrain(value, min, max);
+  if (pin >= 0) {
+    emulator::setServoMicros(pin, pulseWidth);
+  }
+}
+
+int Servo::read(void)
+{
+  return map(pulseWidth + 1, min, max, 0, 180);
+}
+
+int Servo::readMicroseconds(void)
+{
+  return pulseWidth;
+}
+
+bool Servo::attached(void)
+{
+  return (pin >= 0);
+}
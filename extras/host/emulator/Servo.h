@@ -0,0 +1,56 @@
+/*
+  Servo.h - emulated Arduino core for Linux host builds
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Servo outputs of the emulated board. The pulse width of an attached pin
+  can be read back with emulator::servoMicros().
+*/
+
+#ifndef Servo_h
+#define Servo_h
+
+#include <stdint.h>
+
+#include "pins_arduino.h"
+
+// 12 servos per 16-bit timer, like the AVR library
+#if defined(__AVR_ATmega2560__)
+#define MAX_SERVOS              48
+#else
+#define MAX_SERVOS              12
+#endif
+
+#define MIN_PULSE_WIDTH         544  // [us]
+#define MAX_PULSE_WIDTH         2400 // [us]
+#define DEFAULT_PULSE_WIDTH     1500 // [us]
+#define INVALID_SERVO           255
+
+class Servo
+{
+  public:
+    Servo(void);
+    uint8_t attach(int pin);
+    uint8_t attach(int pin, int min, int max);
+    void detach(void);
+    void write(int value);
+    void writeMicroseconds(int value);
+    int read(void);
+    int readMicroseconds(void);
+    bool attached(void);
+
+  private:
+    uint8_t servoIndex;
+    int pin;
+    int min;
+    int max;
+    int pulseWidth;
+};
+
+#endif /* Servo_h */
@@ -0,0 +1,185 @@
+/*
+  SimulatedLink.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include "SimulatedLink.h"
+
+#include "Emulator.h"
+
+using namespace emulator;
+
+//******************************************************************************
+//* Constructors
+//******************************************************************************
+
+/**
+ * @param baud The baud rate of both directions.
+ */
+SimulatedLink::SimulatedLink(unsigned long baud)
+  : bitsTime((10 * 1000000000ULL) / (baud ? baud : 1)),
+    boardLineFree(0),
+    hostLineFree(0),
+    rxHead(0),
+    rxCount(0),
+    txHead(0),
+    txCount(0),
+    received(0),
+    sent(0),
+    lost(0)
+{
+}
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+/**
+ * @return [ns] The time a byte occupies the line.
+ */
+uint64_t SimulatedLink::byteTime(void) const
+{
+  return bitsTime;
+}
+
+/**
+ * The host starts sending bytes. The bytes follow each other and any bytes still on the line.
+ * Calls must come in the order of their time, which may lie in the future.
+ * @param time [ns] The virtual time the host writes the bytes.
+ * @param data The bytes.
+ * @param length The number of bytes.
+ */
+void SimulatedLink::send(uint64_t time, const uint8_t * data, size_t length)
+{
+  size_t i;
+  for (i = 0; i < length; ++i) {
+    boardLineFree = (((time > boardLineFree) ? time : boardLineFree) + bitsTime);
+    timed_byte b = { boardLineFree, data[i] };
+    toBoard.push_back(b);
+  }
+}
+
+/**
+ * Take the bytes that reached the host by now.
+ * @param data Receives the bytes.
+ * @param times Receives the arrival time [ns] of each byte, may be NULL.
+ * @param length The size of the buffers.
+ * @return The number of bytes taken.
+ */
+size_t SimulatedLink::receive(uint8_t * data, uint64_t * times, size_t length)
+{
+  const uint64_t now = nanos64();
+  size_t n = 0;
+  while ( n < length && !toHost.empty() && toHost.front().time <= now ) {
+    data[n] = toHost.front().value;
+    if ( times ) { times[n] = toHost.front().time; }
+    toHost.pop_front();
+    ++n;
+  }
+  return n;
+}
+
+int SimulatedLink::available(void)
+{
+  deliver();
+  return static_cast<int>(rxCount);
+}
+
+int SimulatedLink::peek(void)
+{
+  deliver();
+  if ( rxCount == 0 ) { return -1; }
+  return rxBuffer[rxHead];
+}
+
+int SimulatedLink::read(void)
+{
+  deliver();
+  if ( rxCount == 0 ) { return -1; }
+  const uint8_t c = rxBuffer[rxHead];
+  rxHead = ((rxHead + 1) % SERIAL_RX_BUFFER_SIZE);
+  --rxCount;
+  return c;
+}
+
+/**
+ * Queue a byte in the transmit buffer, waiting for a free slot if necessary.
+ * @return 1
+ */
+size_t SimulatedLink::write(uint8_t c)
+{
+  // free the slots of the bytes that are out
+  while ( txCount > 0 && txDone[txHead] <= nanos64() ) {
+    txHead = ((txHead + 1) % SERIAL_TX_BUFFER_SIZE);
+    --txCount;
+  }
+  if ( txCount == SERIAL_TX_BUFFER_SIZE ) {
+    advanceTo(txDone[txHead]);
+    txHead = ((txHead + 1) % SERIAL_TX_BUFFER_SIZE);
+    --txCount;
+  }
+
+  const uint64_t now = nanos64();
+  hostLineFree = (((now > hostLineFree) ? now : hostLineFree) + bitsTime);
+  txDone[(txHead + txCount) % SERIAL_TX_BUFFER_SIZE] = hostLineFree;
+  ++txCount;
+  timed_byte b = { hostLineFree, c };
+  toHost.push_back(b);
+  ++sent;
+  return 1;
+}
+
+/**
+ * @return The number of bytes that arrived at the board, including the lost ones.
+ */
+uint64_t SimulatedLink::bytesToBoard(void) const
+{
+  return received;
+}
+
+/**
+ * @return The number of bytes the board wrote.
+ */
+uint64_t SimulatedLink::bytesToHost(void) const
+{
+  return sent;
+}
+
+/**
+ * @return The number of bytes lost because the receive buffer was full.
+ */
+uint64_t SimulatedLink::overruns(void) const
+{
+  return lost;
+}
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+// move the bytes that arrived by now into the receive buffer
+void SimulatedLink::deliver(void)
+{
+  const uint64_t now = nanos64();
+  while ( !toBoard.empty() && toBoard.front().time <= now ) {
+    if ( rxCount < SERIAL_RX_BUFFER_SIZE ) {
+      rxBuffer[(rxHead + rxCount) % SERIAL_RX_BUFFER_SIZE] = toBoard.front().value;
+      ++rxCount;
+    } else {
+      ++lost;
+    }
+    ++received;
+    toBoard.pop_front();
+  }
+}
@@ -0,0 +1,79 @@
+/*
+  SimulatedLink.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  A serial line between the host and the emulated board in virtual time.
+  Each byte occupies the line for 10 bit times (8N1) at the baud rate. The
+  board side behaves like the AVR UART: received bytes that find the
+  SERIAL_RX_BUFFER_SIZE byte receive buffer full are lost (overrun), and a
+  write waits while the SERIAL_TX_BUFFER_SIZE byte transmit buffer is full.
+*/
+
+#ifndef SimulatedLink_h
+#define SimulatedLink_h
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+#include "HardwareSerial.h"
+
+namespace emulator {
+
+class SimulatedLink
+{
+  public:
+    explicit SimulatedLink(unsigned long baud);
+
+    uint64_t byteTime(void) const;
+
+    // host side
+    void send(uint64_t time, const uint8_t * data, size_t length);
+    size_t receive(uint8_t * data, uint64_t * times, size_t length);
+
+    // board side
+    int available(void);
+    int peek(void);
+    int read(void);
+    size_t write(uint8_t c);
+
+    uint64_t bytesToBoard(void) const;
+    uint64_t bytesToHost(void) const;
+    uint64_t overruns(void) const;
+
+  private:
+    struct timed_byte {
+      uint64_t time;  // [ns] when the stop bit ends
+      uint8_t value;
+    };
+
+    const uint64_t bitsTime;
+    std::deque<timed_byte> toBoard;
+    std::deque<timed_byte> toHost;
+    uint64_t boardLineFree;
+    uint64_t hostLineFree;
+
+    uint8_t rxBuffer[SERIAL_RX_BUFFER_SIZE];
+    size_t rxHead;
+    size_t rxCount;
+    uint64_t txDone[SERIAL_TX_BUFFER_SIZE];
+    size_t txHead;
+    size_t txCount;
+
+    uint64_t received;
+    uint64_t sent;
+    uint64_t lost;
+
+    void deliver(void);
+};
+
+} // namespace emulator
+
+#endif /* SimulatedLink_h */
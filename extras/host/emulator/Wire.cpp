@@ -0,0 +1,120 @@
+/*
+  Wire.cpp - emulated Arduino core for Linux host builds
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#include "Wire.h"
+
+#include "Emulator.h"
+
+TwoWire Wire;
+
+TwoWire::TwoWire(void)
+  : rxIndex(0),
+    rxLength(0),
+    txAddress(0),
+    txLength(0),
+    transmitting(false),
+    clock(100000)
+{
+}
+
+void TwoWire::begin(void)
+{
+  rxIndex = 0;
+  rxLength = 0;
+  txLength = 0;
+  transmitting = false;
+}
+
+void TwoWire::end(void)
+{
+}
+
+void TwoWire::setClock(uint32_t clock)
+{
+  if (clock > 0) {
+    this->clock = clock;
+  }
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+  transmitting = true;
+  txAddress = address;
+  txLength = 0;
+}
+
+/**
+ * @return 0 on success, 2 if no device acknowledged the address, 3 if the device rejected the
+ * data (the codes of the AVR library).
+ */
+uint8_t TwoWire::endTransmission(uint8_t sendStop)
+{
+  (void)sendStop;
+  transmitting = false;
+  charge(txLength);
+  emulator::I2CDevice *device = emulator::i2cDevice(txAddress);
+  if (device == NULL) return 2;
+  return device->receive(txBuffer, txLength) ? 0 : 3;
+}
+
+/**
+ * @return The number of bytes read, 0 if no device acknowledged the address.
+ */
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop)
+{
+  (void)sendStop;
+  if (quantity > BUFFER_LENGTH) quantity = BUFFER_LENGTH;
+  emulator::I2CDevice *device = emulator::i2cDevice(address);
+  rxIndex = 0;
+  rxLength = (device == NULL) ? 0 : (uint8_t)device->request(rxBuffer, quantity);
+  charge(rxLength);
+  return rxLength;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+  if (!transmitting || txLength >= BUFFER_LENGTH) return 0;
+  txBuffer[txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t * data, size_t quantity)
+{
+  size_t i;
+  for (i = 0; i < quantity; i++) {
+    if (!write(data[i])) break;
+  }
+  return i;
+}
+
+int TwoWire::available(void)
+{
+  return rxLength - rxIndex;
+}
+
+int TwoWire::read(void)
+{
+  if (rxIndex >= rxLength) return -1;
+  return rxBuffer[rxIndex++];
+}
+
+int TwoWire::peek(void)
+{
+  if (rxIndex >= rxLength) return -1;
+  return rxBuffer[rxIndex];
+}
+
+// the time the bus is busy with the address and the data bytes
+void TwoWire::charge(size_t bytes)
+{
+  emulator::charge(emulator::costs.i2cCall + (9 * (bytes + 1) * 1000000000ULL) / clock);
+}
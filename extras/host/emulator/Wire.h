@@ -0,0 +1,70 @@
+/*
+  Wire.h - emulated Arduino core for Linux host builds
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  I2C controller on the emulated bus. Transfers go to the devices attached
+  with emulator::attachI2CDevice(); an address without a device NACKs.
+  Like the AVR library, transfers are limited to BUFFER_LENGTH bytes. In
+  virtual time a transfer costs 9 bit times per byte, address included, at
+  the clock set with setClock().
+*/
+
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Stream.h"
+
+#define BUFFER_LENGTH 32
+
+class TwoWire : public Stream
+{
+  public:
+    TwoWire(void);
+
+    void begin(void);
+    void end(void);
+    void setClock(uint32_t clock);
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    uint8_t endTransmission(uint8_t sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = true);
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+    uint8_t requestFrom(int address, int quantity, int sendStop) { return requestFrom((uint8_t)address, (uint8_t)quantity, (uint8_t)sendStop); }
+
+    size_t write(uint8_t data);
+    size_t write(const uint8_t * data, size_t quantity);
+    size_t write(unsigned long n) { return write((uint8_t)n); }
+    size_t write(long n) { return write((uint8_t)n); }
+    size_t write(unsigned int n) { return write((uint8_t)n); }
+    size_t write(int n) { return write((uint8_t)n); }
+    using Print::write;
+    int available(void);
+    int read(void);
+    int peek(void);
+
+  private:
+    uint8_t rxBuffer[BUFFER_LENGTH];
+    uint8_t rxIndex;
+    uint8_t rxLength;
+    uint8_t txAddress;
+    uint8_t txBuffer[BUFFER_LENGTH];
+    uint8_t txLength;
+    bool transmitting;
+    uint32_t clock;
+
+    void charge(size_t bytes);
+};
+
+extern TwoWire Wire;
+
+#endif /* TwoWire_h */
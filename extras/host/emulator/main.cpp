@@ -0,0 +1,313 @@
+/*
+  main.cpp - runs a sketch on the emulated board
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Connects Serial to a pty (default) or to an inherited descriptor such as
+  one end of a socketpair, then calls setup() once and loop() until the
+  other end hangs up or the process is terminated.
+
+  With --virtual the board runs in virtual time for a given duration and
+  Serial is a SimulatedLink. The host side is a script of timestamped bytes
+  to send (--input) and a log of the bytes received (--output), both with
+  one "time_us hex-bytes" line per burst, e.g. "1000000 f9". A burst in the
+  log is a run of bytes that followed each other without a gap on the line.
+  The same arguments always produce the same log.
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+#include "Emulator.h"
+#include "SimulatedLink.h"
+
+//******************************************************************************
+//* Support Functions
+//******************************************************************************
+
+namespace {
+
+// [us] how long an idle loop() waits for input, keeps the emulator from spinning a core
+const unsigned long IDLE_WAIT = 100;
+
+const char * linkPath = NULL;
+volatile std::sig_atomic_t stopped = 0;
+
+void usage(const char * program)
+{
+  std::fprintf(stderr,
+    "usage: %s [options]\n"
+    "  -f, --fd N          use the inherited descriptor N (e.g. a socketpair end) for Serial\n"
+    "  -l, --link PATH     create a pty and a symlink PATH to its device (default: print the device)\n"
+    "  -i, --i2c ADDRESS   attach a register device at the 7-bit ADDRESS (repeatable)\n"
+    "  -s, --spin          never sleep in an idle loop()\n"
+    "  -v, --verbose       print the pin changes to stderr\n"
+    "  -t, --virtual SECS  run SECS seconds in virtual time on a simulated serial line\n"
+    "  -b, --baud N        baud rate of the simulated line (default 57600)\n"
+    "  -r, --input FILE    \"time_us hex\" lines the host sends on the simulated line\n"
+    "  -w, --output FILE   log of the bytes the host receives (default stdout)\n",
+    program);
+}
+
+void removeLink(void)
+{
+  if ( linkPath ) { ::unlink(linkPath); }
+}
+
+void stop(int)
+{
+  stopped = 1;
+}
+
+bool setNonBlocking(int fd)
+{
+  const int flags = ::fcntl(fd, F_GETFL);
+  return (flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0);
+}
+
+/**
+ * Create a pty in raw mode. The slave side stays open, so reads do not fail while no client
+ * has the device open.
+ * @return The master descriptor, -1 on failure.
+ */
+int openPty(void)
+{
+  const int master = ::posix_openpt(O_RDWR | O_NOCTTY);
+  if ( master < 0 || ::grantpt(master) != 0 || ::unlockpt(master) != 0 ) { return -1; }
+
+  const char * name = ::ptsname(master);
+  const int slave = (name ? ::open(name, O_RDWR | O_NOCTTY) : -1);
+  if ( slave < 0 ) { return -1; }
+
+  struct termios tio;
+  if ( ::tcgetattr(slave, &tio) != 0 ) { return -1; }
+  ::cfmakeraw(&tio);
+  if ( ::tcsetattr(slave, TCSANOW, &tio) != 0 ) { return -1; }
+
+  if ( linkPath ) {
+    ::unlink(linkPath);
+    if ( ::symlink(name, linkPath) != 0 ) {
+      std::fprintf(stderr, "cannot create %s: %s\n", linkPath, std::strerror(errno));
+      return -1;
+    }
+    std::atexit(removeLink);
+  }
+  std::printf("%s\n", name);
+  std::fflush(stdout);
+  return master;
+}
+
+/**
+ * Queue the bytes of an input script on the link.
+ * @return false if the file cannot be read or has a malformed line.
+ */
+bool loadInput(const char * path, emulator::SimulatedLink & link)
+{
+  std::FILE * file = std::fopen(path, "r");
+  if ( !file ) { return false; }
+
+  char line[4096];
+  unsigned lineNumber = 0;
+  std::vector<uint8_t> bytes;
+  bool ok = true;
+  while ( ok && std::fgets(line, sizeof(line), file) ) {
+    ++lineNumber;
+    char * p = line;
+    while ( *p == ' ' || *p == '\t' ) { ++p; }
+    if ( *p == '#' || *p == '\n' || *p == '\r' || *p == '\0' ) { continue; }
+
+    char * end;
+    const unsigned long long time = std::strtoull(p, &end, 10);
+    ok = (end != p);
+    bytes.clear();
+    for (p = end; ok; p += 2) {
+      while ( *p == ' ' || *p == '\t' ) { ++p; }
+      if ( *p == '\n' || *p == '\r' || *p == '\0' ) { break; }
+      unsigned value;
+      ok = (std::sscanf(p, "%2x", &value) == 1 && std::isxdigit(static_cast<unsigned char>(p[1])));
+      bytes.push_back(static_cast<uint8_t>(value));
+    }
+    if ( ok ) {
+      link.send(time * 1000, bytes.data(), bytes.size());
+    } else {
+      std::fprintf(stderr, "%s:%u: expected \"time_us hex-bytes\"\n", path, lineNumber);
+    }
+  }
+  std::fclose(file);
+  return ok;
+}
+
+/**
+ * Write the bytes that reached the host to the log, starting a new line at a gap on the line.
+ * @param last true to end the log.
+ */
+void writeOutput(std::FILE * file, emulator::SimulatedLink & link, bool last)
+{
+  static uint64_t lastTime = 0;
+  static size_t lineLength = 0;
+  uint8_t data[256];
+  uint64_t times[256];
+  size_t n;
+
+  while ( (n = link.receive(data, times, sizeof(data))) > 0 ) {
+    for (size_t i = 0; i < n; ++i) {
+      if ( lineLength == 0 || lineLength == 32 || times[i] != lastTime + link.byteTime() ) {
+        std::fprintf(file, "%s%llu ", (lineLength ? "\n" : ""), static_cast<unsigned long long>(times[i] / 1000));
+        lineLength = 0;
+      }
+      std::fprintf(file, "%02x", data[i]);
+      lastTime = times[i];
+      ++lineLength;
+    }
+  }
+  if ( last && lineLength ) { std::fputc('\n', file); }
+}
+
+/**
+ * Run the sketch in virtual time on a simulated line.
+ * @return The exit code.
+ */
+int simulate(double duration, unsigned long baud, const char * input, const char * output)
+{
+  emulator::setVirtualTime(true);
+  emulator::SimulatedLink link(baud);
+  if ( input && !loadInput(input, link) ) {
+    std::fprintf(stderr, "cannot read %s\n", input);
+    return EXIT_FAILURE;
+  }
+  std::FILE * file = (output ? std::fopen(output, "w") : stdout);
+  if ( !file ) {
+    std::fprintf(stderr, "cannot write %s: %s\n", output, std::strerror(errno));
+    return EXIT_FAILURE;
+  }
+  Serial.attach(&link);
+
+  const uint64_t end = static_cast<uint64_t>(duration * 1e9);
+  uint64_t loops = 0;
+  setup();
+  while ( !stopped && emulator::nanos64() < end ) {
+    loop();
+    emulator::charge(emulator::costs.loop);
+    ++loops;
+    writeOutput(file, link, false);
+  }
+  // bytes still on the line arrive after the end
+  writeOutput(file, link, true);
+  if ( output ) { std::fclose(file); }
+
+  std::fprintf(stderr, "%.6f s, %llu loops, %llu bytes received, %llu bytes sent, %llu overruns\n",
+    duration, static_cast<unsigned long long>(loops), static_cast<unsigned long long>(link.bytesToBoard()),
+    static_cast<unsigned long long>(link.bytesToHost()), static_cast<unsigned long long>(link.overruns()));
+  return EXIT_SUCCESS;
+}
+
+} // namespace
+
+//******************************************************************************
+//* Main
+//******************************************************************************
+
+int main(int argc, char * argv[])
+{
+  static const struct option options[] = {
+    { "fd", required_argument, NULL, 'f' },
+    { "link", required_argument, NULL, 'l' },
+    { "i2c", required_argument, NULL, 'i' },
+    { "spin", no_argument, NULL, 's' },
+    { "verbose", no_argument, NULL, 'v' },
+    { "virtual", required_argument, NULL, 't' },
+    { "baud", required_argument, NULL, 'b' },
+    { "input", required_argument, NULL, 'r' },
+    { "output", required_argument, NULL, 'w' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+  int fd = -1;
+  bool spin = false;
+  double duration = 0.0;
+  unsigned long baud = 57600;
+  const char * input = NULL;
+  const char * output = NULL;
+  int option;
+
+  while ( (option = ::getopt_long(argc, argv, "f:l:i:svt:b:r:w:h", options, NULL)) != -1 ) {
+    switch (option) {
+      case 'f':
+        fd = std::atoi(optarg);
+        break;
+      case 'l':
+        linkPath = optarg;
+        break;
+      case 'i':
+        // the devices live until the process exits
+        emulator::attachI2CDevice(static_cast<uint8_t>(std::strtoul(optarg, NULL, 0)), new emulator::I2CRegisterDevice());
+        break;
+      case 's':
+        spin = true;
+        break;
+      case 'v':
+        emulator::setVerbose(true);
+        break;
+      case 't':
+        duration = std::atof(optarg);
+        break;
+      case 'b':
+        baud = std::strtoul(optarg, NULL, 10);
+        break;
+      case 'r':
+        input = optarg;
+        break;
+      case 'w':
+        output = optarg;
+        break;
+      default:
+        usage(argv[0]);
+        return ((option == 'h') ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+  }
+
+  std::signal(SIGINT, stop);
+  std::signal(SIGTERM, stop);
+  if ( duration > 0.0 ) {
+    return simulate(duration, baud, input, output);
+  }
+
+  // a pty drops what nobody reads, a socket applies back pressure like a UART at full speed
+  const bool pty = (fd < 0);
+  if ( pty ) { fd = openPty(); }
+  if ( fd < 0 || !setNonBlocking(fd) ) {
+    std::fprintf(stderr, "cannot open the serial transport: %s\n", std::strerror(errno));
+    return EXIT_FAILURE;
+  }
+  Serial.attach(fd, !pty);
+
+  std::signal(SIGPIPE, SIG_IGN);
+
+  setup();
+  while ( !stopped && !Serial.hungUp() ) {
+    loop();
+    if ( !spin ) { Serial.waitForInput(IDLE_WAIT); }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+/*
+  pins_arduino.h - board profiles of the emulated Arduino core
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  The board is selected with the MCU macro the AVR toolchain would define,
+  so Boards.h picks the same pin map it uses on the real board:
+
+  -D__AVR_ATmega328P__   Arduino Uno (ARDUINO_PINOUT_OPTIMIZE port access)
+  -D__AVR_ATmega2560__   Arduino Mega 2560 (Serial1 - Serial3)
+
+  __AVR__ itself is not defined, because it selects avr-libc internals.
+*/
+
+#ifndef pins_arduino_h
+#define pins_arduino_h
+
+#include <stdint.h>
+
+#include "Emulator.h"
+
+#define NOT_AN_INTERRUPT        -1
+
+#if defined(__AVR_ATmega328P__)
+
+#define NUM_DIGITAL_PINS        20
+#define NUM_ANALOG_INPUTS       6
+#define NUM_SERIAL_PORTS        1
+#define LED_BUILTIN             13
+
+#define digitalPinHasPWM(p)     ((p) == 3 || (p) == 5 || (p) == 6 || (p) == 9 || (p) == 10 || (p) == 11)
+#define digitalPinToInterrupt(p)  ((p) == 2 ? 0 : ((p) == 3 ? 1 : NOT_AN_INTERRUPT))
+
+static const uint8_t SS   = 10;
+static const uint8_t MOSI = 11;
+static const uint8_t MISO = 12;
+static const uint8_t SCK  = 13;
+
+static const uint8_t SDA = 18;
+static const uint8_t SCL = 19;
+
+static const uint8_t A0 = 14;
+static const uint8_t A1 = 15;
+static const uint8_t A2 = 16;
+static const uint8_t A3 = 17;
+static const uint8_t A4 = 18;
+static const uint8_t A5 = 19;
+
+// port B: pins 8 - 13, port C: pins 14 - 19 (A0 - A5), port D: pins 0 - 7
+extern emulator::InputRegister PINB;
+extern emulator::InputRegister PINC;
+extern emulator::InputRegister PIND;
+extern emulator::OutputRegister PORTB;
+extern emulator::OutputRegister PORTC;
+extern emulator::OutputRegister PORTD;
+
+#elif defined(__AVR_ATmega2560__)
+
+#define NUM_DIGITAL_PINS        70
+#define NUM_ANALOG_INPUTS       16
+#define NUM_SERIAL_PORTS        4
+#define LED_BUILTIN             13
+
+#define digitalPinHasPWM(p)     (((p) >= 2 && (p) <= 13) || ((p) >= 44 && (p) <= 46))
+#define digitalPinToInterrupt(p)  ((p) == 2 ? 0 : ((p) == 3 ? 1 : ((p) >= 18 && (p) <= 21 ? 23 - (p) : NOT_AN_INTERRUPT)))
+
+static const uint8_t SS   = 53;
+static const uint8_t MOSI = 51;
+static const uint8_t MISO = 50;
+static const uint8_t SCK  = 52;
+
+static const uint8_t SDA = 20;
+static const uint8_t SCL = 21;
+
+static const uint8_t A0 = 54;
+static const uint8_t A1 = 55;
+static const uint8_t A2 = 56;
+static const uint8_t A3 = 57;
+static const uint8_t A4 = 58;
+static const uint8_t A5 = 59;
+static const uint8_t A6 = 60;
+static const uint8_t A7 = 61;
+static const uint8_t A8 = 62;
+static const uint8_t A9 = 63;
+static const uint8_t A10 = 64;
+static const uint8_t A11 = 65;
+static const uint8_t A12 = 66;
+static const uint8_t A13 = 67;
+static const uint8_t A14 = 68;
+static const uint8_t A15 = 69;
+
+#else
+#error "Select a board profile: -D__AVR_ATmega328P__ (Uno) or -D__AVR_ATmega2560__ (Mega)"
+#endif
+
+#endif /* pins_arduino_h */
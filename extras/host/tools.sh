@@ -0,0 +1,57 @@
+#!/bin/sh
+
+# Build and run a host tool. See readme.md.
+#
+# usage: extras/host/tools.sh analyze|loadgen|proxy [tool options...]
+#
+# analyze    message statistics of a capture or a raw byte stream
+#            (options: -o file, then the input file)
+# loadgen    simulate many boards on ptys or sockets
+#            (options: -n boards, -P profile, -p port, -u path, -r, -j, -B, -A, -d secs, -o file)
+# proxy      share one board between many clients
+#            (options: -u path, -p port, -a address, -b baud, -q bytes, then the device)
+#
+# The binaries go to extras/host/build. CXX and CXXFLAGS are honored.
+
+set -e
+
+HOST_DIR=$(cd "$(dirname "$0")" && pwd)
+ROOT_DIR=$(cd "$HOST_DIR/../.." && pwd)
+BUILD_DIR="$HOST_DIR/build"
+
+target=$1
+[ $# -gt 0 ] && shift
+
+mkdir -p "$BUILD_DIR"
+CXXFLAGS=${CXXFLAGS:--O2 -g -Wall}
+host_build() {
+  ${CXX:-g++} -std=c++11 $CXXFLAGS -I"$HOST_DIR/emulator" -I"$ROOT_DIR" -I"$HOST_DIR" "$@"
+}
+
+case $target in
+  analyze)
+    host_build "$HOST_DIR/tools/analyze.cpp" \
+      "$ROOT_DIR/FirmataParser.cpp" "$HOST_DIR/FirmataCapture.cpp" "$HOST_DIR/FirmataClockSync.cpp" \
+      "$HOST_DIR/FirmataLatencyHistogram.cpp" "$ROOT_DIR/FirmataMarshaller.cpp" "$HOST_DIR/emulator/Print.cpp" \
+      -o "$BUILD_DIR/analyze"
+    "$BUILD_DIR/analyze" "$@"
+    ;;
+  loadgen)
+    host_build "$HOST_DIR/tools/loadgen.cpp" \
+      "$ROOT_DIR/FirmataParser.cpp" "$ROOT_DIR/FirmataMarshaller.cpp" "$HOST_DIR/FirmataClockSync.cpp" \
+      "$HOST_DIR/emulator/Print.cpp" \
+      -o "$BUILD_DIR/loadgen"
+    "$BUILD_DIR/loadgen" "$@"
+    ;;
+  proxy)
+    host_build -pthread "$HOST_DIR/tools/proxy.cpp" \
+      "$HOST_DIR/FirmataEngine.cpp" "$HOST_DIR/FirmataClient.cpp" "$HOST_DIR/FirmataSysexDecoder.cpp" "$HOST_DIR/FirmataClockSync.cpp" \
+      "$ROOT_DIR/FirmataParser.cpp" "$ROOT_DIR/FirmataMarshaller.cpp" "$HOST_DIR/emulator/Print.cpp" \
+      -o "$BUILD_DIR/proxy"
+    "$BUILD_DIR/proxy" "$@"
+    ;;
+  *)
+    echo "unknown tool: $target (analyze, loadgen, proxy)"
+    exit 1
+    ;;
+esac
@@ -0,0 +1,436 @@
+/*
+  analyze.cpp - traffic statistics of a captured Firmata stream
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Reads a capture (see ../FirmataCapture.h) or a raw byte stream (any other
+  file) in one sequential pass and reports, per direction and message type:
+
+  messages, bytes and share of the bytes of the direction
+  inter-arrival times of the type (captures only, raw streams have no time)
+  redundant reports: ANALOG_MESSAGE and DIGITAL_MESSAGE values repeated on
+    the same pin or port, and the bytes they took
+  encoding efficiency: payload bits / wire bits. Command, START_SYSEX,
+    END_SYSEX and sysex command bytes are framing; a data byte carries 7
+    payload bits, except in STRING_DATA, I2C_REPLY and the firmware name of
+    REPORT_FIRMWARE, where 2 bytes carry one 8-bit byte
+
+  Bytes that belong to no complete message are counted as unparsed. Memory
+  use does not depend on the size of the input.
+
+  usage: analyze [-o file] capture
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include <getopt.h>
+
+#include "FirmataCapture.h"
+#include "FirmataConstants.h"
+#include "FirmataLatencyHistogram.h"
+#include "FirmataParser.h"
+
+using namespace firmata;
+
+namespace {
+
+//******************************************************************************
+//* Message Types
+//******************************************************************************
+
+// a type is the command byte (0x80 - 0xFF) or SYSEX_TYPE + the sysex command
+const size_t SYSEX_TYPE = 0x100;
+const size_t TYPES = SYSEX_TYPE + 0x80;
+const size_t RAW_CHUNK = 1 << 20;  // [bytes] read at a time from a raw stream
+
+const char * typeName(size_t type)
+{
+  switch (type) {
+    case ANALOG_MESSAGE: return "ANALOG_MESSAGE";
+    case DIGITAL_MESSAGE: return "DIGITAL_MESSAGE";
+    case REPORT_ANALOG: return "REPORT_ANALOG";
+    case REPORT_DIGITAL: return "REPORT_DIGITAL";
+    case SET_PIN_MODE: return "SET_PIN_MODE";
+    case SET_DIGITAL_PIN_VALUE: return "SET_DIGITAL_PIN_VALUE";
+    case REPORT_VERSION: return "REPORT_VERSION";
+    case SYSTEM_RESET: return "SYSTEM_RESET";
+    case SYSEX_TYPE + LOGIC_CAPTURE: return "LOGIC_CAPTURE";
+    case SYSEX_TYPE + TIMESTAMP_DATA: return "TIMESTAMP_DATA";
+    case SYSEX_TYPE + CLOCK_SYNC: return "CLOCK_SYNC";
+    case SYSEX_TYPE + ECHO_DATA: return "ECHO_DATA";
+    case SYSEX_TYPE + LOOP_TIMING: return "LOOP_TIMING";
+    case SYSEX_TYPE + LINK_STATS: return "LINK_STATS";
+    case SYSEX_TYPE + TRACE_DATA: return "TRACE_DATA";
+    case SYSEX_TYPE + MEMORY_STATS: return "MEMORY_STATS";
+    case SYSEX_TYPE + SERIAL_DATA: return "SERIAL_DATA";
+    case SYSEX_TYPE + ENCODER_DATA: return "ENCODER_DATA";
+    case SYSEX_TYPE + ANALOG_MAPPING_QUERY: return "ANALOG_MAPPING_QUERY";
+    case SYSEX_TYPE + ANALOG_MAPPING_RESPONSE: return "ANALOG_MAPPING_RESPONSE";
+    case SYSEX_TYPE + CAPABILITY_QUERY: return "CAPABILITY_QUERY";
+    case SYSEX_TYPE + CAPABILITY_RESPONSE: return "CAPABILITY_RESPONSE";
+    case SYSEX_TYPE + PIN_STATE_QUERY: return "PIN_STATE_QUERY";
+    case SYSEX_TYPE + PIN_STATE_RESPONSE: return "PIN_STATE_RESPONSE";
+    case SYSEX_TYPE + EXTENDED_ANALOG: return "EXTENDED_ANALOG";
+    case SYSEX_TYPE + SERVO_CONFIG: return "SERVO_CONFIG";
+    case SYSEX_TYPE + STRING_DATA: return "STRING_DATA";
+    case SYSEX_TYPE + STEPPER_DATA: return "STEPPER_DATA";
+    case SYSEX_TYPE + ONEWIRE_DATA: return "ONEWIRE_DATA";
+    case SYSEX_TYPE + SHIFT_DATA: return "SHIFT_DATA";
+    case SYSEX_TYPE + I2C_REQUEST: return "I2C_REQUEST";
+    case SYSEX_TYPE + I2C_REPLY: return "I2C_REPLY";
+    case SYSEX_TYPE + I2C_CONFIG: return "I2C_CONFIG";
+    case SYSEX_TYPE + REPORT_FIRMWARE: return "REPORT_FIRMWARE";
+    case SYSEX_TYPE + SAMPLING_INTERVAL: return "SAMPLING_INTERVAL";
+    case SYSEX_TYPE + SCHEDULER_DATA: return "SCHEDULER_DATA";
+    default: return NULL;
+  }
+}
+
+struct type_stats {
+  uint64_t messages;
+  uint64_t bytes;
+  uint64_t payloadBits;
+  uint64_t redundant;
+  uint64_t redundantBytes;
+  uint64_t lastTime;  // [us]
+  std::unique_ptr<FirmataLatencyHistogram> interArrival;  // [us], allocated with the first message
+};
+
+//******************************************************************************
+//* Direction Analyzer
+//******************************************************************************
+
+/**
+ * The statistics of one direction of the traffic, fed in order.
+ */
+class Analyzer
+{
+  public:
+    Analyzer(void)
+      : parser(buffer, sizeof(buffer)),
+        types(),
+        time(0),
+        received(0),
+        accounted(0),
+        unparsed(0)
+    {
+      for (size_t i = 0; i < 16; ++i) {
+        analogValues[i] = NO_VALUE;
+        digitalValues[i] = NO_VALUE;
+      }
+      parser.attach(ANALOG_MESSAGE, staticAnalogCallback, this);
+      parser.attach(DIGITAL_MESSAGE, staticDigitalCallback, this);
+      parser.attach(REPORT_ANALOG, staticReportAnalogCallback, this);
+      parser.attach(REPORT_DIGITAL, staticReportDigitalCallback, this);
+      parser.attach(SET_PIN_MODE, staticPinModeCallback, this);
+      parser.attach(SET_DIGITAL_PIN_VALUE, staticPinValueCallback, this);
+      parser.attach(REPORT_VERSION, staticVersionQueryCallback, this);
+      parser.attach(SYSTEM_RESET, staticResetCallback, this);
+      parser.attach(START_SYSEX, staticSysexCallback, this);
+      parser.attach(STRING_DATA, staticStringCallback, this);
+      parser.attach(REPORT_FIRMWARE, staticFirmwareCallback, this);
+    }
+
+    /**
+     * @param data The bytes.
+     * @param length The number of bytes.
+     * @param time_us The time the bytes were taken, 0 for a raw stream.
+     */
+    void feed(const uint8_t * data, size_t length, uint64_t time_us)
+    {
+      time = time_us;
+      for (size_t i = 0; i < length; ++i) {
+        ++received;
+        parser.parse(data[i]);
+      }
+    }
+
+    void writeJson(std::FILE * file, const char * indent, bool timed) const;
+
+  private:
+    static const uint32_t NO_VALUE = 0xFFFFFFFF;  // before the first report
+
+    /**
+     * Account one complete message, whose last byte the parser just took.
+     * @param wire The size of the message on the wire.
+     * @param payload_bits The information it carries.
+     * @param redundant true for a report of the value the previous report already had.
+     */
+    void account(size_t type, size_t wire, uint64_t payload_bits, bool redundant)
+    {
+      type_stats & s = types[type];
+      const uint64_t gap = received - accounted;
+      if ( gap > wire ) { unparsed += gap - wire; }
+      accounted = received;
+
+      if ( !s.interArrival ) {
+        s.interArrival.reset(new FirmataLatencyHistogram());
+      } else {
+        const uint64_t delta = time - s.lastTime;
+        s.interArrival->record((delta > UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(delta));
+      }
+      s.lastTime = time;
+      ++s.messages;
+      s.bytes += wire;
+      s.payloadBits += payload_bits;
+      if ( redundant ) {
+        ++s.redundant;
+        s.redundantBytes += wire;
+      }
+    }
+
+    bool report(uint32_t * values, uint8_t channel, uint16_t value)
+    {
+      uint32_t & last = values[channel & 0x0F];
+      const bool redundant = (last == value);
+      last = value;
+      return redundant;
+    }
+
+    static void staticAnalogCallback(void * context, uint8_t pin, uint16_t value)
+    {
+      Analyzer * a = static_cast<Analyzer *>(context);
+      a->account(ANALOG_MESSAGE, 3, 14, a->report(a->analogValues, pin, value));
+    }
+
+    static void staticDigitalCallback(void * context, uint8_t port, uint16_t value)
+    {
+      Analyzer * a = static_cast<Analyzer *>(context);
+      a->account(DIGITAL_MESSAGE, 3, 14, a->report(a->digitalValues, port, value));
+    }
+
+    static void staticReportAnalogCallback(void * context, uint8_t, uint16_t)
+    {
+      static_cast<Analyzer *>(context)->account(REPORT_ANALOG, 2, 7, false);
+    }
+
+    static void staticReportDigitalCallback(void * context, uint8_t, uint16_t)
+    {
+      static_cast<Analyzer *>(context)->account(REPORT_DIGITAL, 2, 7, false);
+    }
+
+    static void staticPinModeCallback(void * context, uint8_t, uint16_t)
+    {
+      static_cast<Analyzer *>(context)->account(SET_PIN_MODE, 3, 14, false);
+    }
+
+    static void staticPinValueCallback(void * context, uint8_t, uint16_t)
+    {
+      static_cast<Analyzer *>(context)->account(SET_DIGITAL_PIN_VALUE, 3, 14, false);
+    }
+
+    static void staticVersionQueryCallback(void * context)
+    {
+      static_cast<Analyzer *>(context)->account(REPORT_VERSION, 1, 0, false);
+    }
+
+    static void staticResetCallback(void * context)
+    {
+      static_cast<Analyzer *>(context)->account(SYSTEM_RESET, 1, 0, false);
+    }
+
+    static void staticSysexCallback(void * context, uint8_t command, size_t argc, uint8_t *)
+    {
+      // the data bytes of an I2C_REPLY are 8-bit values sent as two 7-bit bytes
+      const uint64_t bits = ((command == I2C_REPLY) ? (argc / 2) * 8 : argc * 7);
+      static_cast<Analyzer *>(context)->account(SYSEX_TYPE + (command & 0x7F), argc + 3, bits, false);
+    }
+
+    static void staticStringCallback(void * context, const char * c_str)
+    {
+      const size_t length = std::strlen(c_str);
+      static_cast<Analyzer *>(context)->account(SYSEX_TYPE + STRING_DATA, 2 * length + 3, length * 8, false);
+    }
+
+    static void staticFirmwareCallback(void * context, size_t, size_t, const char * firmware)
+    {
+      // a query has no data, a report has the version and the name
+      const size_t length = (firmware ? std::strlen(firmware) : 0);
+      const size_t wire = (firmware ? 2 * length + 5 : 3);
+      static_cast<Analyzer *>(context)->account(SYSEX_TYPE + REPORT_FIRMWARE, wire, (firmware ? 14 + length * 8 : 0), false);
+    }
+
+    uint8_t buffer[4096];
+    FirmataParser parser;
+    type_stats types[TYPES];
+    uint32_t analogValues[16];
+    uint32_t digitalValues[16];
+    uint64_t time;      // [us] of the bytes being parsed
+    uint64_t received;  // bytes fed, 64 bits for captures beyond 4 GB
+    uint64_t accounted; // bytes up to the end of the last complete message
+    uint64_t unparsed;
+};
+
+void writeHistogram(std::FILE * file, const FirmataLatencyHistogram & h)
+{
+  std::fprintf(file, "{ \"count\": %llu, \"min\": %u, \"mean\": %.1f, \"p50\": %u, \"p90\": %u, \"p99\": %u, \"max\": %u }",
+    static_cast<unsigned long long>(h.count()), h.min(), h.mean(), h.percentile(50.0), h.percentile(90.0),
+    h.percentile(99.0), h.max());
+}
+
+/**
+ * Write the statistics as a JSON object.
+ * @param timed false for a raw stream, which has no inter-arrival times.
+ */
+void Analyzer::writeJson(std::FILE * file, const char * indent, bool timed) const
+{
+  uint64_t messages = 0;
+  uint64_t redundantBytes = 0;
+  for (size_t t = 0; t < TYPES; ++t) {
+    messages += types[t].messages;
+    redundantBytes += types[t].redundantBytes;
+  }
+  const double total = (received ? static_cast<double>(received) : 1.0);
+
+  std::fprintf(file, "{\n");
+  std::fprintf(file, "%s  \"bytes\": %llu,\n", indent, static_cast<unsigned long long>(received));
+  std::fprintf(file, "%s  \"messages\": %llu,\n", indent, static_cast<unsigned long long>(messages));
+  std::fprintf(file, "%s  \"unparsed_bytes\": %llu,\n", indent, static_cast<unsigned long long>(unparsed + (received - accounted)));
+  std::fprintf(file, "%s  \"redundant_byte_share\": %.4f,\n", indent, redundantBytes / total);
+  std::fprintf(file, "%s  \"types\": [", indent);
+  bool first = true;
+  for (size_t t = 0; t < TYPES; ++t) {
+    const type_stats & s = types[t];
+    if ( !s.messages ) { continue; }
+    char unknown[16];
+    const char * name = typeName(t);
+    if ( !name ) {
+      std::snprintf(unknown, sizeof(unknown), "%s_0x%02zx", ((t >= SYSEX_TYPE) ? "SYSEX" : "COMMAND"), t & 0xFF);
+      name = unknown;
+    }
+    std::fprintf(file, "%s\n%s    {\n", (first ? "" : ","), indent);
+    std::fprintf(file, "%s      \"name\": \"%s\",\n", indent, name);
+    std::fprintf(file, "%s      \"messages\": %llu,\n", indent, static_cast<unsigned long long>(s.messages));
+    std::fprintf(file, "%s      \"bytes\": %llu,\n", indent, static_cast<unsigned long long>(s.bytes));
+    std::fprintf(file, "%s      \"byte_share\": %.4f,\n", indent, s.bytes / total);
+    std::fprintf(file, "%s      \"payload_efficiency\": %.4f,\n", indent, s.payloadBits / (8.0 * s.bytes));
+    std::fprintf(file, "%s      \"redundant\": %llu,\n", indent, static_cast<unsigned long long>(s.redundant));
+    std::fprintf(file, "%s      \"redundant_bytes\": %llu", indent, static_cast<unsigned long long>(s.redundantBytes));
+    if ( timed && s.interArrival ) {
+      std::fprintf(file, ",\n%s      \"inter_arrival_us\": ", indent);
+      writeHistogram(file, *s.interArrival);
+    }
+    std::fprintf(file, "\n%s    }", indent);
+    first = false;
+  }
+  std::fprintf(file, "\n%s  ]\n%s}", indent, indent);
+}
+
+//******************************************************************************
+//* Input
+//******************************************************************************
+
+/**
+ * Analyze a capture, both directions.
+ */
+void analyzeCapture(FirmataCaptureReplayer & replayer, Analyzer * analyzers)
+{
+  capture_record record;
+  while ( replayer.next(record) ) {
+    analyzers[record.direction].feed(record.data, record.length, record.time);
+  }
+}
+
+/**
+ * Analyze a file without timestamps in chunks.
+ * @return false on a read error.
+ */
+bool analyzeRaw(const char * path, Analyzer & analyzer)
+{
+  std::FILE * file = std::fopen(path, "rb");
+  if ( !file ) { return false; }
+  std::unique_ptr<uint8_t[]> chunk(new uint8_t[RAW_CHUNK]);
+  size_t n;
+  while ( (n = std::fread(chunk.get(), 1, RAW_CHUNK, file)) > 0 ) {
+    analyzer.feed(chunk.get(), n, 0);
+  }
+  const bool ok = !std::ferror(file);
+  std::fclose(file);
+  return ok;
+}
+
+void usage(const char * program)
+{
+  std::fprintf(stderr,
+    "usage: %s [-o file] capture\n"
+    "  -o, --output FILE  JSON results (default stdout)\n"
+    "  capture is a FirmataCaptureWriter file or a raw byte stream of one direction\n",
+    program);
+}
+
+} // namespace
+
+//******************************************************************************
+//* Main
+//******************************************************************************
+
+int main(int argc, char * argv[])
+{
+  static const struct option options[] = {
+    { "output", required_argument, NULL, 'o' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+  const char * output = NULL;
+  int option;
+
+  while ( (option = ::getopt_long(argc, argv, "o:h", options, NULL)) != -1 ) {
+    switch (option) {
+      case 'o':
+        output = optarg;
+        break;
+      default:
+        usage(argv[0]);
+        return ((option == 'h') ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+  }
+  if ( optind != argc - 1 ) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  const char * path = argv[optind];
+
+  // the analyzers hold a histogram per message type seen, keep them off the stack
+  std::unique_ptr<Analyzer[]> analyzers(new Analyzer[2]);
+  FirmataCaptureReplayer replayer;
+  const bool capture = replayer.open(path);
+  if ( capture ) {
+    analyzeCapture(replayer, analyzers.get());
+  } else if ( !analyzeRaw(path, analyzers[0]) ) {
+    std::perror(path);
+    return EXIT_FAILURE;
+  }
+
+  std::FILE * file = (output ? std::fopen(output, "w") : stdout);
+  if ( !file ) {
+    std::perror(output);
+    return EXIT_FAILURE;
+  }
+  std::fprintf(file, "{\n  \"tool\": \"analyze\",\n  \"input\": \"%s\",\n", path);
+  if ( capture ) {
+    std::fprintf(file, "  \"format\": \"capture\",\n  \"truncated\": %s,\n", (replayer.truncated() ? "true" : "false"));
+    std::fprintf(file, "  \"to_board\": ");
+    analyzers[CAPTURE_TO_BOARD].writeJson(file, "  ", true);
+    std::fprintf(file, ",\n  \"from_board\": ");
+    analyzers[CAPTURE_FROM_BOARD].writeJson(file, "  ", true);
+  } else {
+    std::fprintf(file, "  \"format\": \"raw\",\n  \"stream\": ");
+    analyzers[0].writeJson(file, "  ", false);
+  }
+  std::fprintf(file, "\n}\n");
+  if ( output ) { std::fclose(file); }
+  return EXIT_SUCCESS;
+}
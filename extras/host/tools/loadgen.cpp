@@ -0,0 +1,1217 @@
+/*
+  loadgen.cpp - simulates many Firmata boards to load a host or gateway
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Each simulated board behaves like StandardFirmataPlus on the wire, with
+  the messages written by FirmataMarshaller:
+
+  - it announces its protocol version and firmware when it starts, and
+    answers the version, firmware, capability, analog mapping and pin state
+    queries (the pins of an Uno, or of a Mega if the profile needs more than
+    6 analog channels or 12 digital inputs)
+  - REPORT_ANALOG, REPORT_DIGITAL, SAMPLING_INTERVAL, I2C_REQUEST (read once,
+    read continuously, stop) and SERIAL_READ start and stop its reports as
+    they would on a board; with --autostart all the reports of the profile
+    run from the start
+  - the reports follow a profile: analog channels and their rate, toggling
+    digital inputs, continuous I2C reads and bursts of serial bridge data
+
+  A profile is a built-in name or a file of "key = value" lines with the
+  keys analog_channels, analog_hz, digital_pins, toggle_hz, i2c_devices,
+  i2c_bytes, i2c_hz, serial_burst and serial_hz ("#" starts a comment).
+
+  Every stream of reports is a timer. --jitter moves each firing by up to a
+  share of its period, --burst fires every N periods and sends N rounds at
+  once, so the average rate stays that of the profile. A board whose send
+  queue is full loses the reports until its reader catches up; the dropped
+  messages are counted.
+
+  The boards are ptys (one per board, the names are printed, --link adds
+  symlinks), the connections accepted on a TCP port or a Unix socket (one
+  board per connection), or one board on an inherited descriptor (--fd, as
+  passed by proxy's exec:; loadgen exits when the other end closes it).
+  Statistics are written as JSON at the end.
+
+  usage: loadgen [options]
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "FirmataClockSync.h"
+#include "FirmataConstants.h"
+#include "FirmataMarshaller.h"
+#include "FirmataParser.h"
+
+using namespace firmata;
+
+namespace {
+
+// defined by StandardFirmataPlus and SerialFirmata, which only compile for a board
+const uint8_t I2C_MODE_MASK = 0x18;
+const uint8_t I2C_READ = 0x08;
+const uint8_t I2C_READ_CONTINUOUSLY = 0x10;
+const uint8_t I2C_STOP_READING = 0x18;
+const size_t I2C_MAX_QUERIES = 8;
+const uint8_t SERIAL_READ = 0x30;
+const uint8_t SERIAL_REPLY = 0x40;
+const size_t SERIAL_REPLY_BYTES = 32;       // data bytes per SERIAL_REPLY
+const uint16_t DEFAULT_SAMPLING_INTERVAL = 19;  // [ms] as StandardFirmataPlus
+const size_t MAX_EVENTS = 64;
+const uint64_t MAX_LATENESS = 1000000;      // [us] a timer further behind restarts from now
+const uint64_t NO_BOARD = 0xFFFFFFFF00000000ULL;
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onSignal(int)
+{
+  stopRequested = 1;
+}
+
+bool setNonBlocking(int fd)
+{
+  const int flags = ::fcntl(fd, F_GETFL);
+  return (flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0);
+}
+
+// a deterministic pseudo random sequence per board, so runs are repeatable
+uint32_t nextRandom(uint32_t & state)
+{
+  state ^= (state << 13);
+  state ^= (state >> 17);
+  state ^= (state << 5);
+  return state;
+}
+
+/**
+ * @return A uniform value in [-1, 1).
+ */
+double symmetricRandom(uint32_t & state)
+{
+  return (nextRandom(state) / 2147483648.0) - 1.0;
+}
+
+//******************************************************************************
+//* Profiles
+//******************************************************************************
+
+struct profile {
+  std::string name;
+  unsigned analogChannels;      // reported analog channels
+  double analogHz;              // reports per second and channel; SAMPLING_INTERVAL overrides it
+  unsigned digitalPins;         // toggling digital inputs, from pin 2 up
+  double toggleHz;              // toggles per second and pin
+  unsigned i2cDevices;          // devices read continuously, from address 0x40 up
+  unsigned i2cBytes;            // bytes per read
+  double i2cHz;                 // reads per second and device; SAMPLING_INTERVAL overrides it
+  unsigned serialBurst;         // bytes per burst on HW_SERIAL1
+  double serialHz;              // bursts per second
+};
+
+const profile builtinProfiles[] = {
+  // name        analog      digital    i2c            serial
+  { "idle",      0, 0,       0, 0,      0, 0, 0,       0, 0 },
+  { "sensor",    6, 50,      2, 1,      0, 0, 0,       0, 0 },
+  { "logger",   16, 1000,    0, 0,      0, 0, 0,       0, 0 },
+  { "i2c",       0, 0,       0, 0,      2, 6, 100,     0, 0 },
+  { "bridge",    0, 0,       0, 0,      0, 0, 0,       64, 20 },
+  { "mixed",     8, 100,     8, 5,      1, 6, 50,      32, 10 },
+};
+
+/**
+ * Read a profile file over the defaults of the idle profile.
+ * @return false if the file cannot be read or has an unknown key.
+ */
+bool loadProfile(const char * path, profile & p)
+{
+  std::FILE * file = std::fopen(path, "r");
+  if ( !file ) { return false; }
+  p = builtinProfiles[0];
+  p.name = path;
+  char line[256];
+  bool ok = true;
+  while ( ok && std::fgets(line, sizeof(line), file) ) {
+    char * hash = std::strchr(line, '#');
+    if ( hash ) { *hash = '\0'; }
+    char key[64];
+    double value;
+    if ( std::sscanf(line, " %63[a-z_] = %lf", key, &value) != 2 ) {
+      // blank lines and comments
+      char rest[2];
+      ok = (std::sscanf(line, " %1s", rest) != 1);
+      continue;
+    }
+    const std::string k(key);
+    if ( k == "analog_channels" ) { p.analogChannels = static_cast<unsigned>(value); }
+    else if ( k == "analog_hz" ) { p.analogHz = value; }
+    else if ( k == "digital_pins" ) { p.digitalPins = static_cast<unsigned>(value); }
+    else if ( k == "toggle_hz" ) { p.toggleHz = value; }
+    else if ( k == "i2c_devices" ) { p.i2cDevices = static_cast<unsigned>(value); }
+    else if ( k == "i2c_bytes" ) { p.i2cBytes = static_cast<unsigned>(value); }
+    else if ( k == "i2c_hz" ) { p.i2cHz = value; }
+    else if ( k == "serial_burst" ) { p.serialBurst = static_cast<unsigned>(value); }
+    else if ( k == "serial_hz" ) { p.serialHz = value; }
+    else { ok = false; }
+  }
+  std::fclose(file);
+  return ok;
+}
+
+bool findProfile(const char * name, profile & p)
+{
+  for (size_t i = 0; i < sizeof(builtinProfiles) / sizeof(builtinProfiles[0]); ++i) {
+    if ( builtinProfiles[i].name == name ) {
+      p = builtinProfiles[i];
+      return true;
+    }
+  }
+  return loadProfile(name, p);
+}
+
+/**
+ * The pins of the simulated board.
+ */
+struct board_layout {
+  uint8_t pinCount;
+  uint8_t firstAnalogPin;
+  uint8_t analogCount;
+  uint8_t sdaPin;
+  bool (*isPwm)(uint8_t pin);
+};
+
+bool unoPwm(uint8_t pin) { return (pin == 3 || pin == 5 || pin == 6 || pin == 9 || pin == 10 || pin == 11); }
+bool megaPwm(uint8_t pin) { return ((pin >= 2 && pin <= 13) || (pin >= 44 && pin <= 46)); }
+
+const board_layout UNO = { 20, 14, 6, 18, unoPwm };
+const board_layout MEGA = { 70, 54, 16, 20, megaPwm };
+
+//******************************************************************************
+//* Board
+//******************************************************************************
+
+/**
+ * A queue of bytes to send. Appends go to the end, writes take from the front; the space is
+ * reused once the queue drains, so a steady board stops allocating.
+ */
+class SendQueue : public Stream
+{
+  public:
+    SendQueue(void) : head(0) {}
+
+    int available(void) { return 0; }
+    int read(void) { return -1; }
+    int peek(void) { return -1; }
+    size_t write(uint8_t c) { bytes.push_back(c); return 1; }
+    size_t write(const uint8_t * data, size_t length) { bytes.insert(bytes.end(), data, data + length); return length; }
+    using Print::write;
+
+    size_t size(void) const { return bytes.size() - head; }
+
+    /**
+     * @return The bytes written, -1 on an error other than a full descriptor.
+     */
+    ssize_t send(int fd)
+    {
+      size_t sent = 0;
+      while ( size() ) {
+        const ssize_t n = ::write(fd, bytes.data() + head, size());
+        if ( n > 0 ) {
+          head += n;
+          sent += n;
+        } else if ( n < 0 && errno == EINTR ) {
+          continue;
+        } else if ( n < 0 && errno == EAGAIN ) {
+          break;
+        } else {
+          return -1;
+        }
+      }
+      if ( head == bytes.size() ) {
+        bytes.clear();
+        head = 0;
+      }
+      return static_cast<ssize_t>(sent);
+    }
+
+  private:
+    std::vector<uint8_t> bytes;
+    size_t head;
+};
+
+enum message_type {
+  MESSAGE_HANDSHAKE,            // version, firmware and the answers to queries
+  MESSAGE_ANALOG,
+  MESSAGE_DIGITAL,
+  MESSAGE_I2C,
+  MESSAGE_SERIAL,
+  MESSAGE_TYPES
+};
+
+const char * const messageNames[MESSAGE_TYPES] = { "handshake", "analog", "digital", "i2c", "serial" };
+
+enum timer_id {
+  TIMER_ANALOG,
+  TIMER_DIGITAL,
+  TIMER_I2C,
+  TIMER_SERIAL,
+  TIMERS
+};
+
+struct statistics {
+  uint64_t messages[MESSAGE_TYPES];
+  uint64_t dropped[MESSAGE_TYPES];
+  uint64_t bytesSent;
+  uint64_t bytesReceived;
+  uint64_t lateTimers;
+  uint64_t boardsOpened;
+  uint64_t boardsClosed;
+};
+
+struct timing {
+  double rateScale;
+  double jitter;                // share of a period
+  unsigned burst;               // periods per firing
+  bool autostart;
+  size_t queueLimit;            // [bytes]
+};
+
+/**
+ * One simulated board: a parser for the commands of the host and a marshaller into its send
+ * queue.
+ */
+class Board
+{
+  public:
+    Board(int fd, uint32_t slot, uint32_t generation, uint32_t seed, const profile &p, const timing &t, statistics &stats, std::vector<Board *> &dirty_list)
+    :
+      fd(fd),
+      slot(slot),
+      generation(generation),
+      dirty(false),
+      dirtyList(dirty_list),
+      prof(p),
+      time(t),
+      stats(stats),
+      layout((p.analogChannels > 6 || p.digitalPins > 12) ? MEGA : UNO),
+      parser(parserBuffer, sizeof(parserBuffer)),
+      random(seed ? seed : 1),
+      i2cCounter(0)
+    {
+      marshaller.begin(queue);
+      parser.attach(REPORT_VERSION, staticVersionQueryCallback, this);
+      parser.attach(REPORT_FIRMWARE, staticFirmwareQueryCallback, this);
+      parser.attach(SYSTEM_RESET, staticResetCallback, this);
+      parser.attach(REPORT_ANALOG, staticReportAnalogCallback, this);
+      parser.attach(REPORT_DIGITAL, staticReportDigitalCallback, this);
+      parser.attach(SET_PIN_MODE, staticPinModeCallback, this);
+      parser.attach(START_SYSEX, staticSysexCallback, this);
+      reset();
+      if ( time.autostart ) { startProfile(); }
+      // StandardFirmataPlus announces itself from setup()
+      sendVersion();
+      sendFirmware();
+    }
+
+    void parse(const uint8_t * data, size_t length)
+    {
+      for (size_t i = 0; i < length; ++i) { parser.parse(data[i]); }
+    }
+
+    /**
+     * @return The period of a timer [us], 0 if the profile has no such reports.
+     */
+    uint64_t period(timer_id timer) const
+    {
+      double hz = 0;
+      switch (timer) {
+        case TIMER_ANALOG: hz = (prof.analogChannels ? analogHz : 0); break;
+        case TIMER_DIGITAL: hz = prof.digitalPins * prof.toggleHz; break;
+        case TIMER_I2C: hz = i2cHz; break;
+        case TIMER_SERIAL: hz = (prof.serialBurst ? prof.serialHz : 0); break;
+        default: break;
+      }
+      hz *= time.rateScale;
+      return ((hz > 0) ? static_cast<uint64_t>(1e6 / hz) : 0);
+    }
+
+    /**
+     * @return The time of the next firing after one due at due.
+     */
+    uint64_t next(timer_id timer, uint64_t due)
+    {
+      const double step = static_cast<double>(period(timer)) * time.burst;
+      const double offset = step * time.jitter * symmetricRandom(random);
+      return due + static_cast<uint64_t>(std::max(1.0, step + offset));
+    }
+
+    void fire(timer_id timer, uint64_t due)
+    {
+      for (unsigned round = 0; round < time.burst; ++round) {
+        const uint64_t at = due + round * period(timer);
+        switch (timer) {
+          case TIMER_ANALOG: fireAnalog(at); break;
+          case TIMER_DIGITAL: fireDigital(); break;
+          case TIMER_I2C: fireI2C(); break;
+          case TIMER_SERIAL: fireSerial(at); break;
+          default: break;
+        }
+      }
+    }
+
+    const int fd;
+    const uint32_t slot;
+    const uint32_t generation;
+    SendQueue queue;
+    bool dirty;                 // in the list of boards to flush
+    std::vector<Board *> &dirtyList;
+
+  private:
+    bool room(message_type type)
+    {
+      if ( queue.size() < time.queueLimit ) {
+        ++stats.messages[type];
+        markDirty();
+        return true;
+      }
+      ++stats.dropped[type];
+      return false;
+    }
+
+    void markDirty(void);
+
+    void reset(void)
+    {
+      analogEnabled = 0;
+      portsEnabled = 0;
+      serialReading = 0;
+      continuousCount = 0;
+      analogHz = prof.analogHz;
+      i2cHz = prof.i2cHz;
+      std::memset(levels, 0, sizeof(levels));
+      for (uint8_t pin = 0; pin < layout.pinCount; ++pin) {
+        modes[pin] = ((pin >= layout.firstAnalogPin) ? PIN_MODE_ANALOG : PIN_MODE_OUTPUT);
+      }
+    }
+
+    void startProfile(void)
+    {
+      for (unsigned channel = 0; channel < prof.analogChannels && channel < layout.analogCount; ++channel) {
+        analogEnabled |= static_cast<uint16_t>(1 << channel);
+      }
+      for (unsigned i = 0; i < prof.digitalPins; ++i) {
+        const uint8_t pin = toggledPin(i);
+        modes[pin] = PIN_MODE_INPUT;
+        portsEnabled |= static_cast<uint16_t>(1 << (pin / 8));
+      }
+      for (unsigned device = 0; device < prof.i2cDevices && continuousCount < I2C_MAX_QUERIES; ++device) {
+        i2c_query &query = continuous[continuousCount++];
+        query.address = static_cast<uint8_t>(0x40 + device);
+        query.reg = 0;
+        query.length = static_cast<uint8_t>(std::min(prof.i2cBytes, 32u));
+      }
+      if ( prof.serialBurst ) { serialReading |= (1 << 1); }
+    }
+
+    /**
+     * The digital pins the profile toggles: from pin 2 up, skipping the I2C and analog pins.
+     */
+    uint8_t toggledPin(unsigned i) const
+    {
+      uint8_t pin = 2;
+      for (unsigned k = 0; ; ++pin) {
+        if ( pin == layout.sdaPin || pin == layout.sdaPin + 1 ) { continue; }
+        if ( pin >= layout.firstAnalogPin ) { return static_cast<uint8_t>(layout.firstAnalogPin - 1); }
+        if ( k++ == i ) { return pin; }
+      }
+    }
+
+    uint8_t portValue(uint8_t port) const
+    {
+      uint8_t value = 0;
+      for (uint8_t bit = 0; bit < 8; ++bit) {
+        const uint8_t pin = static_cast<uint8_t>(port * 8 + bit);
+        if ( pin < layout.pinCount && levels[pin] ) { value |= static_cast<uint8_t>(1 << bit); }
+      }
+      return value;
+    }
+
+    void fireAnalog(uint64_t at)
+    {
+      const double seconds = at / 1e6;
+      for (uint8_t channel = 0; channel < layout.analogCount; ++channel) {
+        if ( !(analogEnabled & (1 << channel)) || !room(MESSAGE_ANALOG) ) { continue; }
+        // a slow sine per channel with a little noise, like a sensor
+        const double wave = std::sin(2 * M_PI * (0.2 + 0.05 * channel) * seconds + channel);
+        const int value = static_cast<int>(512 + 400 * wave + 8 * symmetricRandom(random));
+        marshaller.sendAnalog(channel, static_cast<uint16_t>(std::min(1023, std::max(0, value))));
+      }
+    }
+
+    void fireDigital(void)
+    {
+      if ( !prof.digitalPins ) { return; }
+      const uint8_t pin = toggledPin(nextRandom(random) % prof.digitalPins);
+      levels[pin] ^= 1;
+      const uint8_t port = pin / 8;
+      if ( (portsEnabled & (1 << port)) && room(MESSAGE_DIGITAL) ) {
+        marshaller.sendDigitalPort(port, portValue(port));
+      }
+    }
+
+    void fireI2C(void)
+    {
+      for (size_t q = 0; q < continuousCount; ++q) {
+        if ( room(MESSAGE_I2C) ) { sendI2CReply(continuous[q]); }
+      }
+    }
+
+    void fireSerial(uint64_t at)
+    {
+      for (uint8_t port = 0; port < 12; ++port) {
+        if ( !(serialReading & (1 << port)) ) { continue; }
+        // lines of text as a GPS or a sensor module would send
+        char text[64];
+        std::string burst;
+        while ( burst.size() < prof.serialBurst ) {
+          std::snprintf(text, sizeof(text), "$T,%llu,%u\r\n", static_cast<unsigned long long>(at), nextRandom(random) % 1000);
+          burst += text;
+        }
+        burst.resize(prof.serialBurst);
+        for (size_t offset = 0; offset < burst.size(); offset += SERIAL_REPLY_BYTES) {
+          if ( !room(MESSAGE_SERIAL) ) { continue; }
+          const size_t n = std::min(SERIAL_REPLY_BYTES, burst.size() - offset);
+          // the subcommand byte is not split into 7-bit pairs, so not FirmataMarshaller::sendSysex()
+          uint8_t message[4 + 2 * SERIAL_REPLY_BYTES];
+          size_t length = 0;
+          message[length++] = START_SYSEX;
+          message[length++] = SERIAL_DATA;
+          message[length++] = static_cast<uint8_t>(SERIAL_REPLY | port);
+          for (size_t i = 0; i < n; ++i) {
+            const uint8_t c = static_cast<uint8_t>(burst[offset + i]);
+            message[length++] = c & 0x7F;
+            message[length++] = c >> 7;
+          }
+          queue.write(message, length);
+          queue.write(END_SYSEX);
+        }
+      }
+    }
+
+    struct i2c_query {
+      uint8_t address;
+      uint8_t reg;
+      uint8_t length;
+    };
+
+    void sendI2CReply(const i2c_query &query)
+    {
+      uint8_t reply[2 + 32];
+      reply[0] = query.address;
+      reply[1] = query.reg;
+      // a counter in the first byte, noise in the others
+      reply[2] = static_cast<uint8_t>(++i2cCounter);
+      for (size_t i = 1; i < query.length; ++i) {
+        reply[2 + i] = static_cast<uint8_t>(nextRandom(random));
+      }
+      marshaller.sendSysex(I2C_REPLY, 2 + query.length, reply);
+    }
+
+    void sendVersion(void)
+    {
+      if ( room(MESSAGE_HANDSHAKE) ) { marshaller.sendVersion(PROTOCOL_MAJOR_VERSION, PROTOCOL_MINOR_VERSION); }
+    }
+
+    void sendFirmware(void)
+    {
+      static const char name[] = "StandardFirmataPlus.ino";
+      if ( room(MESSAGE_HANDSHAKE) ) {
+        marshaller.sendFirmwareVersion(FIRMWARE_MAJOR_VERSION, FIRMWARE_MINOR_VERSION, sizeof(name) - 1,
+          reinterpret_cast<uint8_t *>(const_cast<char *>(name)));
+      }
+    }
+
+    void sendCapabilities(void)
+    {
+      if ( !room(MESSAGE_HANDSHAKE) ) { return; }
+      queue.write(START_SYSEX);
+      queue.write(CAPABILITY_RESPONSE);
+      for (uint8_t pin = 0; pin < layout.pinCount; ++pin) {
+        if ( pin >= 2 ) {
+          const uint8_t digital[] = { PIN_MODE_INPUT, 1, PIN_MODE_PULLUP, 1, PIN_MODE_OUTPUT, 1, PIN_MODE_SERVO, 14 };
+          queue.write(digital, sizeof(digital));
+        }
+        if ( layout.isPwm(pin) ) {
+          queue.write(PIN_MODE_PWM);
+          queue.write(8);
+        }
+        if ( pin >= layout.firstAnalogPin ) {
+          queue.write(PIN_MODE_ANALOG);
+          queue.write(10);
+        }
+        if ( pin == layout.sdaPin || pin == layout.sdaPin + 1 ) {
+          queue.write(PIN_MODE_I2C);
+          queue.write(1);
+        }
+        queue.write(0x7F);
+      }
+      queue.write(END_SYSEX);
+    }
+
+    void sendAnalogMapping(void)
+    {
+      if ( !room(MESSAGE_HANDSHAKE) ) { return; }
+      queue.write(START_SYSEX);
+      queue.write(ANALOG_MAPPING_RESPONSE);
+      for (uint8_t pin = 0; pin < layout.pinCount; ++pin) {
+        queue.write((pin >= layout.firstAnalogPin) ? static_cast<uint8_t>(pin - layout.firstAnalogPin) : 0x7F);
+      }
+      queue.write(END_SYSEX);
+    }
+
+    void sendPinState(uint8_t pin)
+    {
+      if ( pin >= layout.pinCount || !room(MESSAGE_HANDSHAKE) ) { return; }
+      const uint8_t message[] = { START_SYSEX, PIN_STATE_RESPONSE, pin, modes[pin], levels[pin], END_SYSEX };
+      queue.write(message, sizeof(message));
+    }
+
+    void handleI2CRequest(size_t argc, const uint8_t * argv)
+    {
+      if ( argc < 2 ) { return; }
+      i2c_query query;
+      query.address = argv[0];
+      const uint8_t mode = argv[1] & I2C_MODE_MASK;
+      if ( mode == I2C_STOP_READING ) {
+        size_t kept = 0;
+        for (size_t q = 0; q < continuousCount; ++q) {
+          if ( continuous[q].address != query.address ) { continuous[kept++] = continuous[q]; }
+        }
+        continuousCount = kept;
+        return;
+      }
+      if ( mode != I2C_READ && mode != I2C_READ_CONTINUOUSLY ) { return; }
+      // the register, if any, and the number of bytes, each as two 7-bit bytes
+      query.reg = ((argc == 6) ? static_cast<uint8_t>(argv[2] | (argv[3] << 7)) : 0);
+      const size_t length = ((argc == 6) ? (argv[4] | (argv[5] << 7)) : ((argc >= 4) ? (argv[2] | (argv[3] << 7)) : 0));
+      query.length = static_cast<uint8_t>(std::min<size_t>(length, 32));
+      if ( mode == I2C_READ ) {
+        if ( room(MESSAGE_I2C) ) { sendI2CReply(query); }
+      } else if ( continuousCount < I2C_MAX_QUERIES ) {
+        continuous[continuousCount++] = query;
+      }
+    }
+
+    void handleSysex(uint8_t command, size_t argc, const uint8_t * argv)
+    {
+      switch (command) {
+        case CAPABILITY_QUERY:
+          sendCapabilities();
+          break;
+        case ANALOG_MAPPING_QUERY:
+          sendAnalogMapping();
+          break;
+        case PIN_STATE_QUERY:
+          if ( argc >= 1 ) { sendPinState(argv[0]); }
+          break;
+        case SAMPLING_INTERVAL:
+          if ( argc >= 2 ) {
+            // StandardFirmataPlus samples analog inputs and continuous I2C reads at this interval
+            const unsigned interval = std::max(1u, static_cast<unsigned>(argv[0] | (argv[1] << 7)));
+            analogHz = 1000.0 / interval;
+            i2cHz = 1000.0 / interval;
+          }
+          break;
+        case I2C_REQUEST:
+          handleI2CRequest(argc, argv);
+          break;
+        case SERIAL_DATA:
+          if ( argc >= 2 && (argv[0] & 0xF0) == SERIAL_READ ) {
+            const uint16_t port = static_cast<uint16_t>(1 << (argv[0] & 0x0F));
+            serialReading = ((argv[1] == 0) ? (serialReading | port) : (serialReading & ~port));
+          }
+          break;
+        default:
+          break;
+      }
+    }
+
+    static void staticVersionQueryCallback(void * context)
+    {
+      static_cast<Board *>(context)->sendVersion();
+    }
+
+    static void staticFirmwareQueryCallback(void * context, size_t, size_t, const char *)
+    {
+      static_cast<Board *>(context)->sendFirmware();
+    }
+
+    static void staticResetCallback(void * context)
+    {
+      static_cast<Board *>(context)->reset();
+    }
+
+    static void staticReportAnalogCallback(void * context, uint8_t command, uint16_t value)
+    {
+      Board * board = static_cast<Board *>(context);
+      const uint16_t channel = static_cast<uint16_t>(1 << (command & 0x0F));
+      board->analogEnabled = (value ? (board->analogEnabled | channel) : (board->analogEnabled & ~channel));
+    }
+
+    static void staticReportDigitalCallback(void * context, uint8_t command, uint16_t value)
+    {
+      Board * board = static_cast<Board *>(context);
+      const uint8_t port = command & 0x0F;
+      const uint16_t mask = static_cast<uint16_t>(1 << port);
+      board->portsEnabled = (value ? (board->portsEnabled | mask) : (board->portsEnabled & ~mask));
+      // the firmware reports the port at once when its reporting starts
+      if ( value && board->room(MESSAGE_DIGITAL) ) { board->marshaller.sendDigitalPort(port, board->portValue(port)); }
+    }
+
+    static void staticPinModeCallback(void * context, uint8_t pin, uint16_t mode)
+    {
+      Board * board = static_cast<Board *>(context);
+      if ( pin < board->layout.pinCount ) { board->modes[pin] = static_cast<uint8_t>(mode); }
+    }
+
+    static void staticSysexCallback(void * context, uint8_t command, size_t argc, uint8_t * argv)
+    {
+      static_cast<Board *>(context)->handleSysex(command, argc, argv);
+    }
+
+    const profile &prof;
+    const timing &time;
+    statistics &stats;
+    const board_layout &layout;
+    FirmataMarshaller marshaller;
+    uint8_t parserBuffer[MAX_DATA_BYTES * 2];
+    FirmataParser parser;
+    uint32_t random;
+
+    uint16_t analogEnabled;
+    uint16_t portsEnabled;
+    uint16_t serialReading;
+    double analogHz;
+    double i2cHz;
+    uint8_t modes[70];
+    uint8_t levels[70];
+    i2c_query continuous[I2C_MAX_QUERIES];
+    size_t continuousCount;
+    uint8_t i2cCounter;
+};
+
+void Board::markDirty(void)
+{
+  if ( dirty ) { return; }
+  dirty = true;
+  dirtyList.push_back(this);
+}
+
+//******************************************************************************
+//* Generator
+//******************************************************************************
+
+struct timer_entry {
+  uint64_t due;
+  uint32_t slot;
+  uint32_t generation;
+  uint8_t timer;
+
+  bool operator>(const timer_entry &other) const { return due > other.due; }
+};
+
+class Generator
+{
+  public:
+    Generator(const profile &p, const timing &t, size_t max_boards)
+    :
+      prof(p),
+      time(t),
+      maxBoards(max_boards),
+      liveBoards(0),
+      nextGeneration(1),
+      epollFd(::epoll_create1(EPOLL_CLOEXEC))
+    {
+      std::memset(&stats, 0, sizeof(stats));
+    }
+
+    ~Generator()
+    {
+      for (size_t i = 0; i < boards.size(); ++i) {
+        if ( boards[i] ) { ::close(boards[i]->fd); }
+      }
+      for (size_t i = 0; i < listeners.size(); ++i) { ::close(listeners[i]); }
+      for (size_t i = 0; i < ptySlaves.size(); ++i) { ::close(ptySlaves[i]); }
+      if ( epollFd >= 0 ) { ::close(epollFd); }
+    }
+
+    /**
+     * Create a pty in raw mode and a board on it. The slave side stays open, so the board keeps
+     * running while no client has the device open.
+     * @return The name of the slave device, empty on failure.
+     */
+    std::string addPty(void)
+    {
+      const int master = ::posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+      if ( master < 0 || ::grantpt(master) != 0 || ::unlockpt(master) != 0 ) { return std::string(); }
+      const char * name = ::ptsname(master);
+      const int slave = (name ? ::open(name, O_RDWR | O_NOCTTY | O_CLOEXEC) : -1);
+      struct termios tio;
+      if ( slave < 0 || ::tcgetattr(slave, &tio) != 0 ) {
+        ::close(master);
+        return std::string();
+      }
+      ::cfmakeraw(&tio);
+      ::tcsetattr(slave, TCSANOW, &tio);
+      ptySlaves.push_back(slave);
+      const std::string path(name);
+      addBoard(master);
+      return path;
+    }
+
+    bool addBoard(int fd)
+    {
+      if ( !setNonBlocking(fd) ) {
+        ::close(fd);
+        return false;
+      }
+      uint32_t slot;
+      if ( freeSlots.empty() ) {
+        slot = static_cast<uint32_t>(boards.size());
+        boards.push_back(NULL);
+      } else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+      }
+      const uint32_t generation = nextGeneration++;
+      boards[slot] = new Board(fd, slot, generation, 0x9E3779B9u * generation, prof, time, stats, dirty);
+      ++liveBoards;
+      ++stats.boardsOpened;
+
+      struct epoll_event event;
+      event.events = EPOLLIN;
+      event.data.u64 = slot;
+      ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+
+      // start the timers at a random phase, so the boards do not fire in lockstep
+      const uint64_t now = FirmataClockSync::hostMicros();
+      uint32_t random = generation * 2654435761u + 1;
+      for (int timer = 0; timer < TIMERS; ++timer) {
+        const uint64_t period = boards[slot]->period(static_cast<timer_id>(timer));
+        const timer_entry entry = { now + (period ? nextRandom(random) % period : 0), slot, generation, static_cast<uint8_t>(timer) };
+        timers.push(entry);
+      }
+      return true;
+    }
+
+    bool listenTcp(const char * address, uint16_t port)
+    {
+      const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      if ( fd < 0 ) { return false; }
+      const int one = 1;
+      ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      struct sockaddr_in addr;
+      std::memset(&addr, 0, sizeof(addr));
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons(port);
+      if ( ::inet_pton(AF_INET, address, &addr.sin_addr) != 1
+        || ::bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0 ) {
+        ::close(fd);
+        return false;
+      }
+      return addListener(fd);
+    }
+
+    bool listenUnix(const char * path)
+    {
+      const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      if ( fd < 0 ) { return false; }
+      struct sockaddr_un addr;
+      std::memset(&addr, 0, sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      std::strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+      ::unlink(path);
+      if ( ::bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0 ) {
+        ::close(fd);
+        return false;
+      }
+      return addListener(fd);
+    }
+
+    /**
+     * Run until SIGINT or SIGTERM, or for a number of seconds.
+     * @param duration [s] 0 to run until stopped.
+     * @param until_closed Also stop once no board is left, e.g. when the only one was inherited.
+     * @return The seconds run.
+     */
+    double run(double duration, bool until_closed)
+    {
+      const uint64_t start = FirmataClockSync::hostMicros();
+      const uint64_t end = ((duration > 0) ? start + static_cast<uint64_t>(duration * 1e6) : 0);
+      struct epoll_event events[MAX_EVENTS];
+      uint64_t now = start;
+      while ( !stopRequested && (!end || now < end) && !(until_closed && !liveBoards) ) {
+        now = FirmataClockSync::hostMicros();
+        fireTimers(now);
+        flushDirty();
+
+        int timeout = 100;
+        if ( !timers.empty() ) {
+          const uint64_t due = timers.top().due;
+          timeout = ((due > now) ? static_cast<int>(std::min<uint64_t>((due - now + 999) / 1000, 100)) : 0);
+        }
+        const int n = ::epoll_wait(epollFd, events, MAX_EVENTS, timeout);
+        for (int i = 0; i < n; ++i) {
+          const uint64_t id = events[i].data.u64;
+          if ( id >= NO_BOARD ) {
+            accept(listeners[id - NO_BOARD]);
+            continue;
+          }
+          Board * board = boards[id];
+          if ( !board ) { continue; }
+          if ( (events[i].events & EPOLLIN) && !receive(*board) ) {
+            closeBoard(static_cast<uint32_t>(id));
+            continue;
+          }
+          if ( events[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR) ) {
+            if ( !flush(*board) ) { closeBoard(static_cast<uint32_t>(id)); }
+          }
+        }
+        now = FirmataClockSync::hostMicros();
+      }
+      return (now - start) / 1e6;
+    }
+
+    statistics stats;
+
+  private:
+    bool addListener(int fd)
+    {
+      if ( ::listen(fd, 128) != 0 || !setNonBlocking(fd) ) {
+        ::close(fd);
+        return false;
+      }
+      struct epoll_event event;
+      event.events = EPOLLIN;
+      event.data.u64 = NO_BOARD + listeners.size();
+      listeners.push_back(fd);
+      return (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0);
+    }
+
+    void accept(int listener)
+    {
+      for (;;) {
+        const int fd = ::accept4(listener, NULL, NULL, SOCK_CLOEXEC);
+        if ( fd < 0 ) { return; }
+        if ( maxBoards && liveBoards >= maxBoards ) {
+          ::close(fd);
+          continue;
+        }
+        const int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        addBoard(fd);
+      }
+    }
+
+    /**
+     * @return false once the host closed the connection.
+     */
+    bool receive(Board &board)
+    {
+      uint8_t buffer[4096];
+      for (;;) {
+        const ssize_t n = ::read(board.fd, buffer, sizeof(buffer));
+        if ( n > 0 ) {
+          stats.bytesReceived += n;
+          board.parse(buffer, n);
+          continue;
+        }
+        if ( n < 0 && errno == EINTR ) { continue; }
+        return (n < 0 && errno == EAGAIN);
+      }
+    }
+
+    void fireTimers(uint64_t now)
+    {
+      while ( !timers.empty() && timers.top().due <= now ) {
+        timer_entry entry = timers.top();
+        timers.pop();
+        Board * board = boards[entry.slot];
+        if ( !board || board->generation != entry.generation ) { continue; }
+        const timer_id timer = static_cast<timer_id>(entry.timer);
+        if ( !board->period(timer) ) {
+          // no reports of this kind now; look again later, SAMPLING_INTERVAL may enable them
+          entry.due = now + 100000;
+          timers.push(entry);
+          continue;
+        }
+        board->fire(timer, entry.due);
+        entry.due = board->next(timer, entry.due);
+        if ( entry.due + MAX_LATENESS < now ) {
+          ++stats.lateTimers;
+          entry.due = now;
+        }
+        timers.push(entry);
+      }
+    }
+
+    void flushDirty(void)
+    {
+      for (size_t i = 0; i < dirty.size(); ++i) {
+        Board * board = dirty[i];
+        board->dirty = false;
+        const ssize_t sent = board->queue.send(board->fd);
+        if ( sent > 0 ) { stats.bytesSent += sent; }
+        if ( board->queue.size() ) {
+          // EPOLLOUT reports when the reader caught up
+          watch(*board, EPOLLIN | EPOLLOUT);
+        }
+      }
+      dirty.clear();
+    }
+
+    /**
+     * @return false on a write error.
+     */
+    bool flush(Board &board)
+    {
+      const ssize_t sent = board.queue.send(board.fd);
+      if ( sent < 0 ) { return false; }
+      stats.bytesSent += sent;
+      if ( !board.queue.size() ) { watch(board, EPOLLIN); }
+      return true;
+    }
+
+    void watch(Board &board, uint32_t events)
+    {
+      struct epoll_event event;
+      event.events = events;
+      event.data.u64 = board.slot;
+      ::epoll_ctl(epollFd, EPOLL_CTL_MOD, board.fd, &event);
+    }
+
+    void closeBoard(uint32_t slot)
+    {
+      Board * board = boards[slot];
+      ::epoll_ctl(epollFd, EPOLL_CTL_DEL, board->fd, NULL);
+      ::close(board->fd);
+      // its timers are dropped as they come up, by generation
+      dirty.erase(std::remove(dirty.begin(), dirty.end(), board), dirty.end());
+      delete board;
+      boards[slot] = NULL;
+      freeSlots.push_back(slot);
+      --liveBoards;
+      ++stats.boardsClosed;
+    }
+
+    const profile &prof;
+    const timing &time;
+    const size_t maxBoards;
+    size_t liveBoards;
+    uint32_t nextGeneration;
+    int epollFd;
+    std::vector<Board *> boards;
+    std::vector<uint32_t> freeSlots;
+    std::vector<Board *> dirty;
+    std::vector<int> listeners;
+    std::vector<int> ptySlaves;
+    std::priority_queue<timer_entry, std::vector<timer_entry>, std::greater<timer_entry> > timers;
+};
+
+//******************************************************************************
+//* Output
+//******************************************************************************
+
+void writeJson(std::FILE * file, const profile &p, const timing &t, double seconds, const statistics &stats)
+{
+  uint64_t messages = 0;
+  uint64_t dropped = 0;
+  for (int type = 0; type < MESSAGE_TYPES; ++type) {
+    messages += stats.messages[type];
+    dropped += stats.dropped[type];
+  }
+  std::fprintf(file, "{\n  \"tool\": \"loadgen\",\n  \"profile\": \"%s\",\n  \"rate_scale\": %.3f,\n  \"jitter\": %.3f,\n  \"burst\": %u,\n",
+    p.name.c_str(), t.rateScale, t.jitter, t.burst);
+  std::fprintf(file, "  \"seconds\": %.3f,\n  \"boards_opened\": %llu,\n  \"boards_closed\": %llu,\n", seconds,
+    static_cast<unsigned long long>(stats.boardsOpened), static_cast<unsigned long long>(stats.boardsClosed));
+  std::fprintf(file, "  \"messages\": {");
+  for (int type = 0; type < MESSAGE_TYPES; ++type) {
+    std::fprintf(file, "%s \"%s\": %llu", (type ? "," : ""), messageNames[type], static_cast<unsigned long long>(stats.messages[type]));
+  }
+  std::fprintf(file, " },\n  \"dropped\": {");
+  for (int type = 0; type < MESSAGE_TYPES; ++type) {
+    std::fprintf(file, "%s \"%s\": %llu", (type ? "," : ""), messageNames[type], static_cast<unsigned long long>(stats.dropped[type]));
+  }
+  std::fprintf(file, " },\n  \"messages_per_s\": %.0f,\n  \"dropped_share\": %.6f,\n", ((seconds > 0) ? messages / seconds : 0),
+    ((messages + dropped) ? static_cast<double>(dropped) / (messages + dropped) : 0));
+  std::fprintf(file, "  \"bytes_sent\": %llu,\n  \"bytes_received\": %llu,\n  \"late_timers\": %llu\n}\n",
+    static_cast<unsigned long long>(stats.bytesSent), static_cast<unsigned long long>(stats.bytesReceived),
+    static_cast<unsigned long long>(stats.lateTimers));
+}
+
+void usage(const char * program)
+{
+  std::fprintf(stderr,
+    "usage: %s [options]\n"
+    "  -n, --boards N       boards: ptys to create, or connections to accept (default 1, 0: any number)\n"
+    "  -P, --profile NAME   idle, sensor, logger, i2c, bridge, mixed or a profile file (default sensor)\n"
+    "  -p, --port N         accept boards on a TCP port instead of ptys\n"
+    "  -u, --unix PATH      accept boards on a Unix socket instead of ptys\n"
+    "  -a, --address ADDR   TCP address to bind (default 127.0.0.1)\n"
+    "      --fd N           one board on an inherited descriptor\n"
+    "  -l, --link DIR       symlink DIR/board0, DIR/board1, ... to the ptys\n"
+    "  -r, --rate F         multiply the rates of the profile (default 1)\n"
+    "  -j, --jitter F       move each report by up to this share of its period (default 0.1)\n"
+    "  -B, --burst N        send N periods of reports at once (default 1)\n"
+    "  -A, --autostart      run the reports of the profile without waiting for the host\n"
+    "  -q, --queue BYTES    send queue limit per board (default 65536)\n"
+    "  -d, --duration SECS  stop after this time (default: at SIGINT or SIGTERM)\n"
+    "  -o, --output FILE    JSON statistics at the end (default stdout)\n",
+    program);
+}
+
+} // namespace
+
+//******************************************************************************
+//* Main
+//******************************************************************************
+
+int main(int argc, char * argv[])
+{
+  static const struct option options[] = {
+    { "boards", required_argument, NULL, 'n' },
+    { "profile", required_argument, NULL, 'P' },
+    { "port", required_argument, NULL, 'p' },
+    { "unix", required_argument, NULL, 'u' },
+    { "address", required_argument, NULL, 'a' },
+    { "fd", required_argument, NULL, 'f' },
+    { "link", required_argument, NULL, 'l' },
+    { "rate", required_argument, NULL, 'r' },
+    { "jitter", required_argument, NULL, 'j' },
+    { "burst", required_argument, NULL, 'B' },
+    { "autostart", no_argument, NULL, 'A' },
+    { "queue", required_argument, NULL, 'q' },
+    { "duration", required_argument, NULL, 'd' },
+    { "output", required_argument, NULL, 'o' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+  size_t board_count = 1;
+  const char * profile_name = "sensor";
+  int port = 0;
+  const char * unix_path = NULL;
+  const char * address = "127.0.0.1";
+  int inherited_fd = -1;
+  const char * link_dir = NULL;
+  timing t = { 1.0, 0.1, 1, false, 65536 };
+  double duration = 0;
+  const char * output = NULL;
+  int option;
+
+  while ( (option = ::getopt_long(argc, argv, "n:P:p:u:a:l:r:j:B:Aq:d:o:h", options, NULL)) != -1 ) {
+    switch (option) {
+      case 'n': board_count = std::strtoul(optarg, NULL, 10); break;
+      case 'P': profile_name = optarg; break;
+      case 'p': port = std::atoi(optarg); break;
+      case 'u': unix_path = optarg; break;
+      case 'a': address = optarg; break;
+      case 'f': inherited_fd = std::atoi(optarg); break;
+      case 'l': link_dir = optarg; break;
+      case 'r': t.rateScale = std::atof(optarg); break;
+      case 'j': t.jitter = std::min(1.0, std::max(0.0, std::atof(optarg))); break;
+      case 'B': t.burst = std::max(1, std::atoi(optarg)); break;
+      case 'A': t.autostart = true; break;
+      case 'q': t.queueLimit = std::strtoul(optarg, NULL, 10); break;
+      case 'd': duration = std::atof(optarg); break;
+      case 'o': output = optarg; break;
+      default:
+        usage(argv[0]);
+        return ((option == 'h') ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+  }
+  profile p;
+  if ( optind != argc || !findProfile(profile_name, p) ) {
+    if ( optind == argc ) { std::fprintf(stderr, "unknown profile or bad profile file: %s\n", profile_name); }
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::signal(SIGPIPE, SIG_IGN);
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+
+  Generator generator(p, t, ((port || unix_path) ? board_count : 0));
+  if ( inherited_fd >= 0 ) {
+    if ( !generator.addBoard(inherited_fd) ) {
+      std::fprintf(stderr, "cannot use descriptor %d\n", inherited_fd);
+      return EXIT_FAILURE;
+    }
+  } else if ( port || unix_path ) {
+    if ( port && !generator.listenTcp(address, static_cast<uint16_t>(port)) ) {
+      std::fprintf(stderr, "cannot listen on %s:%d: %s\n", address, port, std::strerror(errno));
+      return EXIT_FAILURE;
+    }
+    if ( unix_path && !generator.listenUnix(unix_path) ) {
+      std::fprintf(stderr, "cannot listen on %s: %s\n", unix_path, std::strerror(errno));
+      return EXIT_FAILURE;
+    }
+  } else {
+    for (size_t i = 0; i < board_count; ++i) {
+      const std::string name = generator.addPty();
+      if ( name.empty() ) {
+        std::fprintf(stderr, "cannot create pty %zu: %s\n", i, std::strerror(errno));
+        return EXIT_FAILURE;
+      }
+      if ( link_dir ) {
+        const std::string link = std::string(link_dir) + "/board" + std::to_string(i);
+        ::unlink(link.c_str());
+        if ( ::symlink(name.c_str(), link.c_str()) != 0 ) {
+          std::fprintf(stderr, "cannot create %s: %s\n", link.c_str(), std::strerror(errno));
+        }
+      }
+      std::fprintf(stderr, "%s\n", name.c_str());
+    }
+  }
+
+  const double seconds = generator.run(duration, (inherited_fd >= 0));
+  if ( unix_path ) { ::unlink(unix_path); }
+
+  std::FILE * file = (output ? std::fopen(output, "w") : stdout);
+  if ( !file ) {
+    std::perror(output);
+    return EXIT_FAILURE;
+  }
+  writeJson(file, p, t, seconds, generator.stats);
+  if ( output ) { std::fclose(file); }
+  return EXIT_SUCCESS;
+}
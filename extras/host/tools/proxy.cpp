@@ -0,0 +1,817 @@
+/*
+  proxy.cpp - shares one Firmata board between many local clients
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Holds the link to a board and serves any number of clients over a Unix
+  socket and/or a TCP port, so tools connect and disconnect without
+  reopening the serial port (which resets most boards) or redoing the
+  handshake:
+
+  - the messages of a client reach the board whole, never interleaved with
+    another client's
+  - REPORT_VERSION, the firmware, capability and analog mapping queries are
+    answered from the replies cached at startup; a query while the same one
+    is in flight waits for its reply instead of being sent again
+  - SYSTEM_RESET from a client is dropped, the other clients rely on the
+    state of the board
+  - REPORT_ANALOG and REPORT_DIGITAL subscribe the client; the board is told
+    to start a report for the first subscriber and to stop it after the last
+    one. A new subscriber gets the last report at once
+  - analog and digital reports go to their subscribers, other messages from
+    the board to the clients that asked (replies to cached queries) or to
+    all clients
+
+  Each client has a send queue. Reports for a client whose queue is full
+  are dropped for that client only; a client that falls behind on other
+  messages is disconnected. While the queue to the board is full, the proxy
+  stops reading from clients.
+
+  usage: proxy [options] device
+*/
+
+//******************************************************************************
+//* Includes
+//******************************************************************************
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "FirmataClockSync.h"
+#include "FirmataConstants.h"
+#include "FirmataEngine.h"
+
+using namespace firmata;
+
+namespace {
+
+const size_t MAX_MESSAGE = 4096;            // [bytes] a capability response of a large board fits
+const size_t BOARD_QUEUE_LIMIT = 65536;     // [bytes] stop reading clients above this
+const uint64_t QUERY_RETRY = 1000000;       // [us] send a query again if unanswered this long
+const size_t MAX_EVENTS = 64;
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onSignal(int)
+{
+  stopRequested = 1;
+}
+
+bool setNonBlocking(int fd)
+{
+  const int flags = ::fcntl(fd, F_GETFL);
+  return (flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0);
+}
+
+//******************************************************************************
+//* Message Framing
+//******************************************************************************
+
+/**
+ * Splits a byte stream into whole Firmata messages. REPORT_VERSION carries the version from the
+ * board and nothing from a host, so the framer needs to know the direction.
+ */
+class MessageFramer
+{
+  public:
+    explicit MessageFramer(bool from_board) : fromBoard(from_board), length(0), expected(0), sysex(false), overflow(false) {}
+
+    /**
+     * @return true if c completes a message, which is then in data()/size().
+     */
+    bool push(uint8_t c)
+    {
+      if ( c & 0x80 ) {
+        if ( sysex && c == END_SYSEX ) {
+          sysex = false;
+          if ( !overflow ) {
+            buffer[length++] = c;
+            return true;
+          }
+          length = 0;
+          return false;
+        }
+        // a new status byte abandons an unfinished message
+        length = 0;
+        buffer[length++] = c;
+        sysex = (c == START_SYSEX);
+        overflow = false;
+        expected = (sysex ? 0 : dataLength(c));
+        return (!sysex && expected == 0);
+      }
+      if ( length == 0 ) { return false; }       // data without a status byte
+      if ( sysex ) {
+        // drop a sysex too large to forward whole
+        if ( length < MAX_MESSAGE - 1 ) {
+          buffer[length++] = c;
+        } else {
+          overflow = true;
+        }
+        return false;
+      }
+      buffer[length++] = c;
+      if ( --expected == 0 ) { return true; }
+      return false;
+    }
+
+    const uint8_t * data(void) const { return buffer; }
+    size_t size(void) const { return length; }
+
+  private:
+    size_t dataLength(uint8_t status) const
+    {
+      if ( status < 0xF0 ) {
+        const uint8_t command = status & 0xF0;
+        return ((command == REPORT_ANALOG || command == REPORT_DIGITAL) ? 1 : 2);
+      }
+      switch (status) {
+        case SET_PIN_MODE:
+        case SET_DIGITAL_PIN_VALUE:
+          return 2;
+        case REPORT_VERSION:
+          return (fromBoard ? 2 : 0);
+        default:
+          return 0;
+      }
+    }
+
+    const bool fromBoard;
+    uint8_t buffer[MAX_MESSAGE];
+    size_t length;
+    size_t expected;
+    bool sysex;
+    bool overflow;
+};
+
+/**
+ * A queue of bytes to send. Appends go to the end, writes take from the front; the space is
+ * reused once the queue drains, so a steady connection stops allocating.
+ */
+class SendQueue
+{
+  public:
+    SendQueue(void) : head(0) {}
+
+    size_t size(void) const { return bytes.size() - head; }
+    void append(const uint8_t * data, size_t length) { bytes.insert(bytes.end(), data, data + length); }
+
+    /**
+     * @return false on an error other than a full descriptor.
+     */
+    bool send(int fd)
+    {
+      while ( size() ) {
+        const ssize_t n = ::send(fd, bytes.data() + head, size(), MSG_NOSIGNAL);
+        if ( n > 0 ) {
+          head += n;
+        } else if ( n < 0 && errno == EINTR ) {
+          continue;
+        } else if ( n < 0 && errno == EAGAIN ) {
+          break;
+        } else if ( n < 0 && errno == ENOTSOCK ) {
+          // serial ports and ptys
+          const ssize_t w = ::write(fd, bytes.data() + head, size());
+          if ( w > 0 ) { head += w; continue; }
+          if ( w < 0 && (errno == EAGAIN || errno == EINTR) ) { break; }
+          return false;
+        } else {
+          return false;
+        }
+      }
+      if ( head == bytes.size() ) {
+        bytes.clear();
+        head = 0;
+      } else if ( head > 65536 && head > bytes.size() / 2 ) {
+        bytes.erase(bytes.begin(), bytes.begin() + head);
+        head = 0;
+      }
+      return true;
+    }
+
+  private:
+    std::vector<uint8_t> bytes;
+    size_t head;
+};
+
+//******************************************************************************
+//* Proxy
+//******************************************************************************
+
+enum cached_query {
+  QUERY_VERSION,
+  QUERY_FIRMWARE,
+  QUERY_CAPABILITIES,
+  QUERY_ANALOG_MAPPING,
+  CACHED_QUERIES
+};
+
+struct Client {
+  int fd;
+  std::string name;
+  MessageFramer framer;
+  SendQueue queue;
+  bool analog[16];                          // subscribed reports
+  bool digital[16];
+  bool awaiting[CACHED_QUERIES];
+  bool writable;
+  bool reading;
+  uint64_t dropped;                         // reports not queued while the queue was full
+
+  Client(int descriptor, const std::string & peer)
+  :
+    fd(descriptor),
+    name(peer),
+    framer(false),
+    writable(true),
+    reading(true),
+    dropped(0)
+  {
+    std::memset(analog, 0, sizeof(analog));
+    std::memset(digital, 0, sizeof(digital));
+    std::memset(awaiting, 0, sizeof(awaiting));
+  }
+};
+
+class Proxy
+{
+  public:
+    Proxy(int board_fd, size_t queue_limit)
+    :
+      board(board_fd),
+      boardFramer(true),
+      boardWritable(true),
+      clientsPaused(false),
+      queueLimit(queue_limit),
+      epollFd(-1)
+    {
+      std::memset(analogSubscribers, 0, sizeof(analogSubscribers));
+      std::memset(digitalSubscribers, 0, sizeof(digitalSubscribers));
+      std::memset(lastAnalog, 0, sizeof(lastAnalog));
+      std::memset(lastDigital, 0, sizeof(lastDigital));
+      std::memset(querySent, 0, sizeof(querySent));
+    }
+
+    bool listenUnix(const char * path)
+    {
+      const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      struct sockaddr_un address;
+      std::memset(&address, 0, sizeof(address));
+      address.sun_family = AF_UNIX;
+      if ( fd < 0 || std::strlen(path) >= sizeof(address.sun_path) ) { return false; }
+      std::strcpy(address.sun_path, path);
+      ::unlink(path);
+      if ( ::bind(fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0 || ::listen(fd, 64) != 0 ) {
+        ::close(fd);
+        return false;
+      }
+      listeners.push_back(fd);
+      return true;
+    }
+
+    bool listenTcp(const char * host, uint16_t port)
+    {
+      const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      struct sockaddr_in address;
+      std::memset(&address, 0, sizeof(address));
+      address.sin_family = AF_INET;
+      address.sin_port = htons(port);
+      if ( fd < 0 || ::inet_pton(AF_INET, host, &address.sin_addr) != 1 ) { return false; }
+      const int one = 1;
+      ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      if ( ::bind(fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0 || ::listen(fd, 64) != 0 ) {
+        ::close(fd);
+        return false;
+      }
+      listeners.push_back(fd);
+      return true;
+    }
+
+    /**
+     * Serve until the board link fails or a signal arrives.
+     * @return false if the board link failed.
+     */
+    bool run(void)
+    {
+      epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+      if ( epollFd < 0 ) { return false; }
+      setNonBlocking(board);
+      watch(board, EPOLLIN, &board);
+      for (size_t i = 0; i < listeners.size(); ++i) {
+        setNonBlocking(listeners[i]);
+        watch(listeners[i], EPOLLIN, &listeners[i]);
+      }
+
+      // fill the cache before the first client asks
+      for (size_t q = 0; q < CACHED_QUERIES; ++q) { sendQuery(static_cast<cached_query>(q)); }
+      flushBoard();
+
+      struct epoll_event events[MAX_EVENTS];
+      uint8_t chunk[65536];
+      bool board_ok = true;
+      while ( !stopRequested && board_ok ) {
+        const int n = ::epoll_wait(epollFd, events, MAX_EVENTS, 1000);
+        if ( n < 0 && errno != EINTR ) { break; }
+        for (int i = 0; i < n && board_ok; ++i) {
+          void * tag = events[i].data.ptr;
+          if ( tag == &board ) {
+            if ( events[i].events & EPOLLOUT ) { boardWritable = true; }
+            if ( events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR) ) { board_ok = readBoard(chunk, sizeof(chunk)); }
+          } else if ( isListener(tag) ) {
+            accept(*static_cast<int *>(tag));
+          } else {
+            Client * client = static_cast<Client *>(tag);
+            if ( client->fd < 0 ) { continue; }
+            if ( events[i].events & EPOLLOUT ) { client->writable = true; }
+            if ( events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR) ) { readClient(*client, chunk, sizeof(chunk)); }
+          }
+        }
+        if ( !flushBoard() ) { board_ok = false; }
+        flushClients();
+        reap();
+      }
+
+      for (size_t i = 0; i < clients.size(); ++i) {
+        if ( clients[i]->fd >= 0 ) { ::close(clients[i]->fd); }
+      }
+      return board_ok;
+    }
+
+  private:
+    void watch(int fd, uint32_t events, void * tag, int op = EPOLL_CTL_ADD)
+    {
+      struct epoll_event event;
+      event.events = events;
+      event.data.ptr = tag;
+      ::epoll_ctl(epollFd, op, fd, &event);
+    }
+
+    bool isListener(void * tag) const
+    {
+      for (size_t i = 0; i < listeners.size(); ++i) {
+        if ( tag == &listeners[i] ) { return true; }
+      }
+      return false;
+    }
+
+    void accept(int listener)
+    {
+      struct sockaddr_storage peer;
+      socklen_t length = sizeof(peer);
+      const int fd = ::accept4(listener, reinterpret_cast<struct sockaddr *>(&peer), &length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if ( fd < 0 ) { return; }
+      char name[64] = "unix";
+      if ( peer.ss_family == AF_INET ) {
+        const struct sockaddr_in * in = reinterpret_cast<const struct sockaddr_in *>(&peer);
+        char host[INET_ADDRSTRLEN];
+        ::inet_ntop(AF_INET, &in->sin_addr, host, sizeof(host));
+        std::snprintf(name, sizeof(name), "%s:%u", host, ntohs(in->sin_port));
+        const int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      }
+      std::unique_ptr<Client> client(new Client(fd, name));
+      watch(fd, (clientsPaused ? 0 : static_cast<uint32_t>(EPOLLIN)), client.get());
+      client->reading = !clientsPaused;
+      std::fprintf(stderr, "proxy: client %d (%s) connected\n", fd, name);
+      clients.push_back(std::move(client));
+    }
+
+    void disconnect(Client &client, const char * reason)
+    {
+      if ( client.fd < 0 ) { return; }
+      std::fprintf(stderr, "proxy: client %d (%s) %s, %llu reports dropped\n", client.fd, client.name.c_str(), reason, static_cast<unsigned long long>(client.dropped));
+      ::epoll_ctl(epollFd, EPOLL_CTL_DEL, client.fd, NULL);
+      ::close(client.fd);
+      client.fd = -1;
+      for (uint8_t i = 0; i < 16; ++i) {
+        if ( client.analog[i] ) { subscribe(client, REPORT_ANALOG, i, false); }
+        if ( client.digital[i] ) { subscribe(client, REPORT_DIGITAL, i, false); }
+      }
+    }
+
+    /**
+     * Delete the clients disconnected in this iteration, after no event refers to them.
+     */
+    void reap(void)
+    {
+      for (size_t i = 0; i < clients.size(); ) {
+        if ( clients[i]->fd < 0 ) {
+          clients[i] = std::move(clients.back());
+          clients.pop_back();
+        } else {
+          ++i;
+        }
+      }
+    }
+
+    //**************************************************************************
+    //* Board to clients
+    //**************************************************************************
+
+    bool readBoard(uint8_t * chunk, size_t size)
+    {
+      const ssize_t n = ::read(board, chunk, size);
+      if ( n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR) ) {
+        std::fprintf(stderr, "proxy: board link closed\n");
+        return false;
+      }
+      for (ssize_t i = 0; i < n; ++i) {
+        if ( boardFramer.push(chunk[i]) ) { fromBoard(boardFramer.data(), boardFramer.size()); }
+      }
+      return true;
+    }
+
+    void fromBoard(const uint8_t * message, size_t length)
+    {
+      const uint8_t status = message[0];
+      const uint8_t command = ((status < 0xF0) ? (status & 0xF0) : status);
+      if ( command == ANALOG_MESSAGE ) {
+        const uint8_t channel = status & 0x0F;
+        std::memcpy(lastAnalog[channel], message, 3);
+        for (size_t i = 0; i < clients.size(); ++i) {
+          if ( clients[i]->analog[channel] ) { queue(*clients[i], message, length, true); }
+        }
+        return;
+      }
+      if ( command == DIGITAL_MESSAGE ) {
+        const uint8_t port = status & 0x0F;
+        std::memcpy(lastDigital[port], message, 3);
+        for (size_t i = 0; i < clients.size(); ++i) {
+          if ( clients[i]->digital[port] ) { queue(*clients[i], message, length, true); }
+        }
+        return;
+      }
+
+      const int q = cachedReply(message, length);
+      if ( q >= 0 ) {
+        cache[q].assign(message, message + length);
+        querySent[q] = 0;
+        bool asked = false;
+        for (size_t i = 0; i < clients.size(); ++i) {
+          if ( clients[i]->awaiting[q] ) {
+            clients[i]->awaiting[q] = false;
+            queue(*clients[i], message, length, false);
+            asked = true;
+          }
+        }
+        // e.g. the greeting of a board that reset itself
+        if ( asked || q == QUERY_CAPABILITIES || q == QUERY_ANALOG_MAPPING ) { return; }
+      }
+      for (size_t i = 0; i < clients.size(); ++i) {
+        queue(*clients[i], message, length, false);
+      }
+    }
+
+    int cachedReply(const uint8_t * message, size_t length) const
+    {
+      if ( message[0] == REPORT_VERSION ) { return QUERY_VERSION; }
+      if ( message[0] != START_SYSEX || length < 3 ) { return -1; }
+      switch (message[1]) {
+        case REPORT_FIRMWARE:
+          return ((length > 3) ? QUERY_FIRMWARE : -1);
+        case CAPABILITY_RESPONSE:
+          return QUERY_CAPABILITIES;
+        case ANALOG_MAPPING_RESPONSE:
+          return QUERY_ANALOG_MAPPING;
+        default:
+          return -1;
+      }
+    }
+
+    /**
+     * Queue a message for a client. A report that does not fit is dropped; any other message that
+     * does not fit disconnects the client, which would otherwise miss a reply.
+     */
+    void queue(Client &client, const uint8_t * message, size_t length, bool report)
+    {
+      if ( client.fd < 0 ) { return; }
+      if ( client.queue.size() + length > queueLimit ) {
+        if ( report ) {
+          ++client.dropped;
+        } else {
+          disconnect(client, "fell behind");
+        }
+        return;
+      }
+      client.queue.append(message, length);
+    }
+
+    void flushClients(void)
+    {
+      for (size_t i = 0; i < clients.size(); ++i) {
+        Client &client = *clients[i];
+        if ( client.fd < 0 || !client.writable || !client.queue.size() ) { continue; }
+        if ( !client.queue.send(client.fd) ) {
+          disconnect(client, "write failed");
+          continue;
+        }
+        const bool blocked = (client.queue.size() != 0);
+        if ( blocked ) {
+          client.writable = false;
+          watch(client.fd, (client.reading ? static_cast<uint32_t>(EPOLLIN) : 0) | EPOLLOUT, &client, EPOLL_CTL_MOD);
+        } else {
+          watch(client.fd, (client.reading ? static_cast<uint32_t>(EPOLLIN) : 0), &client, EPOLL_CTL_MOD);
+        }
+      }
+    }
+
+    //**************************************************************************
+    //* Clients to board
+    //**************************************************************************
+
+    void readClient(Client &client, uint8_t * chunk, size_t size)
+    {
+      const ssize_t n = ::read(client.fd, chunk, size);
+      if ( n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR) ) {
+        disconnect(client, "disconnected");
+        return;
+      }
+      for (ssize_t i = 0; i < n && client.fd >= 0; ++i) {
+        if ( client.framer.push(chunk[i]) ) { fromClient(client, client.framer.data(), client.framer.size()); }
+      }
+      if ( boardQueue.size() > BOARD_QUEUE_LIMIT ) { pauseClients(true); }
+    }
+
+    void fromClient(Client &client, const uint8_t * message, size_t length)
+    {
+      const uint8_t status = message[0];
+      if ( status == SYSTEM_RESET ) {
+        std::fprintf(stderr, "proxy: client %d (%s) sent SYSTEM_RESET, dropped\n", client.fd, client.name.c_str());
+        return;
+      }
+      if ( status < 0xF0 && ((status & 0xF0) == REPORT_ANALOG || (status & 0xF0) == REPORT_DIGITAL) ) {
+        subscribe(client, (status & 0xF0), (status & 0x0F), (message[1] != 0));
+        return;
+      }
+
+      int q = -1;
+      if ( status == REPORT_VERSION ) {
+        q = QUERY_VERSION;
+      } else if ( status == START_SYSEX && length == 3 ) {
+        switch (message[1]) {
+          case REPORT_FIRMWARE: q = QUERY_FIRMWARE; break;
+          case CAPABILITY_QUERY: q = QUERY_CAPABILITIES; break;
+          case ANALOG_MAPPING_QUERY: q = QUERY_ANALOG_MAPPING; break;
+        }
+      }
+      if ( q >= 0 ) {
+        if ( !cache[q].empty() ) {
+          queue(client, cache[q].data(), cache[q].size(), false);
+        } else {
+          client.awaiting[q] = true;
+          sendQuery(static_cast<cached_query>(q));
+        }
+        return;
+      }
+      boardQueue.append(message, length);
+    }
+
+    void sendQuery(cached_query q)
+    {
+      const uint64_t now = FirmataClockSync::hostMicros();
+      if ( querySent[q] && now - querySent[q] < QUERY_RETRY ) { return; }
+      querySent[q] = now;
+      static const uint8_t queries[CACHED_QUERIES][3] = {
+        { REPORT_VERSION, 0, 0 },
+        { START_SYSEX, REPORT_FIRMWARE, END_SYSEX },
+        { START_SYSEX, CAPABILITY_QUERY, END_SYSEX },
+        { START_SYSEX, ANALOG_MAPPING_QUERY, END_SYSEX },
+      };
+      boardQueue.append(queries[q], ((q == QUERY_VERSION) ? 1 : 3));
+    }
+
+    /**
+     * Count the subscribers of a report; only the first start and the last stop reach the board.
+     */
+    void subscribe(Client &client, uint8_t command, uint8_t index, bool enable)
+    {
+      bool &subscribed = ((command == REPORT_ANALOG) ? client.analog[index] : client.digital[index]);
+      size_t &subscribers = ((command == REPORT_ANALOG) ? analogSubscribers[index] : digitalSubscribers[index]);
+      if ( subscribed == enable ) { return; }
+      subscribed = enable;
+      const uint8_t message[2] = { static_cast<uint8_t>(command | index), static_cast<uint8_t>(enable ? 1 : 0) };
+      if ( enable ) {
+        if ( subscribers++ == 0 ) {
+          boardQueue.append(message, sizeof(message));
+        } else {
+          // the board reports a digital port on change only, give the newcomer the current value
+          const uint8_t * last = ((command == REPORT_ANALOG) ? lastAnalog[index] : lastDigital[index]);
+          if ( last[0] ) { queue(client, last, 3, true); }
+        }
+      } else if ( --subscribers == 0 ) {
+        boardQueue.append(message, sizeof(message));
+      }
+    }
+
+    bool flushBoard(void)
+    {
+      if ( boardWritable && boardQueue.size() ) {
+        if ( !boardQueue.send(board) ) {
+          std::fprintf(stderr, "proxy: board link write failed\n");
+          return false;
+        }
+        boardWritable = (boardQueue.size() == 0);
+        watch(board, EPOLLIN | (boardWritable ? 0 : static_cast<uint32_t>(EPOLLOUT)), &board, EPOLL_CTL_MOD);
+      }
+      if ( clientsPaused && boardQueue.size() < BOARD_QUEUE_LIMIT / 2 ) { pauseClients(false); }
+      return true;
+    }
+
+    void pauseClients(bool pause)
+    {
+      if ( clientsPaused == pause ) { return; }
+      clientsPaused = pause;
+      for (size_t i = 0; i < clients.size(); ++i) {
+        Client &client = *clients[i];
+        if ( client.fd < 0 ) { continue; }
+        client.reading = !pause;
+        watch(client.fd, (client.reading ? static_cast<uint32_t>(EPOLLIN) : 0) | (client.writable ? 0 : static_cast<uint32_t>(EPOLLOUT)), &client, EPOLL_CTL_MOD);
+      }
+    }
+
+    int board;
+    MessageFramer boardFramer;
+    SendQueue boardQueue;
+    bool boardWritable;
+    bool clientsPaused;
+    const size_t queueLimit;
+    int epollFd;
+    std::vector<int> listeners;
+    std::vector<std::unique_ptr<Client> > clients;
+
+    std::vector<uint8_t> cache[CACHED_QUERIES];
+    uint64_t querySent[CACHED_QUERIES];     // [us] host time, 0 if not in flight
+    size_t analogSubscribers[16];
+    size_t digitalSubscribers[16];
+    uint8_t lastAnalog[16][3];
+    uint8_t lastDigital[16][3];
+};
+
+//******************************************************************************
+//* Device
+//******************************************************************************
+
+/**
+ * Run a board program (e.g. an emulated sketch from build.sh) on one end of a socket pair.
+ * @param child Set to the pid of the program, see stopBoard().
+ */
+int spawnBoard(const char * program, pid_t &child)
+{
+  int fds[2];
+  if ( ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0 ) { return -1; }
+  const pid_t pid = ::fork();
+  if ( pid == 0 ) {
+    ::close(fds[0]);
+    const int fd = ::dup(fds[1]);           // without FD_CLOEXEC
+    char number[16];
+    std::snprintf(number, sizeof(number), "%d", fd);
+    ::execl(program, program, "--fd", number, static_cast<char *>(NULL));
+    std::fprintf(stderr, "cannot run %s: %s\n", program, std::strerror(errno));
+    ::_exit(127);
+  }
+  ::close(fds[1]);
+  if ( pid < 0 ) {
+    ::close(fds[0]);
+    return -1;
+  }
+  child = pid;
+  return fds[0];
+}
+
+/**
+ * Terminate and reap a board program started by spawnBoard().
+ * @param child Its pid, -1 if the board is not a program.
+ */
+void stopBoard(pid_t child)
+{
+  if ( child <= 0 ) { return; }
+  ::kill(child, SIGTERM);
+  while ( ::waitpid(child, NULL, 0) < 0 && errno == EINTR ) {}
+}
+
+int openDevice(const char * device, uint32_t baud, pid_t &child)
+{
+  if ( std::strncmp(device, "exec:", 5) == 0 ) { return spawnBoard(device + 5, child); }
+  if ( std::strncmp(device, "tcp:", 4) == 0 ) {
+    const char * colon = std::strrchr(device + 4, ':');
+    if ( !colon ) { return -1; }
+    const std::string host(device + 4, colon - (device + 4));
+    return FirmataEngine::connectTcp(host.c_str(), static_cast<uint16_t>(std::atoi(colon + 1)));
+  }
+  return FirmataEngine::openSerial(device, baud);
+}
+
+void usage(const char * program)
+{
+  std::fprintf(stderr,
+    "usage: %s [options] device\n"
+    "  device               a serial port, tcp:HOST:PORT or exec:PROGRAM (a board built by build.sh)\n"
+    "  -b, --baud N         serial baud rate (default 57600)\n"
+    "  -u, --unix PATH      serve clients on a Unix socket\n"
+    "  -p, --port N         serve clients on a TCP port\n"
+    "  -a, --address ADDR   TCP address to bind (default 127.0.0.1)\n"
+    "  -q, --queue BYTES    send queue limit per client (default 262144)\n",
+    program);
+}
+
+} // namespace
+
+//******************************************************************************
+//* Main
+//******************************************************************************
+
+int main(int argc, char * argv[])
+{
+  static const struct option options[] = {
+    { "baud", required_argument, NULL, 'b' },
+    { "unix", required_argument, NULL, 'u' },
+    { "port", required_argument, NULL, 'p' },
+    { "address", required_argument, NULL, 'a' },
+    { "queue", required_argument, NULL, 'q' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+  uint32_t baud = 57600;
+  const char * unix_path = NULL;
+  int port = 0;
+  const char * address = "127.0.0.1";
+  size_t queue_limit = 262144;
+  int option;
+
+  while ( (option = ::getopt_long(argc, argv, "b:u:p:a:q:h", options, NULL)) != -1 ) {
+    switch (option) {
+      case 'b':
+        baud = std::strtoul(optarg, NULL, 10);
+        break;
+      case 'u':
+        unix_path = optarg;
+        break;
+      case 'p':
+        port = std::atoi(optarg);
+        break;
+      case 'a':
+        address = optarg;
+        break;
+      case 'q':
+        queue_limit = std::strtoul(optarg, NULL, 10);
+        break;
+      default:
+        usage(argv[0]);
+        return ((option == 'h') ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+  }
+  if ( optind != argc - 1 || (!unix_path && !port) ) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::signal(SIGPIPE, SIG_IGN);
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+
+  pid_t child = -1;
+  const int board = openDevice(argv[optind], baud, child);
+  if ( board < 0 ) {
+    std::fprintf(stderr, "cannot open %s\n", argv[optind]);
+    return EXIT_FAILURE;
+  }
+  Proxy proxy(board, queue_limit);
+  if ( unix_path && !proxy.listenUnix(unix_path) ) {
+    std::fprintf(stderr, "cannot listen on %s: %s\n", unix_path, std::strerror(errno));
+    stopBoard(child);
+    return EXIT_FAILURE;
+  }
+  if ( port && !proxy.listenTcp(address, static_cast<uint16_t>(port)) ) {
+    std::fprintf(stderr, "cannot listen on %s:%d: %s\n", address, port, std::strerror(errno));
+    stopBoard(child);
+    return EXIT_FAILURE;
+  }
+
+  const bool ok = proxy.run();
+  if ( unix_path ) { ::unlink(unix_path); }
+  ::close(board);
+  stopBoard(child);
+  return (ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
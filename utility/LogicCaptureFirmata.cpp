@@ -0,0 +1,210 @@
+/*
+  LogicCaptureFirmata.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#include "LogicCaptureFirmata.h"
+
+LogicCaptureFirmata::LogicCaptureFirmata()
+{
+  reset();
+}
+
+boolean LogicCaptureFirmata::handlePinMode(byte pin, int mode)
+{
+  // the capture reads pins in any mode and does not own any of them
+  (void)pin;
+  (void)mode;
+  return false;
+}
+
+void LogicCaptureFirmata::handleCapability(byte pin)
+{
+  (void)pin;
+}
+
+boolean LogicCaptureFirmata::handleSysex(byte command, byte argc, byte *argv)
+{
+  if (command != LOGIC_CAPTURE || argc < 1) {
+    return false;
+  }
+
+  switch (argv[0]) {
+    case LOGIC_CAPTURE_START:
+      if (argc < 7) {
+        Firmata.sendString("Logic capture: not enough data");
+        break;
+      }
+      if (argv[1] >= TOTAL_PORTS || (argv[2] != LOGIC_CAPTURE_NO_PORT && argv[2] >= TOTAL_PORTS)) {
+        Firmata.sendString("Logic capture: invalid port");
+        break;
+      }
+      ports[0] = argv[1];
+      ports[1] = argv[2];
+      samplePeriod = argv[3] | (argv[4] << 7);
+      maxDuration = argv[5] | (argv[6] << 7);
+      flags = (argc > 7) ? argv[7] : 0;
+      // start sampling from update() so the parser is not re-entered during the capture
+      armed = true;
+      break;
+    case LOGIC_CAPTURE_STOP:
+      armed = false;
+      break;
+    case LOGIC_CAPTURE_DUMP:
+      sendRecords();
+      sendEnd();
+      break;
+  }
+  return true;
+}
+
+void LogicCaptureFirmata::update()
+{
+  if (!armed) {
+    return;
+  }
+  armed = false;
+  FIRMATA_TRACE_EVENT(TRACE_FEATURE_BEGIN, LOGIC_CAPTURE);
+  capture();
+  sendRecords();
+  sendEnd();
+  FIRMATA_TRACE_EVENT(TRACE_FEATURE_END, LOGIC_CAPTURE);
+}
+
+void LogicCaptureFirmata::reset()
+{
+  armed = false;
+  recordCount = 0;
+  ports[0] = 0;
+  ports[1] = LOGIC_CAPTURE_NO_PORT;
+  samplePeriod = 0;
+  maxDuration = 0;
+  flags = 0;
+  status = 0;
+  firstSample = 0;
+  totalSamples = 0;
+  elapsedMicros = 0;
+}
+
+uint16_t LogicCaptureFirmata::sample()
+{
+  uint16_t value = readPort(ports[0], 0xFF);
+  if (ports[1] != LOGIC_CAPTURE_NO_PORT) {
+    value |= (uint16_t)readPort(ports[1], 0xFF) << 8;
+  }
+  return value;
+}
+
+/*
+ * Sample the selected ports until the buffer is full, the duration has elapsed or the host
+ * sends a byte. In streaming mode a full buffer is sent and the capture continues; the samples
+ * that elapse while sending are skipped and reported through LOGIC_CAPTURE_GAPS.
+ */
+void LogicCaptureFirmata::capture()
+{
+  const unsigned long start = micros();
+  const unsigned long limit = (unsigned long)maxDuration * 1000UL;
+  unsigned long next = start;
+  uint16_t value;
+  byte poll = 0;
+
+  recordCount = 0;
+  firstSample = 0;
+  totalSamples = 0;
+  status = 0;
+
+  for (;;) {
+    if (samplePeriod) {
+      while ((long)(micros() - next) < 0) {
+        ; // wait for the next sample slot
+      }
+      next += samplePeriod;
+    }
+    value = sample();
+
+    if (recordCount > 0
+        && records[recordCount - 1].value == value
+        && records[recordCount - 1].count < LOGIC_CAPTURE_MAX_RUN) {
+      records[recordCount - 1].count++;
+    } else if (recordCount < LOGIC_CAPTURE_BUFFER_SIZE) {
+      records[recordCount].value = value;
+      records[recordCount].count = 1;
+      recordCount++;
+    } else if (flags & LOGIC_CAPTURE_STREAM) {
+      sendRecords();
+      recordCount = 0;
+      status |= LOGIC_CAPTURE_GAPS;
+      // drop the stale sample and any sample slots that passed while sending
+      totalSamples++;
+      if (samplePeriod && (long)(micros() - next) > 0) {
+        unsigned long missed = (micros() - next) / samplePeriod;
+        next += missed * samplePeriod;
+        totalSamples += missed;
+      }
+      firstSample = totalSamples;
+      continue;
+    } else {
+      status |= LOGIC_CAPTURE_OVERFLOW;
+      break;
+    }
+    totalSamples++;
+
+    if (limit && (micros() - start) >= limit) {
+      break;
+    }
+    // polling the stream is comparatively slow, so only do it every 32 samples
+    if ((++poll & 0x1F) == 0 && Firmata.available()) {
+      status |= LOGIC_CAPTURE_ABORTED;
+      break;
+    }
+  }
+
+  elapsedMicros = micros() - start;
+}
+
+void LogicCaptureFirmata::sendRecords()
+{
+  unsigned long sampleIndex = firstSample;
+  uint16_t i = 0;
+
+  while (i < recordCount) {
+    Firmata.startSysex();
+    Firmata.write(LOGIC_CAPTURE);
+    Firmata.write(LOGIC_CAPTURE_DATA);
+    write7bit(sampleIndex, 4);
+    for (byte n = 0; n < LOGIC_CAPTURE_RECORDS_PER_MESSAGE && i < recordCount; n++, i++) {
+      write7bit(records[i].value, 3);
+      write7bit(records[i].count, 3);
+      sampleIndex += records[i].count;
+    }
+    Firmata.endSysex();
+  }
+}
+
+void LogicCaptureFirmata::sendEnd()
+{
+  Firmata.startSysex();
+  Firmata.write(LOGIC_CAPTURE);
+  Firmata.write(LOGIC_CAPTURE_END);
+  write7bit(totalSamples, 4);
+  write7bit(elapsedMicros, 4);
+  write7bit(recordCount, 2);
+  Firmata.write(status);
+  Firmata.endSysex();
+}
+
+// write the value LSB first as count 7-bit bytes
+void LogicCaptureFirmata::write7bit(unsigned long value, byte count)
+{
+  for (byte i = 0; i < count; i++) {
+    Firmata.write((byte)(value & 0x7F));
+    value >>= 7;
+  }
+}
@@ -0,0 +1,95 @@
+/*
+  LogicCaptureFirmata.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Samples up to two digital ports through readPort() at a fixed period and
+  stores the result as run-length encoded (port value, sample count) records.
+  Long idle periods therefore cost a single record, so the capture depth
+  scales with signal activity rather than with time.
+
+  A capture blocks the main loop while it is running (this is what allows a
+  fixed, high sample rate without a hardware timer). It ends when the buffer
+  is full, the requested duration has elapsed or the host sends any byte.
+*/
+
+#ifndef LogicCaptureFirmata_h
+#define LogicCaptureFirmata_h
+
+#include <Firmata.h>
+#include "FirmataFeature.h"
+
+#define FIRMATA_LOGIC_CAPTURE_FEATURE
+
+// Number of run-length records held in RAM. Each record takes 4 bytes. Edit
+// this value to trade capture depth against free RAM for the main loop.
+#if defined(__AVR__)
+#define LOGIC_CAPTURE_BUFFER_SIZE   48
+#else
+#define LOGIC_CAPTURE_BUFFER_SIZE   512
+#endif
+
+// Logic capture command bytes
+#define LOGIC_CAPTURE_START         0x00 // host: port0 port1 period(2) duration(2) flags
+#define LOGIC_CAPTURE_STOP          0x01 // host: abort a running or armed capture
+#define LOGIC_CAPTURE_DUMP          0x02 // host: resend the records of the last capture
+#define LOGIC_CAPTURE_DATA          0x03 // device: first sample(4) then (value(3), count(3)) records
+#define LOGIC_CAPTURE_END           0x04 // device: samples(4) elapsed us(4) records(2) status
+
+// Logic capture START flags
+#define LOGIC_CAPTURE_STREAM        0x01 // flush the buffer whenever it fills instead of stopping
+
+// Logic capture END status bits
+#define LOGIC_CAPTURE_OVERFLOW      0x01 // the capture stopped because the buffer was full
+#define LOGIC_CAPTURE_ABORTED       0x02 // the capture was stopped by the host
+#define LOGIC_CAPTURE_GAPS          0x04 // samples were skipped while streaming records
+
+#define LOGIC_CAPTURE_NO_PORT       0x7F // unused second port
+#define LOGIC_CAPTURE_MAX_RUN       0xFFFF
+// records sent in a single LOGIC_CAPTURE_DATA message (6 bytes each)
+#define LOGIC_CAPTURE_RECORDS_PER_MESSAGE 8
+
+class LogicCaptureFirmata: public FirmataFeature
+{
+  public:
+    LogicCaptureFirmata();
+    boolean handlePinMode(byte pin, int mode);
+    void handleCapability(byte pin);
+    boolean handleSysex(byte command, byte argc, byte *argv);
+    void update();
+    void reset();
+
+  private:
+    struct logic_record {
+      uint16_t value; // port0 in the low byte, port1 in the high byte
+      uint16_t count; // number of consecutive samples with this value
+    };
+
+    logic_record records[LOGIC_CAPTURE_BUFFER_SIZE];
+    uint16_t recordCount;
+
+    byte ports[2];
+    uint16_t samplePeriod;       // [us], 0 = as fast as possible
+    uint16_t maxDuration;        // [ms], 0 = until the buffer is full or stopped
+    byte flags;
+    byte status;
+    boolean armed;
+
+    unsigned long firstSample;   // index of records[0] within the whole capture
+    unsigned long totalSamples;
+    unsigned long elapsedMicros;
+
+    uint16_t sample();
+    void capture();
+    void sendRecords();
+    void sendEnd();
+    void write7bit(unsigned long value, byte count);
+};
+
+#endif /* LogicCaptureFirmata_h */
@@ -0,0 +1,136 @@
+/*
+  LoopTimingFirmata.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#include "LoopTimingFirmata.h"
+
+LoopTimingFirmata::LoopTimingFirmata()
+{
+  reset();
+}
+
+boolean LoopTimingFirmata::handlePinMode(byte pin, int mode)
+{
+  (void)pin;
+  (void)mode;
+  return false;
+}
+
+void LoopTimingFirmata::handleCapability(byte pin)
+{
+  (void)pin;
+}
+
+boolean LoopTimingFirmata::handleSysex(byte command, byte argc, byte *argv)
+{
+  if (command != LOOP_TIMING || argc < 1) {
+    return false;
+  }
+
+  if (argv[0] == LOOP_TIMING_QUERY) {
+    for (byte stage = 0; stage < LOOP_TIMING_STAGES; stage++) {
+      if (stages[stage].count > 0) {
+        sendStage(stage);
+      }
+    }
+    if (argc > 1 && (argv[1] & LOOP_TIMING_RESET)) {
+      reset();
+    }
+  }
+  return true;
+}
+
+void LoopTimingFirmata::reset()
+{
+  for (byte stage = 0; stage < LOOP_TIMING_STAGES; stage++) {
+    stages[stage].count = 0;
+    stages[stage].minimum = 0xFFFFFFFF;
+    stages[stage].maximum = 0;
+    stages[stage].total = 0;
+    for (byte i = 0; i < LOOP_TIMING_BUCKETS; i++) {
+      stages[stage].buckets[i] = 0;
+    }
+  }
+  // the loop that is running does not have a valid start time anymore
+  started = false;
+}
+
+/*
+ * Call at the start of loop(). Records the period of the previous loop() and starts timing
+ * the first stage.
+ */
+void LoopTimingFirmata::startLoop()
+{
+  unsigned long now = micros();
+  if (started) {
+    record(LOOP_TIMING_LOOP, now - loopStart);
+  }
+  started = true;
+  loopStart = now;
+  stageStart = now;
+}
+
+/*
+ * Call at the end of a stage. The stage lasted from the previous marker until now.
+ */
+void LoopTimingFirmata::endStage(byte stage)
+{
+  unsigned long now = micros();
+  if (started && stage < LOOP_TIMING_STAGES) {
+    record(stage, now - stageStart);
+  }
+  stageStart = now;
+}
+
+void LoopTimingFirmata::record(byte stage, unsigned long duration)
+{
+  stage_timing &timing = stages[stage];
+  byte bucket = 0;
+
+  timing.count++;
+  timing.total += duration;
+  if (duration < timing.minimum) timing.minimum = duration;
+  if (duration > timing.maximum) timing.maximum = duration;
+
+  for (duration >>= 4; duration && bucket < LOOP_TIMING_BUCKETS - 1; duration >>= 2) {
+    bucket++;
+  }
+  if (timing.buckets[bucket] < 0xFFFF) {
+    timing.buckets[bucket]++;
+  }
+}
+
+void LoopTimingFirmata::sendStage(byte stage)
+{
+  const stage_timing &timing = stages[stage];
+
+  Firmata.startSysex();
+  Firmata.write(LOOP_TIMING);
+  Firmata.write(LOOP_TIMING_REPLY);
+  Firmata.write(stage);
+  write7bit(timing.count, 5);
+  write7bit(timing.minimum, 5);
+  write7bit(timing.maximum, 5);
+  write7bit(timing.total, 5);
+  for (byte i = 0; i < LOOP_TIMING_BUCKETS; i++) {
+    write7bit(timing.buckets[i], 3);
+  }
+  Firmata.endSysex();
+}
+
+// write the value LSB first as count 7-bit bytes
+void LoopTimingFirmata::write7bit(unsigned long value, byte count)
+{
+  for (byte i = 0; i < count; i++) {
+    Firmata.write((byte)(value & 0x7F));
+    value >>= 7;
+  }
+}
@@ -0,0 +1,72 @@
+/*
+  LoopTimingFirmata.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Measures how long each stage of the sketch's loop() takes with micros().
+  The sketch marks the stages with LOOP_TIMING_START() and
+  LOOP_TIMING_STAGE(stage) from firmataLoopTiming.h; a stage lasts from the
+  previous marker to its own, so each marker costs a single micros() call.
+  For every stage the number of runs, the minimum, maximum and total
+  duration and a histogram with base 4 buckets are kept, and the host can
+  query them with a LOOP_TIMING sysex message.
+*/
+
+#ifndef LoopTimingFirmata_h
+#define LoopTimingFirmata_h
+
+#include <Firmata.h>
+#include "FirmataFeature.h"
+#include "firmataLoopTiming.h"
+
+#define FIRMATA_LOOP_TIMING_FEATURE
+
+// Loop timing command bytes
+#define LOOP_TIMING_QUERY           0x00 // host: [flags]
+#define LOOP_TIMING_REPLY           0x01 // device: stage count(5) min(5) max(5) total(5) buckets(8 x 3)
+
+// Loop timing QUERY flags
+#define LOOP_TIMING_RESET           0x01 // clear the statistics after reporting them
+
+// Histogram bucket n (n > 0) counts durations of 4^(n + 1) to 4^(n + 2) - 1 us, bucket 0
+// counts durations below 16 us and the last bucket everything from 65536 us
+#define LOOP_TIMING_BUCKETS         8
+
+class LoopTimingFirmata: public FirmataFeature
+{
+  public:
+    LoopTimingFirmata();
+    boolean handlePinMode(byte pin, int mode);
+    void handleCapability(byte pin);
+    boolean handleSysex(byte command, byte argc, byte *argv);
+    void reset();
+
+    void startLoop();
+    void endStage(byte stage);
+
+  private:
+    struct stage_timing {
+      unsigned long count;
+      unsigned long minimum;  // [us]
+      unsigned long maximum;  // [us]
+      unsigned long total;    // [us], wraps after 71 minutes
+      uint16_t buckets[LOOP_TIMING_BUCKETS];  // saturating
+    };
+
+    stage_timing stages[LOOP_TIMING_STAGES];
+    unsigned long loopStart;
+    unsigned long stageStart;
+    boolean started;
+
+    void record(byte stage, unsigned long duration);
+    void sendStage(byte stage);
+    void write7bit(unsigned long value, byte count);
+};
+
+#endif /* LoopTimingFirmata_h */
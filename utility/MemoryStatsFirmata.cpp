@@ -0,0 +1,201 @@
+/*
+  MemoryStatsFirmata.cpp
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#include "MemoryStatsFirmata.h"
+
+#if defined(__AVR__)
+// provided by avr-libc
+extern char __data_start;
+extern char __heap_start;
+extern char *__brkval;
+struct __freelist {
+  size_t sz;
+  struct __freelist *nx;
+};
+extern struct __freelist *__flp;
+#elif defined(__arm__)
+extern "C" char *sbrk(int incr);
+#endif
+
+#if defined(__AVR__)
+// the end of the heap, which grows towards the stack
+static char *heapEnd()
+{
+  return __brkval ? __brkval : &__heap_start;
+}
+#endif
+
+MemoryStatsFirmata::MemoryStatsFirmata()
+{
+  painted = false;
+  paint();
+}
+
+boolean MemoryStatsFirmata::handlePinMode(byte pin, int mode)
+{
+  (void)pin;
+  (void)mode;
+  return false;
+}
+
+void MemoryStatsFirmata::handleCapability(byte pin)
+{
+  (void)pin;
+}
+
+boolean MemoryStatsFirmata::handleSysex(byte command, byte argc, byte *argv)
+{
+  if (command != MEMORY_STATS || argc < 1) {
+    return false;
+  }
+
+  if (argv[0] == MEMORY_STATS_QUERY) {
+    Firmata.startSysex();
+    Firmata.write(MEMORY_STATS);
+    Firmata.write(MEMORY_STATS_REPLY);
+    Firmata.write(painted ? MEMORY_STATS_PAINTED : 0);
+    write7bit(staticSize(), 3);
+    write7bit(stackHighWater(), 3);
+    write7bit(stackHeadroom(), 3);
+    write7bit(freeMemory(), 3);
+    write7bit(freeHeap(), 3);
+    write7bit(largestFreeBlock(), 3);
+    Firmata.write(fragmentation());
+    Firmata.endSysex();
+  }
+  return true;
+}
+
+void MemoryStatsFirmata::reset()
+{
+  // the high-water mark covers the whole run time and is kept across a system reset
+}
+
+boolean MemoryStatsFirmata::isPainted()
+{
+  return painted;
+}
+
+unsigned long MemoryStatsFirmata::staticSize()
+{
+#if defined(__AVR__)
+  return &__heap_start - &__data_start;
+#else
+  return 0;
+#endif
+}
+
+/*
+ * The stack grows down from RAMEND. Its deepest point is the lowest byte above the heap that no
+ * longer holds the painted value.
+ */
+unsigned long MemoryStatsFirmata::stackHighWater()
+{
+#if defined(__AVR__)
+  if (!painted) {
+    return 0;
+  }
+  return (char *)RAMEND - (heapEnd() + stackHeadroom()) + 1;
+#else
+  return 0;
+#endif
+}
+
+unsigned long MemoryStatsFirmata::stackHeadroom()
+{
+#if defined(__AVR__)
+  if (!painted) {
+    return 0;
+  }
+  const uint8_t *p = (const uint8_t *)heapEnd();
+  const uint8_t *sp = (const uint8_t *)SP;
+  unsigned long count = 0;
+  while (p < sp && *p == MEMORY_STATS_CANARY) {
+    p++;
+    count++;
+  }
+  return count;
+#else
+  return 0;
+#endif
+}
+
+unsigned long MemoryStatsFirmata::freeMemory()
+{
+#if defined(__AVR__)
+  return (char *)SP - heapEnd();
+#elif defined(__arm__)
+  char top;
+  return &top - sbrk(0);
+#else
+  return 0;
+#endif
+}
+
+unsigned long MemoryStatsFirmata::freeHeap()
+{
+  unsigned long total = 0;
+#if defined(__AVR__)
+  for (struct __freelist *block = __flp; block; block = block->nx) {
+    total += block->sz + sizeof(size_t);
+  }
+#endif
+  return total;
+}
+
+unsigned long MemoryStatsFirmata::largestFreeBlock()
+{
+  unsigned long largest = freeMemory();
+#if defined(__AVR__)
+  for (struct __freelist *block = __flp; block; block = block->nx) {
+    if (block->sz > largest) {
+      largest = block->sz;
+    }
+  }
+#endif
+  return largest;
+}
+
+byte MemoryStatsFirmata::fragmentation()
+{
+  unsigned long total = freeMemory() + freeHeap();
+  if (total == 0) {
+    return 0;
+  }
+  return (byte)(100 - (largestFreeBlock() * 100) / total);
+}
+
+/*
+ * Fill the RAM between the heap and the stack pointer with MEMORY_STATS_CANARY. This runs from
+ * the constructor, i.e. during the static initialization before setup() when the stack is
+ * shallow.
+ */
+void MemoryStatsFirmata::paint()
+{
+#if defined(__AVR__)
+  uint8_t *p = (uint8_t *)heapEnd();
+  uint8_t *end = (uint8_t *)SP - MEMORY_STATS_MARGIN;
+  while (p < end) {
+    *p++ = MEMORY_STATS_CANARY;
+  }
+  painted = true;
+#endif
+}
+
+// write the value LSB first as count 7-bit bytes
+void MemoryStatsFirmata::write7bit(unsigned long value, byte count)
+{
+  for (byte i = 0; i < count; i++) {
+    Firmata.write((byte)(value & 0x7F));
+    value >>= 7;
+  }
+}
@@ -0,0 +1,66 @@
+/*
+  MemoryStatsFirmata.h
+  Copyright (C) 2026 Firmata Developers.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+
+  Reports how the RAM is used: the stack high-water mark, the free memory,
+  the free heap blocks and the heap fragmentation.
+
+  On AVR boards the constructor paints the unused RAM between the heap and
+  the stack with a known byte before setup() runs. The stack high-water mark
+  is the painted area that has been overwritten since. Declare the feature as
+  a global so it is constructed before anything else uses the stack. Other
+  architectures only report the free memory between the heap and the stack
+  (ARM) or nothing.
+*/
+
+#ifndef MemoryStatsFirmata_h
+#define MemoryStatsFirmata_h
+
+#include <Firmata.h>
+#include "FirmataFeature.h"
+
+#define FIRMATA_MEMORY_STATS_FEATURE
+
+// Memory stats command bytes
+#define MEMORY_STATS_QUERY          0x00 // host: no data
+#define MEMORY_STATS_REPLY          0x01 // device: flags static(3) stack(3) headroom(3) free(3) heap free(3) largest(3) fragmentation
+
+// Memory stats REPLY flags
+#define MEMORY_STATS_PAINTED        0x01 // the stack values are valid
+
+#define MEMORY_STATS_CANARY         0xC5 // value painted into the unused RAM
+#define MEMORY_STATS_MARGIN         16   // bytes below the stack pointer that are not painted
+
+class MemoryStatsFirmata: public FirmataFeature
+{
+  public:
+    MemoryStatsFirmata();
+    boolean handlePinMode(byte pin, int mode);
+    void handleCapability(byte pin);
+    boolean handleSysex(byte command, byte argc, byte *argv);
+    void reset();
+
+    boolean isPainted();
+    unsigned long staticSize();       // [bytes] RAM used by global and static variables
+    unsigned long stackHighWater();   // [bytes] largest stack depth since startup
+    unsigned long stackHeadroom();    // [bytes] RAM never touched by the heap or the stack
+    unsigned long freeMemory();       // [bytes] RAM between the heap and the stack pointer
+    unsigned long freeHeap();         // [bytes] free blocks inside the heap
+    unsigned long largestFreeBlock(); // [bytes] largest block malloc() could return
+    byte fragmentation();             // [%] share of the free memory not in the largest block
+
+  private:
+    boolean painted;
+
+    void paint();
+    void write7bit(unsigned long value, byte count);
+};
+
+#endif /* MemoryStatsFirmata_h */
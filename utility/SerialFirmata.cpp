@@ -374,6 +374,7 @@ void SerialFirmata::checkSerial()
 #if defined(FIRMATA_SERIAL_RX_DELAY)
           lastBytesAvailable[portId] -= numBytesToRead;
 #endif
+          FIRMATA_TRACE_EVENT(TRACE_FEATURE_BEGIN, SERIAL_MESSAGE);
           Firmata.write(START_SYSEX);
           Firmata.write(SERIAL_MESSAGE);
           Firmata.write(SERIAL_REPLY | portId);
@@ -387,6 +388,7 @@ void SerialFirmata::checkSerial()
           }
 
           Firmata.write(END_SYSEX);
+          FIRMATA_TRACE_EVENT(TRACE_FEATURE_END, SERIAL_MESSAGE);
         }
       }
     }
@@ -0,0 +1,24 @@
+#ifndef FIRMATA_LOOP_TIMING_H
+#define FIRMATA_LOOP_TIMING_H
+
+// loop() stages, each one is timed from the end of the previous stage
+#define LOOP_TIMING_LOOP            0 // the whole loop() period, from one start to the next
+#define LOOP_TIMING_DIGITAL_INPUTS  1 // checkDigitalInputs()
+#define LOOP_TIMING_PROCESS_INPUT   2 // Firmata.processInput() including the callbacks
+#define LOOP_TIMING_ANALOG          3 // analog sampling
+#define LOOP_TIMING_I2C             4 // continuous I2C reads
+#define LOOP_TIMING_FEATURES        5 // FirmataFeature update() calls
+#define LOOP_TIMING_NETWORK         6 // transport maintenance (WiFi, Ethernet, BLE)
+#define LOOP_TIMING_STAGES          7
+
+// The markers compile to nothing unless utility/LoopTimingFirmata.h is included
+// before this file and the sketch declares "LoopTimingFirmata loopTimingFeature".
+#ifdef FIRMATA_LOOP_TIMING_FEATURE
+  #define LOOP_TIMING_START()       loopTimingFeature.startLoop()
+  #define LOOP_TIMING_STAGE(stage)  loopTimingFeature.endStage(stage)
+#else
+  #define LOOP_TIMING_START()
+  #define LOOP_TIMING_STAGE(stage)
+#endif
+
+#endif /* FIRMATA_LOOP_TIMING_H */